@@ -185,8 +185,8 @@ void FbxSdkManager::linkSkeleton(const RawMeshContainer& rawMesh, const Rig& arm
     std::vector<std::pair<int, float>> cpIndices;
     for (size_t vId = 0; vId != rawMesh.VertCount; ++vId)
     {
-        uint16_t* joints = rawMesh.joints[vId];
-        float* weights = rawMesh.weights[vId];
+        const uint16_t* joints = rawMesh.joints + vId * 4;
+        const float* weights = rawMesh.weights + vId * 4;
         for (size_t j = 0; j != 4; ++j)
         {
             uint16_t bindId = joints[j];
@@ -297,20 +297,19 @@ void FbxSdkManager::assignNormal(const RawMeshContainer& rawMesh, FbxMesh* mesh)
 
 void FbxSdkManager::assignTexcoord(const RawMeshContainer& rawMesh, FbxMesh* mesh)
 {
-    assignTexcoord(rawMesh.txcoord0, rawMesh.VertCount, mesh);
-    assignTexcoord(rawMesh.txcoord1, rawMesh.VertCount, mesh);
-    assignTexcoord(rawMesh.txcoord2, rawMesh.VertCount, mesh);
+    assignTexcoord(rawMesh.txcoord0, rawMesh.VertCount, 0, mesh);
+    assignTexcoord(rawMesh.txcoord1, rawMesh.VertCount, 1, mesh);
+    assignTexcoord(rawMesh.txcoord2, rawMesh.VertCount, 2, mesh);
 }
 
-void FbxSdkManager::assignTexcoord(Vec2* texcoord, uint32_t count, FbxMesh* mesh)
+void FbxSdkManager::assignTexcoord(Vec2* texcoord, uint32_t count, uint32_t uvLayerId, FbxMesh* mesh)
 {
     if (!texcoord || !count)
     {
         return;
     }
 
-    static uint32_t uvLayerId = 0;
-    std::string uvName = std::string("UV") + std::to_string(uvLayerId++);
+    std::string uvName = std::string("UV") + std::to_string(uvLayerId);
 
     // Create UV for Diffuse channel
     FbxGeometryElementUV* lUVElement = mesh->CreateElementUV(uvName.c_str());
@@ -31,7 +31,7 @@ private:
 
     void assignNormal(const RawMeshContainer& rawMesh, FbxMesh* mesh);
     void assignTexcoord(const RawMeshContainer& rawMesh, FbxMesh* mesh);
-	void assignTexcoord(Vec2* texcoord, uint32_t count, FbxMesh* mesh);
+	void assignTexcoord(Vec2* texcoord, uint32_t count, uint32_t uvLayerId, FbxMesh* mesh);
 	void assignTangent(const RawMeshContainer& rawMesh, FbxMesh* mesh);
 
     void bindSkeleton(
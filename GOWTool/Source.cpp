@@ -1,464 +1,539 @@
 #include "pch.h"
 #include "Rig.h"
 #include "glTFSerializer.h"
+#ifndef GOWTOOL_NO_FBXSDK
 #include "FBXSerializer.h"
+#endif
+#include "FbxExport.h"
 #include "Formats.h"
 #include "MainFunctions.h"
 #include "Texpack.h"
 #include "Lodpack.h"
 #include "Wad.h"
+#include "Catalog.h"
+#include "ThreadPool.h"
 #include "krak.h"
 #include "utils.h"
 #include "Gnf.h"
 #include "converter.h"
 #include "animation.h"
+#include "Bench.h"
+#include "ExportStore.h"
+#include "BuildManifest.h"
 
 #include <unordered_set>
-
-bool ImportAllGnf(const std::filesystem::path& gnfSrcDir, vector<Texpack*>& texpacks)
+#include <functional>
+#include <charconv>
+
+#ifdef GOWTOOL_NO_FBXSDK
+// built without the FBX SDK, skinned meshes always go through the native writer
+constexpr bool FbxSdkAvailable = false;
+#else
+constexpr bool FbxSdkAvailable = true;
+#endif
+
+// file hash of a texture named TX_..._<16 hex digits> or by its decimal hash, false for other names
+bool ParseTextureHash(const std::filesystem::path& path, uint64_t& hash)
+{
+    std::stringstream s;
+    std::string str = path.filename().stem().string();
+    if (str.find("TX_") != std::string::npos)
+    {
+        str = str.substr(str.find_last_of("_") + 1, 16);
+        if (str.length() < 16)
+            return false;
+        s << std::hex << str;
+    }
+    else
+    {
+        s << str;
+    }
+    hash = 0;
+    s >> hash;
+    return !s.fail();
+}
+// images are only read for their headers here, the writer loads them one at a time
+// compressed texpacks are only readable by GOWTool, not by the game
+bool ImportAllGnf(const std::filesystem::path& gnfSrcDir, vector<Texpack*>& texpacks, bool compress, size_t jobs)
 {
     if (gnfSrcDir.empty() || !gnfSrcDir.is_absolute() || !std::filesystem::exists(gnfSrcDir) || !std::filesystem::is_directory(gnfSrcDir))
     {
         return false;
     }
 
-    std::vector<Gnf::GnfImage*> gnfImages;
-    std::vector<uint64_t> gnfHashes;
+    TexpackWriter writer(compress);
+    if (compress && !writer.Compressed())
+        Utils::Logger::Warning("\nOodle library not loaded, textures are packed uncompressed");
     std::filesystem::directory_iterator dir(gnfSrcDir);
     for (const std::filesystem::directory_entry& entry : dir)
     {
-        Gnf::GnfImage* gnfImage = new Gnf::GnfImage();
-        if (Utils::str_tolower(entry.path().extension().string()) == ".gnf")
-        {
-            std::ifstream ifs(entry.path().string(), std::ios::binary | std::ios::in);
-            ifs.seekg(0x0, std::ios::end);
-            size_t size = ifs.tellg();
-            ifs.seekg(0x0, std::ios::beg);
+        std::string ext = Utils::str_tolower(entry.path().extension().string());
+        if (ext != ".gnf" && ext != ".dds")
+            continue;
+        uint64_t hash = 0;
+        if (!ParseTextureHash(entry.path(), hash))
+            continue;
+
+        std::ifstream ifs(entry.path(), std::ios::binary | std::ios::in);
+        ifs.seekg(0x0, std::ios::end);
+        size_t size = ifs.tellg();
+        ifs.seekg(0x0, std::ios::beg);
 
+        TexpackWriter::Texture texture;
+        texture.hash = hash;
+        std::filesystem::path path = entry.path();
+        if (ext == ".gnf")
+        {
             if (size < 0x200)
-            {
                 continue;
-                ifs.close();
-            }
-
-            uint32_t magic;
-            ifs.read((char*)&magic, sizeof(uint32_t));
-            if (magic != gnfImage->header.gnfMagic)
-            {
+            ifs.read((char*)&texture.header, sizeof(texture.header));
+            if (texture.header.gnfMagic != Gnf::Header().gnfMagic || texture.header.dataSize > size - sizeof(Gnf::Header))
                 continue;
-                ifs.close();
-            }
 
-            ifs.seekg(0x0, std::ios::beg);
-
-            byte* bytes = new byte[size];
-            ifs.read((char*)bytes, size);
-            ifs.close();
-
-            try
-            {
-                gnfImage->ReadImage(bytes);
-            }
-            catch (std::exception& ex)
+            uint32_t dataSize = texture.header.dataSize;
+            texture.load = [path, dataSize]() -> std::shared_ptr<byte[]>
             {
-                continue;
-            }
-
-            gnfImages.push_back(gnfImage);
-            delete[] bytes;
+                std::ifstream ifs(path, std::ios::binary | std::ios::in);
+                std::shared_ptr<byte[]> data(new byte[dataSize]);
+                ifs.seekg(sizeof(Gnf::Header), std::ios::beg);
+                if (!ifs.read((char*)data.get(), dataSize))
+                    return nullptr;
+                return data;
+            };
         }
-        else if (Utils::str_tolower(entry.path().extension().string()) == ".dds")
+        else
         {
-            std::ifstream ifs(entry.path().string(), std::ios::binary | std::ios::in);
-            ifs.seekg(0x0, std::ios::end);
-            size_t size = ifs.tellg();
-            ifs.seekg(0x0, std::ios::beg);
-
+            // the gnf header only needs the dds headers, the pixels are converted when the writer gets to them
             if (size < 0x95)
-            {
                 continue;
-                ifs.close();
-            }
-
-            uint32_t magic;
-            ifs.read((char*)&magic, sizeof(uint32_t));
-            
-            if (magic != 0x20534444)
-            {
-                continue;
-                ifs.close();
-            }
-            
-            ifs.seekg(0x0, std::ios::beg);
-
-            byte* ddsbytes = new byte[size];
-            ifs.read((char*)ddsbytes, size);
-            ifs.close();
-
+            byte ddsheader[0x94];
+            ifs.read((char*)ddsheader, sizeof(ddsheader));
             try
             {
-                byte* bytes = nullptr;
-                size = ConvertDDSToGnf(ddsbytes, size, bytes);
-                gnfImage->ReadImage(bytes);
-
-                delete[] bytes;
+                texture.header = GetGnfHeader(ddsheader, size);
             }
             catch (const std::exception& ex)
             {
                 continue;
             }
 
-            gnfImages.push_back(gnfImage);
-            delete[] ddsbytes;
-        }
-        else
-            continue;
-
-        try
-        {
-            std::stringstream s;
-            std::string str = entry.path().filename().stem().string();
-            if (str.find("TX_") != std::string::npos)
-            {
-                str = str.substr(str.find_last_of("_") + 1, 16);
-                if (str.length() < 16)
-                    continue;
-                s << std::hex << str;
-            }
-            else
+            texture.load = [path, size]() -> std::shared_ptr<byte[]>
             {
-                s << str;
-            }
-            uint64_t hash = 0;
-            s >> hash;
-
-            gnfHashes.push_back(hash);
+                std::ifstream ifs(path, std::ios::binary | std::ios::in);
+                vector<byte> ddsbytes(size);
+                if (!ifs.read((char*)ddsbytes.data(), size))
+                    return nullptr;
+                try
+                {
+                    byte* bytes = nullptr;
+                    ConvertDDSToGnf(ddsbytes.data(), size, bytes);
+                    // the image data follows the gnf header in the same allocation
+                    std::shared_ptr<byte[]> gnf(bytes);
+                    return std::shared_ptr<byte[]>(gnf, gnf.get() + sizeof(Gnf::Header));
+                }
+                catch (const std::exception& ex)
+                {
+                    return nullptr;
+                }
+            };
         }
-        catch (const std::exception& ex)
+
+        for (size_t j = 0; j < texpacks.size(); j++)
         {
-            continue;
+            if (texpacks[j]->GetUserHash(hash, texture.header.userHash))
+                break;
         }
+        writer.Add(std::move(texture));
     }
 
-    if (gnfImages.size() < 1)
-        return false;
-
-    if (gnfImages.size() != gnfHashes.size())
+    if (writer.TextureCount() < 1)
         return false;
 
     std::filesystem::path outTexpackPath = gnfSrcDir.parent_path() / (gnfSrcDir.filename().string() + ".texpack");
     std::filesystem::path outTexpackTocPath = gnfSrcDir.parent_path() / (gnfSrcDir.filename().string() + ".texpack.toc");
+    ThreadPool pool(jobs);
+    return writer.Write(outTexpackPath, outTexpackTocPath, &pool);
+}
+// every job writes exactly one file whose name only depends on the wad entry it
+// came from, so the output doesn't depend on the order the jobs end up running in
+typedef vector<std::function<bool()>> ExportJobs;
 
-    std::ofstream ofs(outTexpackPath.string(), std::ios::binary | std::ios::out);
-    std::ofstream ofs1(outTexpackTocPath.string(), std::ios::binary | std::ios::out);
-
-    for (size_t i = 0; i < 4; i++)
+bool RunJobs(ExportJobs& jobs)
+{
+    bool result = true;
+    for (auto& job : jobs)
     {
-        uint64_t z = 0x0ULL;
-        ofs.write((char*)&z, sizeof(z));
-        ofs1.write((char*)&z, sizeof(z));
+        result &= job();
     }
-
-    uint32_t _texSectionOff = (0x38 + gnfImages.size() * 0x18 + gnfImages.size() * 0x20 + 15) & (~15);
-    uint32_t _blocksCount = gnfImages.size();
-    uint32_t _blocksInfoOff = 0x38 + gnfImages.size() * 0x18;
-    uint32_t _TexsCount = gnfImages.size();
-
-    ofs.write((char*)&_texSectionOff, sizeof(_texSectionOff));
-    ofs.write((char*)&_blocksCount, sizeof(_blocksCount));
-    ofs.write((char*)&_blocksInfoOff, sizeof(_blocksInfoOff));
-    ofs.write((char*)&_TexsCount, sizeof(_TexsCount));
-    uint64_t z = 0x5ULL;
-    ofs.write((char*)&z, sizeof(z));
-
-    ofs1.write((char*)&_texSectionOff, sizeof(_texSectionOff));
-    ofs1.write((char*)&_blocksCount, sizeof(_blocksCount));
-    ofs1.write((char*)&_blocksInfoOff, sizeof(_blocksInfoOff));
-    ofs1.write((char*)&_TexsCount, sizeof(_TexsCount));
-    ofs1.write((char*)&z, sizeof(z));
-
-    Texpack::TexInfo* texInfos = new Texpack::TexInfo[_TexsCount];
-    Texpack::BlockInfo* blockInfos = new Texpack::BlockInfo[_TexsCount];
-
-    size_t woff = _texSectionOff;
-    for (size_t i = 0; i < _TexsCount; i++)
+    return result;
+}
+// Optional outputs shared by the jobs of one wad. With a store each unique asset
+// is written into it once and the manifest records which store file every wad
+// entry ended up in. With a build manifest, outputs whose inputs didn't change
+// since the last run are skipped.
+struct ExportContext
+{
+    ExportStore* store{ nullptr };
+    std::shared_ptr<ExportManifest> manifest;
+    BuildManifest* build{ nullptr };
+    const Catalog* catalog{ nullptr };
+    uint64_t wadKey{ 0 }; // fingerprint of the wad itself
+};
+bool IsUpToDate(const ExportContext& context, const std::filesystem::path& outfile, const BuildManifest::Inputs& inputs)
+{
+    return context.build != nullptr && context.build->IsUpToDate(outfile, inputs);
+}
+// runs write and records the output in the build manifest if it succeeded, the
+// old record is dropped first so a job that throws leaves no stale record behind
+template<typename Write>
+bool BuildOutputFile(const ExportContext& context, const std::filesystem::path& outfile, const BuildManifest::Inputs& inputs, Write&& write)
+{
+    if (context.build == nullptr)
+        return write();
+    context.build->Forget(outfile);
+    bool result = write();
+    if (result)
+        context.build->Record(outfile, inputs);
+    return result;
+}
+bool PlanTextures(WadFile& wad, TexpackIndex& texpacks, const std::filesystem::path& outdir, bool dds, ExportJobs& jobs, const ExportContext& context = {})
+{
+    if (wad._FileEntries.size() < 1 || texpacks.PackCount() < 1)
+        return false;
+    if (!std::filesystem::exists(outdir))
+        return false;
+    std::unordered_set<std::string> names;
+    for (uint32_t i : wad.GetEntries(WadFile::FileType::Texture))
     {
-        Gnf::GnfImage*& gnfImg = gnfImages[i];
-
-        for (size_t j = 0; j < texpacks.size(); j++)
+        std::stringstream s;
+        std::string name = wad._FileEntries[i].name.substr(3);
+        s << std::hex << name.substr(name.find_last_of("_") + 1, 16);
+        uint64_t hash = 0;
+        s >> hash;
+        Texpack* texpack = texpacks.Find(hash);
+        if (texpack == nullptr || !names.insert(wad._FileEntries[i].name).second)
+            continue;
+        std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + (dds ? ".dds" : ".gnf"));
+        if (context.store != nullptr)
         {
-            if (texpacks[j]->GetUserHash(gnfHashes[i], gnfImg->header.userHash))
-                break;
+            outfile = context.store->GetPath(ExportStore::Kind::Texture, hash, dds ? ".dds" : ".gnf");
+            context.manifest->Add(wad._FileEntries[i].name, outfile);
+            if (!context.store->Claim(ExportStore::Kind::Texture, hash))
+                continue;
         }
-        Texpack::TexInfo& texInfo = texInfos[i];
-        texInfo._fileHash = gnfHashes[i];
-        texInfo._userHash = gnfImg->header.userHash;
-        texInfo._blockInfoOff = _blocksInfoOff + (i * 0x20);
-
-        Texpack::BlockInfo& blockInfo = blockInfos[i];
-        blockInfo._blockOff = uint32_t(woff >> 4);
-        blockInfo._rawSize = gnfImg->header.dataSize;
-        blockInfo._blockSize = (gnfImg->header.fileSize + 0x24 + 15) & (~15);
-        blockInfo._mipLvlStart = gnfImg->header.mipmaps;
-        blockInfo._mipLvlEnd = 0;
-        blockInfo._tocFileIdx = 0;
-        blockInfo._mipWidth = gnfImg->header.width + 1;
-        blockInfo._mipHeight = gnfImg->header.height + 1;
-        blockInfo._nextSiblingBlockInfoOff = -1LL;
-
-        woff += blockInfo._blockSize;
-    }
-
-    for (size_t i = 0; i < _TexsCount; i++)
-    {
-        Texpack::TexInfo& texInfo = texInfos[i];
-
-        ofs.write((char*)&texInfo, sizeof(texInfo));
-        ofs1.write((char*)&texInfo, sizeof(texInfo));
-    }
-    for (size_t i = 0; i < _TexsCount; i++)
-    {
-        Texpack::BlockInfo& blockInfo = blockInfos[i];
-
-        ofs.write((char*)&blockInfo, sizeof(blockInfo));
-        ofs1.write((char*)&blockInfo, sizeof(blockInfo));
-    }
-
-    size_t curOff = ofs.tellp();
-    for (size_t i = 0; i < _texSectionOff - curOff; i++)
-    {
-        byte zz = 0;
-        ofs.write((char*)&zz, sizeof(zz));
-        ofs1.write((char*)&zz, sizeof(zz));
-    }
-
-    ofs1.close();
-    for (size_t i = 0; i < _TexsCount; i++)
-    {
-        Gnf::GnfImage*& gnfImg = gnfImages[i];
-        uint32_t zz = 0x1U;
-        ofs.write((char*)&zz, sizeof(zz));
-        zz = 0x124U;
-        ofs.write((char*)&zz, sizeof(zz));
-
-        uint32_t blockSize = (gnfImg->header.fileSize + 0x24 + 15) & (~15);
-        ofs.write((char*)&blockSize, sizeof(blockSize));
-        zz = 0x5U;
-        ofs.write((char*)&zz, sizeof(zz));
-        ofs.write((char*)&gnfImg->header, sizeof(gnfImg->header));
-
-        uint64_t zzz = 0x3ULL;
-        ofs.write((char*)&zzz, sizeof(zzz));
-        uint16_t zzzz = uint16_t(gnfImg->header.mipmaps + 1);
-        ofs.write((char*)&zzzz, sizeof(zzzz));
-        ofs.write((char*)&zzzz, sizeof(zzzz));
-        ofs.write((char*)&gnfImg->header.dataSize, sizeof(gnfImg->header.dataSize));
-        zz = 0x2U;
-        ofs.write((char*)&zz, sizeof(zz));
-
-        ofs.write((char*)gnfImg->imageData.get(), gnfImg->header.dataSize);
-
-        curOff = ofs.tellp();
-        for (size_t j = 0; j < ((curOff + 15) & (~15)) - curOff; j++)
+        BuildManifest::Inputs inputs{ 0, hash, dds ? BuildOutput::Dds : BuildOutput::Gnf };
+        if (context.build != nullptr)
         {
-            byte z = 0;
-            ofs.write((char*)&z, sizeof(z));
+            inputs.packKey = context.catalog->GetFingerprint(*texpacks.FindPackPath(hash));
+            if (IsUpToDate(context, outfile, inputs))
+                continue;
         }
+        jobs.push_back([texpack, hash, outfile, dds, inputs, context]()
+        {
+            return BuildOutputFile(context, outfile, inputs, [&]()
+            {
+                return texpack->ExportGnf(outfile.parent_path(), hash, outfile.stem().string(), dds);
+            });
+        });
     }
-    ofs.close();
     return true;
 }
-bool ExportAllTextures(WadFile& wad, vector<Texpack*>& texpacks, const std::filesystem::path& outdir,bool dds)
+bool ExportAllTextures(WadFile& wad, TexpackIndex& texpacks, const std::filesystem::path& outdir,bool dds)
+{
+    ExportJobs jobs;
+    if (!PlanTextures(wad, texpacks, outdir, dds, jobs))
+        return false;
+    return RunJobs(jobs);
+}
+bool PlanExtract(WadFile& wad, const std::filesystem::path& outdir, ExportJobs& jobs, const ExportContext& context = {})
 {
-    if (wad._FileEntries.size() < 1 || texpacks.size() < 1)
+    if (wad._FileEntries.size() < 1)
         return false;
     if (!std::filesystem::exists(outdir))
         return false;
-    for (int i = 0; i < wad._FileEntries.size(); i++)
+    for (uint32_t i = 0; i < wad._FileEntries.size(); i++)
     {
-        if (wad._FileEntries[i].type == WadFile::FileType::Texture)
+        std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".bin");
+        BuildManifest::Inputs inputs{ context.wadKey, Utils::HashCombine(wad._FileEntries[i].offset, wad._FileEntries[i].size), BuildOutput::Extract };
+        if (IsUpToDate(context, outfile, inputs))
+            continue;
+        jobs.push_back([&wad, i, outfile, inputs, context]()
         {
-            std::stringstream s;
-            std::string name = wad._FileEntries[i].name.substr(3);
-            s << std::hex << name.substr(name.find_last_of("_") + 1, 16);
-            uint64_t hash = 0;
-            s >> hash;
-            for (int j = 0; j < texpacks.size(); j++)
-            {
-                if (texpacks[j]->ContainsTexture(hash))
+            return BuildOutputFile(context, outfile, inputs, [&]()
+            {
+                std::fstream fs;
+                fs.open(outfile.string(), ios::binary | ios::out);
+                if (wad.IsMapped())
                 {
-                    texpacks[j]->ExportGnf(outdir, hash, wad._FileEntries[i].name, dds);
-                    break;
+                    auto view = wad.GetView(i);
+                    fs.write((const char*)view.data(), view.size());
                 }
-            }
-        }
+                else
+                    wad.GetBuffer(i, fs);
+                fs.close();
+                return true;
+            });
+        });
     }
     return true;
 }
 bool ExtractAllFiles(WadFile& wad, const std::filesystem::path& outdir)
 {
-    if (wad._FileEntries.size() < 1)
-        return false;
-    if (!std::filesystem::exists(outdir))
+    ExportJobs jobs;
+    if (!PlanExtract(wad, outdir, jobs))
         return false;
-    for (int i = 0; i < wad._FileEntries.size(); i++)
+    return RunJobs(jobs);
+}
+// entry contents straight from the mapping, copied into storage if the wad is streamed
+std::span<const uint8_t> GetEntryView(WadFile& wad, int entryIdx, std::string& storage)
+{
+    if (entryIdx < 0)
+        return {};
+    if (wad.IsMapped())
+        return wad.GetView(entryIdx);
+    std::stringstream stream;
+    wad.GetBuffer(entryIdx, stream);
+    storage = stream.str();
+    return std::span<const uint8_t>((const uint8_t*)storage.data(), storage.size());
+}
+// store key of a mesh file, 0 if one of its exported meshes lives in the wad itself
+uint64_t MeshStoreKey(const vector<MeshInfo>& meshInfos, uint64_t seed)
+{
+    uint64_t key = seed;
+    for (const MeshInfo& info : meshInfos)
     {
-        std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".bin");
-        std::fstream fs;
-        fs.open(outfile.string(), ios::binary | ios::out);
-        wad.GetBuffer(i, fs);
-        fs.close();
+        if (info.LODlvl == 0 && info.Hash == 0)
+            return 0;
+        key = Utils::HashCombine(key, info.Hash);
+        key = Utils::HashCombine(key, info.LODlvl);
     }
-    return true;
+    return key;
+}
+// fingerprints of the lodpacks the exported meshes are read from, plus the wad's
+// own when the file isn't stored by content and may use the wad's mesh buffer
+uint64_t MeshPackKey(const ExportContext& context, LodpackIndex& lodpacks, const vector<MeshInfo>& meshInfos, bool usesWad)
+{
+    uint64_t key = usesWad ? context.wadKey : 0;
+    for (const MeshInfo& info : meshInfos)
+    {
+        LodpackIndex::Member member;
+        if (info.LODlvl == 0 && info.Hash != 0 && lodpacks.Find(info.Hash, member))
+            key = Utils::HashCombine(key, context.catalog->GetFingerprint(lodpacks.GetPackPath(member.packIdx)));
+    }
+    return key;
 }
-bool ExportAllSkinnedMesh(WadFile& wad, vector<Lodpack*>& lodpacks,const std::filesystem::path& outdir)
+bool PlanSkinnedMesh(WadFile& wad, LodpackIndex& lodpacks, const std::filesystem::path& outdir, bool nativeFbx, ExportJobs& jobs, const ExportContext& context = {})
 {
-    if (wad._FileEntries.size() < 1 || lodpacks.size() < 1)
+    if (wad._FileEntries.size() < 1 || lodpacks.PackCount() < 1)
         return false;
     if (!std::filesystem::exists(outdir))
         return false;
-    vector<int> usedMeshBufferIndices;
-    for (int i = 0; i < wad._FileEntries.size(); i++)
+    for (uint32_t i : wad.GetEntries(WadFile::FileType::SkinnedMeshDef))
     {
-        if (wad._FileEntries[i].type == WadFile::FileType::SkinnedMeshDef)
+        int buffIdx = wad.GetMeshBuffer(i);
+        int rigIdx = wad.GetRig(i);
+
+        jobs.push_back([&wad, &lodpacks, i, buffIdx, rigIdx, outdir, nativeFbx, context]()
         {
-            if (wad._FileEntries[i].name.find("MG_heroa00_0") != std::string::npos)
-            {
-                __debugbreak();
-            }
+            std::string meshDefStorage;
+            std::string meshBuffStorage;
+            std::string rigStorage;
+            std::span<const uint8_t> meshDefData = GetEntryView(wad, i, meshDefStorage);
+            std::span<const uint8_t> rigData = GetEntryView(wad, rigIdx, rigStorage);
 
-            std::string name = wad._FileEntries[i].name.substr(3, wad._FileEntries[i].name.length() - 5);
-            std::stringstream meshDefStream;
-            std::stringstream meshBuffStream;
-            std::stringstream rigStream;
-            wad.GetBuffer(i, meshDefStream);
-            for (int j = 0; j < wad._FileEntries.size(); j++)
-            {
-                if (wad._FileEntries[j].type == WadFile::FileType::SkinnedMeshBuff && (wad._FileEntries[j].name.find(wad._FileEntries[i].name) != std::string::npos))
-                {
-                    if (std::find(usedMeshBufferIndices.begin(), usedMeshBufferIndices.end(), j) != usedMeshBufferIndices.end())
-                        continue;
-                    wad.GetBuffer(j, meshBuffStream);
-                    usedMeshBufferIndices.push_back(j);
-                    break;
-                }
+            MGDefinition meshDef;
+            auto meshInfos = meshDef.ReadMG(meshDefData);
+
+            std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".fbx");
+            // files of the two FBX writers are stored apart
+            uint64_t rigHash = Utils::HashBytes(rigData);
+            uint64_t key = context.store != nullptr ? MeshStoreKey(meshInfos, nativeFbx ? Utils::HashCombine(rigHash, 1) : rigHash) : 0;
+            if (key != 0)
+            {
+                outfile = context.store->GetPath(ExportStore::Kind::SkinnedMesh, key, ".fbx");
+                context.manifest->Add(wad._FileEntries[i].name + "." + std::to_string(i), outfile);
+                if (!context.store->Claim(ExportStore::Kind::SkinnedMesh, key))
+                    return true;
             }
-            for (int j = 0; j < wad._FileEntries.size(); j++)
+            BuildManifest::Inputs inputs{ 0, 0, nativeFbx ? BuildOutput::NativeSkinnedMesh : BuildOutput::SkinnedMesh };
+            if (context.build != nullptr)
             {
-                if (wad._FileEntries[j].type == WadFile::FileType::Rig && (wad._FileEntries[j].name.find("Proto") != std::string::npos))
-                {
-                    std::string sample = Utils::str_tolower(wad._FileEntries[j].name.substr(7, wad._FileEntries[j].name.length() - 7));
-                    if (sample == name)
-                    {
-                        wad.GetBuffer(j, rigStream);
-                        break;
-                    }
-                }
+                inputs.packKey = MeshPackKey(context, lodpacks, meshInfos, key == 0);
+                inputs.entryHash = Utils::HashCombine(Utils::HashBytes(meshDefData), rigHash);
+                if (IsUpToDate(context, outfile, inputs))
+                    return true;
             }
 
-            MGDefinition meshDef;
-            auto meshInfos = meshDef.ReadMG(meshDefStream);
-            Rig rig(rigStream);
-
-            vector<RawMeshContainer> meshes;
-            for (int j = 0; j < meshInfos.size(); j++)
-            {
-                char buf[10];
-                sprintf_s(buf, "%04d", j);
-                string subname = "submesh_" + string(buf) + "_" + std::to_string(meshInfos[j].LODlvl);
-                if (meshInfos[j].LODlvl > 0)
-                    continue;
-                if (meshInfos[j].Hash == 0)
+            return BuildOutputFile(context, outfile, inputs, [&]()
+            {
+                std::span<const uint8_t> meshBuff = GetEntryView(wad, buffIdx, meshBuffStorage);
+                std::stringstream rigStream;
+                rigStream.write((const char*)rigData.data(), rigData.size());
+                Rig rig(rigStream);
+
+                // every submesh of this file is decoded into one arena, released once the file is written
+                Arena arena;
+                vector<RawMeshContainer> meshes;
+                for (int j = 0; j < meshInfos.size(); j++)
                 {
-                    if (meshBuffStream.tellp() != std::streampos(0))
+                    char buf[10];
+                    snprintf(buf, sizeof(buf), "%04d", j);
+                    string subname = "submesh_" + string(buf) + "_" + std::to_string(meshInfos[j].LODlvl);
+                    if (meshInfos[j].LODlvl > 0)
+                        continue;
+                    std::span<const uint8_t> buffer = meshInfos[j].Hash == 0 ? meshBuff : lodpacks.GetView(meshInfos[j].Hash);
+                    if (!buffer.empty())
                     {
-                        meshes.push_back(containRawMesh(meshInfos[j], meshBuffStream, subname));
+                        meshes.push_back(containRawMesh(arena, meshInfos[j], buffer, subname));
                     }
                 }
+                //WriteGLB(outfile, meshes, rig);
+                if (nativeFbx)
+                    WriteFbxNative(outfile, meshes, rig);
+#ifndef GOWTOOL_NO_FBXSDK
                 else
-                {
-                    std::stringstream buffer;
-                    for (int k = 0; k < lodpacks.size(); k++)
-                    {
-                        if (lodpacks[k]->GetBuffer(meshInfos[j].Hash, buffer))
-                            break;
-                    }
-                    if (buffer.tellp() != std::streampos(0))
-                    {
-                        meshes.push_back(containRawMesh(meshInfos[j], buffer, subname));
-                    }
-                }
-            }
-            std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".fbx");
-            //WriteGLTF(outfile, meshes, rig);
-            writeFbx(outfile, meshes, rig);
-        }
+                    writeFbx(outfile, meshes, rig);
+#endif
+                return true;
+            });
+        });
     }
     return true;
 }
-bool ExportAllRigidMesh(WadFile& wad, vector<Lodpack*>& lodpacks, const std::filesystem::path& outdir)
+bool ExportAllSkinnedMesh(WadFile& wad, LodpackIndex& lodpacks, const std::filesystem::path& outdir)
 {
-    if (wad._FileEntries.size() < 1 || lodpacks.size() < 1)
+    ExportJobs jobs;
+    if (!PlanSkinnedMesh(wad, lodpacks, outdir, !FbxSdkAvailable, jobs))
+        return false;
+    return RunJobs(jobs);
+}
+bool PlanRigidMesh(WadFile& wad, LodpackIndex& lodpacks, const std::filesystem::path& outdir, bool quantize, ExportJobs& jobs, const ExportContext& context = {})
+{
+    if (wad._FileEntries.size() < 1 || lodpacks.PackCount() < 1)
         return false;
     if (!std::filesystem::exists(outdir))
         return false;
-    vector<int> usedMeshBufferIndices;
-    for (int i = 0; i < wad._FileEntries.size(); i++)
+    for (uint32_t i : wad.GetEntries(WadFile::FileType::RigidMeshDefData))
     {
-        if (wad._FileEntries[i].type == WadFile::FileType::RigidMeshDefData && (wad._FileEntries[i].name.find("smsh_data") != std::string::npos))
+        if (wad._FileEntries[i].name.find("smsh_data") != std::string::npos)
         {
-            std::string name = wad._FileEntries[i].name.substr(0, wad._FileEntries[i].name.length() - 10);
-            std::stringstream meshDefStream;
-            wad.GetBuffer(i, meshDefStream);
-            SmshDefinition smshDef;
-            auto meshInfos = smshDef.ReadSmsh(meshDefStream);
+            int buffIdx = wad.GetMeshBuffer(i);
 
-            std::stringstream meshBuffStream;
-            for (int j = 0; j < wad._FileEntries.size(); j++)
+            jobs.push_back([&wad, &lodpacks, i, buffIdx, outdir, quantize, context]()
             {
-                if (wad._FileEntries[j].type == WadFile::FileType::SkinnedMeshBuff && (wad._FileEntries[j].name.find(name) != std::string::npos))
+                std::string meshDefStorage;
+                std::span<const uint8_t> meshDefData = GetEntryView(wad, i, meshDefStorage);
+                SmshDefinition smshDef;
+                auto meshInfos = smshDef.ReadSmsh(meshDefData);
+
+                std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".glb");
+                // quantized files are stored apart from the float ones
+                uint64_t key = context.store != nullptr ? MeshStoreKey(meshInfos, quantize ? 1 : 0) : 0;
+                if (key != 0)
                 {
-                    if (std::find(usedMeshBufferIndices.begin(), usedMeshBufferIndices.end(), j) != usedMeshBufferIndices.end())
-                        continue;
-                    wad.GetBuffer(j, meshBuffStream);
-                    usedMeshBufferIndices.push_back(j);
-                    break;
+                    outfile = context.store->GetPath(ExportStore::Kind::RigidMesh, key, ".glb");
+                    context.manifest->Add(wad._FileEntries[i].name + "." + std::to_string(i), outfile);
+                    if (!context.store->Claim(ExportStore::Kind::RigidMesh, key))
+                        return true;
                 }
-            }
-            Rig rig;
-
-            vector<RawMeshContainer> meshes;
-            for (int j = 0; j < meshInfos.size(); j++)
-            {
-                char buf[10];
-                sprintf_s(buf, "%04d", j);
-                string subname = "submesh_" + string(buf) + "_" + std::to_string(meshInfos[j].LODlvl);
-                if (meshInfos[j].LODlvl > 0)
-                    continue;
-                if (meshInfos[j].Hash == 0)
+                BuildManifest::Inputs inputs{ 0, 0, quantize ? BuildOutput::QuantizedRigidMesh : BuildOutput::RigidMesh };
+                if (context.build != nullptr)
                 {
-                    meshes.push_back(containRawMesh(meshInfos[j], meshBuffStream, subname));
+                    inputs.packKey = MeshPackKey(context, lodpacks, meshInfos, key == 0);
+                    inputs.entryHash = Utils::HashBytes(meshDefData);
+                    if (IsUpToDate(context, outfile, inputs))
+                        return true;
                 }
-                else
+
+                return BuildOutputFile(context, outfile, inputs, [&]()
                 {
-                    std::stringstream buffer;
-                    for (int k = 0; k < lodpacks.size(); k++)
-                    {
-                        if (lodpacks[k]->GetBuffer(meshInfos[j].Hash, buffer))
-                            break;
-                    }
-                    if (buffer.tellp() != std::streampos(0))
+                    std::string meshBuffStorage;
+                    std::span<const uint8_t> meshBuff = GetEntryView(wad, buffIdx, meshBuffStorage);
+                    Rig rig;
+
+                    Arena arena;
+                    vector<RawMeshContainer> meshes;
+                    for (int j = 0; j < meshInfos.size(); j++)
                     {
-                        meshes.push_back(containRawMesh(meshInfos[j], buffer, subname));
+                        char buf[10];
+                        snprintf(buf, sizeof(buf), "%04d", j);
+                        string subname = "submesh_" + string(buf) + "_" + std::to_string(meshInfos[j].LODlvl);
+                        if (meshInfos[j].LODlvl > 0)
+                            continue;
+                        std::span<const uint8_t> buffer = meshInfos[j].Hash == 0 ? meshBuff : lodpacks.GetView(meshInfos[j].Hash);
+                        if (!buffer.empty())
+                        {
+                            meshes.push_back(containRawMesh(arena, meshInfos[j], buffer, subname));
+                        }
                     }
-                }
-            }
-            std::filesystem::path outfile = outdir / (wad._FileEntries[i].name + "." + std::to_string(i) + ".glb");
-            WriteGLTF(outfile, meshes, rig);
+                    WriteGLB(outfile, meshes, rig, quantize);
+                    return true;
+                });
+            });
         }
     }
     return true;
 }
+bool ExportAllRigidMesh(WadFile& wad, LodpackIndex& lodpacks, const std::filesystem::path& outdir)
+{
+    ExportJobs jobs;
+    if (!PlanRigidMesh(wad, lodpacks, outdir, false, jobs))
+        return false;
+    return RunJobs(jobs);
+}
+// queues the jobs of one wad, the wad stays mapped until the last of them finished
+// and finished (if any) runs right after that
+void SubmitJobs(ThreadPool& pool, std::shared_ptr<WadFile> wad, ExportJobs jobs, const std::string& success, const std::string& failure,
+    std::function<bool()> finished = nullptr)
+{
+    struct JobState
+    {
+        std::atomic<size_t> remaining;
+        std::atomic<bool> failed{ false };
+        std::string success;
+        std::string failure;
+        std::function<bool()> finished;
+    };
+    if (jobs.empty())
+    {
+        if (finished && !finished())
+            Utils::Logger::Error(failure.c_str());
+        else
+            Utils::Logger::Success(success.c_str());
+        return;
+    }
+    auto state = std::make_shared<JobState>();
+    state->remaining = jobs.size();
+    state->success = success;
+    state->failure = failure;
+    state->finished = std::move(finished);
+    for (auto& job : jobs)
+    {
+        pool.Submit([wad, state, job = std::move(job)]()
+        {
+            bool result = false;
+            try
+            {
+                result = job();
+            }
+            catch (const std::exception& e)
+            {
+                Utils::Logger::Error((string("\n") + e.what()).c_str());
+            }
+            if (!result)
+                state->failed = true;
+            if (--state->remaining == 0)
+            {
+                if (state->finished && !state->finished())
+                    state->failed = true;
+                if (state->failed)
+                    Utils::Logger::Error(state->failure.c_str());
+                else
+                    Utils::Logger::Success(state->success.c_str());
+            }
+        });
+    }
+}
 
 void PrintHelp()
 {
@@ -469,6 +544,7 @@ void PrintHelp()
     cout << "  wad       Target a Wad file for export.\n";
     cout << "  texpack   Target a Texpack file for export.\n";
     cout << "  settings  Change tool settings.\n";
+    cout << "  bench     Run micro-benchmarks.\n";
     cout << "\nOptions:\n";
     cout << "  -h, --help  Show help and usage information.\n";
 }
@@ -500,6 +576,18 @@ std::vector<std::string> ParseListFile(const std::string& listfile)
     return result;
 }
 
+// thread count given to -j, false unless it is a whole number in 1..1024
+bool ParseJobCount(const char* arg, size_t& jobs)
+{
+    const char* end = arg + std::strlen(arg);
+    size_t value = 0;
+    auto [ptr, ec] = std::from_chars(arg, end, value);
+    if (ec != std::errc() || ptr != end || value < 1 || value > 1024)
+        return false;
+    jobs = value;
+    return true;
+}
+
 void ParseWad()
 {
     std::filesystem::recursive_directory_iterator dir("F:\\Game\\GodOfWar\\exec\\wad\\pc_le");
@@ -567,15 +655,9 @@ int main(int argc, char* argv[])
         return -1;
     }
 
-    CHAR charbuffer[260] = { 0 };
-    GetCurrentDirectoryA(sizeof(charbuffer), charbuffer);
-    std::filesystem::path configpath = std::filesystem::path(charbuffer) / "config.ini";
-
-    GetPrivateProfileStringA("Settings", "Gamedir", "", charbuffer, sizeof(charbuffer), configpath.string().c_str());
-    std::filesystem::path gamedir(charbuffer);
-
-    GetPrivateProfileStringA("Settings", "Outdir", "", charbuffer, sizeof(charbuffer), configpath.string().c_str());
-    std::filesystem::path outdir(charbuffer);
+    std::filesystem::path configpath = std::filesystem::current_path() / "config.ini";
+    std::filesystem::path gamedir(Utils::GetConfigString(configpath, "Settings", "Gamedir"));
+    std::filesystem::path outdir(Utils::GetConfigString(configpath, "Settings", "Outdir"));
 
     std::string command(argv[1]);
 
@@ -599,6 +681,14 @@ int main(int argc, char* argv[])
             cout << "  -m, --mesh               Export all meshes from .wad.\n";
             cout << "  -t, --texture            Export all textures from .wad.\n";
             cout << "  -d, --dds                Export Textures in DDS Format.\n";
+            cout << "  -q, --quantize           Export rigid meshes with 16 bit attributes (KHR_mesh_quantization).\n";
+            cout << "  -n, --native-fbx         Write skinned meshes with the built-in FBX writer instead of the FBX SDK.\n";
+            cout << "  -r, --rescan             Rebuild the game dir catalog, needed for packs added to its sub-directories.\n";
+            cout << "  -j, --jobs <count>       Number of export threads, 1 exports serially.\n";
+            cout << "  -s, --store              Write every unique mesh/texture once to <outpath>/store,\n";
+            cout << "                           wads get manifests referencing the store files.\n";
+            cout << "  -i, --incremental        Skip files whose source packs, entries and converter\n";
+            cout << "                           version didn't change since the last export to <outpath>.\n";
             cout << "  -h, --help               Show help and usage information.\n";
 
         };
@@ -614,7 +704,13 @@ int main(int argc, char* argv[])
         bool texture = false;
         bool extract = false;
         bool dds = false;
+        bool quantize = false;
+        bool nativeFbx = !FbxSdkAvailable;
         bool all = false;
+        bool rescan = false;
+        bool useStore = false;
+        bool incremental = false;
+        size_t jobs = std::thread::hardware_concurrency();
         for (int i = 2; i < argc; i++)
         {
             std::string op(argv[i]);
@@ -677,6 +773,14 @@ int main(int argc, char* argv[])
             {
                 dds = true;
             }
+            else if (op == "-q" || op == "--quantize")
+            {
+                quantize = true;
+            }
+            else if (op == "-n" || op == "--native-fbx")
+            {
+                nativeFbx = true;
+            }
             else if (op == "-t" || op == "--texture")
             {
                 texture = true;
@@ -685,6 +789,37 @@ int main(int argc, char* argv[])
             {
                 all = true;
             }
+            else if (op == "-r" || op == "--rescan")
+            {
+                rescan = true;
+            }
+            else if (op == "-s" || op == "--store")
+            {
+                useStore = true;
+            }
+            else if (op == "-i" || op == "--incremental")
+            {
+                incremental = true;
+            }
+            else if (op == "-j" || op == "--jobs")
+            {
+                if (argc > (i + 1))
+                {
+                    if (!ParseJobCount(argv[i + 1], jobs))
+                    {
+                        Utils::Logger::Error(("\nInvalid thread count for option -j: " + std::string(argv[i + 1])).c_str());
+                        LogHelp();
+                        return -1;
+                    }
+                    i++;
+                }
+                else
+                {
+                    Utils::Logger::Error("\nRequired argument missing for option: -j");
+                    LogHelp();
+                    return -1;
+                }
+            }
             else
             {
                 Utils::Logger::Error(("\nInvalid option or argument: " + op).c_str());
@@ -723,86 +858,111 @@ int main(int argc, char* argv[])
             return -1;
         }
 
+        // extracting a given wad doesn't need to know about the other packs, the
+        // catalog only checks the packs this export reads against the disk
+        vector<Catalog::PackType> packTypes;
+        if (mesh)
+            packTypes.push_back(Catalog::PackType::Lodpack);
+        if (texture)
+            packTypes.push_back(Catalog::PackType::Texpack);
+        if (all && wadlist.empty())
+            packTypes.push_back(Catalog::PackType::Wad);
+        vector<std::filesystem::path> wadpaths;
+        if (!wadlist.empty())
+            wadpaths.assign(wadlist.begin(), wadlist.end());
+        else if (!all)
+            wadpaths.push_back(path);
+        Catalog catalog;
+        if ((mesh || texture || all) && !catalog.Open(outdir / "gowtool.catalog", gamedir, packTypes, wadpaths, rescan))
+        {
+            Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any game files");
+            return -1;
+        }
+        LodpackIndex lodpacks;
+        TexpackIndex texpacks;
+        if (mesh)
+            catalog.FillLodpacks(lodpacks);
+        if (texture)
+            catalog.FillTexpacks(texpacks);
+
+        if (mesh && lodpacks.PackCount() < 1)
+        {
+            Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any .lodpack files, export failed");
+            return -1;
+        }
+        if (texture && texpacks.PackCount() < 1)
+        {
+            Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any .texpack files, export failed");
+            return -1;
+        }
+
+        std::unique_ptr<ExportStore> store;
+        if (useStore)
+            store = std::make_unique<ExportStore>(outdir / "store");
+        BuildManifest build;
+        if (incremental)
+            build.Open(outdir / "gowtool.build", outdir);
+        auto MakeContext = [&](const std::filesystem::path& wadpath)
+        {
+            ExportContext context;
+            context.store = store.get();
+            // a manifest is only needed when the assets go to the store
+            if (store)
+                context.manifest = std::make_shared<ExportManifest>();
+            if (incremental)
+            {
+                context.build = &build;
+                context.catalog = &catalog;
+                context.wadKey = catalog.GetFingerprint(wadpath);
+            }
+            return context;
+        };
+        auto WriteManifest = [](std::shared_ptr<ExportManifest> manifest, std::filesystem::path path) -> std::function<bool()>
+        {
+            if (!manifest)
+                return nullptr;
+            return [manifest, path]() { return manifest->Write(path); };
+        };
+
+        ThreadPool pool(jobs);
         auto ExtractWad = [&](const std::filesystem::path& wadpath)
         {
             auto outpath = outdir / wadpath.stem();
             std::filesystem::create_directory(outpath);
 
-            WadFile wad;
-            wad.Read(wadpath);
+            auto wad = std::make_shared<WadFile>();
+            if (!wad->Map(wadpath))
+            {
+                Utils::Logger::Error(("\nFailed to open: " + wadpath.string()).c_str());
+                return;
+            }
             if (extract)
             {
-                if (ExtractAllFiles(wad, outpath))
-                {
-                    Utils::Logger::Success(("\nSuccessfully extracted all files to: " + outpath.string()).c_str());
-                }
+                ExportJobs extractJobs;
+                if (PlanExtract(*wad, outpath, extractJobs, MakeContext(wadpath)))
+                    SubmitJobs(pool, wad, std::move(extractJobs), "\nSuccessfully extracted all files to: " + outpath.string(), "\nFiles extraction Failed.");
                 else
-                {
-                    Utils::Logger::Error("\nMeshes export Failed.");
-                }
+                    Utils::Logger::Error("\nFiles extraction Failed.");
             }
             if (mesh)
             {
-                std::filesystem::recursive_directory_iterator dir(gamedir);
-                std::vector<Lodpack*> lodpacks;
-                for (const std::filesystem::directory_entry& entry : dir)
-                {
-                    if (entry.path().extension().string() == ".lodpack")
-                    {
-                        Lodpack* pack = new Lodpack(entry.path().string());
-                        lodpacks.push_back(pack);
-                    }
-                }
-                if (lodpacks.size() < 1)
-                {
-                    Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any .lodpack files, export failed");
-                    return -1;
-                }
-
-                ParseAnime(wad);
-                //if (ExportAllSkinnedMesh(wad, lodpacks, outpath) && ExportAllRigidMesh(wad, lodpacks, outpath))
-                //{
-                //    Utils::Logger::Success(("\nSuccessfully exported all meshes to: " + outpath.string()).c_str());
-                //}
-                //else
-                //{
-                //    Utils::Logger::Error("\nMeshes export Failed.");
-                //}
-
-                for (auto& pack : lodpacks)
-                {
-                    delete pack;
-                }
+                ExportJobs meshJobs;
+                ExportContext context = MakeContext(wadpath);
+                if (PlanSkinnedMesh(*wad, lodpacks, outpath, nativeFbx, meshJobs, context) && PlanRigidMesh(*wad, lodpacks, outpath, quantize, meshJobs, context))
+                    SubmitJobs(pool, wad, std::move(meshJobs), "\nSuccessfully exported all meshes to: " + outpath.string(), "\nMeshes export Failed.",
+                        WriteManifest(context.manifest, outpath / "meshes.manifest"));
+                else
+                    Utils::Logger::Error("\nMeshes export Failed.");
             }
             if (texture)
             {
-                std::filesystem::recursive_directory_iterator dir(gamedir);
-                std::vector<Texpack*> texpacks;
-                for (const std::filesystem::directory_entry& entry : dir)
-                {
-                    if (entry.path().extension().string() == ".texpack")
-                    {
-                        Texpack* pack = new Texpack(entry.path().string());
-                        texpacks.push_back(pack);
-                    }
-                }
-                if (texpacks.size() < 1)
-                {
-                    Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any .texpack files, export failed");
-                    return -1;
-                }
-                if (ExportAllTextures(wad, texpacks, outpath, dds))
-                {
-                    Utils::Logger::Success(("\nSuccessfully exported all textures to: " + outpath.string()).c_str());
-                }
+                ExportJobs textureJobs;
+                ExportContext context = MakeContext(wadpath);
+                if (PlanTextures(*wad, texpacks, outpath, dds, textureJobs, context))
+                    SubmitJobs(pool, wad, std::move(textureJobs), "\nSuccessfully exported all textures to: " + outpath.string(), "\nTextures export Failed.",
+                        WriteManifest(context.manifest, outpath / "textures.manifest"));
                 else
-                {
                     Utils::Logger::Error("\nTextures export Failed.");
-                }
-                for (auto& pack : texpacks)
-                {
-                    delete pack;
-                }
             }
         };
 
@@ -814,26 +974,25 @@ int main(int argc, char* argv[])
                 if (path.extension().string() == ".wad")
                 {
                     cout << "process " << path << std::endl;
-                    ExtractWad(path);
+                    pool.Submit([&ExtractWad, path]() { ExtractWad(path); });
                 }
             }
         }
         else if (all)
         {
-            std::filesystem::recursive_directory_iterator dir(gamedir);
-            for (const std::filesystem::directory_entry& entry : dir)
+            for (const auto& wadpath : catalog.GetPacks(Catalog::PackType::Wad))
             {
-                if (entry.path().extension().string() == ".wad")
-                {
-                    cout << "process " << entry.path() << std::endl;
-                    ExtractWad(entry.path());
-                }
+                cout << "process " << wadpath << std::endl;
+                pool.Submit([&ExtractWad, wadpath]() { ExtractWad(wadpath); });
             }
         }
         else
         {
             ExtractWad(path);
         }
+        pool.Wait();
+        if (incremental && !build.Save())
+            Utils::Logger::Warning(("\nFailed to write build manifest: " + (outdir / "gowtool.build").string()).c_str());
 
         cout << "Finished!" << std::endl;
        
@@ -853,6 +1012,9 @@ int main(int argc, char* argv[])
             cout << "  -i, --import             Import textures and pack .texpack file.\n";
             cout << "  -p, --path <path>        path to .texpack file or path to directory containing dds/gnf files for import.\n";
             cout << "  -o, --outpath <outpath>  Output directory.\n";
+            cout << "  -c, --compress           Oodle compress imported textures. The game can't read such\n";
+            cout << "                           texpacks, only GOWTool can, needs the oodle dll.\n";
+            cout << "  -j, --jobs <count>       Number of import threads, 1 imports serially.\n";
         };
         if (argc < 3)
         {
@@ -865,6 +1027,8 @@ int main(int argc, char* argv[])
         bool imp = false;
         bool exp = false;
         bool dds = false;
+        bool compress = false;
+        size_t jobs = std::thread::hardware_concurrency();
         for (int i = 2; i < argc; i++)
         {
             std::string op(argv[i]);
@@ -914,6 +1078,29 @@ int main(int argc, char* argv[])
             {
                 dds = true;
             }
+            else if (op == "-c" || op == "--compress")
+            {
+                compress = true;
+            }
+            else if (op == "-j" || op == "--jobs")
+            {
+                if (argc > (i + 1))
+                {
+                    if (!ParseJobCount(argv[i + 1], jobs))
+                    {
+                        Utils::Logger::Error(("Invalid thread count for option -j: " + std::string(argv[i + 1])).c_str());
+                        LogHelp();
+                        return -1;
+                    }
+                    i++;
+                }
+                else
+                {
+                    Utils::Logger::Error("Required argument missing for option: -j");
+                    LogHelp();
+                    return -1;
+                }
+            }
             else
             {
                 Utils::Logger::Error(("Invalid option or argument: " + op).c_str());
@@ -987,7 +1174,7 @@ int main(int argc, char* argv[])
                 Utils::Logger::Error("\nspecified gamedir(including sub-directories) doesn't contain any .texpack files, import failed");
                 return -1;
             }
-            if (ImportAllGnf(path,texpacks))
+            if (ImportAllGnf(path, texpacks, compress, jobs))
             {
                 Utils::Logger::Success("\nSuccessfully Imported all and packed textures to .texpack ");
                 return 0;
@@ -1066,7 +1253,7 @@ int main(int argc, char* argv[])
             LogHelp();
             return -1;
         }
-        if (WritePrivateProfileStringA("Settings", "Gamedir", gamedir.string().c_str(), configpath.string().c_str()))
+        if (Utils::SetConfigString(configpath, "Settings", "Gamedir", gamedir.string().c_str()))
         {
             Utils::Logger::Success("\nGamedir Updated");
         }
@@ -1079,13 +1266,128 @@ int main(int argc, char* argv[])
                 return -1;
             }
 
-            if (WritePrivateProfileStringA("Settings", "Outdir", outdir.string().c_str(), configpath.string().c_str()))
+            if (Utils::SetConfigString(configpath, "Settings", "Outdir", outdir.string().c_str()))
             {
                 Utils::Logger::Success("\Outdir Updated");
                 return 0;
             }
         }
     }
+    else if (command == "bench")
+    {
+        auto LogHelp = []()
+        {
+            cout << "\nbench\n";
+            cout << "  Run micro-benchmarks.\n";
+            cout << "\nUsage:\n";
+            cout << "  GOWTool bench [options]\n";
+            cout << "\nOptions:\n";
+            cout << "  -s, --swizzle            GNF swizzle/unswizzle kernels.\n";
+            cout << "  -p, --path <path>        Mesh definition parsing, over all MG/smsh entries of a .wad file.\n";
+            cout << "  -g, --glb                GLB export of a synthetic skinned model.\n";
+            cout << "  -x, --fbx                FBX export of a synthetic skinned model, native writer against the FBX SDK.\n";
+            cout << "  -d, --decompress [path]  Oodle decompression, built-in decoder against oo2core, over the .cmp/.raw\n";
+            cout << "                           sample pairs in samples/oodle and in path, if given. Samples compressed\n";
+            cout << "                           with oo2core are added to path.\n";
+            cout << "  -n, --iterations <count> Iterations per benchmark.\n";
+            cout << "  -h, --help               Show help and usage information.\n";
+        };
+        if (argc < 3)
+        {
+            Utils::Logger::Error("\nNo option/arguments provided: ");
+            LogHelp();
+            return -1;
+        }
+        bool swizzle = false;
+        bool glb = false;
+        bool fbx = false;
+        std::filesystem::path wadpath;
+        bool decompress = false;
+        std::filesystem::path samplespath;
+        size_t iterations = 10;
+        for (int i = 2; i < argc; i++)
+        {
+            std::string op(argv[i]);
+            if (op == "-h" || op == "--help")
+            {
+                LogHelp();
+                return 0;
+            }
+            else if (op == "-s" || op == "--swizzle")
+            {
+                swizzle = true;
+            }
+            else if (op == "-g" || op == "--glb")
+            {
+                glb = true;
+            }
+            else if (op == "-x" || op == "--fbx")
+            {
+                fbx = true;
+            }
+            else if (op == "-p" || op == "--path")
+            {
+                if (argc > (i + 1))
+                {
+                    wadpath = std::filesystem::path(argv[i + 1]);
+                    i++;
+                }
+                else
+                {
+                    Utils::Logger::Error("\nRequired argument missing for option: -p");
+                    LogHelp();
+                    return -1;
+                }
+            }
+            else if (op == "-d" || op == "--decompress")
+            {
+                decompress = true;
+                if (argc > (i + 1) && argv[i + 1][0] != '-')
+                {
+                    samplespath = std::filesystem::path(argv[i + 1]);
+                    i++;
+                }
+            }
+            else if (op == "-n" || op == "--iterations")
+            {
+                if (argc > (i + 1))
+                {
+                    iterations = std::strtoul(argv[i + 1], nullptr, 10);
+                    i++;
+                }
+                else
+                {
+                    Utils::Logger::Error("\nRequired argument missing for option: -n");
+                    LogHelp();
+                    return -1;
+                }
+            }
+            else
+            {
+                Utils::Logger::Error(("\nInvalid option or argument: " + op).c_str());
+                LogHelp();
+                return -1;
+            }
+        }
+        if (!swizzle && !glb && !fbx && wadpath.empty() && !decompress)
+        {
+            Utils::Logger::Error("\nNo benchmark specified");
+            LogHelp();
+            return -1;
+        }
+        bool result = true;
+        if (swizzle)
+            result &= Bench::GnfSwizzle(iterations);
+        if (!wadpath.empty())
+            result &= Bench::MeshDefinitions(wadpath, iterations);
+        if (glb)
+            result &= Bench::GlbExport(iterations);
+        if (fbx)
+            result &= Bench::FbxExport(iterations);
+        if (decompress)
+            result &= Bench::Decompression(samplespath, iterations);
+        return result ? 0 : -1;
+    }
     else
     {
         Utils::Logger::Error(("Invalid command or argument: " + command).c_str());
@@ -0,0 +1,43 @@
+# Generates SchemaJson.h for the glTF SDK, what GenerateSchemaJsonHeader.ps1 does
+# for the Visual Studio build, without needing PowerShell.
+#   cmake -DSCHEMA_DIR=<glTF-SDK/GLTFSDK/schema> -DOUTPUT=<SchemaJson.h> -P GLTFSchemaJson.cmake
+
+file(GLOB schemas RELATIVE "${SCHEMA_DIR}" "${SCHEMA_DIR}/*.json")
+list(SORT schemas)
+
+set(declarations "")
+set(definitions "")
+set(entries "")
+foreach(schema IN LISTS schemas)
+    string(REPLACE "." "_" name "${schema}")
+    file(READ "${SCHEMA_DIR}/${schema}" content)
+    string(APPEND declarations "    static const char* const ${name};\n")
+    string(APPEND definitions "const char* const SchemaJson::${name} = R\"rawstring(\n${content})rawstring\";\n")
+    string(APPEND entries "    { \"${schema}\", SchemaJson::${name} },\n")
+endforeach()
+
+file(WRITE "${OUTPUT}.tmp"
+"// Generated by GLTFSchemaJson.cmake, don't edit.
+#pragma once
+#include <string>
+#include <unordered_map>
+
+namespace Microsoft
+{
+namespace glTF
+{
+class SchemaJson
+{
+public:
+${declarations}    static const std::unordered_map<std::string, std::string> GLTF_SCHEMA_MAP;
+};
+
+${definitions}
+const std::unordered_map<std::string, std::string> SchemaJson::GLTF_SCHEMA_MAP =
+{
+${entries}};
+}
+}
+")
+execute_process(COMMAND "${CMAKE_COMMAND}" -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
@@ -0,0 +1,45 @@
+#pragma once
+#include "pch.h"
+#include <cstring>
+#include <type_traits>
+
+// Bump allocator for the buffers of one export. Allocations are never freed on
+// their own, everything goes away at once when the arena is reset or destroyed.
+// Only trivially destructible types may be placed in it, and an arena must not
+// be shared between threads.
+class Arena
+{
+	struct Block
+	{
+		std::unique_ptr<uint8_t[]> data;
+		size_t size;
+	};
+	vector<Block> _blocks;
+	size_t _used{ 0 };
+	size_t _blockSize;
+
+	void* AllocateBytes(size_t size, size_t align);
+public:
+	explicit Arena(size_t blockSize = 1 << 20) : _blockSize(blockSize) {}
+	Arena(const Arena&) = delete;
+	Arena& operator=(const Arena&) = delete;
+	Arena(Arena&&) noexcept = default;
+	Arena& operator=(Arena&&) noexcept = default;
+
+	// count zero-initialized elements, nullptr for a count of 0
+	template<typename T>
+	T* Allocate(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+		if (count == 0)
+			return nullptr;
+		if (count > SIZE_MAX / sizeof(T))
+			throw std::bad_alloc();
+		void* ptr = AllocateBytes(count * sizeof(T), alignof(T));
+		memset(ptr, 0, count * sizeof(T));
+		return static_cast<T*>(ptr);
+	}
+	// releases everything but the first block
+	void Reset();
+	size_t Capacity() const;
+};
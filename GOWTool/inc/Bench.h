@@ -0,0 +1,20 @@
+#pragma once
+#include "pch.h"
+
+// Micro-benchmarks for the hot paths of the exporters, run through the bench command.
+// Every benchmark checks its results against a reference before reporting timings.
+namespace Bench
+{
+	// table driven GNF swizzle kernels against the original per-element implementation
+	bool GnfSwizzle(size_t iterations);
+	// span based mesh definition parsers against the stringstream ones, over every MG/smsh entry of a wad
+	bool MeshDefinitions(const std::filesystem::path& wadpath, size_t iterations);
+	// GLB written straight from the mesh arrays against the glTF SDK writer, on a synthetic skinned model
+	bool GlbExport(size_t iterations);
+	// FBX written by FbxSceneWriter against the FBX SDK writer, both read back through the SDK importer
+	bool FbxExport(size_t iterations);
+	// in-tree Oodle decoder against the oo2core library, over the checked-in .cmp/.raw pairs of
+	// samples/oodle, those of an optional directory and, with the library, synthetic samples it
+	// compresses and stores there. Fails if any output isn't the .raw byte for byte
+	bool Decompression(const std::filesystem::path& samples, size_t iterations);
+}
\ No newline at end of file
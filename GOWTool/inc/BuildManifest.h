@@ -0,0 +1,71 @@
+#pragma once
+#include "pch.h"
+#include <mutex>
+#include <unordered_map>
+
+// Kinds of files an export writes, each with the version of the code producing it.
+enum class BuildOutput : uint32_t
+{
+	Extract,
+	Gnf,
+	Dds,
+	SkinnedMesh,
+	RigidMesh,
+	QuantizedRigidMesh,
+	NativeSkinnedMesh
+};
+// bump the version of an output whenever a change makes it write different bytes,
+// incremental exports then redo every file of that kind
+constexpr uint32_t BuildVersion(BuildOutput output)
+{
+	switch (output)
+	{
+	case BuildOutput::Extract: return 1;
+	case BuildOutput::Gnf: return 1;
+	case BuildOutput::Dds: return 1;
+	case BuildOutput::SkinnedMesh: return 1;
+	case BuildOutput::RigidMesh: return 2;
+	case BuildOutput::QuantizedRigidMesh: return 1;
+	case BuildOutput::NativeSkinnedMesh: return 1;
+	}
+	return 0;
+}
+
+// Persistent record of the inputs every exported file was built from, kept next
+// to the exported files. An output is up to date when the fingerprints of the
+// packs it was read from, the hash of its source entries and the tool version of
+// its kind all match the record and the file is still there with its old size.
+class BuildManifest
+{
+public:
+	struct Inputs
+	{
+		uint64_t packKey; // fingerprints of the source packs
+		uint64_t entryHash;
+		BuildOutput output;
+	};
+	// loads the manifest if there is one, outputs are stored relative to outdir
+	bool Open(const std::filesystem::path& manifestPath, const std::filesystem::path& outdir);
+	bool IsUpToDate(const std::filesystem::path& output, const Inputs& inputs) const;
+	// call once the output was written
+	void Record(const std::filesystem::path& output, const Inputs& inputs);
+	// call when writing the output failed, the file is redone on the next run
+	void Forget(const std::filesystem::path& output);
+	bool Save();
+private:
+	struct Entry
+	{
+		uint64_t packKey;
+		uint64_t entryHash;
+		uint64_t toolKey;
+		uint64_t size;
+	};
+	static uint64_t ToolKey(BuildOutput output);
+	string Key(const std::filesystem::path& output) const;
+
+	std::filesystem::path _path;
+	std::filesystem::path _outdir;
+	mutable std::mutex _mutex;
+	std::unordered_map<string, Entry> _records;
+	bool _dirty{ false };
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "pch.h"
+#include "MappedFile.h"
+#include "Lodpack.h"
+#include "Texpack.h"
+
+// On-disk catalog of every wad/lodpack/texpack under the game dir together with
+// the hashes their TOCs contain. It is written next to the exported files and
+// mapped on later runs, only the packs an export reads get their size/mtime checked.
+class Catalog
+{
+public:
+	enum class PackType : uint32_t
+	{
+		Wad = 0,
+		Lodpack = 1,
+		Texpack = 2
+	};
+	struct Entry
+	{
+		uint64_t hash;
+		uint64_t offset;
+		uint32_t size;
+		uint32_t group;
+	};
+
+	// loads the catalog and trusts it while the game dir's mtime matches the one it was written
+	// with, otherwise the dir is listed again and every pack checked. Packs of the given types and
+	// the given files are checked either way, changed ones are rescanned and the catalog is
+	// written back when anything changed. Packs added to sub-directories only show up after the
+	// game dir itself changed or with rescan, which throws the old catalog away.
+	bool Open(const std::filesystem::path& catalogPath, const std::filesystem::path& gamedir, std::span<const PackType> types,
+		std::span<const std::filesystem::path> files, bool rescan = false);
+	void FillLodpacks(LodpackIndex& index) const;
+	void FillTexpacks(TexpackIndex& index) const;
+	vector<std::filesystem::path> GetPacks(PackType type) const;
+	// size/mtime fingerprint of a pack, files outside of the catalog are fingerprinted on the spot
+	uint64_t GetFingerprint(const std::filesystem::path& filepath) const;
+	size_t PackCount() const { return _packs.size(); }
+private:
+	struct Pack
+	{
+		string path; // relative to gamedir
+		PackType type;
+		uint64_t fileSize;
+		int64_t mtime;
+		std::span<const Entry> entries;
+		vector<Entry> ownedEntries;
+	};
+	bool Load(const std::filesystem::path& catalogPath, const std::filesystem::path& gamedir);
+	bool Save(const std::filesystem::path& catalogPath) const;
+	bool Scan(Pack& pack) const;
+	// rescans the pack if its fingerprint changed, false if it is gone
+	bool Refresh(Pack& pack);
+	void Walk();
+
+	std::filesystem::path _gamedir;
+	int64_t _gamedirMtime{ 0 };
+	MappedFile _mapping;
+	vector<Pack> _packs;
+	bool _dirty{ false };
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "pch.h"
+#include <memory>
+#include <span>
+
+class ThreadPool;
+
+// Oodle decompression behind one interface, the in-tree decoder by default and the
+// oo2core library when it's present and asked for.
+namespace Oodle
+{
+	enum class Backend
+	{
+		Builtin,
+		Library
+	};
+
+	class Decompressor
+	{
+	public:
+		virtual ~Decompressor() = default;
+		virtual const char* Name() const = 0;
+		// decodes exactly dstSize bytes, dst needs SAFE_SPACE bytes past that for the
+		// library. The pool, if any, may split one stream over its threads.
+		virtual bool Decompress(const byte* src, size_t srcSize, byte* dst, size_t dstSize, ThreadPool* pool) const = 0;
+	};
+
+	// nullptr if the library can't be loaded
+	std::unique_ptr<Decompressor> Create(Backend backend);
+
+	struct Job
+	{
+		const byte* src;
+		size_t srcSize;
+		byte* dst;
+		size_t dstSize;
+		bool result;
+	};
+	// independent buffers spread over the pool, false if any of them failed
+	bool DecompressAll(const Decompressor& decompressor, std::span<Job> jobs, ThreadPool& pool);
+}
\ No newline at end of file
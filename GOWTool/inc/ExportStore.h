@@ -0,0 +1,44 @@
+#pragma once
+#include "pch.h"
+#include "HashIndex.h"
+#include <mutex>
+
+// Content addressed output shared by every wad of an export. Each asset is
+// written once as <root>/<kind dir>/<hash><extension>, the first job to claim a
+// hash writes the file and all others only reference it from their manifest.
+class ExportStore
+{
+public:
+	enum class Kind : uint32_t
+	{
+		SkinnedMesh,
+		RigidMesh,
+		Texture,
+		Count
+	};
+	explicit ExportStore(const std::filesystem::path& root);
+	ExportStore(const ExportStore&) = delete;
+	ExportStore& operator=(const ExportStore&) = delete;
+
+	// true for the first caller of a kind/hash pair, who then has to write the file
+	bool Claim(Kind kind, uint64_t hash);
+	std::filesystem::path GetPath(Kind kind, uint64_t hash, const std::string& extension) const;
+	const std::filesystem::path& Root() const { return _root; }
+private:
+	std::filesystem::path _root;
+	std::mutex _mutex;
+	HashIndex<bool> _claimed[size_t(Kind::Count)];
+};
+
+// Per wad list of the store files its entries were exported to, filled by the
+// export jobs in any order and written sorted by entry name.
+class ExportManifest
+{
+public:
+	void Add(const std::string& name, const std::filesystem::path& file);
+	// paths are stored relative to the directory of the manifest
+	bool Write(const std::filesystem::path& path);
+private:
+	std::mutex _mutex;
+	vector<std::pair<std::string, std::filesystem::path>> _entries;
+};
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+#include "pch.h"
+#include "Mesh.h"
+#include "Rig.h"
+// writes the scene FbxSdkManager::writeFbx builds (a skeleton of the rig's bones, one model per mesh skinned by
+// a cluster per bone it uses) with FbxSceneWriter, attribute arrays go from the mesh to the file in bulk
+// and no FBX SDK is needed
+void WriteFbxNative(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature);
\ No newline at end of file
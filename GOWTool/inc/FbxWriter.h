@@ -0,0 +1,205 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// Binary FBX 7.4 records written straight to a stream. Records go out as they are
+// built and their end offsets are patched in once they are closed, so geometry is
+// written as whole arrays without an FbxScene in between. GowReplay builds this
+// file too, keep it to the standard library.
+class FbxBinaryStream
+{
+public:
+	explicit FbxBinaryStream(std::ostream& os);
+	FbxBinaryStream(const FbxBinaryStream&) = delete;
+	FbxBinaryStream& operator=(const FbxBinaryStream&) = delete;
+
+	// the properties of a record have to be added before its first child
+	void BeginNode(std::string_view name);
+	void EndNode();
+
+	void Bool(bool value);
+	void Int32(int32_t value);
+	void Int64(int64_t value);
+	void Double(double value);
+	void String(std::string_view value);
+	void Raw(const void* data, size_t size);
+	void Int32Array(const int32_t* values, size_t count);
+	void DoubleArray(const double* values, size_t count);
+	// array of count T produced in batches by fill(T* out, size_t first, size_t n), for
+	// sources that have to be converted on the way out
+	template<typename T, typename Fill>
+	void Array(size_t count, Fill&& fill);
+
+	// int32 property written as 0, its offset is passed to PatchInt32 once the value is known
+	size_t ReserveInt32();
+	void PatchInt32(size_t offset, int32_t value);
+
+	// closes the file with the empty top level record and the footer
+	void Finish();
+private:
+	struct Record
+	{
+		size_t headerOffset;
+		size_t propertiesOffset;
+		size_t propertiesEnd;
+		uint32_t propertyCount;
+		bool hasChildren;
+	};
+	static constexpr size_t FlushSize = 1 << 20;
+	// elements per converted batch, a multiple of 2 and 3 so batches hold whole vertices
+	static constexpr size_t BatchSize = 6 << 13;
+
+	void Property(char type);
+	void BeginArray(char type, size_t count, size_t elementSize);
+	void Write(const void* data, size_t size);
+	template<typename T>
+	void WriteValue(T value) { Write(&value, sizeof(value)); }
+	void Patch(size_t offset, const void* data, size_t size);
+	void Flush();
+	size_t Tell() const { return _flushed + _buffer.size(); }
+
+	std::ostream& _os;
+	std::vector<char> _buffer;
+	size_t _flushed{ 0 };
+	std::vector<Record> _records;
+};
+
+template<typename T, typename Fill>
+void FbxBinaryStream::Array(size_t count, Fill&& fill)
+{
+	static_assert(std::is_same_v<T, int32_t> || std::is_same_v<T, double>, "FBX arrays are written as int32 or double");
+	BeginArray(std::is_same_v<T, int32_t> ? 'i' : 'd', count, sizeof(T));
+	std::vector<T> batch(std::min(count, BatchSize));
+	for (size_t first = 0; first < count; first += batch.size())
+	{
+		size_t n = std::min(batch.size(), count - first);
+		fill(batch.data(), first, n);
+		Write(batch.data(), n * sizeof(T));
+	}
+}
+
+// FBX scene written in one pass: the fixed header sections, every object as it is
+// added, then the connections between them. Covers what the exporters need, meshes
+// with per vertex attributes, skeletons, skin clusters and phong materials with file
+// textures. Ids are handed out by the writer, 0 is the scene root.
+class FbxSceneWriter
+{
+public:
+	enum class ModelType
+	{
+		Mesh,
+		Root,
+		LimbNode
+	};
+	// local transform of a model, rotation in degrees applied in X, Y, Z order
+	struct Transform
+	{
+		double translation[3]{ 0, 0, 0 };
+		double rotation[3]{ 0, 0, 0 };
+		double scaling[3]{ 1, 1, 1 };
+	};
+	// float vertex attribute, vertex i starts at data + i * stride bytes
+	struct Attribute
+	{
+		const float* data{ nullptr };
+		size_t stride{ 0 };
+	};
+	struct UVSet
+	{
+		std::string name;
+		Attribute uv;
+	};
+	// control points with per vertex attributes and a triangle list
+	struct Geometry
+	{
+		size_t vertexCount{ 0 };
+		Attribute positions;
+		Attribute normals;
+		Attribute tangents;
+		// one layer per set
+		std::vector<UVSet> uvSets;
+		const void* indices{ nullptr };
+		size_t indexCount{ 0 };
+		// 2 or 4
+		uint32_t indexSize{ 2 };
+		// maps every polygon to the first material of the models using the geometry
+		bool material{ false };
+	};
+	struct Material
+	{
+		double ambientFactor{ 1 };
+		double diffuseFactor{ 1 };
+		double specularFactor{ 0 };
+		double transparencyFactor{ 0 };
+	};
+	// control points bound to one bone, transforms are column major like glm
+	struct Cluster
+	{
+		int64_t bone{ 0 };
+		std::vector<int32_t> indexes;
+		std::vector<double> weights;
+		double transform[16]{};
+		double transformLink[16]{};
+	};
+
+	FbxSceneWriter(std::ostream& os, std::string_view creator);
+	FbxSceneWriter(const FbxSceneWriter&) = delete;
+	FbxSceneWriter& operator=(const FbxSceneWriter&) = delete;
+
+	int64_t AddGeometry(std::string_view name, const Geometry& geometry);
+	// skeleton models get their node attribute with them
+	int64_t AddModel(std::string_view name, ModelType type, const Transform& transform, int64_t parent = 0);
+	int64_t AddMaterial(std::string_view name, const Material& material);
+	int64_t AddTexture(std::string_view name, std::string_view filename, std::string_view uvSet);
+	// skin deformer of a geometry, clusters without control points are skipped
+	int64_t AddSkin(int64_t geometry, const std::vector<Cluster>& clusters);
+	// attaches an object to its owner: geometries and materials to models, textures to a
+	// material channel such as "DiffuseColor" given as property
+	void Connect(int64_t child, int64_t parent, std::string_view property = {});
+	// writes the connections and the footer, the writer can't be used afterwards
+	void Finish();
+private:
+	enum ObjectType
+	{
+		GlobalSettingsType,
+		ModelObject,
+		GeometryObject,
+		NodeAttributeObject,
+		MaterialObject,
+		TextureObject,
+		DeformerObject,
+		ObjectTypeCount
+	};
+	struct Connection
+	{
+		int64_t child;
+		int64_t parent;
+		std::string property;
+	};
+
+	void WriteHeader(std::string_view creator);
+	void WriteGlobalSettings();
+	void WriteDefinitions();
+	int64_t BeginObject(ObjectType type, std::string_view record, std::string_view name, std::string_view className, std::string_view subclass);
+	void WriteAttribute(std::string_view record, std::string_view arrayName, int32_t index, std::string_view name, const Attribute& attribute, size_t count, uint32_t components);
+	void WriteLayerElement(std::string_view type, int32_t index);
+	// Properties70 entries
+	void BeginProperty(std::string_view name, std::string_view type, std::string_view label, std::string_view flags);
+	void IntProperty(std::string_view name, std::string_view type, std::string_view label, int32_t value);
+	void NumberProperty(std::string_view name, std::string_view type, std::string_view label, std::string_view flags, double value);
+	void VectorProperty(std::string_view name, const double value[3]);
+	void StringProperty(std::string_view name, std::string_view value);
+
+	FbxBinaryStream _stream;
+	int64_t _nextId{ 1000000 };
+	uint32_t _counts[ObjectTypeCount]{};
+	size_t _countOffsets[ObjectTypeCount]{};
+	size_t _totalCountOffset{ 0 };
+	std::vector<Connection> _connections;
+	bool _finished{ false };
+};
\ No newline at end of file
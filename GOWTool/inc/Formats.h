@@ -1,16 +1,16 @@
 #pragma once
 #include "Mesh.h"
+#include <span>
 
+// Mesh definition parsers, they read the entry bytes as stored in the wad and
+// throw if the definition points outside of them.
 class MGDefinition
 {
-	uint16_t defCount;
-	uint32_t* defOffsets;
 public:
-	vector<MeshInfo> ReadMG(std::stringstream& file);
-	~MGDefinition();
+	vector<MeshInfo> ReadMG(std::span<const uint8_t> data);
 };
 class SmshDefinition
 {
 public:
-	vector<MeshInfo> ReadSmsh(std::iostream& file);
+	vector<MeshInfo> ReadSmsh(std::span<const uint8_t> data);
 };
\ No newline at end of file
@@ -89,6 +89,19 @@ namespace Gnf
         FormatTypeReserved_14 = 0xe,
         FormatTypeReserved_15 = 0xf
     };
+    // how a format is laid out in memory, everything the swizzle kernels and the converter need
+    struct FormatInfo
+    {
+        uint16_t bpp{ 0 };      // bits per pixel
+        uint16_t pixbl{ 1 };    // width/height of a block in pixels, 1 for uncompressed formats
+        uint16_t minPitch{ 0 }; // mips are padded to at least this many pixels in both dimensions
+        uint8_t channels{ 0 };
+
+        constexpr uint32_t ElementSize() const { return uint32_t(bpp) * pixbl * pixbl / 8; }
+    };
+    // nullptr for formats with no known layout
+    const FormatInfo* GetFormatInfo(Format format);
+
     struct alignas(0x100) Header
     {
         uint32_t gnfMagic{ 0x20464E47U };
@@ -138,7 +151,13 @@ namespace Gnf
         Header header;
         std::shared_ptr<byte[]> imageData;
         GnfImage();
+        // size in bytes of one swizzled element, a compressed block or an uncompressed pixel
+        static uint32_t ElementSize(const uint16_t& bpp, const uint16_t& pixbl);
+        // tiles are walked through precomputed morton tables with a kernel per element size,
+        // dst has to hold w * h * bpp / 8 bytes
         static void UnSwizzle(const byte* src, byte* dest, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl);
+        // only writes the top left dstW x dstH pixels, rows in dst are dstW pixels wide
+        static void UnSwizzle(const byte* src, byte* dest, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl, const uint16_t& dstW, const uint16_t& dstH);
         static void Swizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl);
         static int morton(int t, int sx, int sy);
         void ReadImage(const byte* file);
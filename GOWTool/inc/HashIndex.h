@@ -0,0 +1,87 @@
+#pragma once
+#include "pch.h"
+
+// Open-addressing table keyed by the 64-bit asset hashes used throughout the
+// game files. Hash 0 is reserved as the empty slot marker, the first insert of
+// a key wins so lookups keep the "first pack found" behaviour of the old scans.
+template<typename T>
+class HashIndex
+{
+	struct Slot
+	{
+		uint64_t key;
+		T value;
+	};
+	vector<Slot> _slots;
+	size_t _count{ 0 };
+
+	static uint64_t Mix(uint64_t key)
+	{
+		key ^= key >> 30;
+		key *= 0xBF58476D1CE4E5B9ull;
+		key ^= key >> 27;
+		key *= 0x94D049BB133111EBull;
+		key ^= key >> 31;
+		return key;
+	}
+	void Rehash(size_t capacity)
+	{
+		vector<Slot> old = std::move(_slots);
+		_slots.assign(capacity, Slot{ 0, T{} });
+		_count = 0;
+		for (const Slot& slot : old)
+		{
+			if (slot.key != 0)
+				Insert(slot.key, slot.value);
+		}
+	}
+public:
+	void Reserve(size_t count)
+	{
+		size_t capacity = 16;
+		while (capacity < count + count / 2)
+			capacity <<= 1;
+		if (capacity > _slots.size())
+			Rehash(capacity);
+	}
+	bool Insert(uint64_t key, const T& value)
+	{
+		if (key == 0)
+			return false;
+		if ((_count + 1) * 3 > _slots.size() * 2)
+			Rehash(_slots.empty() ? 16 : _slots.size() * 2);
+
+		size_t mask = _slots.size() - 1;
+		for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+		{
+			if (_slots[i].key == key)
+				return false;
+			if (_slots[i].key == 0)
+			{
+				_slots[i] = Slot{ key, value };
+				_count++;
+				return true;
+			}
+		}
+	}
+	const T* Find(uint64_t key) const
+	{
+		if (key == 0 || _slots.empty())
+			return nullptr;
+
+		size_t mask = _slots.size() - 1;
+		for (size_t i = Mix(key) & mask;; i = (i + 1) & mask)
+		{
+			if (_slots[i].key == key)
+				return &_slots[i].value;
+			if (_slots[i].key == 0)
+				return nullptr;
+		}
+	}
+	void Clear()
+	{
+		_slots.clear();
+		_count = 0;
+	}
+	size_t Size() const { return _count; }
+};
\ No newline at end of file
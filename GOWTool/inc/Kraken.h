@@ -0,0 +1,16 @@
+#pragma once
+#include "pch.h"
+
+class ThreadPool;
+
+// In-tree decoder for Oodle streams made of 256KB blocks coded with Kraken, Mermaid
+// or Selkie (which shares the Mermaid block format). Leviathan, LZNA and BitKnit
+// blocks are rejected. Neither buffer needs any padding.
+namespace Kraken
+{
+	// decodes exactly dstSize bytes, false if the stream is corrupt, shorter or longer
+	// than that or uses an unsupported codec. With a pool, runs of blocks starting at a
+	// decoder reset (seek chunks) are decoded in parallel; don't call this from a task
+	// of that pool, ThreadPool::Wait would wait on the caller itself.
+	bool Decompress(const byte* src, size_t srcSize, byte* dst, size_t dstSize, ThreadPool* pool = nullptr);
+}
\ No newline at end of file
@@ -1,8 +1,16 @@
 #pragma once
 #include "pch.h"
+#include "HashIndex.h"
+#include "MappedFile.h"
+#include <mutex>
+#include <sstream>
 
 class Lodpack
 {
+	friend class Catalog;
+	friend class LodpackIndex;
+
+	string _filename;
 	uint32_t groupCount;
 	uint32_t* groupStartOff;
 	uint64_t* groupHash;
@@ -19,4 +27,40 @@ public:
 	Lodpack(string filename);
 	~Lodpack();
 	bool GetBuffer(uint64_t& Hash, std::stringstream& outstream);
+};
+
+// Member lookup shared by every lodpack in the game dir, the packs themselves
+// are only mapped the first time one of their members is requested.
+class LodpackIndex
+{
+public:
+	struct Member
+	{
+		uint32_t packIdx;
+		uint32_t group;
+		uint64_t offset;
+		uint32_t size;
+	};
+	// registers the pack file and returns its id, members are added with AddMember
+	uint32_t AddPack(const std::filesystem::path& filepath);
+	void AddMember(uint64_t hash, const Member& member);
+	// registers the pack and all of its members
+	uint32_t Add(const Lodpack& pack);
+	void Reserve(size_t count) { _members.Reserve(count); }
+
+	bool Find(uint64_t hash, Member& outMember) const;
+	std::span<const uint8_t> GetView(uint64_t hash);
+	bool GetBuffer(uint64_t hash, std::stringstream& outstream);
+	size_t PackCount() const { return _packs.size(); }
+	size_t MemberCount() const { return _members.Size(); }
+	const std::filesystem::path& GetPackPath(uint32_t packIdx) const { return _packs[packIdx]->path; }
+private:
+	struct Pack
+	{
+		std::filesystem::path path;
+		MappedFile mapping;
+		std::once_flag mapped;
+	};
+	vector<std::unique_ptr<Pack>> _packs;
+	HashIndex<Member> _members;
 };
\ No newline at end of file
@@ -2,4 +2,6 @@
 #include "pch.h"
 #include "Mesh.h"
 #include "Formats.h"
-RawMeshContainer containRawMesh(MeshInfo& meshinfo, std::stringstream& file,std::string name, uint64_t off = 0);
\ No newline at end of file
+#include <span>
+// the mesh arrays are allocated from arena
+RawMeshContainer containRawMesh(Arena& arena, MeshInfo& meshinfo, std::span<const uint8_t> buffer, std::string name, uint64_t off = 0);
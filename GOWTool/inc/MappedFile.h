@@ -0,0 +1,37 @@
+#pragma once
+#include "pch.h"
+#include <span>
+
+// View of a whole file mapped into memory, views handed out from it stay
+// valid for as long as the MappedFile is alive. Files are mapped read-only
+// by Open, Create makes a new file of a fixed size that is mapped writable.
+class MappedFile
+{
+	uint8_t* _data{ nullptr };
+	size_t _size{ 0 };
+	bool _open{ false };
+	bool _writable{ false };
+#ifdef _WIN32
+	void* _file{ nullptr };
+	void* _mapping{ nullptr };
+#endif
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+	~MappedFile();
+
+	bool Open(const std::filesystem::path& filepath);
+	// creates (or truncates) the file with the given size, its contents are written through MutableData
+	bool Create(const std::filesystem::path& filepath, size_t size);
+	void Close();
+	bool IsOpen() const { return _open; }
+	const uint8_t* Data() const { return _data; }
+	// nullptr unless the file was created with Create
+	uint8_t* MutableData() { return _writable ? _data : nullptr; }
+	size_t Size() const { return _size; }
+	// returns an empty span if the range is not fully inside the file
+	std::span<const uint8_t> GetView(uint64_t offset, uint64_t size) const;
+};
\ No newline at end of file
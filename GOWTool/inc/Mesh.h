@@ -1,22 +1,11 @@
 #pragma once
 
 #include "MathFunctions.h"
+#include "Arena.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
 
-struct RawMeshContainer
-{
-	uint32_t VertCount{ 0 }, IndCount{ 0 };
-	Vec3* vertices{ nullptr };
-	Vec3* normals{ nullptr };
-	Vec4* tangents{ nullptr };
-	Vec2* txcoord0{ nullptr };
-	Vec2* txcoord1{ nullptr };
-	Vec2* txcoord2{ nullptr };
-	uint16_t* indices{ nullptr };
-	uint16_t** joints{ nullptr };
-	float** weights{ nullptr };
-	std::string name;
-	RawMeshContainer() = default;
-};
 enum class PrimitiveTypes
 {
 	POSITION,
@@ -48,6 +37,54 @@ enum class DataTypes
 	HALFWORD_STRUCT_2,  //USHORT half normalized or compliment bs maybe
 	BYTE_STRUCT_0		//UBYTE_UNORM
 };
+// Decoded mesh, one array per attribute. The arrays live in the Arena the mesh
+// was decoded into and are released together with it, so a mesh must not
+// outlive its arena. Attributes missing from the source are nullptr.
+struct RawMeshContainer
+{
+	uint32_t VertCount{ 0 }, IndCount{ 0 };
+	Vec3* vertices{ nullptr };
+	Vec3* normals{ nullptr };
+	Vec4* tangents{ nullptr };
+	Vec2* txcoord0{ nullptr };
+	Vec2* txcoord1{ nullptr };
+	Vec2* txcoord2{ nullptr };
+	uint16_t* indices{ nullptr };
+	// four per vertex, vertex v uses joints[v * 4] to joints[v * 4 + 3]
+	uint16_t* joints{ nullptr };
+	float* weights{ nullptr };
+	std::string name;
+	// encodings the attributes were decoded from, so writers can quantize them again without
+	// loss. UNSIGNED_SHORT positions are q / 65535 * positionScale + positionMin
+	DataTypes positionType{ DataTypes::FLOAT };
+	Vec3 positionScale{ };
+	Vec3 positionMin{ };
+	DataTypes txcoordTypes[3]{ DataTypes::FLOAT, DataTypes::FLOAT, DataTypes::FLOAT };
+	RawMeshContainer() = default;
+	RawMeshContainer(const RawMeshContainer&) = delete;
+	RawMeshContainer& operator=(const RawMeshContainer&) = delete;
+	RawMeshContainer(RawMeshContainer&& other) noexcept { *this = std::move(other); }
+	RawMeshContainer& operator=(RawMeshContainer&& other) noexcept
+	{
+		VertCount = std::exchange(other.VertCount, 0);
+		IndCount = std::exchange(other.IndCount, 0);
+		vertices = std::exchange(other.vertices, nullptr);
+		normals = std::exchange(other.normals, nullptr);
+		tangents = std::exchange(other.tangents, nullptr);
+		txcoord0 = std::exchange(other.txcoord0, nullptr);
+		txcoord1 = std::exchange(other.txcoord1, nullptr);
+		txcoord2 = std::exchange(other.txcoord2, nullptr);
+		indices = std::exchange(other.indices, nullptr);
+		joints = std::exchange(other.joints, nullptr);
+		weights = std::exchange(other.weights, nullptr);
+		name = std::move(other.name);
+		positionType = other.positionType;
+		positionScale = other.positionScale;
+		positionMin = other.positionMin;
+		std::copy(std::begin(other.txcoordTypes), std::end(other.txcoordTypes), txcoordTypes);
+		return *this;
+	}
+};
 struct Component
 {
 	PrimitiveTypes primitiveType;
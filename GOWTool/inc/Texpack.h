@@ -1,9 +1,16 @@
 #pragma once
 
 #include "pch.h"
+#include "HashIndex.h"
+#include "Gnf.h"
+#include <functional>
+#include <mutex>
 
 class Texpack
 {
+	friend class Catalog;
+	friend class TexpackIndex;
+
 	uint32_t _texSectionOff {0};
 	uint32_t _blocksCount{ 0 };
 	uint32_t _blocksInfoOff{ 0 };
@@ -28,12 +35,28 @@ public:
 		uint16_t _mipHeight;
 		uint64_t _nextSiblingBlockInfoOff;
 	};
+
+	// how the data of a block is stored, the field after its raw size. The game's packs
+	// only use Stored, Oodle blocks are written by TexpackWriter's compressed mode and
+	// hold their packed size in the field before the mip counts, 0 for stored ones.
+	enum class BlockEncoding : uint32_t
+	{
+		Oodle = 1,
+		Stored = 2
+	};
 private:
 	TexInfo* _texInfos{ nullptr };
 	BlockInfo* _blockInfos{ nullptr };
 
 	uint64_t* _blockInfoOffsets{ nullptr };
+	HashIndex<uint32_t> _texIndex; // fileHash -> _texInfos
+	HashIndex<uint32_t> _blockIndex; // block info offset -> _blockInfos
+	vector<vector<uint32_t>> _mipChains; // resolved block chain per texture, first mip first
 	ifstream fs;
+	std::mutex _fsMutex;
+
+	const TexInfo* FindTexture(const uint64_t& hash) const;
+	const vector<uint32_t>& GetMipChain(uint32_t texIdx);
 public:
 	Texpack(const std::filesystem::path &filepath);
 	bool ContainsTexture(const uint64_t &hash);
@@ -42,4 +65,72 @@ public:
 	bool ExportAllGnf(const std::filesystem::path& dir,bool dds = false);
 	bool GetUserHash(const uint64_t& hash, uint64_t& outUserHash);
 	~Texpack();
+};
+
+// Texture lookup shared by every texpack in the game dir, a Texpack is only
+// constructed (and its TOC read) the first time one of its textures is requested.
+class TexpackIndex
+{
+public:
+	// registers the pack file and returns its id, textures are added with AddTexture
+	uint32_t AddPack(const std::filesystem::path& filepath);
+	void AddTexture(uint64_t hash, uint32_t packIdx);
+	// registers an already opened pack and all of its textures
+	uint32_t Add(const std::filesystem::path& filepath, std::unique_ptr<Texpack> pack);
+	void Reserve(size_t count) { _textures.Reserve(count); }
+
+	Texpack* Find(uint64_t hash);
+	// file of the pack holding the texture, nullptr if there is none
+	const std::filesystem::path* FindPackPath(uint64_t hash) const;
+	size_t PackCount() const { return _packs.size(); }
+	size_t TextureCount() const { return _textures.Size(); }
+private:
+	struct Pack
+	{
+		std::filesystem::path path;
+		std::unique_ptr<Texpack> texpack;
+		std::once_flag opened;
+	};
+	vector<std::unique_ptr<Pack>> _packs;
+	HashIndex<uint32_t> _textures;
+};
+
+class ThreadPool;
+
+// Writes a new .texpack and its .toc, loading one image at a time. By default every
+// texture is one stored block, the layout the game reads. The compressed mode is
+// GOWTool's own and only readable by Texpack: mips of at least SplitSize bytes get a
+// block each, the smaller ones share the last block and block data is Oodle compressed.
+class TexpackWriter
+{
+public:
+	struct Texture
+	{
+		uint64_t hash;
+		Gnf::Header header;
+		// image data of header.dataSize bytes, nullptr if it can't be loaded
+		std::function<std::shared_ptr<byte[]>()> load;
+	};
+	static constexpr size_t SplitSize = 0x10000;
+
+	// compression needs oo2core, without it the default layout is written
+	explicit TexpackWriter(bool compress = false);
+	void Add(Texture texture) { _textures.push_back(std::move(texture)); }
+	size_t TextureCount() const { return _textures.size(); }
+	bool Compressed() const { return _compress; }
+	// blocks of a texture are compressed on the pool, if any. Existing files are only
+	// replaced once both were written completely
+	bool Write(const std::filesystem::path& texpackPath, const std::filesystem::path& tocPath, ThreadPool* pool = nullptr);
+private:
+	struct Block
+	{
+		uint32_t firstMip;
+		uint32_t lastMip;
+		size_t offset; // in the image data
+		size_t size;
+	};
+	vector<Block> PlanBlocks(const Gnf::Header& header) const;
+
+	vector<Texture> _textures;
+	bool _compress;
 };
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+#include "pch.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Work-stealing pool, every worker owns a deque: tasks submitted from a worker go
+// to its own deque and are popped LIFO, idle workers steal FIFO from the others.
+// With a single thread tasks run inline on Submit, which keeps the serial order.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+	~ThreadPool();
+
+	void Submit(std::function<void()> task);
+	// blocks until every submitted task finished, the calling thread helps out meanwhile
+	void Wait();
+	size_t ThreadCount() const { return _workers.empty() ? 1 : _workers.size(); }
+private:
+	struct Worker
+	{
+		std::deque<std::function<void()>> tasks;
+		std::mutex mutex;
+	};
+	bool TryRun(size_t self);
+	void Run(std::function<void()>& task);
+	void WorkerLoop(size_t self);
+
+	vector<std::unique_ptr<Worker>> _workers;
+	vector<std::thread> _threads;
+	std::atomic<size_t> _queued{ 0 };
+	std::atomic<size_t> _pending{ 0 };
+	std::atomic<size_t> _next{ 0 };
+	std::mutex _waitMutex;
+	std::condition_variable _wake;
+	bool _stop{ false };
+};
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+#include "pch.h"
+#include "Mesh.h"
+#include <span>
+
+// One attribute stream of a vertex buffer, vertex v starts at data[offset + v * stride].
+struct VertexStream
+{
+	std::span<const uint8_t> data;
+	uint64_t offset{ 0 };
+	uint32_t stride{ 0 };
+	uint32_t count{ 0 };
+};
+
+// Decoders for the vertex attribute encodings found in mesh buffers. Each call
+// processes a whole stream in one pass, vertices that would be read from outside
+// of data are left untouched.
+namespace VertexDecoder
+{
+	VertexStream GetStream(const MeshInfo& meshinfo, const Component& component, std::span<const uint8_t> data, uint64_t off = 0);
+	// number of leading vertices whose elementSize bytes lie inside the stream's data
+	uint32_t Available(const VertexStream& stream, uint32_t elementSize);
+
+	// UNSIGNED_SHORT positions are dequantized with meshScale/meshMin, anything else is read as float
+	void DecodePositions(const VertexStream& stream, DataTypes type, const Vec3& scale, const Vec3& min, Vec3* out);
+	// 10-10-10-2 signed, normalized
+	void DecodeNormals(const VertexStream& stream, Vec3* out);
+	void DecodeTangents(const VertexStream& stream, Vec4* out);
+	void DecodeTexcoords(const VertexStream& stream, DataTypes type, Vec2* out);
+	// four joints per vertex
+	void DecodeJoints(const VertexStream& stream, DataTypes type, uint16_t* out);
+	// four weights per vertex, 10-10-10 unsigned renormalized to sum up to 1
+	void DecodeWeights(const VertexStream& stream, float* out);
+	uint32_t DecodeIndices(std::span<const uint8_t> data, uint64_t offset, uint32_t count, uint16_t* out);
+}
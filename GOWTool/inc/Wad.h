@@ -1,4 +1,6 @@
 #pragma once
+#include "MappedFile.h"
+#include <unordered_map>
 
 struct WadFile
 {
@@ -24,7 +26,27 @@ struct WadFile
 	};
 	vector<FileDesc> _FileEntries;
 	bool Read(const std::filesystem::path& filepath);
+	// maps the whole wad instead of streaming it, entries can then be accessed with GetView
+	bool Map(const std::filesystem::path& filepath);
+	bool IsMapped() const { return _mapping.IsOpen(); }
 	bool GetBuffer(const uint32_t& entryIdx, std::iostream& outstream);
+	// zero-copy view of an entry, empty if the wad isn't mapped
+	std::span<const uint8_t> GetView(const uint32_t& entryIdx) const;
+	bool FindEntry(const std::string& name, uint32_t& outIdx, FileType type = FileType::None) const;
+	const vector<uint32_t>& GetEntries(FileType type) const;
+	// SkinnedMeshBuff entry holding the data of a SkinnedMeshDef or smsh_data entry, -1 if there is none
+	int GetMeshBuffer(uint32_t defIdx) const;
+	// Proto rig of a SkinnedMeshDef entry, -1 if there is none
+	int GetRig(uint32_t defIdx) const;
 private:
+	void BuildIndex();
+	void BuildRelations();
+
 	ifstream fs;
+	MappedFile _mapping;
+	std::unordered_map<std::string, vector<uint32_t>> _nameIndex;
+	std::unordered_map<FileType, vector<uint32_t>> _typeIndex;
+	// per entry, -1 where there is no relation
+	vector<int> _meshBuffers;
+	vector<int> _rigs;
 };
\ No newline at end of file
@@ -1,5 +1,17 @@
 #pragma once
 #include "pch.h"
+#include "Gnf.h"
 
+// size of the dds ConvertGnfToDDS produces for the gnf, throws for unsupported formats
+size_t GetDDSSize(const byte* gnfsrc, const size_t& gnfsize);
+// converts into a caller provided buffer of at least GetDDSSize bytes, returns the bytes written
+size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte* ddsout, const size_t& ddssize);
+// converts straight into a memory mapped output file
+bool ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, const std::filesystem::path& ddspath);
 size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte*& ddsout);
-size_t ConvertDDSToGnf(const byte* ddssrc, const size_t& ddssize, byte*& gnfout);
\ No newline at end of file
+size_t ConvertDDSToGnf(const byte* ddssrc, const size_t& ddssize, byte*& gnfout);
+// gnf header ConvertDDSToGnf gives the dds, ddssize is the size of the whole file but
+// only the dds headers have to be in ddssrc
+Gnf::Header GetGnfHeader(const byte* ddssrc, const size_t& ddssize);
+// bytes every mip takes in the gnf image data, top mip first, empty for unknown formats
+vector<size_t> GetGnfMipSizes(const Gnf::Header& header);
\ No newline at end of file
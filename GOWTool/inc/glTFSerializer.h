@@ -2,4 +2,8 @@
 #include "pch.h"
 #include "Mesh.h"
 #include "Rig.h"
-void WriteGLTF(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature);
\ No newline at end of file
+// writes a .gltf (plus external .bin) or .glb through the glTF SDK's BufferBuilder
+void WriteGLTF(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature);
+// writes a .glb container directly, attribute data goes from the mesh arrays to the file without intermediate copies.
+// quantize stores the attributes as 16 bit integers (KHR_mesh_quantization), keeping the encodings they had in the game files
+void WriteGLB(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature, bool quantize = false);
\ No newline at end of file
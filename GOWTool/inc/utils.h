@@ -1,14 +1,19 @@
 #pragma once
 #include "pch.h"
-#include <Windows.h>
+#include <algorithm>
+#include <cctype>
+#include <span>
 
+// platform specific bits live behind these, the rest of the tool stays portable
 namespace Utils
 {
 	class FileDialogs
 	{
 	public:
-		static std::string OpenFile(const char* filter = "All Files (*.*)\0*.*\0", const char* title = "Open", HWND owner = NULL);
+		// owner is the parent HWND, empty string if cancelled or there is no dialog on the platform
+		static std::string OpenFile(const char* filter = "All Files (*.*)\0*.*\0", const char* title = "Open", void* owner = nullptr);
 	};
+	// colored console output, serialized between threads
 	class Logger
 	{
 	public:
@@ -16,10 +21,45 @@ namespace Utils
 		static void Warning(const char* msg);
 		static void Success(const char* msg);
 	};
+	// value of key in an ini file section, fallback if the file or key is missing
+	std::string GetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* fallback = "");
+	// adds or replaces key in section, creating the file when needed
+	bool SetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* value);
+	// shared library loaded with LoadLibrary or dlopen, unloaded on destruction
+	class SharedLibrary
+	{
+		void* _handle{ nullptr };
+	public:
+		SharedLibrary() = default;
+		SharedLibrary(const SharedLibrary&) = delete;
+		SharedLibrary& operator=(const SharedLibrary&) = delete;
+		~SharedLibrary();
+
+		bool Open(const char* name);
+		bool IsOpen() const { return _handle != nullptr; }
+		// nullptr if the library is not open or has no such export
+		void* GetSymbol(const char* name) const;
+	};
 	std::string inline str_tolower(std::string s) {
 		std::transform(s.begin(), s.end(), s.begin(),
 			[](unsigned char c) { return std::tolower(c); }
 		);
 		return s;
 	}
+	// FNV-1a, for content keys of exported files
+	uint64_t inline HashBytes(std::span<const uint8_t> data) {
+		uint64_t hash = 0xCBF29CE484222325ull;
+		for (uint8_t b : data)
+		{
+			hash ^= b;
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+	uint64_t inline HashCombine(uint64_t seed, uint64_t value) {
+		value ^= value >> 33;
+		value *= 0xFF51AFD7ED558CCDull;
+		value ^= value >> 33;
+		return seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+	}
 }
\ No newline at end of file
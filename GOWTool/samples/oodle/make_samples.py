@@ -0,0 +1,782 @@
+#!/usr/bin/env python3
+# Writes the .cmp/.raw pairs `GOWTool bench -d` checks the built-in Kraken/Mermaid/Selkie
+# decoder against. The .raw data is generated here and the .cmp streams are produced by a
+# small independent encoder of the Oodle block, quantum, LZ and entropy layouts, so the
+# pairs don't depend on the decoder they test. Streams the real oo2core writes can be
+# added to the same directory with `GOWTool bench -d <dir>` where the library exists.
+#
+# Covered: Kraken (delta and raw literals, plain and scaled offsets, long lengths),
+# Mermaid/Selkie (16 bit and far offsets, long literal runs and matches, both 64KB halves),
+# stored, Huffman (old sparse and new Golomb-Rice code lengths, one and two stream groups)
+# and RLE byte streams, memset quanta, uncompressed blocks, checksum flags and decoder
+# resets that split a stream into independently decoded segments.
+# Not covered: tANS and multi-array streams, old dense Huffman code lengths.
+#
+# usage: make_samples.py [outdir]
+
+import heapq
+import os
+import struct
+import sys
+
+BLOCK = 0x40000
+CHUNK = 0x20000
+KRAKEN = 6
+MERMAID = 10
+
+
+class Rng:
+    # xorshift64, stable across python versions unlike random
+    def __init__(self, seed):
+        self.s = seed
+
+    def next(self):
+        x = self.s
+        x ^= (x << 13) & 0xFFFFFFFFFFFFFFFF
+        x ^= x >> 7
+        x ^= (x << 17) & 0xFFFFFFFFFFFFFFFF
+        self.s = x
+        return x
+
+    def below(self, n):
+        return self.next() % n
+
+
+# sample contents
+
+def make_words(rng):
+    syllables = ['ka', 'to', 'ra', 'mi', 'ne', 'gor', 'thu', 'val', 'sk', 'ir', 'os', 'en', 'la', 'dr', 'ma', 'ri', 'fen', 'ul']
+    return [''.join(syllables[rng.below(len(syllables))] for _ in range(1 + rng.below(3))) for _ in range(400)]
+
+
+def text(rng, words, size):
+    out = bytearray()
+    while len(out) < size:
+        sentence = ' '.join(words[min(rng.below(len(words)), rng.below(len(words)))] for _ in range(3 + rng.below(12)))
+        out += (sentence.capitalize() + '. ').encode()
+        if rng.below(6) == 0:
+            out += b'\n'
+    return bytes(out[:size])
+
+
+def records(rng, size):
+    # vertex-like records, neighbouring fields change slowly
+    out = bytearray()
+    x = y = z = 0.0
+    i = 0
+    while len(out) < size:
+        x += (rng.below(200) - 100) / 1000.0
+        y += (rng.below(50) - 25) / 1000.0
+        z += 0.01
+        out += struct.pack('<fffHHI', x, y, z, rng.below(64), i & 0xFFFF, 0xFF00FF00 | rng.below(4))
+        i += 1
+    return bytes(out[:size])
+
+
+def runs(rng, size):
+    out = bytearray()
+    while len(out) < size:
+        out += bytes([rng.below(256)]) * (1 + rng.below(300))
+        out += bytes(rng.below(256) for _ in range(rng.below(40)))
+    return bytes(out[:size])
+
+
+def noise(rng, size):
+    return bytes(rng.below(256) for _ in range(size))
+
+
+def repeats(rng, source, size, mutate):
+    # slices of source with a few bytes changed, gives long and far matches
+    out = bytearray()
+    while len(out) < size:
+        start = rng.below(len(source) - 4096)
+        out += source[start:start + 64 + rng.below(3000)]
+        for _ in range(mutate):
+            if out:
+                out[len(out) - 1 - rng.below(min(len(out), 64))] = rng.below(256)
+        out += bytes(rng.below(256) for _ in range(rng.below(120)))
+    return bytes(out[:size])
+
+
+# bit writers
+
+class MsbBits:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.n = 0
+
+    def put(self, value, count):
+        assert 0 <= value < (1 << count) or (count == 0 and value == 0)
+        self.acc = (self.acc << count) | value
+        self.n += count
+        while self.n >= 8:
+            self.n -= 8
+            self.out.append((self.acc >> self.n) & 0xFF)
+        self.acc &= (1 << self.n) - 1
+
+    def zeros(self, count):
+        while count > 16:
+            self.put(0, 16)
+            count -= 16
+        self.put(0, count)
+
+    def getvalue(self):
+        out = bytearray(self.out)
+        if self.n:
+            out.append((self.acc << (8 - self.n)) & 0xFF)
+        return bytes(out)
+
+
+class LsbBits:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.n = 0
+
+    def put(self, value, count):
+        self.acc |= value << self.n
+        self.n += count
+        while self.n >= 8:
+            self.out.append(self.acc & 0xFF)
+            self.acc >>= 8
+            self.n -= 8
+
+    def getvalue(self):
+        out = bytearray(self.out)
+        if self.n:
+            out.append(self.acc & 0xFF)
+        return bytes(out)
+
+
+# entropy coded byte streams
+
+def huffman_lengths(data, limit=11):
+    freq = [0] * 256
+    for b in data:
+        freq[b] += 1
+    heap = [(freq[s], s, [s]) for s in range(256) if freq[s]]
+    if len(heap) < 2:
+        return None
+    depth = {s: 0 for _, s, _ in heap}
+    heapq.heapify(heap)
+    tie = 256
+    while len(heap) > 1:
+        fa, _, a = heapq.heappop(heap)
+        fb, _, b = heapq.heappop(heap)
+        for s in a + b:
+            depth[s] += 1
+        heapq.heappush(heap, (fa + fb, tie, a + b))
+        tie += 1
+    lengths = {s: min(d, limit) for s, d in depth.items()}
+    # the decoder needs a complete code, kraft sum in units of 2^-limit
+    kraft = sum(1 << (limit - l) for l in lengths.values())
+    full = 1 << limit
+    while kraft > full:
+        s = max((s for s in lengths if lengths[s] < limit), key=lambda s: (lengths[s], -freq[s]))
+        kraft -= 1 << (limit - lengths[s] - 1)
+        lengths[s] += 1
+    while kraft < full:
+        s = max((s for s in lengths if lengths[s] > 1 and (1 << (limit - lengths[s])) <= full - kraft),
+                key=lambda s: (lengths[s], freq[s]))
+        kraft += 1 << (limit - lengths[s])
+        lengths[s] -= 1
+    return lengths
+
+
+def canonical_codes(lengths):
+    codes = {}
+    code = 0
+    for l in range(1, 12):
+        for s in sorted(s for s in lengths if lengths[s] == l):
+            codes[s] = code
+            code += 1
+        code <<= 1
+    return codes
+
+
+def reverse_bits(v, n):
+    r = 0
+    for _ in range(n):
+        r = (r << 1) | (v & 1)
+        v >>= 1
+    return r
+
+
+def huffman_header_old(lengths):
+    # sparse symbol list, 8 bit symbols with their code length
+    w = MsbBits()
+    w.put(0, 1)
+    w.put(0, 1)
+    syms = sorted(lengths)
+    w.put(len(syms), 8)
+    lenbits = (max(lengths.values()) - 1).bit_length()
+    w.put(lenbits, 3)
+    for s in syms:
+        w.put(s, 8)
+        w.put(lengths[s] - 1, lenbits)
+    return w.getvalue()
+
+
+def huffman_header_new(lengths, forced_bits=1):
+    # code length deltas as golomb-rice values, symbols as runs and gaps
+    w = MsbBits()
+    w.put(1, 1)
+    w.put(0, 1)
+    syms = sorted(lengths)
+    n = len(syms)
+    w.put(forced_bits, 2)
+    w.put(n - 1, 8)
+
+    ranges = []
+    for s in syms:
+        if ranges and ranges[-1][0] + ranges[-1][1] == s:
+            ranges[-1][1] += 1
+        else:
+            ranges.append([s, 1])
+    extra = []
+    range_bits = []
+    if ranges[0][0] > 0:
+        gap = ranges[0][0]
+        v = (gap + 1).bit_length() - 2
+        extra.append(v)
+        range_bits.append((gap + 1 - (1 << (v + 1)), v + 1))
+    for i in range(len(ranges) - 1):
+        num = ranges[i][1]
+        v = num.bit_length() - 1
+        extra.append(v)
+        range_bits.append((num - (1 << v), v))
+        space = ranges[i + 1][0] - (ranges[i][0] + ranges[i][1])
+        v = (space + 1).bit_length() - 2
+        extra.append(v)
+        range_bits.append((space + 1 - (1 << (v + 1)), v + 1))
+    fluff = len(extra)
+    if n != 256:
+        x = min(257 - n, n) * 2
+        assert fluff < x
+        y = (x - 1).bit_length()
+        z = (1 << y) - x
+        if fluff < z:
+            w.put(fluff, y - 1)
+        else:
+            w.put(fluff + z, y)
+
+    running = 0x1E
+    values = []
+    for s in syms:
+        v = lengths[s] - (running >> 2) - 1
+        running += v
+        values.append(2 * v if v >= 0 else -2 * v - 1)
+    for v in values:
+        w.zeros(v >> forced_bits)
+        w.put(1, 1)
+    for v in extra:
+        w.zeros(v)
+        w.put(1, 1)
+    if forced_bits:
+        for v in values:
+            w.put(v & ((1 << forced_bits) - 1), forced_bits)
+    for value, count in range_bits:
+        w.put(value, count)
+    return w.getvalue()
+
+
+def huffman_group(data, codes, lengths):
+    # symbol i goes to the forward, backward and middle stream in turns
+    streams = [LsbBits(), LsbBits(), LsbBits()]
+    for i, b in enumerate(data):
+        streams[i % 3].put(reverse_bits(codes[b], lengths[b]), lengths[b])
+    forward, backward, middle = (s.getvalue() for s in streams)
+    return forward, middle + backward[::-1]
+
+
+def huffman(data, groups, new_lengths):
+    lengths = huffman_lengths(data)
+    if lengths is None or (len(lengths) == 256 and not new_lengths):
+        return None
+    codes = canonical_codes(lengths)
+    header = huffman_header_new(lengths) if new_lengths else huffman_header_old(lengths)
+    if groups == 1:
+        forward, rest = huffman_group(data, codes, lengths)
+        return header + struct.pack('<H', len(forward)) + forward + rest
+    half = (len(data) + 1) >> 1
+    forward1, rest1 = huffman_group(data[:half], codes, lengths)
+    forward2, rest2 = huffman_group(data[half:], codes, lengths)
+    if len(rest1) < 2 or len(rest2) < 2:
+        return None
+    left = struct.pack('<H', len(forward1)) + forward1 + rest1
+    return header + struct.pack('<I', len(left))[:3] + left + struct.pack('<H', len(forward2)) + forward2 + rest2
+
+
+def rle(data):
+    # copies and runs, commands are read from the back, their bytes from the front
+    front = bytearray()
+    commands = []
+    rle_byte = 0
+    i = 0
+    n = len(data)
+    while i < n:
+        start = i
+        while i < n:
+            j = i
+            while j < n and data[j] == data[i]:
+                j += 1
+            if j - i >= 4:
+                break
+            i = j
+        copy = data[start:i]
+        j = i
+        while j < n and data[j] == data[i] if i < n else False:
+            j += 1
+        run = j - i
+        if run and data[i] != rle_byte:
+            rle_byte = data[i]
+            front.append(rle_byte)
+            commands.append(bytes([1]))
+        while len(copy) >= 64:
+            k = min(len(copy) // 64, 0x6FF)
+            front += copy[:k * 64]
+            copy = copy[k * 64:]
+            commands.append(struct.pack('<H', k + 511))
+        front += copy
+        first = min(run, 127)
+        if len(copy) <= 15 and 3 <= first <= 15:
+            commands.append(bytes([first << 4 | (~len(copy) & 0xF)]))
+        elif copy or first:
+            commands.append(struct.pack('<H', 4096 + (len(copy) | first << 6)))
+        run -= first
+        while run >= 128:
+            k = min(run // 128, 0x6FF)
+            commands.append(struct.pack('<H', k + 0x8FF))
+            run -= k * 128
+        if run:
+            commands.append(struct.pack('<H', 4096 + (run << 6)))
+        i = j
+    return bytes([0]) + bytes(front) + b''.join(reversed(commands))
+
+
+def bytes_header(chunk_type, src_size, dst_size, short):
+    if chunk_type == 0:
+        if short and src_size <= 0xFFF:
+            return bytes([0x80 | src_size >> 8, src_size & 0xFF])
+        assert src_size <= 0x3FFFF
+        return src_size.to_bytes(3, 'big')
+    assert src_size < dst_size
+    if short and src_size < 0x400 and dst_size - src_size - 1 < 0x400:
+        return (0x800000 | chunk_type << 20 | (dst_size - src_size - 1) << 10 | src_size).to_bytes(3, 'big')
+    d = dst_size - 1
+    assert d < 0x40000
+    return bytes([chunk_type << 4 | d >> 14]) + ((d & 0x3FFF) << 18 | src_size).to_bytes(4, 'big')
+
+
+def encode_bytes(data, coder, short=True):
+    # coder is stored, huff, huff2 (two stream groups) or rle, huffman with new or old code lengths
+    data = bytes(data)
+    body = None
+    chunk_type = 0
+    if len(data) >= 16:
+        if coder in ('huff', 'huff-old'):
+            body, chunk_type = huffman(data, 1, coder == 'huff'), 2
+        elif coder in ('huff2', 'huff2-old'):
+            body, chunk_type = huffman(data, 2, coder == 'huff2'), 4
+        elif coder == 'rle':
+            body, chunk_type = rle(data), 3
+    if body is None or len(body) >= len(data):
+        return bytes_header(0, len(data), len(data), short) + data
+    return bytes_header(chunk_type, len(body), len(data), short) + body
+
+
+# LZ parsing
+
+class Matcher:
+    def __init__(self, data):
+        self.data = data
+        self.table = {}
+
+    def insert(self, p):
+        if p + 4 <= len(self.data):
+            chain = self.table.setdefault(self.data[p:p + 4], [])
+            chain.append(p)
+            if len(chain) > 24:
+                del chain[0]
+
+    def candidates(self, p):
+        return reversed(self.table.get(self.data[p:p + 4], ()))
+
+
+def match_length(data, a, b, limit):
+    n = 0
+    while n + 16 <= limit and data[a + n:a + n + 16] == data[b + n:b + n + 16]:
+        n += 16
+    while n < limit and data[a + n] == data[b + n]:
+        n += 1
+    return n
+
+
+def parse(data, matcher, start, end, window, reps, accept, update):
+    # greedy, returns (literals, match length, distance) tokens and the trailing literals
+    tokens = []
+    lit_start = p = start
+    while p < end:
+        limit = end - p
+        best = (0, 0)
+        for d in reps:
+            if p - d >= window:
+                l = accept(p, d, match_length(data, p, p - d, limit), True)
+                if l >= 3 and l > best[0]:
+                    best = (l, d)
+        if best[0] < 8:
+            for q in matcher.candidates(p):
+                if q < window:
+                    break
+                l = accept(p, p - q, match_length(data, p, q, limit), False)
+                if l >= 4 and l > best[0]:
+                    best = (l, p - q)
+        if best[0]:
+            tokens.append((p - lit_start, best[0], best[1]))
+            reps = update(reps, best[1])
+            for q in range(p, p + best[0]):
+                matcher.insert(q)
+            p += best[0]
+            lit_start = p
+        else:
+            matcher.insert(p)
+            p += 1
+    return tokens, end - lit_start, reps
+
+
+# kraken
+
+def kraken_distance(w, d, scaled):
+    if scaled:
+        offs = d + 8
+        e = offs.bit_length() - 4
+        w.put(offs & ((1 << e) - 1), e)
+        return e << 3 | ((offs >> e) - 8)
+    x = d + 248
+    n = (x >> 4).bit_length() - 1
+    assert 4 <= n <= 18
+    w.put((x >> 4) - (1 << n), n)
+    return (n - 4) << 4 | (x & 0xF)
+
+
+def kraken_chunk(data, matcher, start, end, window, cfg):
+    mode = cfg.get('mode', 1)
+    scaled = cfg.get('scaled', False)
+    head = b''
+    p = start
+    if start == window:
+        head = data[start:start + 8]
+        for q in range(start, start + 8):
+            matcher.insert(q)
+        p += 8
+
+    def accept(pos, d, l, rep):
+        if not rep and d < (1 if scaled else 8):
+            return 0
+        return l if l >= 2 else 0
+
+    def update(reps, d):
+        reps = list(reps)
+        if d in reps:
+            reps.remove(d)
+        else:
+            reps.pop()
+        return [d] + reps
+
+    tokens, trail, _ = parse(data, matcher, p, end, window, [8, 8, 8], accept, update)
+
+    lits = bytearray()
+    cmds = bytearray()
+    offsets = []
+    lens = bytearray()
+    longs = []
+    recent = [8, 8, 8]
+    last = 8
+
+    def literals(n):
+        nonlocal p
+        for i in range(p, p + n):
+            lits.append(data[i] if mode == 1 else (data[i] - data[i - last]) & 0xFF)
+        p += n
+
+    def length(v):
+        if v < 255:
+            lens.append(v)
+        else:
+            lens.append(255)
+            longs.append(v - 255)
+
+    for litlen, matchlen, d in tokens:
+        literals(litlen)
+        if litlen >= 3:
+            length(litlen - 3)
+        if d in recent:
+            index = recent.index(d)
+            recent.remove(d)
+        else:
+            index = 3
+            offsets.append(d)
+            recent.pop()
+        recent.insert(0, d)
+        last = d
+        if matchlen > 16:
+            length(matchlen - 17)
+        cmds.append(min(litlen, 3) | min(matchlen - 2, 15) << 2 | index << 6)
+        p += matchlen
+    literals(trail)
+    assert p == end and len(longs) <= 512
+
+    a = MsbBits()
+    b = MsbBits()
+    count = len(longs) + 1
+    b.put(0, count.bit_length() - 1)
+    b.put(count, count.bit_length())
+    packed = bytearray()
+    for i, d in enumerate(offsets):
+        packed.append(kraken_distance(b if i & 1 else a, d, scaled))
+    for i, u in enumerate(longs):
+        w = b if i & 1 else a
+        x = u + 64
+        w.put(0, x.bit_length() - 7)
+        w.put(x, x.bit_length())
+
+    # the literal and offset stream headers must not have their top bit set
+    body = head + encode_bytes(lits, cfg.get('lit', 'huff'), short=False)
+    body += encode_bytes(cmds, cfg.get('cmd', 'huff'))
+    body += (b'\x80' + encode_bytes(packed, cfg.get('off', 'huff'))) if scaled else encode_bytes(packed, cfg.get('off', 'huff'), short=False)
+    body += encode_bytes(lens, cfg.get('len', 'huff'))
+    body += a.getvalue() + b.getvalue()[::-1]
+    return body, mode
+
+
+# mermaid and selkie
+
+def mermaid_chunk(data, matcher, start, end, window, cfg):
+    mode = cfg.get('mode', 1)
+    head = b''
+    if start == window:
+        head = data[start:start + 8]
+        for q in range(start, start + 8):
+            matcher.insert(q)
+
+    def accept(pos, d, l, rep):
+        if d >= 0x10000 and not rep and l < 8:
+            return 0
+        return l
+
+    lits = bytearray()
+    cmds = bytearray()
+    off16 = []
+    off32 = [[], []]
+    lens = bytearray()
+    recent = 8
+    split = None
+    p = start
+
+    def literals(n):
+        nonlocal p
+        for i in range(p, p + n):
+            lits.append(data[i] if mode == 1 else (data[i] - data[i - recent]) & 0xFF)
+        p += n
+
+    def length(v):
+        if v <= 251:
+            lens.append(v)
+        else:
+            u = (v - 252) // 4
+            lens.append(v - 4 * u)
+            lens.extend(struct.pack('<H', u))
+
+    for half, half_start in enumerate((start, start + 0x10000)):
+        half_end = min(end, half_start + 0x10000)
+        if half_start >= end:
+            break
+        p = half_start + (8 if half_start == window else 0)
+        tokens, trail, _ = parse(data, matcher, p, half_end, window, [recent], accept, lambda reps, d: [d])
+        for litlen, matchlen, d in tokens:
+            if litlen >= 64:
+                cmds.append(0)
+                length(litlen - 64)
+                literals(litlen)
+                litlen = 0
+            while litlen >= 8:
+                cmds.append(0x80 | 7)
+                literals(7)
+                litlen -= 7
+            if d == recent:
+                first = min(matchlen, 15)
+                cmds.append(0x80 | first << 3 | litlen)
+                literals(litlen)
+                p += first
+                matchlen -= first
+                while matchlen:
+                    piece = min(matchlen, 15)
+                    cmds.append(0x80 | piece << 3)
+                    p += piece
+                    matchlen -= piece
+                continue
+            if d < 0x10000 and matchlen <= 90:
+                first = min(matchlen, 15)
+                cmds.append(first << 3 | litlen)
+                literals(litlen)
+                off16.append(d)
+                recent = d
+                p += first
+                matchlen -= first
+                while matchlen:
+                    piece = min(matchlen, 15)
+                    cmds.append(0x80 | piece << 3)
+                    p += piece
+                    matchlen -= piece
+                continue
+            if litlen:
+                cmds.append(0x80 | litlen)
+                literals(litlen)
+            if d < 0x10000:
+                cmds.append(1)
+                length(matchlen - 91)
+                off16.append(d)
+            else:
+                if matchlen <= 28:
+                    cmds.append(matchlen - 5)
+                else:
+                    cmds.append(2)
+                    length(matchlen - 29)
+                off32[half].append(d - (p - half_start))
+            recent = d
+            p += matchlen
+        literals(trail)
+        assert p == half_end
+        if half == 0:
+            split = len(cmds)
+
+    body = head + encode_bytes(lits, cfg.get('lit', 'huff'))
+    body += encode_bytes(cmds, cfg.get('cmd', 'huff'))
+    if end - start > 0x10000:
+        body += struct.pack('<H', split)
+    if cfg.get('off16') == 'split':
+        body += b'\xff\xff'
+        body += encode_bytes(bytes(d >> 8 for d in off16), 'huff')
+        body += encode_bytes(bytes(d & 0xFF for d in off16), 'huff')
+    else:
+        body += struct.pack('<H', len(off16)) + b''.join(struct.pack('<H', d) for d in off16)
+    sizes = [len(off32[0]), len(off32[1])]
+    body += struct.pack('<I', min(sizes[0], 4095) << 12 | min(sizes[1], 4095))[:3]
+    for size in sizes:
+        if size >= 4095:
+            body += struct.pack('<H', size)
+    for offs in off32:
+        for off in offs:
+            assert off < 0xC00000
+            body += struct.pack('<I', off)[:3]
+    body += lens
+    return body, mode
+
+
+# blocks
+
+def encode_stream(data, decoder, blocks):
+    out = bytearray()
+    pos = 0
+    matcher = None
+    window = 0
+    for spec in blocks:
+        end = min(len(data), pos + BLOCK)
+        restart = spec.get('restart', False) or pos == 0
+        if restart:
+            matcher = Matcher(data)
+            window = pos
+        flags = 0x8C if restart else 0x0C
+        checksums = spec.get('checksums', False)
+        kind = spec['kind']
+        if kind == 'uncompressed' or (kind == 'stored' and end - pos == BLOCK):
+            out += bytes([flags | 0x40, decoder | (0x80 if checksums else 0)]) + data[pos:end]
+        elif kind == 'memset':
+            assert data[pos:end] == bytes([data[pos]]) * (end - pos)
+            out += bytes([flags, decoder]) + b'\x07\xff\xff' + bytes([data[pos]])
+        else:
+            quantum = bytearray()
+            if kind == 'stored':
+                quantum = data[pos:end]
+            for i, cfg in enumerate(spec.get('chunks', [])):
+                start = pos + i * CHUNK
+                stop = min(end, start + CHUNK)
+                if cfg['kind'] == 'entropy':
+                    chunk = encode_bytes(data[start:stop], cfg['coder'], short=False)
+                else:
+                    encoder = kraken_chunk if decoder == KRAKEN else mermaid_chunk
+                    body, mode = encoder(data, matcher, start, stop, window, cfg)
+                    if len(body) >= stop - start:
+                        body, mode = data[start:stop], 0
+                    chunk = (0x800000 | mode << 19 | len(body)).to_bytes(3, 'big') + body
+                quantum += chunk
+            assert len(quantum) <= end - pos
+            out += bytes([flags, decoder | (0x80 if checksums else 0)])
+            out += (len(quantum) - 1).to_bytes(3, 'big')
+            if checksums:
+                out += b'\x00\x00\x00'
+            out += quantum
+        pos = end
+    assert pos == len(data)
+    return bytes(out)
+
+
+def samples():
+    # the decoder splits the output into 256KB blocks, only the last one may be shorter
+    rng = Rng(0x9E3779B97F4A7C15)
+    words = make_words(rng)
+
+    # kraken: a two block segment with matches across the blocks, then two resets
+    base = text(rng, words, 0x40000)
+    data = base + text(rng, words, 0x10000) + repeats(rng, base, 0x10000, 2) + runs(rng, 0x20000)
+    table = records(rng, 0x20000)
+    data += table + repeats(rng, table, 0x20000, 1) + noise(rng, 0x4000)
+    yield 'kraken', data, KRAKEN, [
+        {'kind': 'lz', 'chunks': [
+            {'kind': 'lz', 'mode': 1, 'lit': 'huff', 'cmd': 'huff-old', 'off': 'stored', 'len': 'stored'},
+            {'kind': 'lz', 'mode': 0, 'scaled': True, 'lit': 'huff2', 'cmd': 'huff2-old', 'off': 'huff', 'len': 'huff'}]},
+        {'kind': 'lz', 'checksums': True, 'chunks': [
+            {'kind': 'lz', 'mode': 1, 'lit': 'huff-old', 'cmd': 'huff', 'off': 'huff2', 'len': 'rle'},
+            {'kind': 'entropy', 'coder': 'rle'}]},
+        {'kind': 'lz', 'restart': True, 'chunks': [
+            {'kind': 'entropy', 'coder': 'huff2'},
+            {'kind': 'lz', 'mode': 0, 'scaled': True, 'lit': 'huff', 'cmd': 'huff', 'off': 'huff', 'len': 'huff'}]},
+        {'kind': 'uncompressed', 'restart': True}]
+
+    # mermaid: delta literals, far offsets into the first chunk, then two resets
+    base = records(rng, 0x10000) + text(rng, words, 0x10000)
+    data = base + repeats(rng, base, 0x20000, 3)
+    base = text(rng, words, 0x20000)
+    data += base + repeats(rng, base, 0x20000, 2) + bytes(0x4000)
+    yield 'mermaid', data, MERMAID, [
+        {'kind': 'lz', 'chunks': [
+            {'kind': 'lz', 'mode': 0, 'lit': 'huff', 'cmd': 'huff-old', 'off16': 'split'},
+            {'kind': 'lz', 'mode': 0, 'lit': 'huff2-old', 'cmd': 'huff2'}]},
+        {'kind': 'lz', 'restart': True, 'chunks': [
+            {'kind': 'entropy', 'coder': 'huff'},
+            {'kind': 'lz', 'mode': 1, 'lit': 'huff', 'cmd': 'huff'}]},
+        {'kind': 'memset', 'restart': True}]
+
+    # selkie: raw literals and streams only, long literal runs and long matches
+    base = noise(rng, 0x8000) + text(rng, words, 0x8000)
+    data = base + repeats(rng, base, 0x18000, 0) + repeats(rng, base, 0x8000, 1)
+    yield 'selkie', data, MERMAID, [
+        {'kind': 'lz', 'chunks': [
+            {'kind': 'lz', 'mode': 1, 'lit': 'stored', 'cmd': 'stored'},
+            {'kind': 'lz', 'mode': 1, 'lit': 'stored', 'cmd': 'stored'}]}]
+
+
+def main():
+    outdir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.abspath(__file__))
+    for name, data, decoder, blocks in samples():
+        stream = encode_stream(data, decoder, blocks)
+        with open(os.path.join(outdir, name + '.raw'), 'wb') as f:
+            f.write(data)
+        with open(os.path.join(outdir, name + '.cmp'), 'wb') as f:
+            f.write(stream)
+        print('%s: %d -> %d bytes' % (name, len(data), len(stream)))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,36 @@
+#include "pch.h"
+#include "Arena.h"
+
+void* Arena::AllocateBytes(size_t size, size_t align)
+{
+	if (!_blocks.empty())
+	{
+		Block& block = _blocks.back();
+		size_t offset = (_used + align - 1) & ~(align - 1);
+		if (offset <= block.size && size <= block.size - offset)
+		{
+			_used = offset + size;
+			return block.data.get() + offset;
+		}
+	}
+	// big requests get a block of their own, new blocks are aligned by operator new[]
+	size_t blockSize = std::max(size, _blockSize);
+	_blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize });
+	_used = size;
+	return _blocks.back().data.get();
+}
+
+void Arena::Reset()
+{
+	if (_blocks.size() > 1)
+		_blocks.resize(1);
+	_used = 0;
+}
+
+size_t Arena::Capacity() const
+{
+	size_t capacity = 0;
+	for (const Block& block : _blocks)
+		capacity += block.size;
+	return capacity;
+}
@@ -0,0 +1,1338 @@
+#include "pch.h"
+#include "Bench.h"
+#include "Gnf.h"
+#include "Formats.h"
+#include "Wad.h"
+#include "Mesh.h"
+#include "Rig.h"
+#include "glTFSerializer.h"
+#ifndef GOWTOOL_NO_FBXSDK
+#include "FBXSerializer.h"
+#endif
+#include "FbxExport.h"
+#include "Decompressor.h"
+#include "krak.h"
+#include "ThreadPool.h"
+#include "utils.h"
+#include <GLTFSDK/GLBResourceReader.h>
+#include <GLTFSDK/Deserialize.h>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <random>
+#include <sstream>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	// original GnfImage::UnSwizzle/Swizzle, kept as the baseline and to validate the kernels
+	void ReferenceUnSwizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl)
+	{
+		size_t min = pixbl * pixbl * bpp / 8;
+		uint32_t num2 = w * h * bpp / 8;
+		if (num2 <= min)
+		{
+			memcpy(dst, src, min);
+			return;
+		}
+
+		uint32_t num4 = pixbl;
+		uint32_t num5 = bpp * 2;
+		if (num4 == 1)
+		{
+			num5 = bpp / 8;
+		}
+		byte* array1 = new byte[num2 * 2];
+		byte* array2 = new byte[16];
+		int num6 = h / num4;
+		int num7 = w / num4;
+		int roff = 0;
+		for (int i = 0; i < (num6 + 7) / 8; i++)
+		{
+			for (int j = 0; j < (num7 + 7) / 8; j++)
+			{
+				for (int k = 0; k < 64; k++)
+				{
+					int num8 = Gnf::GnfImage::morton(k, 8, 8);
+					int num9 = num8 / 8;
+					int num10 = num8 % 8;
+					memcpy(array2, src + roff, num5);
+					roff += num5;
+					if (j * 8 + num10 < num7 && i * 8 + num9 < num6)
+					{
+						int destinationIndex = num5 * ((i * 8 + num9) * num7 + j * 8 + num10);
+						memcpy(array1 + destinationIndex, array2, num5);
+					}
+				}
+			}
+		}
+		memcpy(dst, array1, num2);
+
+		delete[] array1;
+		delete[] array2;
+	}
+	void ReferenceSwizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl)
+	{
+		size_t min = pixbl * pixbl * bpp / 8;
+		uint32_t num2 = w * h * bpp / 8;
+		if (num2 <= min)
+		{
+			memcpy(dst, src, min);
+			return;
+		}
+
+		uint32_t num4 = pixbl;
+		uint32_t num5 = bpp * 2;
+		if (num4 == 1)
+		{
+			num5 = bpp / 8;
+		}
+		byte* array1 = new byte[num2 * 2];
+		int num6 = h / num4;
+		int num7 = w / num4;
+		int roff = 0;
+		for (int i = 0; i < (num6 + 7) / 8; i++)
+		{
+			for (int j = 0; j < (num7 + 7) / 8; j++)
+			{
+				for (int k = 0; k < 64; k++)
+				{
+					int num8 = Gnf::GnfImage::morton(k, 8, 8);
+					int num9 = num8 / 8;
+					int num10 = num8 % 8;
+					if (j * 8 + num10 < num7 && i * 8 + num9 < num6)
+					{
+						int destinationIndex = num5 * ((i * 8 + num9) * num7 + j * 8 + num10);
+						memcpy(array1 + roff, src + destinationIndex, num5);
+						roff += num5;
+					}
+				}
+			}
+		}
+		memcpy(dst, array1, num2);
+
+		delete[] array1;
+	}
+
+	typedef void (*SwizzleFunc)(const byte*, byte*, const uint16_t&, const uint16_t&, const uint16_t&, const uint16_t&);
+
+	double TimeMs(SwizzleFunc func, const byte* src, byte* dst, uint16_t w, uint16_t h, uint16_t bpp, uint16_t pixbl, size_t iterations)
+	{
+		auto start = Clock::now();
+		for (size_t i = 0; i < iterations; i++)
+		{
+			func(src, dst, w, h, bpp, pixbl);
+		}
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+	}
+
+	void Report(const char* name, const char* direction, size_t size, double referenceMs, double kernelMs)
+	{
+		char line[160];
+		snprintf(line, sizeof(line), "  %-14s %-10s reference %8.2f ms  kernel %8.2f ms  %8.1f MB/s  x%.1f\n",
+			name, direction, referenceMs, kernelMs, size / (kernelMs * 1000.0), referenceMs / kernelMs);
+		cout << line;
+	}
+
+	// original stream based MGDefinition::ReadMG/SmshDefinition::ReadSmsh, the baseline for the span parsers
+	vector<MeshInfo> ReferenceReadMG(std::stringstream& file)
+	{
+		vector<MeshInfo> meshesinfo;
+		uint16_t defCount = 0;
+		file.seekg(56);
+		file.read((char*)&defCount, sizeof(uint16_t));
+
+		vector<uint32_t> defOffsets(defCount);
+
+		file.seekg(76);
+		for (uint16_t i = 0; i < defCount; i++)
+		{
+			file.read((char*)&defOffsets[i], sizeof(uint32_t));
+		}
+
+		for (uint16_t i = 0; i < defCount; i++)
+		{
+			uint32_t offset = defOffsets[i];
+
+			file.seekg((uint64_t)offset);
+
+			uint16_t boneAsso = UINT16_MAX;
+			file.read((char*)&boneAsso, sizeof(uint16_t));
+			uint8_t subMeshCount = UINT8_MAX;
+			file.read((char*)&subMeshCount, sizeof(uint8_t));
+
+			for (uint8_t e = 0; e < subMeshCount; e++)
+			{
+				uint32_t subMeshOffsetter = UINT32_MAX;
+				file.seekg((uint64_t)offset + 60 + (uint64_t)e * 4);
+				file.read((char*)&subMeshOffsetter, sizeof(uint32_t));
+
+				uint32_t partCount = UINT32_MAX;
+				file.seekg((uint64_t)offset + (uint64_t)subMeshOffsetter);
+				file.read((char*)&partCount, sizeof(uint32_t));
+
+				if (partCount == 0)
+					continue;
+
+				uint32_t partOffset = (uint32_t)file.tellg() + 8;
+				for (uint32_t c = 0; c < partCount; c++)
+				{
+					MeshInfo info;
+					info.LODlvl = e;
+					info.boneAssociated = boneAsso;
+					file.seekg((uint64_t)partOffset + (uint64_t)c * 4);
+					uint32_t off = UINT32_MAX;
+					file.read((char*)&off, sizeof(uint32_t));
+					off += partOffset + c * 4;
+
+					uint32_t smBaseOff = off;
+					file.seekg((uint64_t)smBaseOff + 48);
+
+					uint32_t indOff = UINT32_MAX;
+					file.read((char*)&indOff, sizeof(uint32_t));
+					info.indicesOffset = indOff;
+
+					file.seekg(4, std::ios::cur);
+					uint32_t vertOff = UINT32_MAX;
+					file.read((char*)&vertOff, sizeof(uint32_t));
+					info.vertexOffset = vertOff;
+
+					file.seekg(4, std::ios::cur);
+					uint32_t vertC = UINT32_MAX;
+					file.read((char*)&vertC, sizeof(uint32_t));
+					info.vertCount = vertC;
+					uint32_t indC = UINT32_MAX;
+					file.read((char*)&indC, sizeof(uint32_t));
+					info.indCount = indC;
+
+					file.seekg((uint64_t)smBaseOff + 16);
+					Vec3 extent;
+					file.read((char*)&extent.X, sizeof(float));
+					file.read((char*)&extent.Y, sizeof(float));
+					file.read((char*)&extent.Z, sizeof(float));
+					Vec3 origin;
+					file.read((char*)&origin.X, sizeof(float));
+					file.read((char*)&origin.Y, sizeof(float));
+					file.read((char*)&origin.Z, sizeof(float));
+
+					Vec3 scale(extent.X * 2, extent.Y * 2, extent.Z * 2);
+					Vec3 min(origin.X - extent.X, origin.Y - extent.Y, origin.Z - extent.Z);
+
+					info.meshScale = scale;
+					info.meshMin = min;
+					file.seekg((uint64_t)smBaseOff + 84);
+
+					uint32_t vertexBlockInfoOffset = UINT32_MAX;
+					file.read((char*)&vertexBlockInfoOffset, sizeof(uint32_t));
+					uint32_t vertexBlockOffsetterOff = UINT32_MAX;
+					file.read((char*)&vertexBlockOffsetterOff, sizeof(uint32_t));
+
+					uint64_t Hash = UINT64_MAX;
+					file.read((char*)&Hash, sizeof(uint64_t));
+					info.Hash = Hash;
+
+					file.seekg((uint64_t)smBaseOff + (uint64_t)vertexBlockInfoOffset - 8);
+
+					uint8_t buffC = UINT8_MAX;
+					file.read((char*)&buffC, sizeof(uint8_t));
+					file.seekg(2, std::ios::cur);
+					uint8_t compC = UINT8_MAX;
+					file.read((char*)&compC, sizeof(uint8_t));
+
+					file.seekg(smBaseOff + vertexBlockOffsetterOff);
+					for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
+					{
+						uint32_t bufferOff = 0;
+						file.read((char*)&bufferOff, sizeof(uint32_t));
+						info.bufferOffset.push_back(bufferOff);
+					}
+
+					file.seekg((uint64_t)smBaseOff + (uint64_t)vertexBlockInfoOffset);
+
+					for (uint16_t d = 0; d < compC; d++)
+					{
+						Component component;
+						uint8_t val = 0;
+						file.read((char*)&val, sizeof(uint8_t));
+						component.primitiveType = static_cast<PrimitiveTypes>(val);
+						file.read((char*)&val, sizeof(uint8_t));
+						component.dataType = static_cast<DataTypes>(val);
+						file.read((char*)&component.elementCount, sizeof(uint8_t));
+						file.read((char*)&component.offset, sizeof(uint8_t));
+						file.read((char*)&component.bufferIndex, sizeof(uint8_t));
+
+						file.seekg(3, std::ios::cur);
+
+						info.Components.push_back(component);
+					}
+					for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
+					{
+						uint16_t stride = 0;
+						for (uint8_t f = 0; f < info.Components.size(); f++)
+						{
+							if (bIdx == info.Components[f].bufferIndex)
+							{
+								switch (info.Components[f].dataType)
+								{
+								case DataTypes::FLOAT:
+									stride += 4 * info.Components[f].elementCount;
+									break;
+								case DataTypes::WORD_STRUCT_0:
+									stride += 4 * info.Components[f].elementCount;
+									break;
+								case DataTypes::WORD_STRUCT_1:
+									stride += 4 * info.Components[f].elementCount;
+									break;
+								case DataTypes::HALFWORD_STRUCT_0:
+									stride += 2 * info.Components[f].elementCount;
+									break;
+								case DataTypes::HALFWORD_STRUCT_1:
+									stride += 2 * info.Components[f].elementCount;
+									break;
+								case DataTypes::HALFWORD_STRUCT_2:
+									stride += 2 * info.Components[f].elementCount;
+									break;
+								case DataTypes::UNSIGNED_SHORT:
+									stride += 2 * info.Components[f].elementCount;
+									break;
+								case DataTypes::BYTE_STRUCT_0:
+									stride += 1 * info.Components[f].elementCount;
+									break;
+								default:
+									break;
+								}
+							}
+						}
+						info.bufferStride.push_back(stride);
+					}
+					meshesinfo.push_back(info);
+				}
+			}
+		}
+		return meshesinfo;
+	}
+	vector<MeshInfo> ReferenceReadSmsh(std::iostream& file)
+	{
+		uint32_t groupDataOffset = 0;
+		uint32_t meshDefSectionOff = 0;
+		uint32_t meshDefCnt = 0;
+		file.seekg(0x48, ios::beg);
+		file.read((char*)&groupDataOffset, sizeof(uint32_t));
+		groupDataOffset += 0x48;
+		file.seekg(0x58, ios::beg);
+		file.read((char*)&meshDefSectionOff, sizeof(uint32_t));
+		file.read((char*)&meshDefCnt, sizeof(uint32_t));
+		meshDefSectionOff += 0x58;
+
+
+		uint64_t currHash = UINT64_MAX;
+		uint16_t curGroup = UINT16_MAX;
+		uint16_t curLod = 0;
+		vector<MeshInfo> meshinfos;
+		for (uint32_t i = 0; i < meshDefCnt; i++)
+		{
+			file.seekg(meshDefSectionOff + i * 4, ios::beg);
+			uint32_t off = 0;
+			file.read((char*)&off, sizeof(uint32_t));
+			off += i * 4;
+			file.seekg(meshDefSectionOff + off, ios::beg);
+
+			file.seekg(0x10, ios::cur);
+			Vec3 extent;
+			file.read((char*)&extent.X, sizeof(float));
+			file.read((char*)&extent.Y, sizeof(float));
+			file.read((char*)&extent.Z, sizeof(float));
+			Vec3 origin;
+			file.read((char*)&origin.X, sizeof(float));
+			file.read((char*)&origin.Y, sizeof(float));
+			file.read((char*)&origin.Z, sizeof(float));
+
+			Vec3 scale(extent.X * 2, extent.Y * 2, extent.Z * 2);
+			Vec3 min(origin.X - extent.X, origin.Y - extent.Y, origin.Z - extent.Z);
+
+			MeshInfo info;
+			info.meshScale = scale;
+			info.meshMin = min;
+			info.boneAssociated = 0;
+
+			file.seekg(meshDefSectionOff + off + 0x30, ios::beg);
+			uint32_t temp = 0;
+			file.read((char*)&temp, sizeof(uint32_t));
+			info.indicesOffset = temp;
+			file.seekg(4, std::ios::cur);
+			file.read((char*)&temp, sizeof(uint32_t));
+			info.vertexOffset = temp;
+			file.seekg(4, std::ios::cur);
+			file.read((char*)&info.vertCount, sizeof(uint32_t));
+			file.read((char*)&info.indCount, sizeof(uint32_t));
+
+			file.seekg(meshDefSectionOff + off + 0x54, ios::beg);
+			uint32_t vertexInfoOffset = 0;
+			uint32_t vertexDataOffsOffset = 0;
+			file.read((char*)&vertexInfoOffset, sizeof(uint32_t));
+			file.read((char*)&vertexDataOffsOffset, sizeof(uint32_t));
+			file.read((char*)&info.Hash, sizeof(uint64_t));
+
+			file.seekg(meshDefSectionOff + off + vertexInfoOffset - 8);
+
+			uint8_t buffC = 0;
+			file.read((char*)&buffC, sizeof(uint8_t));
+			file.seekg(2, std::ios::cur);
+			uint8_t compC = 0;
+			file.read((char*)&compC, sizeof(uint8_t));
+
+			file.seekg(meshDefSectionOff + off + vertexInfoOffset);
+			for (uint16_t d = 0; d < compC; d++)
+			{
+				Component component;
+				uint8_t val = 0;
+				file.read((char*)&val, sizeof(uint8_t));
+				component.primitiveType = static_cast<PrimitiveTypes>(val);
+				file.read((char*)&val, sizeof(uint8_t));
+				component.dataType = static_cast<DataTypes>(val);
+				file.read((char*)&component.elementCount, sizeof(uint8_t));
+				file.read((char*)&component.offset, sizeof(uint8_t));
+				file.read((char*)&component.bufferIndex, sizeof(uint8_t));
+
+				file.seekg(3, std::ios::cur);
+
+				info.Components.push_back(component);
+			}
+
+			for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
+			{
+				uint16_t stride = 0;
+				for (uint8_t f = 0; f < info.Components.size(); f++)
+				{
+					if (bIdx == info.Components[f].bufferIndex)
+					{
+						switch (info.Components[f].dataType)
+						{
+						case DataTypes::FLOAT:
+							stride += 4 * info.Components[f].elementCount;
+							break;
+						case DataTypes::WORD_STRUCT_0:
+							stride += 4 * info.Components[f].elementCount;
+							break;
+						case DataTypes::WORD_STRUCT_1:
+							stride += 4 * info.Components[f].elementCount;
+							break;
+						case DataTypes::HALFWORD_STRUCT_0:
+							stride += 2 * info.Components[f].elementCount;
+							break;
+						case DataTypes::HALFWORD_STRUCT_1:
+							stride += 2 * info.Components[f].elementCount;
+							break;
+						case DataTypes::HALFWORD_STRUCT_2:
+							stride += 2 * info.Components[f].elementCount;
+							break;
+						case DataTypes::UNSIGNED_SHORT:
+							stride += 2 * info.Components[f].elementCount;
+							break;
+						case DataTypes::BYTE_STRUCT_0:
+							stride += 1 * info.Components[f].elementCount;
+							break;
+						default:
+							break;
+						}
+					}
+				}
+				info.bufferStride.push_back(stride);
+			}
+
+			file.seekg(meshDefSectionOff + off + vertexDataOffsOffset);
+			for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
+			{
+				uint32_t bufferOff = 0;
+				file.read((char*)&bufferOff, sizeof(uint32_t));
+				info.bufferOffset.push_back(bufferOff);
+			}
+
+			file.seekg(groupDataOffset + i * 2, ios::beg);
+			uint16_t group = 0;
+			file.read((char*)&group, sizeof(uint16_t));
+			if (curGroup == group && currHash != info.Hash)
+			{
+				++curLod;
+			}
+			if (curGroup != group)
+			{
+				curGroup = group;
+				curLod = 0;
+			}
+			info.LODlvl = curLod;
+			if (currHash != info.Hash)
+			{
+				currHash = info.Hash;
+			}
+
+			meshinfos.push_back(info);
+		}
+		return meshinfos;
+	}
+
+	bool SameMeshInfo(const MeshInfo& a, const MeshInfo& b)
+	{
+		if (a.Hash != b.Hash || a.vertCount != b.vertCount || a.indCount != b.indCount ||
+			a.vertexOffset != b.vertexOffset || a.indicesOffset != b.indicesOffset ||
+			a.LODlvl != b.LODlvl || a.boneAssociated != b.boneAssociated ||
+			a.bufferOffset != b.bufferOffset || a.bufferStride != b.bufferStride ||
+			a.Components.size() != b.Components.size())
+			return false;
+		if (memcmp(&a.meshScale, &b.meshScale, sizeof(Vec3)) != 0 || memcmp(&a.meshMin, &b.meshMin, sizeof(Vec3)) != 0)
+			return false;
+		for (size_t i = 0; i < a.Components.size(); i++)
+		{
+			const Component& x = a.Components[i];
+			const Component& y = b.Components[i];
+			if (x.primitiveType != y.primitiveType || x.dataType != y.dataType || x.elementCount != y.elementCount ||
+				x.offset != y.offset || x.bufferIndex != y.bufferIndex)
+				return false;
+		}
+		return true;
+	}
+
+	// GLB files written by the benchmark are self contained, any external uri is an error
+	class GlbStreamReader : public Microsoft::glTF::IStreamReader
+	{
+	public:
+		std::shared_ptr<std::istream> GetInputStream(const std::string& filename) const override
+		{
+			throw Microsoft::glTF::GLTFException("Unexpected external resource " + filename);
+		}
+	};
+	struct GlbFile
+	{
+		Microsoft::glTF::Document document;
+		std::unique_ptr<Microsoft::glTF::GLBResourceReader> reader;
+	};
+	GlbFile ReadGlb(const std::filesystem::path& path)
+	{
+		auto stream = std::make_shared<std::ifstream>(path, std::ios::binary);
+		GlbFile glb;
+		glb.reader = std::make_unique<Microsoft::glTF::GLBResourceReader>(std::make_shared<GlbStreamReader>(), stream);
+		glb.document = Microsoft::glTF::Deserialize(glb.reader->GetJson());
+		return glb;
+	}
+	bool SameAccessor(const GlbFile& a, const std::string& aId, const GlbFile& b, const std::string& bId)
+	{
+		using namespace Microsoft::glTF;
+		const Accessor& x = a.document.accessors.Get(aId);
+		const Accessor& y = b.document.accessors.Get(bId);
+		if (x.type != y.type || x.componentType != y.componentType || x.count != y.count || x.min != y.min || x.max != y.max)
+			return false;
+		if (x.componentType == COMPONENT_FLOAT)
+			return a.reader->ReadBinaryData<float>(a.document, x) == b.reader->ReadBinaryData<float>(b.document, y);
+		return a.reader->ReadBinaryData<uint16_t>(a.document, x) == b.reader->ReadBinaryData<uint16_t>(b.document, y);
+	}
+	// compares node names, the data behind every mesh primitive and the skin of two GLBs
+	bool SameGlb(const GlbFile& a, const GlbFile& b)
+	{
+		using namespace Microsoft::glTF;
+		if (a.document.nodes.Size() != b.document.nodes.Size() || a.document.meshes.Size() != b.document.meshes.Size() ||
+			a.document.skins.Size() != b.document.skins.Size())
+			return false;
+		for (size_t i = 0; i < a.document.nodes.Size(); i++)
+		{
+			if (a.document.nodes[i].name != b.document.nodes[i].name)
+				return false;
+		}
+		for (size_t i = 0; i < a.document.meshes.Size(); i++)
+		{
+			const MeshPrimitive& x = a.document.meshes[i].primitives[0];
+			const MeshPrimitive& y = b.document.meshes[i].primitives[0];
+			if (x.attributes.size() != y.attributes.size() || !SameAccessor(a, x.indicesAccessorId, b, y.indicesAccessorId))
+				return false;
+			for (const auto& [name, accessorId] : x.attributes)
+			{
+				auto it = y.attributes.find(name);
+				if (it == y.attributes.end() || !SameAccessor(a, accessorId, b, it->second))
+					return false;
+			}
+		}
+		for (size_t i = 0; i < a.document.skins.Size(); i++)
+		{
+			if (!SameAccessor(a, a.document.skins[i].inverseBindMatricesAccessorId, b, b.document.skins[i].inverseBindMatricesAccessorId))
+				return false;
+		}
+		return true;
+	}
+	// positions and 16 bit UVs of a quantized GLB must be the integers they were decoded from,
+	// normals must match the decoded ones within SNORM16 precision
+	bool CheckQuantizedGlb(const GlbFile& glb, const vector<RawMeshContainer>& meshes,
+		const vector<vector<uint16_t>>& sourcePositions, const vector<vector<uint16_t>>& sourceTexcoords)
+	{
+		using namespace Microsoft::glTF;
+		if (glb.document.meshes.Size() != meshes.size() || !glb.document.IsExtensionRequired("KHR_mesh_quantization"))
+			return false;
+		for (size_t m = 0; m < meshes.size(); m++)
+		{
+			const MeshPrimitive& primitive = glb.document.meshes[m].primitives[0];
+			const Accessor& positions = glb.document.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_POSITION));
+			const Accessor& texcoords = glb.document.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_TEXCOORD_0));
+			const Accessor& normals = glb.document.accessors.Get(primitive.GetAttributeAccessorId(ACCESSOR_NORMAL));
+			if (positions.componentType != COMPONENT_UNSIGNED_SHORT || texcoords.componentType != COMPONENT_UNSIGNED_SHORT || normals.componentType != COMPONENT_SHORT)
+				return false;
+			if (glb.reader->ReadBinaryData<uint16_t>(glb.document, positions) != sourcePositions[m] ||
+				glb.reader->ReadBinaryData<uint16_t>(glb.document, texcoords) != sourceTexcoords[m])
+				return false;
+			// the stored normals are in the space of the quantized positions
+			const Vec3& scale = meshes[m].positionScale;
+			vector<int16_t> data = glb.reader->ReadBinaryData<int16_t>(glb.document, normals);
+			for (size_t v = 0; v < meshes[m].VertCount; v++)
+			{
+				Vec3 normal(data[v * 3] / 32767.f / scale.X, data[v * 3 + 1] / 32767.f / scale.Y, data[v * 3 + 2] / 32767.f / scale.Z);
+				normal.normalize();
+				const Vec3& expected = meshes[m].normals[v];
+				if (std::abs(normal.X - expected.X) > 1e-3f || std::abs(normal.Y - expected.Y) > 1e-3f || std::abs(normal.Z - expected.Z) > 1e-3f)
+					return false;
+			}
+		}
+		return true;
+	}
+
+#ifndef GOWTOOL_NO_FBXSDK
+	// what the FBX SDK imports from a skinned mesh file, nodes are keyed by name
+	struct FbxClusterData
+	{
+		std::map<int, double> weights;
+		FbxAMatrix transform;
+		FbxAMatrix transformLink;
+	};
+	struct FbxMeshData
+	{
+		vector<double> controlPoints;
+		vector<int> polygonVertices;
+		vector<double> normals;
+		vector<double> tangents;
+		std::map<string, vector<double>> uvSets;
+		std::map<string, FbxClusterData> clusters;
+	};
+	struct FbxSceneData
+	{
+		std::map<string, FbxMeshData> meshes;
+		std::map<string, FbxAMatrix> bones;
+	};
+	template<typename Element>
+	vector<double> ReadFbxElement(Element* element, int components)
+	{
+		vector<double> result;
+		if (!element)
+			return result;
+		auto& values = element->GetDirectArray();
+		for (int i = 0; i < values.GetCount(); i++)
+		{
+			auto value = values.GetAt(i);
+			for (int c = 0; c < components; c++)
+				result.push_back(value[c]);
+		}
+		return result;
+	}
+	void ReadFbxNode(FbxNode* node, FbxSceneData& scene)
+	{
+		if (node->GetSkeleton())
+			scene.bones[node->GetName()] = node->EvaluateLocalTransform();
+		if (FbxMesh* mesh = node->GetMesh())
+		{
+			FbxMeshData& data = scene.meshes[node->GetName()];
+			const FbxVector4* points = mesh->GetControlPoints();
+			for (int i = 0; i < mesh->GetControlPointsCount(); i++)
+			{
+				for (int c = 0; c < 3; c++)
+					data.controlPoints.push_back(points[i][c]);
+			}
+			for (int p = 0; p < mesh->GetPolygonCount(); p++)
+			{
+				for (int v = 0; v < mesh->GetPolygonSize(p); v++)
+					data.polygonVertices.push_back(mesh->GetPolygonVertex(p, v));
+			}
+			data.normals = ReadFbxElement(mesh->GetElementNormal(0), 3);
+			data.tangents = ReadFbxElement(mesh->GetElementTangent(0), 3);
+			for (int i = 0; i < mesh->GetElementUVCount(); i++)
+				data.uvSets[mesh->GetElementUV(i)->GetName()] = ReadFbxElement(mesh->GetElementUV(i), 2);
+			for (int d = 0; d < mesh->GetDeformerCount(FbxDeformer::eSkin); d++)
+			{
+				FbxSkin* skin = static_cast<FbxSkin*>(mesh->GetDeformer(d, FbxDeformer::eSkin));
+				for (int k = 0; k < skin->GetClusterCount(); k++)
+				{
+					FbxCluster* cluster = skin->GetCluster(k);
+					FbxClusterData& clusterData = data.clusters[cluster->GetLink()->GetName()];
+					for (int i = 0; i < cluster->GetControlPointIndicesCount(); i++)
+						clusterData.weights[cluster->GetControlPointIndices()[i]] = cluster->GetControlPointWeights()[i];
+					cluster->GetTransformMatrix(clusterData.transform);
+					cluster->GetTransformLinkMatrix(clusterData.transformLink);
+				}
+			}
+		}
+		for (int i = 0; i < node->GetChildCount(); i++)
+			ReadFbxNode(node->GetChild(i), scene);
+	}
+	FbxSceneData ReadFbxScene(FbxManager* manager, const std::filesystem::path& path)
+	{
+		FbxImporter* importer = FbxImporter::Create(manager, "");
+		if (!importer->Initialize(path.string().c_str(), -1, manager->GetIOSettings()))
+		{
+			string error = importer->GetStatus().GetErrorString();
+			importer->Destroy();
+			throw std::runtime_error("Failed to open " + path.string() + ": " + error);
+		}
+		FbxScene* scene = FbxScene::Create(manager, "");
+		bool imported = importer->Import(scene);
+		importer->Destroy();
+		FbxSceneData data;
+		if (imported)
+			ReadFbxNode(scene->GetRootNode(), data);
+		scene->Destroy();
+		if (!imported)
+			throw std::runtime_error("Failed to import " + path.string());
+		return data;
+	}
+	// transforms are compared with a tolerance, the SDK writer goes through euler angles
+	bool SameMatrix(const FbxAMatrix& a, const FbxAMatrix& b)
+	{
+		for (int r = 0; r < 4; r++)
+		{
+			for (int c = 0; c < 4; c++)
+			{
+				if (std::abs(a.Get(r, c) - b.Get(r, c)) > 1e-4)
+					return false;
+			}
+		}
+		return true;
+	}
+	// compares the geometry, skin clusters and skeleton of two imported scenes
+	bool SameFbxScene(const FbxSceneData& a, const FbxSceneData& b)
+	{
+		if (a.meshes.size() != b.meshes.size() || a.bones.size() != b.bones.size())
+			return false;
+		for (const auto& [name, transform] : a.bones)
+		{
+			auto it = b.bones.find(name);
+			if (it == b.bones.end() || !SameMatrix(transform, it->second))
+				return false;
+		}
+		for (const auto& [name, x] : a.meshes)
+		{
+			auto it = b.meshes.find(name);
+			if (it == b.meshes.end())
+				return false;
+			const FbxMeshData& y = it->second;
+			if (x.controlPoints != y.controlPoints || x.polygonVertices != y.polygonVertices || x.normals != y.normals ||
+				x.tangents != y.tangents || x.uvSets != y.uvSets || x.clusters.size() != y.clusters.size())
+				return false;
+			for (const auto& [bone, cluster] : x.clusters)
+			{
+				auto c = y.clusters.find(bone);
+				if (c == y.clusters.end() || cluster.weights != c->second.weights ||
+					!SameMatrix(cluster.transform, c->second.transform) || !SameMatrix(cluster.transformLink, c->second.transformLink))
+					return false;
+			}
+		}
+		return true;
+	}
+#endif
+
+	// a skinned model with every attribute the decoder produces, positions and the first UV set
+	// decoded from 16 bit integers like the game's meshes. The integers are kept to check the
+	// quantized export against
+	struct SyntheticModel
+	{
+		Arena arena;
+		vector<RawMeshContainer> meshes;
+		vector<vector<uint16_t>> sourcePositions;
+		vector<vector<uint16_t>> sourceTexcoords;
+		vector<int16_t> parents;
+		vector<string> names;
+		vector<Matrix4x4> matrices;
+		vector<Matrix4x4> IBMs;
+		Rig rig;
+
+		SyntheticModel(uint32_t meshCount, uint32_t vertCount, uint16_t boneCount);
+	};
+	SyntheticModel::SyntheticModel(uint32_t meshCount, uint32_t vertCount, uint16_t boneCount)
+	{
+		std::mt19937 rng(0x474C42);
+		std::uniform_real_distribution<float> unit(-1.f, 1.f);
+		sourcePositions.resize(meshCount);
+		sourceTexcoords.resize(meshCount);
+		for (uint32_t m = 0; m < meshCount; m++)
+		{
+			RawMeshContainer mesh;
+			mesh.VertCount = vertCount;
+			mesh.IndCount = vertCount * 3;
+			mesh.vertices = arena.Allocate<Vec3>(vertCount);
+			mesh.normals = arena.Allocate<Vec3>(vertCount);
+			mesh.tangents = arena.Allocate<Vec4>(vertCount);
+			mesh.txcoord0 = arena.Allocate<Vec2>(vertCount);
+			mesh.txcoord1 = arena.Allocate<Vec2>(vertCount);
+			mesh.indices = arena.Allocate<uint16_t>(mesh.IndCount);
+			mesh.joints = arena.Allocate<uint16_t>(vertCount * 4);
+			mesh.weights = arena.Allocate<float>(vertCount * 4);
+			mesh.positionType = DataTypes::UNSIGNED_SHORT;
+			mesh.positionScale = Vec3(200.f, 150.f + m, 80.f);
+			mesh.positionMin = Vec3(-100.f, -75.f, -40.f + m);
+			mesh.txcoordTypes[0] = DataTypes::UNSIGNED_SHORT;
+			sourcePositions[m].resize(size_t(vertCount) * 3);
+			sourceTexcoords[m].resize(size_t(vertCount) * 2);
+			for (uint32_t v = 0; v < vertCount; v++)
+			{
+				uint16_t* q = &sourcePositions[m][v * 3];
+				uint16_t* t = &sourceTexcoords[m][v * 2];
+				for (uint32_t k = 0; k < 3; k++)
+					q[k] = uint16_t(rng());
+				t[0] = uint16_t(rng());
+				t[1] = uint16_t(rng());
+				mesh.vertices[v] = Vec3(q[0] / 65535.f * mesh.positionScale.X + mesh.positionMin.X, q[1] / 65535.f * mesh.positionScale.Y + mesh.positionMin.Y,
+					q[2] / 65535.f * mesh.positionScale.Z + mesh.positionMin.Z);
+				Vec3 normal(unit(rng), unit(rng), unit(rng) + 2.f);
+				normal.normalize();
+				mesh.normals[v] = normal;
+				mesh.tangents[v] = Vec4(normal.Z, 0.f, -normal.X, 1.f);
+				mesh.txcoord0[v] = Vec2(t[0] / 65535.f, t[1] / 65535.f);
+				mesh.txcoord1[v] = Vec2(unit(rng) * 4.f, unit(rng) * 4.f);
+				for (uint32_t k = 0; k < 4; k++)
+				{
+					mesh.joints[v * 4 + k] = uint16_t(rng() % boneCount);
+					mesh.weights[v * 4 + k] = 0.25f;
+				}
+			}
+			for (uint32_t i = 0; i < mesh.IndCount; i++)
+				mesh.indices[i] = uint16_t(rng() % vertCount);
+			mesh.name = "submesh_" + std::to_string(m);
+			meshes.push_back(std::move(mesh));
+		}
+		parents.resize(boneCount);
+		names.resize(boneCount);
+		matrices.resize(boneCount);
+		IBMs.resize(boneCount);
+		for (uint16_t i = 0; i < boneCount; i++)
+		{
+			parents[i] = int16_t(i) - 1;
+			names[i] = "bone";
+			matrices[i].m41 = unit(rng);
+			IBMs[i].m41 = -matrices[i].m41;
+		}
+		rig.boneCount = boneCount;
+		rig.boneParents = parents.data();
+		rig.boneNames = names.data();
+		rig.matrix = matrices.data();
+		rig.IBMs = IBMs.data();
+	}
+	// a decompression sample, raw is the known-good output
+	struct CompressedSample
+	{
+		string name;
+		vector<byte> compressed;
+		vector<byte> raw;
+	};
+
+	bool ReadBytes(const std::filesystem::path& path, vector<byte>& data)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		data.resize(std::filesystem::file_size(path));
+		return bool(file.read((char*)data.data(), data.size()));
+	}
+	bool WriteBytes(const std::filesystem::path& path, const vector<byte>& data)
+	{
+		std::ofstream file(path, std::ios::binary);
+		return bool(file.write((const char*)data.data(), data.size()));
+	}
+
+	// <name>.cmp with its decompressed <name>.raw next to it
+	bool ReadSamples(const std::filesystem::path& dir, vector<CompressedSample>& cases)
+	{
+		std::error_code ec;
+		for (const auto& item : std::filesystem::directory_iterator(dir, ec))
+		{
+			if (item.path().extension() != ".cmp")
+				continue;
+			CompressedSample sample;
+			sample.name = item.path().stem().string();
+			if (!ReadBytes(item.path(), sample.compressed) || !ReadBytes(std::filesystem::path(item.path()).replace_extension(".raw"), sample.raw))
+			{
+				Utils::Logger::Error(("  " + sample.name + ": .cmp without a readable .raw\n").c_str());
+				return false;
+			}
+			cases.push_back(std::move(sample));
+		}
+		if (ec)
+		{
+			Utils::Logger::Error(("\nFailed to read " + dir.string()).c_str());
+			return false;
+		}
+		return true;
+	}
+
+	// checked-in pairs written by samples/oodle/make_samples.py, next to the sources when built with CMake
+	std::filesystem::path BuiltinSamples()
+	{
+#ifdef GOWTOOL_SAMPLES_DIR
+		return std::filesystem::path(GOWTOOL_SAMPLES_DIR);
+#else
+		return std::filesystem::current_path() / "samples" / "oodle";
+#endif
+	}
+
+	// words and slowly changing 16 bit values, compresses about like game data does
+	vector<byte> SyntheticPayload(size_t size)
+	{
+		static const char* words[] = { "wad", "texpack", "gnf", "mesh", "rig", "lodpack", "mg", "smsh", "bone", "joint" };
+		std::mt19937 rng(7);
+		vector<byte> data;
+		data.reserve(size + 64);
+		uint16_t value = 0;
+		while (data.size() < size)
+		{
+			if (rng() % 4 == 0)
+			{
+				const char* word = words[rng() % std::size(words)];
+				data.insert(data.end(), word, word + strlen(word));
+				data.push_back(byte('_' + rng() % 2));
+			}
+			else
+			{
+				for (int i = 0; i < 8; i++)
+				{
+					value += uint16_t(rng() % 17) - 8;
+					data.push_back(byte(value));
+					data.push_back(byte(value >> 8));
+				}
+			}
+		}
+		data.resize(size);
+		return data;
+	}
+}
+
+namespace Bench
+{
+	bool GnfSwizzle(size_t iterations)
+	{
+		struct Case
+		{
+			const char* name;
+			uint16_t w;
+			uint16_t h;
+			uint16_t bpp;
+			uint16_t pixbl;
+		};
+		// sizes as they reach the kernels, pitch and height padded to a power of two
+		const Case cases[] =
+		{
+			{ "BC7 4096x4096", 4096, 4096, 8, 4 },
+			{ "BC1 4096x4096", 4096, 4096, 4, 4 },
+			{ "BC5 1024x1024", 1024, 1024, 8, 4 },
+			{ "R8 2048x2048", 2048, 2048, 8, 1 },
+			{ "BC7 32x32", 32, 32, 8, 4 },
+			{ "BC1 40x24", 40, 24, 4, 4 }, // partial tiles
+		};
+		iterations = std::max<size_t>(iterations, 1);
+
+		bool result = true;
+		std::mt19937 rng(0x474E46);
+		cout << "\nGNF swizzle, " << iterations << " iterations\n";
+		for (const Case& c : cases)
+		{
+			const size_t size = size_t(c.w) * c.h * c.bpp / 8;
+			// swizzled data always holds whole 8x8 tiles of elements
+			const size_t tiles = ((c.w / c.pixbl + 7) / 8) * ((c.h / c.pixbl + 7) / 8);
+			vector<byte> src(std::max(size, tiles * 64 * Gnf::GnfImage::ElementSize(c.bpp, c.pixbl)));
+			for (byte& b : src)
+			{
+				b = byte(rng());
+			}
+			vector<byte> expected(size);
+			vector<byte> actual(size);
+
+			ReferenceUnSwizzle(src.data(), expected.data(), c.w, c.h, c.bpp, c.pixbl);
+			Gnf::GnfImage::UnSwizzle(src.data(), actual.data(), c.w, c.h, c.bpp, c.pixbl);
+			if (expected != actual)
+			{
+				Utils::Logger::Error((string("  ") + c.name + " unswizzle output differs from the reference\n").c_str());
+				result = false;
+				continue;
+			}
+			double referenceMs = TimeMs(ReferenceUnSwizzle, src.data(), expected.data(), c.w, c.h, c.bpp, c.pixbl, iterations);
+			double kernelMs = TimeMs(Gnf::GnfImage::UnSwizzle, src.data(), actual.data(), c.w, c.h, c.bpp, c.pixbl, iterations);
+			Report(c.name, "unswizzle", size, referenceMs, kernelMs);
+
+			ReferenceSwizzle(src.data(), expected.data(), c.w, c.h, c.bpp, c.pixbl);
+			Gnf::GnfImage::Swizzle(src.data(), actual.data(), c.w, c.h, c.bpp, c.pixbl);
+			if (expected != actual)
+			{
+				Utils::Logger::Error((string("  ") + c.name + " swizzle output differs from the reference\n").c_str());
+				result = false;
+				continue;
+			}
+			referenceMs = TimeMs(ReferenceSwizzle, src.data(), expected.data(), c.w, c.h, c.bpp, c.pixbl, iterations);
+			kernelMs = TimeMs(Gnf::GnfImage::Swizzle, src.data(), actual.data(), c.w, c.h, c.bpp, c.pixbl, iterations);
+			Report(c.name, "swizzle", size, referenceMs, kernelMs);
+		}
+		return result;
+	}
+
+	bool MeshDefinitions(const std::filesystem::path& wadpath, size_t iterations)
+	{
+		struct Entry
+		{
+			uint32_t index;
+			bool smsh;
+			std::span<const uint8_t> data;
+		};
+		iterations = std::max<size_t>(iterations, 1);
+
+		WadFile wad;
+		if (!wad.Map(wadpath))
+		{
+			Utils::Logger::Error(("\nFailed to map " + wadpath.string()).c_str());
+			return false;
+		}
+		// the same entries the mesh exporters parse
+		vector<Entry> entries;
+		for (uint32_t i : wad.GetEntries(WadFile::FileType::SkinnedMeshDef))
+			entries.push_back({ i, false, wad.GetView(i) });
+		for (uint32_t i : wad.GetEntries(WadFile::FileType::RigidMeshDefData))
+		{
+			if (wad._FileEntries[i].name.find("smsh_data") != std::string::npos)
+				entries.push_back({ i, true, wad.GetView(i) });
+		}
+		if (entries.empty())
+		{
+			Utils::Logger::Error(("\nNo mesh definitions in " + wadpath.string()).c_str());
+			return false;
+		}
+
+		MGDefinition mg;
+		SmshDefinition smsh;
+		auto parse = [&](const Entry& entry)
+		{
+			return entry.smsh ? smsh.ReadSmsh(entry.data) : mg.ReadMG(entry.data);
+		};
+		// the old exporters copied each entry into a stringstream before parsing it
+		auto parseReference = [](const Entry& entry)
+		{
+			std::stringstream stream;
+			stream.write((const char*)entry.data.data(), entry.data.size());
+			return entry.smsh ? ReferenceReadSmsh(stream) : ReferenceReadMG(stream);
+		};
+
+		bool result = true;
+		size_t meshes = 0;
+		for (const Entry& entry : entries)
+		{
+			vector<MeshInfo> actual;
+			try
+			{
+				actual = parse(entry);
+			}
+			catch (const std::exception& e)
+			{
+				Utils::Logger::Error(("  " + wad._FileEntries[entry.index].name + ": " + e.what() + "\n").c_str());
+				result = false;
+				continue;
+			}
+			vector<MeshInfo> expected = parseReference(entry);
+			meshes += actual.size();
+			bool same = actual.size() == expected.size();
+			for (size_t m = 0; same && m < actual.size(); m++)
+				same = SameMeshInfo(actual[m], expected[m]);
+			if (!same)
+			{
+				Utils::Logger::Error(("  " + wad._FileEntries[entry.index].name + " differs from the reference\n").c_str());
+				result = false;
+			}
+		}
+		if (!result)
+			return false;
+
+		auto time = [&](auto&& func)
+		{
+			auto start = Clock::now();
+			for (size_t i = 0; i < iterations; i++)
+			{
+				for (const Entry& entry : entries)
+					func(entry);
+			}
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+		};
+		double referenceMs = time(parseReference);
+		double parserMs = time(parse);
+
+		cout << "\nMesh definitions, " << entries.size() << " entries, " << meshes << " meshes, " << iterations << " iterations\n";
+		char line[160];
+		snprintf(line, sizeof(line), "  reference %8.2f ms  %10.0f entries/s\n  parser    %8.2f ms  %10.0f entries/s  x%.1f\n",
+			referenceMs, entries.size() / (referenceMs / 1000.0), parserMs, entries.size() / (parserMs / 1000.0), referenceMs / parserMs);
+		cout << line;
+		return true;
+	}
+	bool GlbExport(size_t iterations)
+	{
+		const uint32_t meshCount = 8;
+		const uint32_t vertCount = 60000;
+		const uint16_t boneCount = 96;
+		iterations = std::max<size_t>(iterations, 1);
+
+		SyntheticModel model(meshCount, vertCount, boneCount);
+		const vector<RawMeshContainer>& meshes = model.meshes;
+		const Rig& rig = model.rig;
+
+		std::filesystem::path dir = std::filesystem::temp_directory_path();
+		std::filesystem::path referencePath = dir / "gowtool_bench_sdk.glb";
+		std::filesystem::path directPath = dir / "gowtool_bench_direct.glb";
+		std::filesystem::path quantizedPath = dir / "gowtool_bench_quantized.glb";
+		auto writeDirect = [](const std::filesystem::path& path, const vector<RawMeshContainer>& meshes, const Rig& rig)
+		{
+			WriteGLB(path, meshes, rig);
+		};
+		auto writeQuantized = [](const std::filesystem::path& path, const vector<RawMeshContainer>& meshes, const Rig& rig)
+		{
+			WriteGLB(path, meshes, rig, true);
+		};
+		bool result = true;
+		try
+		{
+			WriteGLTF(referencePath, meshes, rig);
+			writeDirect(directPath, meshes, rig);
+			writeQuantized(quantizedPath, meshes, rig);
+			if (!SameGlb(ReadGlb(referencePath), ReadGlb(directPath)))
+			{
+				Utils::Logger::Error("  GLB written directly differs from the glTF SDK output\n");
+				result = false;
+			}
+			if (!CheckQuantizedGlb(ReadGlb(quantizedPath), meshes, model.sourcePositions, model.sourceTexcoords))
+			{
+				Utils::Logger::Error("  quantized GLB doesn't match the source encodings\n");
+				result = false;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			Utils::Logger::Error((string("  GLB export failed: ") + e.what() + "\n").c_str());
+			result = false;
+		}
+		if (result)
+		{
+			auto time = [&](auto&& write, const std::filesystem::path& path)
+			{
+				auto start = Clock::now();
+				for (size_t i = 0; i < iterations; i++)
+					write(path, meshes, rig);
+				return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+			};
+			double referenceMs = time(WriteGLTF, referencePath);
+			double directMs = time(writeDirect, directPath);
+			double quantizedMs = time(writeQuantized, quantizedPath);
+			size_t size = std::filesystem::file_size(directPath);
+			size_t quantizedSize = std::filesystem::file_size(quantizedPath);
+
+			cout << "\nGLB export, " << meshCount << " meshes of " << vertCount << " vertices, " << iterations << " iterations\n";
+			char line[256];
+			snprintf(line, sizeof(line), "  glTF SDK  %8.2f ms  %8.1f MB/s  %6.1f MB\n  direct    %8.2f ms  %8.1f MB/s  %6.1f MB  x%.1f\n  quantized %8.2f ms  %8.1f MB/s  %6.1f MB  %.0f%% of the size\n",
+				referenceMs, size / (referenceMs * 1000.0), size / 1048576.0, directMs, size / (directMs * 1000.0), size / 1048576.0, referenceMs / directMs,
+				quantizedMs, quantizedSize / (quantizedMs * 1000.0), quantizedSize / 1048576.0, 100.0 * quantizedSize / size);
+			cout << line;
+		}
+		std::error_code ec;
+		std::filesystem::remove(referencePath, ec);
+		std::filesystem::remove(directPath, ec);
+		std::filesystem::remove(quantizedPath, ec);
+		return result;
+	}
+
+	bool Decompression(const std::filesystem::path& samples, size_t iterations)
+	{
+		iterations = std::max<size_t>(iterations, 1);
+		std::unique_ptr<Oodle::Decompressor> builtin = Oodle::Create(Oodle::Backend::Builtin);
+		std::unique_ptr<Oodle::Decompressor> library = Oodle::Create(Oodle::Backend::Library);
+		vector<CompressedSample> cases;
+
+		// the built-in samples always run, so a broken decoder can't pass without the library
+		std::filesystem::path builtinSamples = BuiltinSamples();
+		if (!ReadSamples(builtinSamples, cases))
+			return false;
+		if (cases.empty())
+		{
+			Utils::Logger::Error(("\nNo .cmp/.raw pairs in " + builtinSamples.string() + "\n").c_str());
+			return false;
+		}
+		if (!samples.empty())
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(samples, ec);
+			if (!std::filesystem::equivalent(samples, builtinSamples, ec) && !ReadSamples(samples, cases))
+				return false;
+		}
+
+		// with the library, compress a synthetic payload per codec and keep the result as a sample
+		if (library)
+		{
+			const struct { const char* name; int codec; } codecs[] = { { "kraken", 8 }, { "mermaid", 9 }, { "selkie", 11 } };
+			vector<byte> payload = SyntheticPayload(8 << 20);
+			for (const auto& codec : codecs)
+			{
+				string name = string("synthetic_") + codec.name;
+				if (std::any_of(cases.begin(), cases.end(), [&](const CompressedSample& c) { return c.name == name; }))
+					continue;
+				CompressedSample sample{ name, vector<byte>(payload.size() + payload.size() / 8 + 0x10000), payload };
+				int size = OodLZ_Compress(codec.codec, sample.raw.data(), sample.raw.size(), sample.compressed.data(), 4, NULL, 0, 0, NULL, 0);
+				if (size <= 0)
+				{
+					Utils::Logger::Error(("  " + name + ": compression failed\n").c_str());
+					return false;
+				}
+				sample.compressed.resize(size);
+				if (!samples.empty())
+				{
+					WriteBytes(samples / (name + ".cmp"), sample.compressed);
+					WriteBytes(samples / (name + ".raw"), sample.raw);
+				}
+				cases.push_back(std::move(sample));
+			}
+		}
+
+		// both backends have to give the known-good bytes before anything is timed, the
+		// built-in one also with the pool so the reset segments are decoded in parallel
+		ThreadPool pool;
+		bool result = true;
+		size_t totalSize = 0;
+		vector<vector<byte>> outputs(cases.size());
+		for (size_t i = 0; i < cases.size(); i++)
+		{
+			const CompressedSample& sample = cases[i];
+			outputs[i].resize(sample.raw.size() + SAFE_SPACE);
+			totalSize += sample.raw.size();
+			const struct { const Oodle::Decompressor* backend; ThreadPool* threads; const char* mode; } runs[] = {
+				{ builtin.get(), nullptr, "serial" }, { builtin.get(), &pool, "parallel" }, { library.get(), nullptr, "serial" } };
+			for (const auto& run : runs)
+			{
+				if (!run.backend)
+					continue;
+				memset(outputs[i].data(), 0, outputs[i].size());
+				if (!run.backend->Decompress(sample.compressed.data(), sample.compressed.size(), outputs[i].data(), sample.raw.size(), run.threads)
+					|| memcmp(outputs[i].data(), sample.raw.data(), sample.raw.size()) != 0)
+				{
+					Utils::Logger::Error(("  " + sample.name + ": " + run.backend->Name() + " " + run.mode + " output differs from the sample\n").c_str());
+					result = false;
+				}
+			}
+		}
+		if (!result)
+			return false;
+
+		auto time = [&](auto&& func)
+		{
+			auto start = Clock::now();
+			for (size_t i = 0; i < iterations; i++)
+				func();
+			return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+		};
+		cout << "\nDecompression, " << cases.size() << " samples, " << (library ? "" : "no oo2core library, ") << iterations << " iterations\n";
+		for (size_t i = 0; i < cases.size(); i++)
+		{
+			const CompressedSample& sample = cases[i];
+			auto decode = [&](const Oodle::Decompressor& backend, ThreadPool* threads)
+			{
+				return [&, threads]() { backend.Decompress(sample.compressed.data(), sample.compressed.size(), outputs[i].data(), sample.raw.size(), threads); };
+			};
+			double builtinMs = time(decode(*builtin, nullptr));
+			double parallelMs = time(decode(*builtin, &pool));
+			double libraryMs = library ? time(decode(*library, nullptr)) : builtinMs;
+			Report(sample.name.c_str(), "serial", sample.raw.size(), libraryMs, builtinMs);
+			Report(sample.name.c_str(), "resets", sample.raw.size(), libraryMs, parallelMs);
+		}
+
+		// every sample decoded at once, one stream per task
+		auto decodeAll = [&](const Oodle::Decompressor& backend)
+		{
+			vector<Oodle::Job> jobs;
+			for (size_t i = 0; i < cases.size(); i++)
+				jobs.push_back({ cases[i].compressed.data(), cases[i].compressed.size(), outputs[i].data(), cases[i].raw.size(), false });
+			return [&, jobs]() mutable
+			{
+				if (!Oodle::DecompressAll(backend, jobs, pool))
+					result = false;
+			};
+		};
+		double builtinBatchMs = time(decodeAll(*builtin));
+		double libraryBatchMs = library ? time(decodeAll(*library)) : builtinBatchMs;
+		Report("all samples", "batch", totalSize, libraryBatchMs, builtinBatchMs);
+		if (!result)
+			Utils::Logger::Error("  batch decompression failed\n");
+		return result;
+	}
+
+#ifdef GOWTOOL_NO_FBXSDK
+	bool FbxExport(size_t /*iterations*/)
+	{
+		Utils::Logger::Warning("\nFBX export needs the FBX SDK as reference, skipped in this build\n");
+		return true;
+	}
+#else
+	bool FbxExport(size_t iterations)
+	{
+		const uint32_t meshCount = 8;
+		const uint32_t vertCount = 30000;
+		const uint16_t boneCount = 96;
+		iterations = std::max<size_t>(iterations, 1);
+
+		SyntheticModel model(meshCount, vertCount, boneCount);
+		const vector<RawMeshContainer>& meshes = model.meshes;
+		const Rig& rig = model.rig;
+
+		std::filesystem::path dir = std::filesystem::temp_directory_path();
+		std::filesystem::path referencePath = dir / "gowtool_bench_sdk.fbx";
+		std::filesystem::path nativePath = dir / "gowtool_bench_native.fbx";
+		bool result = true;
+		try
+		{
+			writeFbx(referencePath, meshes, rig);
+			WriteFbxNative(nativePath, meshes, rig);
+			// both files are read back through the SDK importer and have to give the same scene
+			std::unique_ptr<FbxManager, void(*)(FbxManager*)> manager(FbxManager::Create(), [](FbxManager* m) { m->Destroy(); });
+			manager->SetIOSettings(FbxIOSettings::Create(manager.get(), IOSROOT));
+			FbxSceneData reference = ReadFbxScene(manager.get(), referencePath);
+			FbxSceneData native = ReadFbxScene(manager.get(), nativePath);
+			if (reference.meshes.size() != meshCount || !SameFbxScene(reference, native))
+			{
+				Utils::Logger::Error("  FBX written natively differs from the FBX SDK output\n");
+				result = false;
+			}
+		}
+		catch (const std::exception& e)
+		{
+			Utils::Logger::Error((string("  FBX export failed: ") + e.what() + "\n").c_str());
+			result = false;
+		}
+		if (result)
+		{
+			auto time = [&](auto&& write, const std::filesystem::path& path)
+			{
+				auto start = Clock::now();
+				for (size_t i = 0; i < iterations; i++)
+					write(path, meshes, rig);
+				return std::chrono::duration<double, std::milli>(Clock::now() - start).count() / iterations;
+			};
+			double referenceMs = time(writeFbx, referencePath);
+			double nativeMs = time(WriteFbxNative, nativePath);
+			size_t referenceSize = std::filesystem::file_size(referencePath);
+			size_t nativeSize = std::filesystem::file_size(nativePath);
+
+			cout << "\nFBX export, " << meshCount << " meshes of " << vertCount << " vertices, " << iterations << " iterations\n";
+			char line[256];
+			snprintf(line, sizeof(line), "  FBX SDK   %8.2f ms  %8.1f MB/s  %6.1f MB\n  native    %8.2f ms  %8.1f MB/s  %6.1f MB  x%.1f\n",
+				referenceMs, referenceSize / (referenceMs * 1000.0), referenceSize / 1048576.0,
+				nativeMs, nativeSize / (nativeMs * 1000.0), nativeSize / 1048576.0, referenceMs / nativeMs);
+			cout << line;
+		}
+		std::error_code ec;
+		std::filesystem::remove(referencePath, ec);
+		std::filesystem::remove(nativePath, ec);
+		return result;
+	}
+#endif
+}
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include "pch.h"
+#include "BuildManifest.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t ManifestMagic = 0x4D425747; // GWBM
+	constexpr uint32_t ManifestVersion = 1;
+
+	struct ManifestHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t recordCount;
+		uint64_t stringsSize;
+	};
+	struct OutputRecord
+	{
+		uint64_t pathOff;
+		uint32_t pathSize;
+		uint32_t reserved;
+		uint64_t packKey;
+		uint64_t entryHash;
+		uint64_t toolKey;
+		uint64_t size;
+	};
+	static_assert(sizeof(ManifestHeader) == 0x18 && sizeof(OutputRecord) == 0x30);
+}
+
+bool BuildManifest::Open(const std::filesystem::path& manifestPath, const std::filesystem::path& outdir)
+{
+	_path = manifestPath;
+	_outdir = outdir;
+	_records.clear();
+	_dirty = false;
+
+	MappedFile mapping;
+	if (!mapping.Open(manifestPath))
+		return false;
+	auto headerView = mapping.GetView(0, sizeof(ManifestHeader));
+	if (headerView.empty())
+		return false;
+	ManifestHeader header;
+	memcpy(&header, headerView.data(), sizeof(header));
+	if (header.magic != ManifestMagic || header.version != ManifestVersion)
+		return false;
+
+	uint64_t recordsOff = sizeof(ManifestHeader);
+	uint64_t stringsOff = recordsOff + header.recordCount * sizeof(OutputRecord);
+	auto recordsView = mapping.GetView(recordsOff, header.recordCount * sizeof(OutputRecord));
+	auto stringsView = mapping.GetView(stringsOff, header.stringsSize);
+	if ((header.recordCount && recordsView.empty()) || (header.stringsSize && stringsView.empty()))
+		return false;
+
+	const char* strings = (const char*)stringsView.data();
+	_records.reserve(header.recordCount);
+	for (uint64_t i = 0; i < header.recordCount; i++)
+	{
+		OutputRecord record;
+		memcpy(&record, recordsView.data() + i * sizeof(OutputRecord), sizeof(record));
+		if (record.pathOff > header.stringsSize || record.pathSize > header.stringsSize - record.pathOff)
+		{
+			_records.clear();
+			return false;
+		}
+		_records[string(strings + record.pathOff, record.pathSize)] = Entry{ record.packKey, record.entryHash, record.toolKey, record.size };
+	}
+	return true;
+}
+
+uint64_t BuildManifest::ToolKey(BuildOutput output)
+{
+	return (uint64_t(output) << 32) | BuildVersion(output);
+}
+
+string BuildManifest::Key(const std::filesystem::path& output) const
+{
+	auto str = output.lexically_relative(_outdir).generic_u8string();
+	return string(str.begin(), str.end());
+}
+
+bool BuildManifest::IsUpToDate(const std::filesystem::path& output, const Inputs& inputs) const
+{
+	uint64_t size = 0;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		auto it = _records.find(Key(output));
+		if (it == _records.end())
+			return false;
+		const Entry& record = it->second;
+		if (record.packKey != inputs.packKey || record.entryHash != inputs.entryHash || record.toolKey != ToolKey(inputs.output))
+			return false;
+		size = record.size;
+	}
+	std::error_code ec;
+	return std::filesystem::file_size(output, ec) == size && !ec;
+}
+
+void BuildManifest::Record(const std::filesystem::path& output, const Inputs& inputs)
+{
+	std::error_code ec;
+	uint64_t size = std::filesystem::file_size(output, ec);
+	if (ec)
+	{
+		Forget(output);
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_mutex);
+	_records[Key(output)] = Entry{ inputs.packKey, inputs.entryHash, ToolKey(inputs.output), size };
+	_dirty = true;
+}
+
+void BuildManifest::Forget(const std::filesystem::path& output)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (_records.erase(Key(output)))
+		_dirty = true;
+}
+
+bool BuildManifest::Save()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	if (!_dirty)
+		return true;
+
+	// sorted so the file only depends on its contents
+	vector<const std::pair<const string, Entry>*> sorted;
+	sorted.reserve(_records.size());
+	for (const auto& record : _records)
+		sorted.push_back(&record);
+	std::sort(sorted.begin(), sorted.end(), [](auto a, auto b) { return a->first < b->first; });
+
+	ManifestHeader header{};
+	header.magic = ManifestMagic;
+	header.version = ManifestVersion;
+	header.recordCount = sorted.size();
+
+	string strings;
+	vector<OutputRecord> records;
+	records.reserve(sorted.size());
+	for (auto entry : sorted)
+	{
+		OutputRecord record{};
+		record.pathOff = strings.size();
+		record.pathSize = static_cast<uint32_t>(entry->first.size());
+		record.packKey = entry->second.packKey;
+		record.entryHash = entry->second.entryHash;
+		record.toolKey = entry->second.toolKey;
+		record.size = entry->second.size;
+		records.push_back(record);
+		strings += entry->first;
+	}
+	header.stringsSize = strings.size();
+
+	std::filesystem::path tmpPath = _path;
+	tmpPath += ".tmp";
+	ofstream ofs(tmpPath.string(), ios::out | ios::binary);
+	if (!ofs.is_open())
+		return false;
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write((const char*)records.data(), records.size() * sizeof(OutputRecord));
+	ofs.write(strings.data(), strings.size());
+	ofs.close();
+	if (ofs.fail())
+		return false;
+
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, _path, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	_dirty = false;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,405 @@
+#include "pch.h"
+#include "Catalog.h"
+#include "utils.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t CatalogMagic = 0x54435747; // GWCT
+	constexpr uint32_t CatalogVersion = 2;
+
+	struct CatalogHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t packCount;
+		uint32_t gamedirSize;
+		uint64_t entryCount;
+		uint64_t stringsSize;
+		int64_t gamedirMtime;
+	};
+	struct PackRecord
+	{
+		uint64_t pathOff;
+		uint32_t pathSize;
+		Catalog::PackType type;
+		uint64_t fileSize;
+		int64_t mtime;
+		uint64_t firstEntry;
+		uint64_t entryCount;
+	};
+	static_assert(sizeof(CatalogHeader) == 0x28 && sizeof(PackRecord) == 0x30 && sizeof(Catalog::Entry) == 0x18);
+
+	string ToUtf8(const std::filesystem::path& path)
+	{
+		auto str = path.generic_u8string();
+		return string(str.begin(), str.end());
+	}
+	std::filesystem::path FromUtf8(const string& str)
+	{
+		return std::filesystem::path(std::u8string(str.begin(), str.end()));
+	}
+
+	bool ReadFingerprint(const std::filesystem::path& filepath, uint64_t& fileSize, int64_t& mtime)
+	{
+		std::error_code ec;
+		fileSize = std::filesystem::file_size(filepath, ec);
+		if (ec)
+			return false;
+		mtime = std::filesystem::last_write_time(filepath, ec).time_since_epoch().count();
+		return !ec;
+	}
+	int64_t ReadMtime(const std::filesystem::path& path)
+	{
+		std::error_code ec;
+		int64_t mtime = std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+		return ec ? 0 : mtime;
+	}
+}
+
+bool Catalog::Open(const std::filesystem::path& catalogPath, const std::filesystem::path& gamedir, std::span<const PackType> types,
+	std::span<const std::filesystem::path> files, bool rescan)
+{
+	_gamedir = gamedir;
+	bool loaded = !rescan && Load(catalogPath, gamedir);
+	if (!loaded)
+	{
+		_mapping.Close();
+		_packs.clear();
+	}
+	int64_t gamedirMtime = ReadMtime(gamedir);
+	if (!loaded || gamedirMtime != _gamedirMtime)
+	{
+		// packs were added or removed, or there is no catalog yet
+		_gamedirMtime = gamedirMtime;
+		_dirty = true;
+		Walk();
+		for (Pack& pack : _packs)
+		{
+			if (!Refresh(pack))
+				pack.path.clear();
+		}
+	}
+	else
+	{
+		vector<string> paths;
+		for (const std::filesystem::path& file : files)
+			paths.push_back(ToUtf8(file.lexically_relative(_gamedir)));
+		for (Pack& pack : _packs)
+		{
+			bool needed = std::find(types.begin(), types.end(), pack.type) != types.end()
+				|| std::find(paths.begin(), paths.end(), pack.path) != paths.end();
+			if (needed && !Refresh(pack))
+				pack.path.clear();
+		}
+	}
+	std::erase_if(_packs, [](const Pack& pack) { return pack.path.empty(); });
+
+	if (_dirty)
+	{
+		// detach from the old mapping so it can be replaced
+		for (Pack& pack : _packs)
+		{
+			if (pack.ownedEntries.empty() && !pack.entries.empty())
+			{
+				pack.ownedEntries.assign(pack.entries.begin(), pack.entries.end());
+				pack.entries = pack.ownedEntries;
+			}
+		}
+		_mapping.Close();
+		if (!Save(catalogPath))
+			Utils::Logger::Warning(("\nFailed to write catalog: " + catalogPath.string()).c_str());
+		_dirty = false;
+	}
+	return !_packs.empty();
+}
+
+bool Catalog::Refresh(Pack& pack)
+{
+	uint64_t fileSize = 0;
+	int64_t mtime = 0;
+	if (!ReadFingerprint(_gamedir / FromUtf8(pack.path), fileSize, mtime))
+	{
+		_dirty = true;
+		return false;
+	}
+	if (fileSize == pack.fileSize && mtime == pack.mtime)
+		return true;
+	pack.fileSize = fileSize;
+	pack.mtime = mtime;
+	_dirty = true;
+	return Scan(pack);
+}
+
+bool Catalog::Load(const std::filesystem::path& catalogPath, const std::filesystem::path& gamedir)
+{
+	if (!_mapping.Open(catalogPath))
+		return false;
+
+	auto headerView = _mapping.GetView(0, sizeof(CatalogHeader));
+	if (headerView.empty())
+		return false;
+	CatalogHeader header;
+	memcpy(&header, headerView.data(), sizeof(header));
+	if (header.magic != CatalogMagic || header.version != CatalogVersion)
+		return false;
+	_gamedirMtime = header.gamedirMtime;
+
+	uint64_t packsOff = sizeof(CatalogHeader);
+	uint64_t entriesOff = packsOff + uint64_t(header.packCount) * sizeof(PackRecord);
+	uint64_t stringsOff = entriesOff + header.entryCount * sizeof(Entry);
+	auto packsView = _mapping.GetView(packsOff, uint64_t(header.packCount) * sizeof(PackRecord));
+	auto entriesView = _mapping.GetView(entriesOff, header.entryCount * sizeof(Entry));
+	auto stringsView = _mapping.GetView(stringsOff, header.stringsSize);
+	if ((header.packCount && packsView.empty()) || (header.entryCount && entriesView.empty()) || header.gamedirSize > header.stringsSize)
+		return false;
+
+	const char* strings = (const char*)stringsView.data();
+	if (string(strings, header.gamedirSize) != ToUtf8(gamedir))
+		return false;
+
+	const PackRecord* records = (const PackRecord*)packsView.data();
+	const Entry* entries = (const Entry*)entriesView.data();
+	_packs.resize(header.packCount);
+	for (uint32_t i = 0; i < header.packCount; i++)
+	{
+		const PackRecord& record = records[i];
+		if (record.pathOff > header.stringsSize || record.pathSize > header.stringsSize - record.pathOff ||
+			record.firstEntry > header.entryCount || record.entryCount > header.entryCount - record.firstEntry)
+		{
+			_packs.clear();
+			return false;
+		}
+		Pack& pack = _packs[i];
+		pack.path = string(strings + record.pathOff, record.pathSize);
+		pack.type = record.type;
+		pack.fileSize = record.fileSize;
+		pack.mtime = record.mtime;
+		pack.entries = std::span<const Entry>(entries + record.firstEntry, record.entryCount);
+	}
+	return true;
+}
+
+bool Catalog::Save(const std::filesystem::path& catalogPath) const
+{
+	CatalogHeader header{};
+	header.magic = CatalogMagic;
+	header.version = CatalogVersion;
+	header.packCount = static_cast<uint32_t>(_packs.size());
+	header.gamedirMtime = _gamedirMtime;
+
+	string strings = ToUtf8(_gamedir);
+	header.gamedirSize = static_cast<uint32_t>(strings.size());
+
+	vector<PackRecord> records;
+	records.reserve(_packs.size());
+	for (const Pack& pack : _packs)
+	{
+		PackRecord record{};
+		record.pathOff = strings.size();
+		record.pathSize = static_cast<uint32_t>(pack.path.size());
+		record.type = pack.type;
+		record.fileSize = pack.fileSize;
+		record.mtime = pack.mtime;
+		record.firstEntry = header.entryCount;
+		record.entryCount = pack.entries.size();
+		records.push_back(record);
+		strings += pack.path;
+		header.entryCount += pack.entries.size();
+	}
+	header.stringsSize = strings.size();
+
+	std::filesystem::path tmpPath = catalogPath;
+	tmpPath += ".tmp";
+	ofstream ofs(tmpPath.string(), ios::out | ios::binary);
+	if (!ofs.is_open())
+		return false;
+	ofs.write((const char*)&header, sizeof(header));
+	ofs.write((const char*)records.data(), records.size() * sizeof(PackRecord));
+	for (const Pack& pack : _packs)
+	{
+		ofs.write((const char*)pack.entries.data(), pack.entries.size_bytes());
+	}
+	ofs.write(strings.data(), strings.size());
+	ofs.close();
+	if (ofs.fail())
+		return false;
+
+	std::error_code ec;
+	std::filesystem::rename(tmpPath, catalogPath, ec);
+	if (ec)
+	{
+		std::filesystem::remove(tmpPath, ec);
+		return false;
+	}
+	// a catalog in the game dir itself changes its mtime, store the new one in place
+	// so the next run doesn't take that for added packs
+	if (std::filesystem::equivalent(catalogPath.parent_path(), _gamedir, ec))
+	{
+		header.gamedirMtime = ReadMtime(_gamedir);
+		std::fstream fs(catalogPath, ios::in | ios::out | ios::binary);
+		fs.write((const char*)&header, sizeof(header));
+		return bool(fs);
+	}
+	return true;
+}
+
+bool Catalog::Scan(Pack& pack) const
+{
+	std::filesystem::path filepath = _gamedir / FromUtf8(pack.path);
+	pack.ownedEntries.clear();
+	switch (pack.type)
+	{
+	case PackType::Wad:
+		break;
+	case PackType::Lodpack:
+	{
+		if (pack.fileSize < 0x10)
+			return false;
+		Lodpack lodpack(filepath.string());
+		pack.ownedEntries.reserve(lodpack.TotalmembersCount);
+		for (uint32_t e = 0; e < lodpack.TotalmembersCount; e++)
+		{
+			uint32_t group = lodpack.memberGroupIndex[e];
+			if (group >= lodpack.groupCount)
+				continue;
+			Entry entry;
+			entry.hash = lodpack.memberHash[e];
+			entry.offset = (uint64_t)lodpack.memberOffsetter[e] + lodpack.groupStartOff[group];
+			entry.size = lodpack.memberBlockSize[e];
+			entry.group = group;
+			pack.ownedEntries.push_back(entry);
+		}
+		break;
+	}
+	case PackType::Texpack:
+	{
+		if (pack.fileSize < 0x38)
+			return false;
+		Texpack texpack(filepath);
+		pack.ownedEntries.reserve(texpack._TexsCount);
+		for (uint32_t i = 0; i < texpack._TexsCount; i++)
+		{
+			Entry entry;
+			entry.hash = texpack._texInfos[i]._fileHash;
+			entry.offset = texpack._texInfos[i]._blockInfoOff;
+			entry.size = 0;
+			entry.group = i;
+			pack.ownedEntries.push_back(entry);
+		}
+		break;
+	}
+	default:
+		return false;
+	}
+	pack.entries = pack.ownedEntries;
+	return true;
+}
+
+void Catalog::Walk()
+{
+	// only lists the dir, known packs get their fingerprint checked by Open
+	vector<Pack> added;
+	std::filesystem::recursive_directory_iterator dir(_gamedir);
+	for (const std::filesystem::directory_entry& entry : dir)
+	{
+		if (!entry.is_regular_file())
+			continue;
+		Pack pack;
+		std::string ext = Utils::str_tolower(entry.path().extension().string());
+		if (ext == ".wad")
+			pack.type = PackType::Wad;
+		else if (ext == ".lodpack")
+			pack.type = PackType::Lodpack;
+		else if (ext == ".texpack")
+			pack.type = PackType::Texpack;
+		else
+			continue;
+		pack.path = ToUtf8(std::filesystem::relative(entry.path(), _gamedir));
+		// packs are sorted by path
+		auto it = std::lower_bound(_packs.begin(), _packs.end(), pack.path, [](const Pack& pack, const string& path) { return pack.path < path; });
+		if (it != _packs.end() && it->path == pack.path)
+			continue;
+		// fingerprint is left empty so Refresh scans the pack
+		pack.fileSize = 0;
+		pack.mtime = 0;
+		added.push_back(std::move(pack));
+	}
+	if (added.empty())
+		return;
+	for (Pack& pack : added)
+		_packs.push_back(std::move(pack));
+	std::sort(_packs.begin(), _packs.end(), [](const Pack& a, const Pack& b) { return a.path < b.path; });
+	_dirty = true;
+}
+
+void Catalog::FillLodpacks(LodpackIndex& index) const
+{
+	size_t count = 0;
+	for (const Pack& pack : _packs)
+	{
+		if (pack.type == PackType::Lodpack)
+			count += pack.entries.size();
+	}
+	index.Reserve(count);
+	for (const Pack& pack : _packs)
+	{
+		if (pack.type != PackType::Lodpack)
+			continue;
+		uint32_t packIdx = index.AddPack(_gamedir / FromUtf8(pack.path));
+		for (const Entry& entry : pack.entries)
+		{
+			index.AddMember(entry.hash, LodpackIndex::Member{ packIdx, entry.group, entry.offset, entry.size });
+		}
+	}
+}
+
+void Catalog::FillTexpacks(TexpackIndex& index) const
+{
+	size_t count = 0;
+	for (const Pack& pack : _packs)
+	{
+		if (pack.type == PackType::Texpack)
+			count += pack.entries.size();
+	}
+	index.Reserve(count);
+	for (const Pack& pack : _packs)
+	{
+		if (pack.type != PackType::Texpack)
+			continue;
+		uint32_t packIdx = index.AddPack(_gamedir / FromUtf8(pack.path));
+		for (const Entry& entry : pack.entries)
+		{
+			index.AddTexture(entry.hash, packIdx);
+		}
+	}
+}
+
+vector<std::filesystem::path> Catalog::GetPacks(PackType type) const
+{
+	vector<std::filesystem::path> result;
+	for (const Pack& pack : _packs)
+	{
+		if (pack.type == type)
+			result.push_back(_gamedir / FromUtf8(pack.path));
+	}
+	return result;
+}
+
+uint64_t Catalog::GetFingerprint(const std::filesystem::path& filepath) const
+{
+	uint64_t fileSize = 0;
+	int64_t mtime = 0;
+	// packs are sorted by path
+	string path = ToUtf8(filepath.lexically_relative(_gamedir));
+	auto it = std::lower_bound(_packs.begin(), _packs.end(), path, [](const Pack& pack, const string& path) { return pack.path < path; });
+	if (it != _packs.end() && it->path == path)
+	{
+		fileSize = it->fileSize;
+		mtime = it->mtime;
+	}
+	else if (!ReadFingerprint(filepath, fileSize, mtime))
+		return 0;
+	return Utils::HashCombine(fileSize, uint64_t(mtime));
+}
\ No newline at end of file
@@ -0,0 +1,327 @@
+#include "pch.h"
+#include "Dds.h"
+#include <cstring>
+
+namespace Dds
+{
+	namespace
+	{
+		constexpr uint32_t Magic = 0x20534444; // "DDS "
+
+		constexpr uint32_t FourCC(char a, char b, char c, char d)
+		{
+			return uint32_t(uint8_t(a)) | (uint32_t(uint8_t(b)) << 8) | (uint32_t(uint8_t(c)) << 16) | (uint32_t(uint8_t(d)) << 24);
+		}
+
+		// DDS_PIXELFORMAT flags
+		constexpr uint32_t PixelFourCC = 0x4;
+		constexpr uint32_t PixelRGB = 0x40;
+		constexpr uint32_t PixelRGBA = 0x41;
+		constexpr uint32_t PixelLuminance = 0x20000;
+		constexpr uint32_t PixelLuminanceA = 0x20001;
+		constexpr uint32_t PixelBumpDuDv = 0x80000;
+		// DDS_HEADER flags and caps
+		constexpr uint32_t HeaderTexture = 0x1007;
+		constexpr uint32_t HeaderMipmap = 0x20000;
+		constexpr uint32_t HeaderPitch = 0x8;
+		constexpr uint32_t HeaderLinearSize = 0x80000;
+		constexpr uint32_t SurfaceTexture = 0x1000;
+		constexpr uint32_t SurfaceMipmap = 0x400008;
+		constexpr uint32_t DimensionTexture2D = 3;
+
+#pragma pack(push, 1)
+		struct PixelFormat
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t fourCC;
+			uint32_t bitCount;
+			uint32_t rMask;
+			uint32_t gMask;
+			uint32_t bMask;
+			uint32_t aMask;
+		};
+		struct Header
+		{
+			uint32_t size;
+			uint32_t flags;
+			uint32_t height;
+			uint32_t width;
+			uint32_t pitchOrLinearSize;
+			uint32_t depth;
+			uint32_t mipMapCount;
+			uint32_t reserved1[11];
+			PixelFormat pixelFormat;
+			uint32_t caps;
+			uint32_t caps2;
+			uint32_t caps3;
+			uint32_t caps4;
+			uint32_t reserved2;
+		};
+		struct HeaderDX10
+		{
+			uint32_t dxgiFormat;
+			uint32_t resourceDimension;
+			uint32_t miscFlag;
+			uint32_t arraySize;
+			uint32_t miscFlags2;
+		};
+#pragma pack(pop)
+		static_assert(sizeof(Header) == 124, "DDS header size mismatch");
+		static_assert(sizeof(HeaderDX10) == 20, "DDS DX10 header size mismatch");
+
+		constexpr PixelFormat FourCCFormat(uint32_t fourCC)
+		{
+			return { sizeof(PixelFormat), PixelFourCC, fourCC, 0, 0, 0, 0, 0 };
+		}
+		constexpr PixelFormat MaskFormat(uint32_t flags, uint32_t bitCount, uint32_t r, uint32_t g, uint32_t b, uint32_t a)
+		{
+			return { sizeof(PixelFormat), flags, 0, bitCount, r, g, b, a };
+		}
+
+		constexpr PixelFormat DX10 = FourCCFormat(FourCC('D', 'X', '1', '0'));
+		constexpr PixelFormat DXT1 = FourCCFormat(FourCC('D', 'X', 'T', '1'));
+		constexpr PixelFormat DXT2 = FourCCFormat(FourCC('D', 'X', 'T', '2'));
+		constexpr PixelFormat DXT3 = FourCCFormat(FourCC('D', 'X', 'T', '3'));
+		constexpr PixelFormat DXT4 = FourCCFormat(FourCC('D', 'X', 'T', '4'));
+		constexpr PixelFormat DXT5 = FourCCFormat(FourCC('D', 'X', 'T', '5'));
+		constexpr PixelFormat ATI1 = FourCCFormat(FourCC('A', 'T', 'I', '1'));
+		constexpr PixelFormat ATI2 = FourCCFormat(FourCC('A', 'T', 'I', '2'));
+		constexpr PixelFormat BC4U = FourCCFormat(FourCC('B', 'C', '4', 'U'));
+		constexpr PixelFormat BC4S = FourCCFormat(FourCC('B', 'C', '4', 'S'));
+		constexpr PixelFormat BC5U = FourCCFormat(FourCC('B', 'C', '5', 'U'));
+		constexpr PixelFormat BC5S = FourCCFormat(FourCC('B', 'C', '5', 'S'));
+		constexpr PixelFormat A8B8G8R8 = MaskFormat(PixelRGBA, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+		constexpr PixelFormat G16R16 = MaskFormat(PixelRGB, 32, 0x0000ffff, 0xffff0000, 0, 0);
+		constexpr PixelFormat A2B10G10R10 = MaskFormat(PixelRGBA, 32, 0x3ff00000, 0x000ffc00, 0x000003ff, 0xc0000000);
+		constexpr PixelFormat R5G6B5 = MaskFormat(PixelRGB, 16, 0xf800, 0x07e0, 0x001f, 0);
+		constexpr PixelFormat A1R5G5B5 = MaskFormat(PixelRGBA, 16, 0x7c00, 0x03e0, 0x001f, 0x8000);
+		constexpr PixelFormat A4R4G4B4 = MaskFormat(PixelRGBA, 16, 0x0f00, 0x00f0, 0x000f, 0xf000);
+		constexpr PixelFormat L8 = MaskFormat(PixelLuminance, 8, 0xff, 0, 0, 0);
+		constexpr PixelFormat L16 = MaskFormat(PixelLuminance, 16, 0xffff, 0, 0, 0);
+		constexpr PixelFormat A8L8 = MaskFormat(PixelLuminanceA, 16, 0x00ff, 0, 0, 0xff00);
+		constexpr PixelFormat V8U8 = MaskFormat(PixelBumpDuDv, 16, 0x00ff, 0xff00, 0, 0);
+		constexpr PixelFormat Q8W8V8U8 = MaskFormat(PixelBumpDuDv, 32, 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000);
+		constexpr PixelFormat V16U16 = MaskFormat(PixelBumpDuDv, 32, 0x0000ffff, 0xffff0000, 0, 0);
+
+		struct LegacyFormat
+		{
+			DxgiFormat format;
+			PixelFormat pixelFormat;
+		};
+		// dx9 pixel formats DirectXTex loads without converting the pixels
+		constexpr LegacyFormat LegacyFormats[] =
+		{
+			{ DXGI_FORMAT_BC1_UNORM, DXT1 },
+			{ DXGI_FORMAT_BC2_UNORM, DXT3 },
+			{ DXGI_FORMAT_BC3_UNORM, DXT5 },
+			{ DXGI_FORMAT_BC2_UNORM, DXT2 },
+			{ DXGI_FORMAT_BC3_UNORM, DXT4 },
+			{ DXGI_FORMAT_BC4_UNORM, BC4U },
+			{ DXGI_FORMAT_BC4_SNORM, BC4S },
+			{ DXGI_FORMAT_BC5_UNORM, BC5U },
+			{ DXGI_FORMAT_BC5_SNORM, BC5S },
+			{ DXGI_FORMAT_BC4_UNORM, ATI1 },
+			{ DXGI_FORMAT_BC5_UNORM, ATI2 },
+			{ DXGI_FORMAT_BC6H_UF16, FourCCFormat(FourCC('B', 'C', '6', 'H')) },
+			{ DXGI_FORMAT_BC7_UNORM, FourCCFormat(FourCC('B', 'C', '7', 'L')) },
+			{ DXGI_FORMAT_BC7_UNORM, FourCCFormat(FourCC('B', 'C', '7', '\0')) },
+			{ DXGI_FORMAT_R8G8B8A8_UNORM, A8B8G8R8 },
+			{ DXGI_FORMAT_R16G16_UNORM, G16R16 },
+			{ DXGI_FORMAT_R10G10B10A2_UNORM, A2B10G10R10 },
+			{ DXGI_FORMAT_B5G6R5_UNORM, R5G6B5 },
+			{ DXGI_FORMAT_B5G5R5A1_UNORM, A1R5G5B5 },
+			{ DXGI_FORMAT_B4G4R4A4_UNORM, A4R4G4B4 },
+			{ DXGI_FORMAT_R8_UNORM, L8 },
+			{ DXGI_FORMAT_R16_UNORM, L16 },
+			{ DXGI_FORMAT_R8G8_UNORM, A8L8 },
+			{ DXGI_FORMAT_R8G8_UNORM, MaskFormat(PixelLuminanceA, 8, 0x00ff, 0, 0, 0xff00) },
+			// written by old nvtt versions
+			{ DXGI_FORMAT_R8_UNORM, MaskFormat(PixelRGB, 8, 0xff, 0, 0, 0) },
+			{ DXGI_FORMAT_R16_UNORM, MaskFormat(PixelRGB, 16, 0xffff, 0, 0, 0) },
+			{ DXGI_FORMAT_R8G8_UNORM, MaskFormat(PixelRGBA, 16, 0x00ff, 0, 0, 0xff00) },
+			// D3DFMT values used as FourCC by D3DX
+			{ DXGI_FORMAT_R16G16B16A16_UNORM, FourCCFormat(36) },
+			{ DXGI_FORMAT_R16G16B16A16_SNORM, FourCCFormat(110) },
+			{ DXGI_FORMAT_R16_FLOAT, FourCCFormat(111) },
+			{ DXGI_FORMAT_R16G16_FLOAT, FourCCFormat(112) },
+			{ DXGI_FORMAT_R16G16B16A16_FLOAT, FourCCFormat(113) },
+			{ DXGI_FORMAT_R32_FLOAT, FourCCFormat(114) },
+			{ DXGI_FORMAT_R32G32_FLOAT, FourCCFormat(115) },
+			{ DXGI_FORMAT_R32G32B32A32_FLOAT, FourCCFormat(116) },
+			{ DXGI_FORMAT_R32_FLOAT, MaskFormat(PixelRGB, 32, 0xffffffff, 0, 0, 0) },
+			{ DXGI_FORMAT_R8G8_SNORM, V8U8 },
+			{ DXGI_FORMAT_R8G8B8A8_SNORM, Q8W8V8U8 },
+			{ DXGI_FORMAT_R16G16_SNORM, V16U16 },
+		};
+
+		// the dx9 pixel format DirectXTex writes with DDS_FLAGS_FORCE_DX9_LEGACY, false if there is none
+		bool GetLegacyPixelFormat(DxgiFormat format, PixelFormat& pixelFormat)
+		{
+			switch (format)
+			{
+			case DXGI_FORMAT_R8G8B8A8_UNORM:
+			case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: pixelFormat = A8B8G8R8; return true;
+			case DXGI_FORMAT_R16G16_UNORM: pixelFormat = G16R16; return true;
+			case DXGI_FORMAT_R8G8_UNORM: pixelFormat = A8L8; return true;
+			case DXGI_FORMAT_R16_UNORM: pixelFormat = L16; return true;
+			case DXGI_FORMAT_R8_UNORM: pixelFormat = L8; return true;
+			case DXGI_FORMAT_BC1_UNORM:
+			case DXGI_FORMAT_BC1_UNORM_SRGB: pixelFormat = DXT1; return true;
+			case DXGI_FORMAT_BC2_UNORM:
+			case DXGI_FORMAT_BC2_UNORM_SRGB: pixelFormat = DXT3; return true;
+			case DXGI_FORMAT_BC3_UNORM:
+			case DXGI_FORMAT_BC3_UNORM_SRGB: pixelFormat = DXT5; return true;
+			case DXGI_FORMAT_BC4_UNORM: pixelFormat = ATI1; return true;
+			case DXGI_FORMAT_BC4_SNORM: pixelFormat = BC4S; return true;
+			case DXGI_FORMAT_BC5_UNORM: pixelFormat = ATI2; return true;
+			case DXGI_FORMAT_BC5_SNORM: pixelFormat = BC5S; return true;
+			case DXGI_FORMAT_B5G6R5_UNORM: pixelFormat = R5G6B5; return true;
+			case DXGI_FORMAT_B5G5R5A1_UNORM: pixelFormat = A1R5G5B5; return true;
+			case DXGI_FORMAT_B4G4R4A4_UNORM: pixelFormat = A4R4G4B4; return true;
+			case DXGI_FORMAT_R8G8_SNORM: pixelFormat = V8U8; return true;
+			case DXGI_FORMAT_R8G8B8A8_SNORM: pixelFormat = Q8W8V8U8; return true;
+			case DXGI_FORMAT_R16G16_SNORM: pixelFormat = V16U16; return true;
+			case DXGI_FORMAT_R10G10B10A2_UNORM: pixelFormat = A2B10G10R10; return true;
+			case DXGI_FORMAT_R32G32B32A32_FLOAT: pixelFormat = FourCCFormat(116); return true;
+			case DXGI_FORMAT_R16G16B16A16_FLOAT: pixelFormat = FourCCFormat(113); return true;
+			case DXGI_FORMAT_R16G16B16A16_UNORM: pixelFormat = FourCCFormat(36); return true;
+			case DXGI_FORMAT_R16G16B16A16_SNORM: pixelFormat = FourCCFormat(110); return true;
+			case DXGI_FORMAT_R32G32_FLOAT: pixelFormat = FourCCFormat(115); return true;
+			case DXGI_FORMAT_R16G16_FLOAT: pixelFormat = FourCCFormat(112); return true;
+			case DXGI_FORMAT_R32_FLOAT: pixelFormat = FourCCFormat(114); return true;
+			case DXGI_FORMAT_R16_FLOAT: pixelFormat = FourCCFormat(111); return true;
+			default: return false;
+			}
+		}
+
+		DxgiFormat FindLegacyFormat(const Header& header)
+		{
+			const PixelFormat& pixelFormat = header.pixelFormat;
+			uint32_t flags = pixelFormat.flags;
+			// nvtt marks srgb and normal maps with flags of its own
+			if (header.reserved1[9] == FourCC('N', 'V', 'T', 'T'))
+				flags &= ~0xC0000000u;
+
+			for (const LegacyFormat& entry : LegacyFormats)
+			{
+				const PixelFormat& known = entry.pixelFormat;
+				if ((flags & PixelFourCC) && (known.flags & PixelFourCC))
+				{
+					if (pixelFormat.fourCC == known.fourCC)
+						return entry.format;
+				}
+				else if (flags == known.flags && pixelFormat.bitCount == known.bitCount &&
+					pixelFormat.rMask == known.rMask && pixelFormat.gMask == known.gMask &&
+					pixelFormat.bMask == known.bMask && pixelFormat.aMask == known.aMask)
+				{
+					return entry.format;
+				}
+			}
+			return DXGI_FORMAT_UNKNOWN;
+		}
+
+		bool IsCompressed(DxgiFormat format)
+		{
+			return (format >= DXGI_FORMAT_BC1_UNORM && format <= DXGI_FORMAT_BC5_SNORM) ||
+				(format >= DXGI_FORMAT_BC6H_UF16 && format <= DXGI_FORMAT_BC7_UNORM_SRGB);
+		}
+	}
+
+	bool HasLegacyHeader(DxgiFormat format)
+	{
+		PixelFormat pixelFormat;
+		return GetLegacyPixelFormat(format, pixelFormat);
+	}
+
+	size_t GetHeaderSize(DxgiFormat format, bool legacy)
+	{
+		PixelFormat pixelFormat;
+		if (legacy && !GetLegacyPixelFormat(format, pixelFormat))
+			return 0;
+		return sizeof(uint32_t) + sizeof(Header) + (legacy ? 0 : sizeof(HeaderDX10));
+	}
+
+	size_t EncodeHeader(const TextureDesc& desc, bool legacy, byte* out, size_t outSize)
+	{
+		size_t size = GetHeaderSize(desc.format, legacy);
+		if (size == 0)
+			throw std::runtime_error("Format has no DX9 DDS header");
+		if (outSize < size)
+			throw std::runtime_error("DDS header buffer too small");
+		if (desc.mipLevels > UINT16_MAX)
+			throw std::runtime_error("Invalid DDS mip count");
+
+		Header header{};
+		header.size = sizeof(Header);
+		header.flags = HeaderTexture | (desc.compressed ? HeaderLinearSize : HeaderPitch);
+		header.caps = SurfaceTexture;
+		if (desc.mipLevels > 0)
+		{
+			header.flags |= HeaderMipmap;
+			header.mipMapCount = desc.mipLevels;
+			if (desc.mipLevels > 1)
+				header.caps |= SurfaceMipmap;
+		}
+		header.width = desc.width;
+		header.height = desc.height;
+		header.depth = 1;
+		header.pitchOrLinearSize = desc.pitchOrLinearSize;
+
+		uint32_t magic = Magic;
+		memcpy(out, &magic, sizeof(magic));
+		if (legacy)
+		{
+			GetLegacyPixelFormat(desc.format, header.pixelFormat);
+			memcpy(out + sizeof(magic), &header, sizeof(header));
+		}
+		else
+		{
+			header.pixelFormat = DX10;
+			memcpy(out + sizeof(magic), &header, sizeof(header));
+
+			HeaderDX10 ext{};
+			ext.dxgiFormat = desc.format;
+			ext.resourceDimension = DimensionTexture2D;
+			ext.arraySize = 1;
+			memcpy(out + sizeof(magic) + sizeof(header), &ext, sizeof(ext));
+		}
+		return size;
+	}
+
+	size_t DecodeHeader(const byte* data, size_t size, TextureDesc& desc)
+	{
+		uint32_t magic;
+		Header header;
+		if (size < sizeof(magic) + sizeof(header))
+			throw std::runtime_error("Invalid DDS size");
+		memcpy(&magic, data, sizeof(magic));
+		memcpy(&header, data + sizeof(magic), sizeof(header));
+		if (magic != Magic || header.size != sizeof(Header) || header.pixelFormat.size != sizeof(PixelFormat))
+			throw std::runtime_error("Invalid DDS header");
+
+		size_t offset = sizeof(magic) + sizeof(header);
+		if ((header.pixelFormat.flags & PixelFourCC) && header.pixelFormat.fourCC == DX10.fourCC)
+		{
+			HeaderDX10 ext;
+			if (size < offset + sizeof(ext))
+				throw std::runtime_error("Invalid DDS size");
+			memcpy(&ext, data + offset, sizeof(ext));
+			if (ext.arraySize == 0)
+				throw std::runtime_error("Invalid DDS header");
+			desc.format = DxgiFormat(ext.dxgiFormat);
+			offset += sizeof(ext);
+		}
+		else
+		{
+			desc.format = FindLegacyFormat(header);
+		}
+
+		desc.width = header.width;
+		desc.height = header.height;
+		desc.mipLevels = header.mipMapCount == 0 ? 1 : header.mipMapCount;
+		desc.pitchOrLinearSize = header.pitchOrLinearSize;
+		desc.compressed = IsCompressed(desc.format);
+		return offset;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "Decompressor.h"
+#include "Kraken.h"
+#include "krak.h"
+#include "ThreadPool.h"
+#include <climits>
+
+namespace
+{
+	class BuiltinDecompressor : public Oodle::Decompressor
+	{
+	public:
+		const char* Name() const override { return "builtin"; }
+		bool Decompress(const byte* src, size_t srcSize, byte* dst, size_t dstSize, ThreadPool* pool) const override
+		{
+			return Kraken::Decompress(src, srcSize, dst, dstSize, pool);
+		}
+	};
+
+	class LibraryDecompressor : public Oodle::Decompressor
+	{
+	public:
+		const char* Name() const override { return "oo2core"; }
+		bool Decompress(const byte* src, size_t srcSize, byte* dst, size_t dstSize, ThreadPool*) const override
+		{
+			if (srcSize > INT_MAX)
+				return false;
+			int decoded = OodLZ_Decompress((uint8_t*)src, int(srcSize), dst, dstSize, 1, 0, 0, NULL, 0, NULL, NULL, NULL, 0, 3);
+			return decoded >= 0 && size_t(decoded) == dstSize;
+		}
+	};
+}
+
+namespace Oodle
+{
+	std::unique_ptr<Decompressor> Create(Backend backend)
+	{
+		if (backend == Backend::Library)
+		{
+			if (!LoadLib())
+				return nullptr;
+			return std::make_unique<LibraryDecompressor>();
+		}
+		return std::make_unique<BuiltinDecompressor>();
+	}
+
+	bool DecompressAll(const Decompressor& decompressor, std::span<Job> jobs, ThreadPool& pool)
+	{
+		for (Job& job : jobs)
+		{
+			// each task decodes its buffer alone, it can't wait on the pool it runs on
+			pool.Submit([&decompressor, &job]()
+			{
+				job.result = decompressor.Decompress(job.src, job.srcSize, job.dst, job.dstSize, nullptr);
+			});
+		}
+		pool.Wait();
+		for (const Job& job : jobs)
+		{
+			if (!job.result)
+				return false;
+		}
+		return true;
+	}
+}
\ No newline at end of file
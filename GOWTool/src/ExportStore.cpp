@@ -0,0 +1,47 @@
+#include "pch.h"
+#include "ExportStore.h"
+#include <algorithm>
+
+ExportStore::ExportStore(const std::filesystem::path& root) : _root(root)
+{
+	std::filesystem::create_directories(_root / "meshes");
+	std::filesystem::create_directories(_root / "textures");
+}
+
+bool ExportStore::Claim(Kind kind, uint64_t hash)
+{
+	// 0 is the empty marker of HashIndex
+	if (hash == 0)
+		hash = 1;
+	std::lock_guard<std::mutex> lock(_mutex);
+	return _claimed[size_t(kind)].Insert(hash, true);
+}
+
+std::filesystem::path ExportStore::GetPath(Kind kind, uint64_t hash, const std::string& extension) const
+{
+	char name[17];
+	snprintf(name, sizeof(name), "%016llX", (unsigned long long)hash);
+	return _root / (kind == Kind::Texture ? "textures" : "meshes") / (name + extension);
+}
+
+void ExportManifest::Add(const std::string& name, const std::filesystem::path& file)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_entries.emplace_back(name, file);
+}
+
+bool ExportManifest::Write(const std::filesystem::path& path)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	std::sort(_entries.begin(), _entries.end());
+
+	std::ofstream ofs(path, ios::out | ios::trunc);
+	if (!ofs)
+		return false;
+	const std::filesystem::path dir = path.parent_path();
+	for (const auto& entry : _entries)
+	{
+		ofs << entry.first << '\t' << entry.second.lexically_relative(dir).generic_string() << '\n';
+	}
+	return ofs.good();
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#include "pch.h"
+#include "FbxExport.h"
+#include "FbxWriter.h"
+#include <glm.hpp>
+#include "gtc/matrix_access.hpp"
+#include "gtc/type_ptr.hpp"
+#include "gtx/euler_angles.hpp"
+
+namespace
+{
+	// translation, rotation as XYZ euler angles in degrees (the order FBX applies them in) and scaling
+	FbxSceneWriter::Transform DecomposeTransform(const glm::mat4& transform)
+	{
+		glm::vec3 scaling(glm::length(glm::column(transform, 0)), glm::length(glm::column(transform, 1)), glm::length(glm::column(transform, 2)));
+		glm::mat3 upper = glm::mat3(transform);
+		upper = glm::column(upper, 0, glm::column(upper, 0) / scaling.x);
+		upper = glm::column(upper, 1, glm::column(upper, 1) / scaling.y);
+		upper = glm::column(upper, 2, glm::column(upper, 2) / scaling.z);
+		glm::vec3 radians(0.f);
+		glm::extractEulerAngleZYX(glm::mat4(upper), radians.z, radians.y, radians.x);
+		glm::vec3 rotation = glm::degrees(radians);
+
+		FbxSceneWriter::Transform result;
+		for (int i = 0; i < 3; i++)
+		{
+			result.translation[i] = transform[3][i];
+			result.rotation[i] = rotation[i];
+			result.scaling[i] = scaling[i];
+		}
+		return result;
+	}
+
+	glm::mat4 ToMat4(const Matrix4x4& matrix)
+	{
+		return glm::make_mat4(&matrix.m11);
+	}
+
+	void CopyMatrix(const glm::mat4& matrix, double* out)
+	{
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				out[c * 4 + r] = matrix[c][r];
+	}
+
+	// one cluster per bone of the rig with the vertices it influences, a vertex listing a
+	// bone more than once is bound with the weight of its first slot
+	vector<FbxSceneWriter::Cluster> GatherClusters(const RawMeshContainer& mesh, uint16_t boneCount)
+	{
+		vector<FbxSceneWriter::Cluster> clusters(boneCount);
+		for (uint32_t v = 0; v < mesh.VertCount; v++)
+		{
+			const uint16_t* joints = mesh.joints + size_t(v) * 4;
+			const float* weights = mesh.weights + size_t(v) * 4;
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				uint16_t bone = joints[j];
+				if (bone >= boneCount || std::find(joints, joints + j, bone) != joints + j)
+					continue;
+				clusters[bone].indexes.push_back(int32_t(v));
+				clusters[bone].weights.push_back(weights[j]);
+			}
+		}
+		return clusters;
+	}
+}
+
+void WriteFbxNative(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature)
+{
+	std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+	if (!ofs)
+		throw std::runtime_error("Failed to open " + path.string());
+	FbxSceneWriter writer(ofs, "GOWTool");
+
+	// bones come after their parents in the rig, global transforms are accumulated on the way
+	vector<int64_t> boneIds(Armature.boneCount);
+	vector<glm::mat4> globals(Armature.boneCount);
+	for (uint16_t i = 0; i < Armature.boneCount; i++)
+	{
+		glm::mat4 local = ToMat4(Armature.matrix[i]);
+		int16_t parent = Armature.boneParents[i];
+		bool hasParent = parent > -1 && parent < i;
+		globals[i] = hasParent ? globals[parent] * local : local;
+		std::string name = Armature.boneNames[i] + "_J" + std::to_string(i);
+		boneIds[i] = writer.AddModel(name, hasParent ? FbxSceneWriter::ModelType::LimbNode : FbxSceneWriter::ModelType::Root,
+			DecomposeTransform(local), hasParent ? boneIds[parent] : 0);
+	}
+
+	for (const RawMeshContainer& mesh : expMeshes)
+	{
+		FbxSceneWriter::Geometry geometry;
+		geometry.vertexCount = mesh.VertCount;
+		geometry.positions = { &mesh.vertices->X, sizeof(Vec3) };
+		if (mesh.normals)
+			geometry.normals = { &mesh.normals->X, sizeof(Vec3) };
+		if (mesh.tangents)
+			geometry.tangents = { mesh.tangents->XYZW, sizeof(Vec4) };
+		const Vec2* texcoords[3] = { mesh.txcoord0, mesh.txcoord1, mesh.txcoord2 };
+		for (uint32_t n = 0; n < 3; n++)
+		{
+			if (texcoords[n])
+				geometry.uvSets.push_back({ "UV" + std::to_string(n), { &texcoords[n]->X, sizeof(Vec2) } });
+		}
+		geometry.indices = mesh.indices;
+		geometry.indexCount = mesh.IndCount;
+		geometry.indexSize = sizeof(uint16_t);
+
+		int64_t geometryId = writer.AddGeometry("", geometry);
+		int64_t modelId = writer.AddModel(mesh.name, FbxSceneWriter::ModelType::Mesh, {});
+		writer.Connect(geometryId, modelId);
+
+		if (Armature.boneCount == 0 || !mesh.joints || !mesh.weights)
+			continue;
+		vector<FbxSceneWriter::Cluster> clusters = GatherClusters(mesh, Armature.boneCount);
+		bool skinned = false;
+		for (uint16_t i = 0; i < Armature.boneCount; i++)
+		{
+			FbxSceneWriter::Cluster& cluster = clusters[i];
+			if (cluster.indexes.empty())
+				continue;
+			skinned = true;
+			cluster.bone = boneIds[i];
+			CopyMatrix(ToMat4(Armature.IBMs[i]) * globals[i], cluster.transform);
+			CopyMatrix(globals[i], cluster.transformLink);
+		}
+		if (skinned)
+			writer.AddSkin(geometryId, clusters);
+	}
+	writer.Finish();
+}
\ No newline at end of file
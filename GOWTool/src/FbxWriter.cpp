@@ -0,0 +1,694 @@
+#include "FbxWriter.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace
+{
+	const uint32_t FbxVersion = 7400;
+	const char HeaderMagic[] = "Kaydara FBX Binary  \0\x1a";
+	// file id, creation time and footer id only validate together, these are the values for
+	// the epoch time stamp every file is written with, which keeps exports reproducible
+	const uint8_t FileId[16] = { 0x28, 0xb3, 0x2a, 0xeb, 0xb6, 0x24, 0xcc, 0xc2, 0xbf, 0xc8, 0xb0, 0x2a, 0xa9, 0x2b, 0xfc, 0xf1 };
+	const char CreationTime[] = "1970-01-01 10:00:00:000";
+	const uint8_t FooterId[16] = { 0xfa, 0xbc, 0xab, 0x09, 0xd0, 0xc8, 0xd4, 0x66, 0xb1, 0x76, 0xfb, 0x83, 0x1c, 0xf7, 0x26, 0x7e };
+	const uint8_t FooterMagic[16] = { 0xf8, 0x5a, 0x8c, 0x6a, 0xde, 0xf5, 0xd9, 0x7e, 0xec, 0xe9, 0x0c, 0xe3, 0x75, 0x8f, 0x29, 0x0b };
+	// end offset, property count and property list length of a record, all 0
+	const char NullRecord[13] = {};
+
+	// object names carry their class after a "\x00\x01" separator
+	std::string ObjectName(std::string_view name, std::string_view className)
+	{
+		std::string result(name);
+		result.push_back('\0');
+		result.push_back('\x01');
+		result.append(className);
+		return result;
+	}
+}
+
+FbxBinaryStream::FbxBinaryStream(std::ostream& os) : _os(os)
+{
+	_buffer.reserve(FlushSize + BatchSize * sizeof(double));
+	Write(HeaderMagic, sizeof(HeaderMagic));
+	WriteValue(FbxVersion);
+}
+
+void FbxBinaryStream::BeginNode(std::string_view name)
+{
+	if (name.size() > 255)
+		throw std::length_error("FBX record name is too long");
+	if (!_records.empty() && !_records.back().hasChildren)
+	{
+		_records.back().propertiesEnd = Tell();
+		_records.back().hasChildren = true;
+	}
+	Record record{ Tell(), 0, 0, 0, false };
+	// end offset, property count and property list length are patched in by EndNode
+	Write(NullRecord, 12);
+	WriteValue(uint8_t(name.size()));
+	Write(name.data(), name.size());
+	record.propertiesOffset = Tell();
+	_records.push_back(record);
+}
+
+void FbxBinaryStream::EndNode()
+{
+	Record record = _records.back();
+	_records.pop_back();
+	if (!record.hasChildren)
+		record.propertiesEnd = Tell();
+	// children are terminated by a null record, so are records without any content
+	if (record.hasChildren || record.propertyCount == 0)
+		Write(NullRecord, sizeof(NullRecord));
+	if (Tell() > std::numeric_limits<uint32_t>::max())
+		throw std::length_error("FBX 7.4 files are limited to 4 GB");
+	uint32_t header[3] = { uint32_t(Tell()), record.propertyCount, uint32_t(record.propertiesEnd - record.propertiesOffset) };
+	Patch(record.headerOffset, header, sizeof(header));
+}
+
+void FbxBinaryStream::Property(char type)
+{
+	if (_records.empty() || _records.back().hasChildren)
+		throw std::logic_error("FBX properties have to precede the children of their record");
+	_records.back().propertyCount++;
+	WriteValue(type);
+}
+
+void FbxBinaryStream::Bool(bool value)
+{
+	Property('C');
+	WriteValue(uint8_t(value ? 1 : 0));
+}
+
+void FbxBinaryStream::Int32(int32_t value)
+{
+	Property('I');
+	WriteValue(value);
+}
+
+void FbxBinaryStream::Int64(int64_t value)
+{
+	Property('L');
+	WriteValue(value);
+}
+
+void FbxBinaryStream::Double(double value)
+{
+	Property('D');
+	WriteValue(value);
+}
+
+void FbxBinaryStream::String(std::string_view value)
+{
+	Property('S');
+	WriteValue(uint32_t(value.size()));
+	Write(value.data(), value.size());
+}
+
+void FbxBinaryStream::Raw(const void* data, size_t size)
+{
+	Property('R');
+	WriteValue(uint32_t(size));
+	Write(data, size);
+}
+
+void FbxBinaryStream::Int32Array(const int32_t* values, size_t count)
+{
+	BeginArray('i', count, sizeof(int32_t));
+	Write(values, count * sizeof(int32_t));
+}
+
+void FbxBinaryStream::DoubleArray(const double* values, size_t count)
+{
+	BeginArray('d', count, sizeof(double));
+	Write(values, count * sizeof(double));
+}
+
+void FbxBinaryStream::BeginArray(char type, size_t count, size_t elementSize)
+{
+	if (count * elementSize > std::numeric_limits<uint32_t>::max())
+		throw std::length_error("FBX array is too large");
+	Property(type);
+	// length, encoding (0, uncompressed) and size in bytes
+	uint32_t header[3] = { uint32_t(count), 0, uint32_t(count * elementSize) };
+	Write(header, sizeof(header));
+}
+
+size_t FbxBinaryStream::ReserveInt32()
+{
+	Int32(0);
+	return Tell() - sizeof(int32_t);
+}
+
+void FbxBinaryStream::PatchInt32(size_t offset, int32_t value)
+{
+	Patch(offset, &value, sizeof(value));
+}
+
+void FbxBinaryStream::Finish()
+{
+	if (!_records.empty())
+		throw std::logic_error("FBX record left open");
+	Write(NullRecord, sizeof(NullRecord));
+	Write(FooterId, sizeof(FooterId));
+	WriteValue(uint32_t(0));
+	// the version is aligned to 16 bytes, with a full 16 bytes of padding if it already is
+	size_t padding = 16 - (Tell() & 15);
+	const char zeros[120] = {};
+	Write(zeros, padding);
+	WriteValue(FbxVersion);
+	Write(zeros, sizeof(zeros));
+	Write(FooterMagic, sizeof(FooterMagic));
+	Flush();
+	_os.flush();
+	if (!_os)
+		throw std::runtime_error("Failed to write FBX file");
+}
+
+void FbxBinaryStream::Write(const void* data, size_t size)
+{
+	// large arrays skip the buffer
+	if (size >= FlushSize)
+	{
+		Flush();
+		_os.write(static_cast<const char*>(data), size);
+		_flushed += size;
+		return;
+	}
+	const char* bytes = static_cast<const char*>(data);
+	_buffer.insert(_buffer.end(), bytes, bytes + size);
+	if (_buffer.size() >= FlushSize)
+		Flush();
+}
+
+void FbxBinaryStream::Patch(size_t offset, const void* data, size_t size)
+{
+	if (offset >= _flushed)
+	{
+		std::memcpy(_buffer.data() + (offset - _flushed), data, size);
+		return;
+	}
+	// the record started before the last flush, only enclosing records get here
+	Flush();
+	_os.seekp(std::streamoff(offset));
+	_os.write(static_cast<const char*>(data), size);
+	_os.seekp(0, std::ios::end);
+}
+
+void FbxBinaryStream::Flush()
+{
+	_os.write(_buffer.data(), _buffer.size());
+	_flushed += _buffer.size();
+	_buffer.clear();
+}
+
+FbxSceneWriter::FbxSceneWriter(std::ostream& os, std::string_view creator) : _stream(os)
+{
+	WriteHeader(creator);
+	WriteGlobalSettings();
+
+	_stream.BeginNode("Documents");
+	_stream.BeginNode("Count");
+	_stream.Int32(1);
+	_stream.EndNode();
+	_stream.BeginNode("Document");
+	_stream.Int64(_nextId++);
+	_stream.String("");
+	_stream.String("Scene");
+	_stream.BeginNode("RootNode");
+	_stream.Int64(0);
+	_stream.EndNode();
+	_stream.EndNode();
+	_stream.EndNode();
+
+	_stream.BeginNode("References");
+	_stream.EndNode();
+
+	WriteDefinitions();
+	_counts[GlobalSettingsType] = 1;
+	_stream.BeginNode("Objects");
+}
+
+void FbxSceneWriter::WriteHeader(std::string_view creator)
+{
+	auto intRecord = [this](std::string_view name, int32_t value)
+	{
+		_stream.BeginNode(name);
+		_stream.Int32(value);
+		_stream.EndNode();
+	};
+	_stream.BeginNode("FBXHeaderExtension");
+	intRecord("FBXHeaderVersion", 1003);
+	intRecord("FBXVersion", int32_t(FbxVersion));
+	intRecord("EncryptionType", 0);
+	_stream.BeginNode("CreationTimeStamp");
+	intRecord("Version", 1000);
+	intRecord("Year", 1970);
+	intRecord("Month", 1);
+	intRecord("Day", 1);
+	intRecord("Hour", 10);
+	intRecord("Minute", 0);
+	intRecord("Second", 0);
+	intRecord("Millisecond", 0);
+	_stream.EndNode();
+	_stream.BeginNode("Creator");
+	_stream.String(creator);
+	_stream.EndNode();
+	_stream.EndNode();
+
+	_stream.BeginNode("FileId");
+	_stream.Raw(FileId, sizeof(FileId));
+	_stream.EndNode();
+	_stream.BeginNode("CreationTime");
+	_stream.String(CreationTime);
+	_stream.EndNode();
+	_stream.BeginNode("Creator");
+	_stream.String(creator);
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::WriteGlobalSettings()
+{
+	// Y up, right handed, centimeters like scenes created by the FBX SDK
+	_stream.BeginNode("GlobalSettings");
+	_stream.BeginNode("Version");
+	_stream.Int32(1000);
+	_stream.EndNode();
+	_stream.BeginNode("Properties70");
+	IntProperty("UpAxis", "int", "Integer", 1);
+	IntProperty("UpAxisSign", "int", "Integer", 1);
+	IntProperty("FrontAxis", "int", "Integer", 2);
+	IntProperty("FrontAxisSign", "int", "Integer", 1);
+	IntProperty("CoordAxis", "int", "Integer", 0);
+	IntProperty("CoordAxisSign", "int", "Integer", 1);
+	IntProperty("OriginalUpAxis", "int", "Integer", 1);
+	IntProperty("OriginalUpAxisSign", "int", "Integer", 1);
+	NumberProperty("UnitScaleFactor", "double", "Number", "", 1.0);
+	NumberProperty("OriginalUnitScaleFactor", "double", "Number", "", 1.0);
+	_stream.EndNode();
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::WriteDefinitions()
+{
+	static const char* const names[ObjectTypeCount] = { "GlobalSettings", "Model", "Geometry", "NodeAttribute", "Material", "Texture", "Deformer" };
+	// object counts are only known once the scene is written, Finish patches them in
+	_stream.BeginNode("Definitions");
+	_stream.BeginNode("Version");
+	_stream.Int32(100);
+	_stream.EndNode();
+	_stream.BeginNode("Count");
+	_totalCountOffset = _stream.ReserveInt32();
+	_stream.EndNode();
+	for (int type = 0; type < ObjectTypeCount; type++)
+	{
+		_stream.BeginNode("ObjectType");
+		_stream.String(names[type]);
+		_stream.BeginNode("Count");
+		_countOffsets[type] = _stream.ReserveInt32();
+		_stream.EndNode();
+		_stream.EndNode();
+	}
+	_stream.EndNode();
+}
+
+int64_t FbxSceneWriter::BeginObject(ObjectType type, std::string_view record, std::string_view name, std::string_view className, std::string_view subclass)
+{
+	int64_t id = _nextId++;
+	_counts[type]++;
+	_stream.BeginNode(record);
+	_stream.Int64(id);
+	_stream.String(ObjectName(name, className));
+	_stream.String(subclass);
+	return id;
+}
+
+int64_t FbxSceneWriter::AddGeometry(std::string_view name, const Geometry& geometry)
+{
+	int64_t id = BeginObject(GeometryObject, "Geometry", name, "Geometry", "Mesh");
+	_stream.BeginNode("GeometryVersion");
+	_stream.Int32(124);
+	_stream.EndNode();
+
+	WriteAttribute("Vertices", {}, -1, {}, geometry.positions, geometry.vertexCount, 3);
+
+	// the last index of every polygon is stored as its one's complement, a trailing
+	// partial triangle is dropped
+	size_t indexCount = geometry.indexCount / 3 * 3;
+	_stream.BeginNode("PolygonVertexIndex");
+	if (geometry.indexSize == 4)
+	{
+		const uint32_t* indices = static_cast<const uint32_t*>(geometry.indices);
+		_stream.Array<int32_t>(indexCount, [indices](int32_t* out, size_t first, size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+				out[i] = (first + i) % 3 == 2 ? ~int32_t(indices[first + i]) : int32_t(indices[first + i]);
+		});
+	}
+	else
+	{
+		const uint16_t* indices = static_cast<const uint16_t*>(geometry.indices);
+		_stream.Array<int32_t>(indexCount, [indices](int32_t* out, size_t first, size_t n)
+		{
+			for (size_t i = 0; i < n; i++)
+				out[i] = (first + i) % 3 == 2 ? ~int32_t(indices[first + i]) : int32_t(indices[first + i]);
+		});
+	}
+	_stream.EndNode();
+
+	// layer 0 holds the normals, tangents, material and first UV set, every further UV set its own layer
+	if (geometry.normals.data)
+		WriteAttribute("LayerElementNormal", "Normals", 0, "", geometry.normals, geometry.vertexCount, 3);
+	if (geometry.tangents.data)
+		WriteAttribute("LayerElementTangent", "Tangents", 0, "", geometry.tangents, geometry.vertexCount, 3);
+	for (size_t i = 0; i < geometry.uvSets.size(); i++)
+		WriteAttribute("LayerElementUV", "UV", int32_t(i), geometry.uvSets[i].name, geometry.uvSets[i].uv, geometry.vertexCount, 2);
+	if (geometry.material)
+	{
+		_stream.BeginNode("LayerElementMaterial");
+		_stream.Int32(0);
+		_stream.BeginNode("Version");
+		_stream.Int32(101);
+		_stream.EndNode();
+		_stream.BeginNode("Name");
+		_stream.String("");
+		_stream.EndNode();
+		_stream.BeginNode("MappingInformationType");
+		_stream.String("AllSame");
+		_stream.EndNode();
+		_stream.BeginNode("ReferenceInformationType");
+		_stream.String("IndexToDirect");
+		_stream.EndNode();
+		_stream.BeginNode("Materials");
+		int32_t material = 0;
+		_stream.Int32Array(&material, 1);
+		_stream.EndNode();
+		_stream.EndNode();
+	}
+
+	size_t layerCount = std::max<size_t>(geometry.uvSets.size(), 1);
+	for (size_t layer = 0; layer < layerCount; layer++)
+	{
+		_stream.BeginNode("Layer");
+		_stream.Int32(int32_t(layer));
+		_stream.BeginNode("Version");
+		_stream.Int32(100);
+		_stream.EndNode();
+		if (layer == 0 && geometry.normals.data)
+			WriteLayerElement("LayerElementNormal", 0);
+		if (layer == 0 && geometry.tangents.data)
+			WriteLayerElement("LayerElementTangent", 0);
+		if (layer == 0 && geometry.material)
+			WriteLayerElement("LayerElementMaterial", 0);
+		if (layer < geometry.uvSets.size())
+			WriteLayerElement("LayerElementUV", int32_t(layer));
+		_stream.EndNode();
+	}
+	_stream.EndNode();
+	return id;
+}
+
+void FbxSceneWriter::WriteAttribute(std::string_view record, std::string_view arrayName, int32_t index, std::string_view name, const Attribute& attribute, size_t count, uint32_t components)
+{
+	// index < 0 writes the bare array, otherwise a layer element mapped by control point
+	_stream.BeginNode(record);
+	if (index >= 0)
+	{
+		_stream.Int32(index);
+		_stream.BeginNode("Version");
+		_stream.Int32(101);
+		_stream.EndNode();
+		_stream.BeginNode("Name");
+		_stream.String(name);
+		_stream.EndNode();
+		_stream.BeginNode("MappingInformationType");
+		_stream.String("ByVertice");
+		_stream.EndNode();
+		_stream.BeginNode("ReferenceInformationType");
+		_stream.String("Direct");
+		_stream.EndNode();
+		_stream.BeginNode(arrayName);
+	}
+	const char* data = reinterpret_cast<const char*>(attribute.data);
+	size_t stride = attribute.stride;
+	_stream.Array<double>(count * components, [data, stride, components](double* out, size_t first, size_t n)
+	{
+		for (size_t v = first / components, end = (first + n) / components; v < end; v++)
+		{
+			const float* values = reinterpret_cast<const float*>(data + v * stride);
+			for (uint32_t c = 0; c < components; c++)
+				*out++ = values[c];
+		}
+	});
+	if (index >= 0)
+		_stream.EndNode();
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::WriteLayerElement(std::string_view type, int32_t index)
+{
+	_stream.BeginNode("LayerElement");
+	_stream.BeginNode("Type");
+	_stream.String(type);
+	_stream.EndNode();
+	_stream.BeginNode("TypedIndex");
+	_stream.Int32(index);
+	_stream.EndNode();
+	_stream.EndNode();
+}
+
+int64_t FbxSceneWriter::AddModel(std::string_view name, ModelType type, const Transform& transform, int64_t parent)
+{
+	static const char* const subclasses[] = { "Mesh", "Root", "LimbNode" };
+	int64_t attribute = 0;
+	if (type != ModelType::Mesh)
+	{
+		attribute = BeginObject(NodeAttributeObject, "NodeAttribute", name, "NodeAttribute", subclasses[int(type)]);
+		if (type == ModelType::LimbNode)
+		{
+			_stream.BeginNode("Properties70");
+			NumberProperty("Size", "double", "Number", "", 1.0);
+			_stream.EndNode();
+		}
+		_stream.BeginNode("TypeFlags");
+		if (type == ModelType::Root)
+		{
+			_stream.String("Null");
+			_stream.String("Skeleton");
+			_stream.String("Root");
+		}
+		else
+		{
+			_stream.String("Skeleton");
+		}
+		_stream.EndNode();
+		_stream.EndNode();
+	}
+
+	int64_t id = BeginObject(ModelObject, "Model", name, "Model", subclasses[int(type)]);
+	_stream.BeginNode("Version");
+	_stream.Int32(232);
+	_stream.EndNode();
+	_stream.BeginNode("Properties70");
+	VectorProperty("Lcl Translation", transform.translation);
+	VectorProperty("Lcl Rotation", transform.rotation);
+	VectorProperty("Lcl Scaling", transform.scaling);
+	IntProperty("DefaultAttributeIndex", "int", "Integer", 0);
+	_stream.EndNode();
+	_stream.BeginNode("Shading");
+	_stream.Bool(true);
+	_stream.EndNode();
+	_stream.BeginNode("Culling");
+	_stream.String("CullingOff");
+	_stream.EndNode();
+	_stream.EndNode();
+
+	Connect(id, parent);
+	if (attribute != 0)
+		Connect(attribute, id);
+	return id;
+}
+
+int64_t FbxSceneWriter::AddMaterial(std::string_view name, const Material& material)
+{
+	int64_t id = BeginObject(MaterialObject, "Material", name, "Material", "");
+	_stream.BeginNode("Version");
+	_stream.Int32(102);
+	_stream.EndNode();
+	_stream.BeginNode("ShadingModel");
+	_stream.String("phong");
+	_stream.EndNode();
+	_stream.BeginNode("MultiLayer");
+	_stream.Int32(0);
+	_stream.EndNode();
+	_stream.BeginNode("Properties70");
+	StringProperty("ShadingModel", "Phong");
+	NumberProperty("AmbientFactor", "Number", "", "A", material.ambientFactor);
+	NumberProperty("DiffuseFactor", "Number", "", "A", material.diffuseFactor);
+	NumberProperty("TransparencyFactor", "Number", "", "A", material.transparencyFactor);
+	NumberProperty("SpecularFactor", "Number", "", "A", material.specularFactor);
+	_stream.EndNode();
+	_stream.EndNode();
+	return id;
+}
+
+int64_t FbxSceneWriter::AddTexture(std::string_view name, std::string_view filename, std::string_view uvSet)
+{
+	int64_t id = BeginObject(TextureObject, "Texture", name, "Texture", "");
+	_stream.BeginNode("Type");
+	_stream.String("TextureVideoClip");
+	_stream.EndNode();
+	_stream.BeginNode("Version");
+	_stream.Int32(202);
+	_stream.EndNode();
+	_stream.BeginNode("TextureName");
+	_stream.String(ObjectName(name, "Texture"));
+	_stream.EndNode();
+	_stream.BeginNode("Properties70");
+	StringProperty("UVSet", uvSet);
+	_stream.EndNode();
+	_stream.BeginNode("Media");
+	_stream.String(ObjectName(name, "Video"));
+	_stream.EndNode();
+	_stream.BeginNode("FileName");
+	_stream.String(filename);
+	_stream.EndNode();
+	_stream.BeginNode("RelativeFilename");
+	_stream.String(filename);
+	_stream.EndNode();
+	_stream.BeginNode("ModelUVTranslation");
+	_stream.Double(0.0);
+	_stream.Double(0.0);
+	_stream.EndNode();
+	_stream.BeginNode("ModelUVScaling");
+	_stream.Double(1.0);
+	_stream.Double(1.0);
+	_stream.EndNode();
+	_stream.BeginNode("Texture_Alpha_Source");
+	_stream.String("None");
+	_stream.EndNode();
+	_stream.BeginNode("Cropping");
+	for (int i = 0; i < 4; i++)
+		_stream.Int32(0);
+	_stream.EndNode();
+	_stream.EndNode();
+	return id;
+}
+
+int64_t FbxSceneWriter::AddSkin(int64_t geometry, const std::vector<Cluster>& clusters)
+{
+	int64_t id = BeginObject(DeformerObject, "Deformer", "", "Deformer", "Skin");
+	_stream.BeginNode("Version");
+	_stream.Int32(101);
+	_stream.EndNode();
+	_stream.BeginNode("Link_DeformAcuracy");
+	_stream.Double(50.0);
+	_stream.EndNode();
+	_stream.EndNode();
+	Connect(id, geometry);
+
+	for (const Cluster& cluster : clusters)
+	{
+		if (cluster.indexes.empty())
+			continue;
+		int64_t clusterId = BeginObject(DeformerObject, "Deformer", "", "SubDeformer", "Cluster");
+		_stream.BeginNode("Version");
+		_stream.Int32(100);
+		_stream.EndNode();
+		_stream.BeginNode("UserData");
+		_stream.String("");
+		_stream.String("");
+		_stream.EndNode();
+		_stream.BeginNode("Indexes");
+		_stream.Int32Array(cluster.indexes.data(), cluster.indexes.size());
+		_stream.EndNode();
+		_stream.BeginNode("Weights");
+		_stream.DoubleArray(cluster.weights.data(), cluster.weights.size());
+		_stream.EndNode();
+		_stream.BeginNode("Transform");
+		_stream.DoubleArray(cluster.transform, 16);
+		_stream.EndNode();
+		_stream.BeginNode("TransformLink");
+		_stream.DoubleArray(cluster.transformLink, 16);
+		_stream.EndNode();
+		_stream.EndNode();
+		Connect(clusterId, id);
+		Connect(cluster.bone, clusterId);
+	}
+	return id;
+}
+
+void FbxSceneWriter::Connect(int64_t child, int64_t parent, std::string_view property)
+{
+	_connections.push_back({ child, parent, std::string(property) });
+}
+
+void FbxSceneWriter::Finish()
+{
+	if (_finished)
+		return;
+	_finished = true;
+	_stream.EndNode();
+
+	_stream.BeginNode("Connections");
+	for (const Connection& connection : _connections)
+	{
+		_stream.BeginNode("C");
+		_stream.String(connection.property.empty() ? "OO" : "OP");
+		_stream.Int64(connection.child);
+		_stream.Int64(connection.parent);
+		if (!connection.property.empty())
+			_stream.String(connection.property);
+		_stream.EndNode();
+	}
+	_stream.EndNode();
+
+	uint32_t total = 0;
+	for (int type = 0; type < ObjectTypeCount; type++)
+	{
+		_stream.PatchInt32(_countOffsets[type], int32_t(_counts[type]));
+		total += _counts[type];
+	}
+	_stream.PatchInt32(_totalCountOffset, int32_t(total));
+	_stream.Finish();
+}
+
+void FbxSceneWriter::BeginProperty(std::string_view name, std::string_view type, std::string_view label, std::string_view flags)
+{
+	_stream.BeginNode("P");
+	_stream.String(name);
+	_stream.String(type);
+	_stream.String(label);
+	_stream.String(flags);
+}
+
+void FbxSceneWriter::IntProperty(std::string_view name, std::string_view type, std::string_view label, int32_t value)
+{
+	BeginProperty(name, type, label, "");
+	_stream.Int32(value);
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::NumberProperty(std::string_view name, std::string_view type, std::string_view label, std::string_view flags, double value)
+{
+	BeginProperty(name, type, label, flags);
+	_stream.Double(value);
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::VectorProperty(std::string_view name, const double value[3])
+{
+	BeginProperty(name, name, "", "A");
+	_stream.Double(value[0]);
+	_stream.Double(value[1]);
+	_stream.Double(value[2]);
+	_stream.EndNode();
+}
+
+void FbxSceneWriter::StringProperty(std::string_view name, std::string_view value)
+{
+	BeginProperty(name, "KString", "", "");
+	_stream.String(value);
+	_stream.EndNode();
+}
\ No newline at end of file
@@ -1,329 +1,207 @@
 #include <pch.h>
 #include "Formats.h"
+#include <cstring>
 
-MGDefinition::~MGDefinition()
+namespace
 {
-	delete[] defOffsets;
-}
-
-vector<MeshInfo> MGDefinition::ReadMG(std::stringstream& file)
-{
-	vector<MeshInfo> meshesinfo;
-	file.seekg(56);
-	file.read((char*)&defCount, sizeof(uint16_t));
-
-	defOffsets = new uint32_t[defCount];
+#pragma pack(push, 1)
+	// submesh of an MG file and mesh definition of a smsh file share this header
+	struct SubMeshHeader
+	{
+		uint8_t unk0[16];
+		float extent[3];
+		float origin[3];
+		uint8_t unk1[8];
+		uint32_t indicesOffset;
+		uint32_t unk2;
+		uint32_t vertexOffset;
+		uint32_t unk3;
+		uint32_t vertCount;
+		uint32_t indCount;
+		uint8_t unk4[12];
+		// relative to the header
+		uint32_t vertexInfoOffset;
+		uint32_t vertexDataOffsOffset;
+		uint64_t hash;
+	};
+	// found 8 bytes before the component list
+	struct VertexInfoHeader
+	{
+		uint8_t bufferCount;
+		uint8_t unk[2];
+		uint8_t componentCount;
+	};
+	struct ComponentDesc
+	{
+		uint8_t primitiveType;
+		uint8_t dataType;
+		uint8_t elementCount;
+		uint8_t offset;
+		uint8_t bufferIndex;
+		uint8_t pad[3];
+	};
+#pragma pack(pop)
+	static_assert(sizeof(SubMeshHeader) == 100, "SubMeshHeader layout");
+	static_assert(sizeof(ComponentDesc) == 8, "ComponentDesc layout");
+
+	// bounds checked reads from the definition bytes
+	class DefView
+	{
+		std::span<const uint8_t> _data;
+	public:
+		explicit DefView(std::span<const uint8_t> data) : _data(data) {}
+		void Check(uint64_t offset, uint64_t size) const
+		{
+			if (offset > _data.size() || size > _data.size() - offset)
+				throw std::runtime_error("Mesh definition is truncated");
+		}
+		template<typename T>
+		T Read(uint64_t offset) const
+		{
+			Check(offset, sizeof(T));
+			T value;
+			memcpy(&value, _data.data() + offset, sizeof(T));
+			return value;
+		}
+	};
 
-	file.seekg(76);
-	for (uint16_t i = 0; i < defCount; i++)
+	uint16_t DataTypeSize(DataTypes type)
 	{
-		file.read((char*)&defOffsets[i], sizeof(uint32_t));
+		switch (type)
+		{
+		case DataTypes::FLOAT:
+		case DataTypes::WORD_STRUCT_0:
+		case DataTypes::WORD_STRUCT_1:
+			return 4;
+		case DataTypes::HALFWORD_STRUCT_0:
+		case DataTypes::HALFWORD_STRUCT_1:
+		case DataTypes::HALFWORD_STRUCT_2:
+		case DataTypes::UNSIGNED_SHORT:
+			return 2;
+		case DataTypes::BYTE_STRUCT_0:
+			return 1;
+		default:
+			return 0;
+		}
 	}
 
-	for (uint16_t i = 0; i < defCount; i++)
+	MeshInfo ReadMeshInfo(const DefView& view, uint64_t base)
 	{
-		uint32_t offset = defOffsets[i];
+		const SubMeshHeader header = view.Read<SubMeshHeader>(base);
 
-		file.seekg((uint64_t)offset);
-
-		uint16_t boneAsso = UINT16_MAX;
-		file.read((char*)&boneAsso, sizeof(uint16_t));
-		uint8_t subMeshCount = UINT8_MAX;
-		file.read((char*)&subMeshCount, sizeof(uint8_t));
+		MeshInfo info;
+		info.Hash = header.hash;
+		info.vertCount = header.vertCount;
+		info.indCount = header.indCount;
+		info.vertexOffset = header.vertexOffset;
+		info.indicesOffset = header.indicesOffset;
+		info.meshScale = Vec3(header.extent[0] * 2, header.extent[1] * 2, header.extent[2] * 2);
+		info.meshMin = Vec3(header.origin[0] - header.extent[0], header.origin[1] - header.extent[1], header.origin[2] - header.extent[2]);
+
+		const uint64_t componentsOff = base + header.vertexInfoOffset;
+		const VertexInfoHeader vertexInfo = view.Read<VertexInfoHeader>(componentsOff - 8);
+		view.Check(componentsOff, uint64_t(vertexInfo.componentCount) * sizeof(ComponentDesc));
+		info.Components.reserve(vertexInfo.componentCount);
+		for (uint8_t d = 0; d < vertexInfo.componentCount; d++)
+		{
+			const ComponentDesc desc = view.Read<ComponentDesc>(componentsOff + uint64_t(d) * sizeof(ComponentDesc));
+			Component component;
+			component.primitiveType = static_cast<PrimitiveTypes>(desc.primitiveType);
+			component.dataType = static_cast<DataTypes>(desc.dataType);
+			component.elementCount = desc.elementCount;
+			component.offset = desc.offset;
+			component.bufferIndex = desc.bufferIndex;
+			info.Components.push_back(component);
+		}
 
-		for (uint8_t e = 0; e < subMeshCount; e++)
+		const uint64_t bufferOffsetsOff = base + header.vertexDataOffsOffset;
+		view.Check(bufferOffsetsOff, uint64_t(vertexInfo.bufferCount) * sizeof(uint32_t));
+		info.bufferOffset.reserve(vertexInfo.bufferCount);
+		info.bufferStride.reserve(vertexInfo.bufferCount);
+		for (uint8_t bIdx = 0; bIdx < vertexInfo.bufferCount; bIdx++)
 		{
-			uint32_t subMeshOffsetter = UINT32_MAX;
-			file.seekg((uint64_t)offset + 60 + (uint64_t)e * 4);
-			file.read((char*)&subMeshOffsetter, sizeof(uint32_t));
+			info.bufferOffset.push_back(view.Read<uint32_t>(bufferOffsetsOff + uint64_t(bIdx) * sizeof(uint32_t)));
+			uint16_t stride = 0;
+			for (const Component& component : info.Components)
+			{
+				if (component.bufferIndex == bIdx)
+					stride += DataTypeSize(component.dataType) * component.elementCount;
+			}
+			info.bufferStride.push_back(stride);
+		}
+		return info;
+	}
+}
+
+vector<MeshInfo> MGDefinition::ReadMG(std::span<const uint8_t> data)
+{
+	struct Part
+	{
+		uint32_t offset;
+		uint16_t lod;
+		uint16_t boneAssociated;
+	};
 
-			uint32_t partCount = UINT32_MAX;
-			file.seekg((uint64_t)offset + (uint64_t)subMeshOffsetter);
-			file.read((char*)&partCount, sizeof(uint32_t));
+	const DefView view(data);
+	const uint16_t defCount = view.Read<uint16_t>(56);
+	view.Check(76, uint64_t(defCount) * sizeof(uint32_t));
 
+	// walk the offset tables first so the result can be allocated once
+	vector<Part> parts;
+	for (uint16_t i = 0; i < defCount; i++)
+	{
+		const uint32_t offset = view.Read<uint32_t>(76 + uint64_t(i) * 4);
+		const uint16_t boneAsso = view.Read<uint16_t>(offset);
+		const uint8_t subMeshCount = view.Read<uint8_t>(uint64_t(offset) + 2);
+		for (uint8_t e = 0; e < subMeshCount; e++)
+		{
+			const uint32_t subMeshOffsetter = view.Read<uint32_t>(uint64_t(offset) + 60 + uint64_t(e) * 4);
+			const uint32_t partCount = view.Read<uint32_t>(uint64_t(offset) + subMeshOffsetter);
 			if (partCount == 0)
 				continue;
-
-			uint32_t partOffset = (uint32_t)file.tellg() + 8;
+			// part offsets are relative to their own slot in the table
+			const uint32_t partOffset = offset + subMeshOffsetter + 12;
+			view.Check(partOffset, uint64_t(partCount) * 4);
 			for (uint32_t c = 0; c < partCount; c++)
 			{
-				MeshInfo info;
-				info.LODlvl = e;
-				info.boneAssociated = boneAsso;
-				file.seekg((uint64_t)partOffset + (uint64_t)c * 4);
-				uint32_t off = UINT32_MAX;
-				file.read((char*)&off, sizeof(uint32_t));
-				off += partOffset + c * 4;
-
-				uint32_t smBaseOff = off;
-				file.seekg((uint64_t)smBaseOff + 48);
-
-				uint32_t indOff = UINT32_MAX;
-				file.read((char*)&indOff, sizeof(uint32_t));
-				info.indicesOffset = indOff;
-
-				file.seekg(4, std::ios::cur);
-				uint32_t vertOff = UINT32_MAX;
-				file.read((char*)&vertOff, sizeof(uint32_t));
-				info.vertexOffset = vertOff;
-
-				file.seekg(4, std::ios::cur);
-				uint32_t vertC = UINT32_MAX;
-				file.read((char*)&vertC, sizeof(uint32_t));
-				info.vertCount = vertC;
-				uint32_t indC = UINT32_MAX;
-				file.read((char*)&indC, sizeof(uint32_t));
-				info.indCount = indC;
-
-				file.seekg((uint64_t)smBaseOff + 16);
-				Vec3 extent;
-				file.read((char*)&extent.X, sizeof(float));
-				file.read((char*)&extent.Y, sizeof(float));
-				file.read((char*)&extent.Z, sizeof(float));
-				Vec3 origin;
-				file.read((char*)&origin.X, sizeof(float));
-				file.read((char*)&origin.Y, sizeof(float));
-				file.read((char*)&origin.Z, sizeof(float));
-
-				//std::cout << extent.X << " " << extent.Y << " " << extent.Z << " " << origin.X << " " << origin.Y << " " << origin.Z << std::endl;
-				Vec3 scale(extent.X * 2, extent.Y * 2, extent.Z * 2);
-				Vec3 min(origin.X - extent.X, origin.Y - extent.Y, origin.Z - extent.Z);
-
-				info.meshScale = scale;
-				info.meshMin = min;
-				file.seekg((uint64_t)smBaseOff + 84);
-
-				uint32_t vertexBlockInfoOffset = UINT32_MAX;
-				file.read((char*)&vertexBlockInfoOffset, sizeof(uint32_t));
-				uint32_t vertexBlockOffsetterOff = UINT32_MAX;
-				file.read((char*)&vertexBlockOffsetterOff, sizeof(uint32_t));
-
-				uint64_t Hash = UINT64_MAX;
-				file.read((char*)&Hash, sizeof(uint64_t));
-				info.Hash = Hash;
-
-				file.seekg((uint64_t)smBaseOff + (uint64_t)vertexBlockInfoOffset - 8);
-
-				uint8_t buffC = UINT8_MAX;
-				file.read((char*)&buffC, sizeof(uint8_t));
-				file.seekg(2, std::ios::cur);
-				uint8_t compC = UINT8_MAX;
-				file.read((char*)&compC, sizeof(uint8_t));
-
-				file.seekg(smBaseOff + vertexBlockOffsetterOff);
-				for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
-				{
-					uint32_t bufferOff = 0;
-					file.read((char*)&bufferOff, sizeof(uint32_t));
-					info.bufferOffset.push_back(bufferOff);
-				}
-
-				file.seekg((uint64_t)smBaseOff + (uint64_t)vertexBlockInfoOffset);
-
-				for (uint16_t d = 0; d < compC; d++)
-				{
-					Component component;
-					uint8_t val = 0;
-					file.read((char*)&val, sizeof(uint8_t));
-					component.primitiveType = static_cast<PrimitiveTypes>(val);
-					file.read((char*)&val, sizeof(uint8_t));
-					component.dataType = static_cast<DataTypes>(val);
-					if (component.primitiveType == PrimitiveTypes::UNKNOWN0)/* && (component.dataType != DataTypes::BYTE_STRUCT_0 && component.dataType != DataTypes::HALFWORD_STRUCT_1) && component.dataType != DataTypes::HALFWORD_STRUCT_2) */
-						cout << file.tellg() << "\n";
-					file.read((char*)&component.elementCount, sizeof(uint8_t));
-					file.read((char*)&component.offset, sizeof(uint8_t));
-					file.read((char*)&component.bufferIndex, sizeof(uint8_t));
-
-					file.seekg(3, std::ios::cur);
-
-					info.Components.push_back(component);
-				}
-				for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
-				{
-					uint16_t stride = 0;
-					for (uint8_t f = 0; f < info.Components.size(); f++)
-					{
-						if (bIdx == info.Components[f].bufferIndex)
-						{
-							switch (info.Components[f].dataType)
-							{
-							case DataTypes::FLOAT:
-								stride += 4 * info.Components[f].elementCount;
-								break;
-							case DataTypes::WORD_STRUCT_0:
-								stride += 4 * info.Components[f].elementCount;
-								break;
-							case DataTypes::WORD_STRUCT_1:
-								stride += 4 * info.Components[f].elementCount;
-								break;
-							case DataTypes::HALFWORD_STRUCT_0:
-								stride += 2 * info.Components[f].elementCount;
-								break;
-							case DataTypes::HALFWORD_STRUCT_1:
-								stride += 2 * info.Components[f].elementCount;
-								break;
-							case DataTypes::HALFWORD_STRUCT_2:
-								stride += 2 * info.Components[f].elementCount;
-								break;
-							case DataTypes::UNSIGNED_SHORT:
-								stride += 2 * info.Components[f].elementCount;
-								break;
-							case DataTypes::BYTE_STRUCT_0:
-								stride += 1 * info.Components[f].elementCount;
-								break;
-							default:
-								break;
-							}
-						}
-					}
-					info.bufferStride.push_back(stride);
-				}
-				meshesinfo.push_back(info);
+				const uint32_t slot = partOffset + c * 4;
+				parts.push_back({ view.Read<uint32_t>(slot) + slot, e, boneAsso });
 			}
 		}
 	}
+
+	vector<MeshInfo> meshesinfo;
+	meshesinfo.reserve(parts.size());
+	for (const Part& part : parts)
+	{
+		MeshInfo& info = meshesinfo.emplace_back(ReadMeshInfo(view, part.offset));
+		info.LODlvl = part.lod;
+		info.boneAssociated = part.boneAssociated;
+	}
 	return meshesinfo;
 }
-vector<MeshInfo> SmshDefinition::ReadSmsh(std::iostream& file)
+vector<MeshInfo> SmshDefinition::ReadSmsh(std::span<const uint8_t> data)
 {
-	uint32_t groupDataOffset = 0;
-	uint32_t meshDefSectionOff = 0;
-	uint32_t meshDefCnt = 0;
-	file.seekg(0x48, ios::beg);
-	file.read((char*)&groupDataOffset, sizeof(uint32_t));
-	groupDataOffset += 0x48;
-	file.seekg(0x58, ios::beg);
-	file.read((char*)&meshDefSectionOff, sizeof(uint32_t));
-	file.read((char*)&meshDefCnt, sizeof(uint32_t));
-	meshDefSectionOff += 0x58;
-
+	const DefView view(data);
+	const uint32_t groupDataOffset = view.Read<uint32_t>(0x48) + 0x48;
+	const uint32_t meshDefSectionOff = view.Read<uint32_t>(0x58) + 0x58;
+	const uint32_t meshDefCnt = view.Read<uint32_t>(0x5C);
+	view.Check(meshDefSectionOff, uint64_t(meshDefCnt) * 4);
+	view.Check(groupDataOffset, uint64_t(meshDefCnt) * 2);
 
 	uint64_t currHash = UINT64_MAX;
 	uint16_t curGroup = UINT16_MAX;
 	uint16_t curLod = 0;
 	vector<MeshInfo> meshinfos;
+	meshinfos.reserve(meshDefCnt);
 	for (uint32_t i = 0; i < meshDefCnt; i++)
 	{
-		file.seekg(meshDefSectionOff + i * 4, ios::beg);
-		uint32_t off = 0;
-		file.read((char*)&off, sizeof(uint32_t));
-		off += i * 4;
-		file.seekg(meshDefSectionOff + off, ios::beg);
-
-		file.seekg(0x10, ios::cur);
-		Vec3 extent;
-		file.read((char*)&extent.X, sizeof(float));
-		file.read((char*)&extent.Y, sizeof(float));
-		file.read((char*)&extent.Z, sizeof(float));
-		Vec3 origin;
-		file.read((char*)&origin.X, sizeof(float));
-		file.read((char*)&origin.Y, sizeof(float));
-		file.read((char*)&origin.Z, sizeof(float));
-
-		Vec3 scale(extent.X * 2, extent.Y * 2, extent.Z * 2);
-		Vec3 min(origin.X - extent.X, origin.Y - extent.Y, origin.Z - extent.Z);
-
-		MeshInfo info;
-		info.meshScale = scale;
-		info.meshMin = min;
+		const uint32_t off = view.Read<uint32_t>(uint64_t(meshDefSectionOff) + uint64_t(i) * 4) + i * 4;
+		MeshInfo& info = meshinfos.emplace_back(ReadMeshInfo(view, uint32_t(meshDefSectionOff + off)));
 		info.boneAssociated = 0;
 
-		file.seekg(meshDefSectionOff + off + 0x30, ios::beg);
-		uint32_t temp = 0;
-		file.read((char*)&temp, sizeof(uint32_t));
-		info.indicesOffset = temp;
-		file.seekg(4, std::ios::cur);
-		file.read((char*)&temp, sizeof(uint32_t));
-		info.vertexOffset = temp;
-		file.seekg(4, std::ios::cur);
-		file.read((char*)&info.vertCount, sizeof(uint32_t));
-		file.read((char*)&info.indCount, sizeof(uint32_t));
-
-		file.seekg(meshDefSectionOff + off + 0x54, ios::beg);
-		uint32_t vertexInfoOffset = 0;
-		uint32_t vertexDataOffsOffset = 0;
-		file.read((char*)&vertexInfoOffset, sizeof(uint32_t));
-		file.read((char*)&vertexDataOffsOffset, sizeof(uint32_t));
-		file.read((char*)&info.Hash, sizeof(uint64_t));
-
-		file.seekg(meshDefSectionOff + off + vertexInfoOffset - 8);
-
-		uint8_t buffC = 0;
-		file.read((char*)&buffC, sizeof(uint8_t));
-		file.seekg(2, std::ios::cur);
-		uint8_t compC = 0;
-		file.read((char*)&compC, sizeof(uint8_t));
-
-		file.seekg(meshDefSectionOff + off + vertexInfoOffset);
-		for (uint16_t d = 0; d < compC; d++)
-		{
-			Component component;
-			uint8_t val = 0;
-			file.read((char*)&val, sizeof(uint8_t));
-			component.primitiveType = static_cast<PrimitiveTypes>(val);
-			file.read((char*)&val, sizeof(uint8_t));
-			component.dataType = static_cast<DataTypes>(val);
-			file.read((char*)&component.elementCount, sizeof(uint8_t));
-			file.read((char*)&component.offset, sizeof(uint8_t));
-			file.read((char*)&component.bufferIndex, sizeof(uint8_t));
-
-			file.seekg(3, std::ios::cur);
-
-			info.Components.push_back(component);
-		}
-
-		for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
-		{
-			uint16_t stride = 0;
-			for (uint8_t f = 0; f < info.Components.size(); f++)
-			{
-				if (bIdx == info.Components[f].bufferIndex)
-				{
-					switch (info.Components[f].dataType)
-					{
-					case DataTypes::FLOAT:
-						stride += 4 * info.Components[f].elementCount;
-						break;
-					case DataTypes::WORD_STRUCT_0:
-						stride += 4 * info.Components[f].elementCount;
-						break;
-					case DataTypes::WORD_STRUCT_1:
-						stride += 4 * info.Components[f].elementCount;
-						break;
-					case DataTypes::HALFWORD_STRUCT_0:
-						stride += 2 * info.Components[f].elementCount;
-						break;
-					case DataTypes::HALFWORD_STRUCT_1:
-						stride += 2 * info.Components[f].elementCount;
-						break;
-					case DataTypes::HALFWORD_STRUCT_2:
-						stride += 2 * info.Components[f].elementCount;
-						break;
-					case DataTypes::UNSIGNED_SHORT:
-						stride += 2 * info.Components[f].elementCount;
-						break;
-					case DataTypes::BYTE_STRUCT_0:
-						stride += 1 * info.Components[f].elementCount;
-						break;
-					default:
-						break;
-					}
-				}
-			}
-			info.bufferStride.push_back(stride);
-		}
-
-		file.seekg(meshDefSectionOff + off + vertexDataOffsOffset);
-		for (uint8_t bIdx = 0; bIdx < buffC; bIdx++)
-		{
-			uint32_t bufferOff = 0;
-			file.read((char*)&bufferOff, sizeof(uint32_t));
-			info.bufferOffset.push_back(bufferOff);
-		}
-
-		file.seekg(groupDataOffset + i * 2, ios::beg);
-		uint16_t group = 0;
-		file.read((char*)&group, sizeof(uint16_t));
+		// a new hash inside the same group is the next lod of the previous mesh
+		const uint16_t group = view.Read<uint16_t>(uint64_t(groupDataOffset) + uint64_t(i) * 2);
 		if (curGroup == group && currHash != info.Hash)
 		{
 			++curLod;
@@ -334,12 +212,7 @@ vector<MeshInfo> SmshDefinition::ReadSmsh(std::iostream& file)
 			curLod = 0;
 		}
 		info.LODlvl = curLod;
-		if (currHash != info.Hash)
-		{
-			currHash = info.Hash;
-		}
-
-		meshinfos.push_back(info);
+		currHash = info.Hash;
 	}
 	return meshinfos;
 }
\ No newline at end of file
@@ -1,8 +1,245 @@
 #include "pch.h"
-#include "gnf.h"
+#include "Gnf.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	// position (y * 8 + x) inside an 8x8 tile of the k-th element in the tile's
+	// morton order, i.e. morton(k, 8, 8)
+	constexpr std::array<uint8_t, 64> MakeMortonTable()
+	{
+		std::array<uint8_t, 64> table{};
+		for (int k = 0; k < 64; k++)
+		{
+			int x = 0;
+			int y = 0;
+			for (int bit = 0; bit < 3; bit++)
+			{
+				x |= ((k >> (bit * 2)) & 1) << bit;
+				y |= ((k >> (bit * 2 + 1)) & 1) << bit;
+			}
+			table[k] = uint8_t(y * 8 + x);
+		}
+		return table;
+	}
+	// morton index of every tile position, the inverse of MortonTable
+	constexpr std::array<uint8_t, 64> MakeLinearTable()
+	{
+		constexpr std::array<uint8_t, 64> morton = MakeMortonTable();
+		std::array<uint8_t, 64> table{};
+		for (int k = 0; k < 64; k++)
+		{
+			table[morton[k]] = uint8_t(k);
+		}
+		return table;
+	}
+	constexpr std::array<uint8_t, 64> MortonTable = MakeMortonTable();
+	constexpr std::array<uint8_t, 64> LinearTable = MakeLinearTable();
+
+	template<size_t N>
+	inline void CopyElement(byte* dst, const byte* src)
+	{
+#if defined(_M_X64) || defined(__SSE2__)
+		if constexpr (N == 16)
+		{
+			_mm_storeu_si128((__m128i*)dst, _mm_loadu_si128((const __m128i*)src));
+			return;
+		}
+#endif
+		memcpy(dst, src, N);
+	}
+
+	// fast paths for images made of whole tiles, which is every mip the converter
+	// hands in since pitch and height are padded to at least 16 (R8) / 32 (BC) pixels.
+	// Unswizzling only writes the top left dstCols x dstRows elements, so padded mips
+	// can go straight into their final place. Destination rows of a tile are written
+	// front to back, source reads stay inside the tile's 64 elements.
+	template<size_t N>
+	void UnSwizzleTiles(const byte* src, byte* dst, uint32_t cols, uint32_t rows, uint32_t dstCols, uint32_t dstRows)
+	{
+		const size_t pitch = size_t(dstCols) * N;
+		for (uint32_t ty = 0; ty < rows; ty += 8)
+		{
+			for (uint32_t tx = 0; tx < cols; tx += 8, src += 64 * N)
+			{
+				if (tx >= dstCols || ty >= dstRows)
+					continue;
+				byte* tile = dst + ty * pitch + tx * N;
+				if (tx + 8 <= dstCols && ty + 8 <= dstRows)
+				{
+					for (uint32_t y = 0; y < 8; y++)
+					{
+						byte* row = tile + y * pitch;
+						const uint8_t* linear = LinearTable.data() + y * 8;
+						for (uint32_t x = 0; x < 8; x++)
+						{
+							CopyElement<N>(row + x * N, src + linear[x] * N);
+						}
+					}
+				}
+				else
+				{
+					const uint32_t w = std::min<uint32_t>(8, dstCols - tx);
+					const uint32_t h = std::min<uint32_t>(8, dstRows - ty);
+					for (uint32_t y = 0; y < h; y++)
+					{
+						byte* row = tile + y * pitch;
+						const uint8_t* linear = LinearTable.data() + y * 8;
+						for (uint32_t x = 0; x < w; x++)
+						{
+							CopyElement<N>(row + x * N, src + linear[x] * N);
+						}
+					}
+				}
+			}
+		}
+	}
+	template<size_t N>
+	void SwizzleTiles(const byte* src, byte* dst, uint32_t cols, uint32_t rows)
+	{
+		const size_t pitch = size_t(cols) * N;
+		for (uint32_t ty = 0; ty < rows; ty += 8)
+		{
+			for (uint32_t tx = 0; tx < cols; tx += 8)
+			{
+				const byte* tile = src + ty * pitch + tx * N;
+				for (uint32_t k = 0; k < 64; k++)
+				{
+					const uint8_t pos = MortonTable[k];
+					CopyElement<N>(dst, tile + (pos >> 3) * pitch + (pos & 7) * N);
+					dst += N;
+				}
+			}
+		}
+	}
+
+	// generic paths for partial tiles, same element order as the original per-element loops:
+	// unswizzling skips the source elements of a tile that fall outside the image,
+	// swizzling packs the elements that are inside without gaps
+	void UnSwizzleGeneric(const byte* src, byte* dst, uint32_t cols, uint32_t rows, uint32_t dstCols, uint32_t dstRows, uint32_t elemSize)
+	{
+		for (uint32_t ty = 0; ty < rows; ty += 8)
+		{
+			for (uint32_t tx = 0; tx < cols; tx += 8)
+			{
+				for (uint32_t k = 0; k < 64; k++)
+				{
+					const uint32_t x = tx + (MortonTable[k] & 7);
+					const uint32_t y = ty + (MortonTable[k] >> 3);
+					if (x < dstCols && y < dstRows)
+						memcpy(dst + (size_t(y) * dstCols + x) * elemSize, src, elemSize);
+					src += elemSize;
+				}
+			}
+		}
+	}
+	void SwizzleGeneric(const byte* src, byte* dst, uint32_t cols, uint32_t rows, uint32_t elemSize)
+	{
+		for (uint32_t ty = 0; ty < rows; ty += 8)
+		{
+			for (uint32_t tx = 0; tx < cols; tx += 8)
+			{
+				for (uint32_t k = 0; k < 64; k++)
+				{
+					const uint32_t x = tx + (MortonTable[k] & 7);
+					const uint32_t y = ty + (MortonTable[k] >> 3);
+					if (x < cols && y < rows)
+					{
+						memcpy(dst, src + (size_t(y) * cols + x) * elemSize, elemSize);
+						dst += elemSize;
+					}
+				}
+			}
+		}
+	}
+
+	template<template<size_t> class Kernels, typename TileKernel = decltype(&Kernels<1>::Run)>
+	TileKernel SelectKernel(uint32_t elemSize)
+	{
+		switch (elemSize)
+		{
+		case 1: return Kernels<1>::Run;
+		case 2: return Kernels<2>::Run;
+		case 4: return Kernels<4>::Run;
+		case 8: return Kernels<8>::Run;
+		case 12: return Kernels<12>::Run;
+		case 16: return Kernels<16>::Run;
+		default: return nullptr;
+		}
+	}
+	template<size_t N>
+	struct UnSwizzleKernel
+	{
+		static void Run(const byte* src, byte* dst, uint32_t cols, uint32_t rows, uint32_t dstCols, uint32_t dstRows)
+		{
+			UnSwizzleTiles<N>(src, dst, cols, rows, dstCols, dstRows);
+		}
+	};
+	template<size_t N>
+	struct SwizzleKernel
+	{
+		static void Run(const byte* src, byte* dst, uint32_t cols, uint32_t rows) { SwizzleTiles<N>(src, dst, cols, rows); }
+	};
+}
 
 namespace Gnf
 {
+	namespace
+	{
+		constexpr FormatInfo Uncompressed(uint16_t bpp, uint8_t channels)
+		{
+			return FormatInfo{ bpp, 1, 16, channels };
+		}
+		constexpr FormatInfo Block(uint16_t bpp, uint8_t channels)
+		{
+			return FormatInfo{ bpp, 4, 32, channels };
+		}
+		constexpr std::array<FormatInfo, 64> MakeFormatTable()
+		{
+			// only formats the converter maps to dxgi, 11_11_10, 10_10_10_2 and 5_5_5_1 store
+			// their components in the opposite order of any dxgi format and have no entry
+			std::array<FormatInfo, 64> table{};
+			table[uint32_t(Format::Format8)] = Uncompressed(8, 1);
+			table[uint32_t(Format::Format16)] = Uncompressed(16, 1);
+			table[uint32_t(Format::Format8_8)] = Uncompressed(16, 2);
+			table[uint32_t(Format::Format32)] = Uncompressed(32, 1);
+			table[uint32_t(Format::Format16_16)] = Uncompressed(32, 2);
+			table[uint32_t(Format::Format10_11_11)] = Uncompressed(32, 3);
+			table[uint32_t(Format::Format2_10_10_10)] = Uncompressed(32, 4);
+			table[uint32_t(Format::Format8_8_8_8)] = Uncompressed(32, 4);
+			table[uint32_t(Format::Format32_32)] = Uncompressed(64, 2);
+			table[uint32_t(Format::Format16_16_16_16)] = Uncompressed(64, 4);
+			table[uint32_t(Format::Format32_32_32)] = Uncompressed(96, 3);
+			table[uint32_t(Format::Format32_32_32_32)] = Uncompressed(128, 4);
+			table[uint32_t(Format::Format5_6_5)] = Uncompressed(16, 3);
+			table[uint32_t(Format::Format1_5_5_5)] = Uncompressed(16, 4);
+			table[uint32_t(Format::Format4_4_4_4)] = Uncompressed(16, 4);
+			table[uint32_t(Format::Format5_9_9_9)] = Uncompressed(32, 3);
+			table[uint32_t(Format::FormatBC1)] = Block(4, 4);
+			table[uint32_t(Format::FormatBC2)] = Block(8, 4);
+			table[uint32_t(Format::FormatBC3)] = Block(8, 4);
+			table[uint32_t(Format::FormatBC4)] = Block(4, 1);
+			table[uint32_t(Format::FormatBC5)] = Block(8, 2);
+			table[uint32_t(Format::FormatBC6)] = Block(8, 3);
+			table[uint32_t(Format::FormatBC7)] = Block(8, 4);
+			return table;
+		}
+		constexpr std::array<FormatInfo, 64> FormatTable = MakeFormatTable();
+	}
+
+	const FormatInfo* GetFormatInfo(Format format)
+	{
+		uint32_t idx = uint32_t(format);
+		if (idx >= FormatTable.size() || FormatTable[idx].bpp == 0)
+			return nullptr;
+		return &FormatTable[idx];
+	}
+
 	GnfImage::GnfImage()
 	{
 		imageData = std::make_shared<byte[]>(0x100);
@@ -23,7 +260,16 @@ namespace Gnf
 
 		return;
 	}
+	uint32_t GnfImage::ElementSize(const uint16_t& bpp, const uint16_t& pixbl)
+	{
+		// a block of pixbl * pixbl pixels, or a single pixel for uncompressed formats
+		return pixbl == 1 ? bpp / 8 : bpp * 2;
+	}
 	void GnfImage::UnSwizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h,const uint16_t &bpp, const uint16_t &pixbl)
+	{
+		UnSwizzle(src, dst, w, h, bpp, pixbl, w, h);
+	}
+	void GnfImage::UnSwizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl, const uint16_t& dstW, const uint16_t& dstH)
 	{
 		size_t min = pixbl * pixbl * bpp / 8;
 		uint32_t num2 = w * h * bpp / 8;
@@ -33,42 +279,16 @@ namespace Gnf
 			return;
 		}
 
-		uint32_t num4 = pixbl; // sub to change
-		uint32_t num5 = bpp * 2;
-		if (num4 == 1)
-		{
-			num5 = bpp / 8;
-		}
-		byte* array1 = new byte[num2 * 2];
-		byte* array2 = new byte[16];
-		int num6 = h / num4;
-		int num7 = w / num4;
-		int roff = 0;
-		for (int i = 0; i < (num6 + 7) / 8; i++)
-		{
-			for (int j = 0; j < (num7 + 7) / 8; j++)
-			{
-				for (int k = 0; k < 64; k++)
-				{
-					int num8 = morton(k, 8, 8);
-					int num9 = num8 / 8;
-					int num10 = num8 % 8;
-					memcpy(array2, src + roff, num5);
-					roff += num5;
-					if (j * 8 + num10 < num7 && i * 8 + num9 < num6)
-					{
-						int destinationIndex = num5 * ((i * 8 + num9) * num7 + j * 8 + num10);
-						memcpy(array1 + destinationIndex, array2, num5);
-					}
-				}
-			}
-		}
-
-		memcpy(dst, array1, num2);
-
-		delete[] array1;
-		delete[] array2;
-		return;
+		const uint32_t elemSize = ElementSize(bpp, pixbl);
+		const uint32_t rows = h / pixbl;
+		const uint32_t cols = w / pixbl;
+		const uint32_t dstRows = std::min<uint32_t>(dstH / pixbl, rows);
+		const uint32_t dstCols = std::min<uint32_t>(dstW / pixbl, cols);
+		auto kernel = SelectKernel<UnSwizzleKernel>(elemSize);
+		if (kernel != nullptr && rows % 8 == 0 && cols % 8 == 0)
+			kernel(src, dst, cols, rows, dstCols, dstRows);
+		else
+			UnSwizzleGeneric(src, dst, cols, rows, dstCols, dstRows, elemSize);
 	}
 	void GnfImage::Swizzle(const byte* src, byte* dst, const uint16_t& w, const uint16_t& h, const uint16_t& bpp, const uint16_t& pixbl)
 	{
@@ -80,38 +300,14 @@ namespace Gnf
 			return;
 		}
 
-		uint32_t num4 = pixbl; // sub to change
-		uint32_t num5 = bpp * 2;
-		if (num4 == 1)
-		{
-			num5 = bpp / 8;
-		}
-		byte* array1 = new byte[num2 * 2];
-		int num6 = h / num4;
-		int num7 = w / num4;
-		int roff = 0;
-		for (int i = 0; i < (num6 + 7) / 8; i++)
-		{
-			for (int j = 0; j < (num7 + 7) / 8; j++)
-			{
-				for (int k = 0; k < 64; k++)
-				{
-					int num8 = morton(k, 8, 8);
-					int num9 = num8 / 8;
-					int num10 = num8 % 8;
-					if (j * 8 + num10 < num7 && i * 8 + num9 < num6)
-					{
-						int destinationIndex = num5 * ((i * 8 + num9) * num7 + j * 8 + num10);
-						memcpy(array1 + roff, src + destinationIndex, num5);
-						roff += num5;
-					}
-				}
-			}
-		}
-		memcpy(dst, array1, num2);
-
-		delete[] array1;
-		return;
+		const uint32_t elemSize = ElementSize(bpp, pixbl);
+		const uint32_t rows = h / pixbl;
+		const uint32_t cols = w / pixbl;
+		auto kernel = SelectKernel<SwizzleKernel>(elemSize);
+		if (kernel != nullptr && rows % 8 == 0 && cols % 8 == 0)
+			kernel(src, dst, cols, rows);
+		else
+			SwizzleGeneric(src, dst, cols, rows, elemSize);
 	}
 	int GnfImage::morton(int t, int sx, int sy)
 	{
@@ -0,0 +1,2510 @@
+// Port of the Kraken/Mermaid decoder of ooz (https://github.com/powzix/ooz),
+// Copyright (C) 2016 Powzix, licensed under the GNU General Public License v3.0.
+// This file is distributed under the same license.
+#include "pch.h"
+#include "Kraken.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstring>
+
+// Block, quantum and entropy formats are those of ooz. Readers load whole words past
+// the ends of their streams, the compressed data is decoded from a padded copy, the
+// LZ copies never write past the end of the output.
+namespace
+{
+	constexpr size_t BlockSize = 0x40000;
+	constexpr size_t ChunkSize = 0x20000;
+	constexpr size_t ScratchSize = 0x6C000;
+	constexpr size_t SourcePadding = 64;
+
+	enum DecoderType
+	{
+		KrakenDecoder = 6,
+		MermaidDecoder = 10
+	};
+
+	inline uint16_t Load16(const byte* p)
+	{
+		uint16_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+	inline uint32_t Load32(const byte* p)
+	{
+		uint32_t v;
+		memcpy(&v, p, sizeof(v));
+		return v;
+	}
+	inline uint32_t ByteSwap32(uint32_t v)
+	{
+		return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+	}
+	inline uint32_t Load24BE(const byte* p)
+	{
+		return (uint32_t(p[0]) << 16) | (uint32_t(p[1]) << 8) | p[2];
+	}
+	inline int HighBit(uint32_t v)
+	{
+		return 31 - std::countl_zero(v);
+	}
+	template<typename T>
+	inline T* AlignPointer(T* p, size_t align)
+	{
+		return (T*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+	}
+
+	// MSB first reader, the next bit is the top one of bits, bitpos > 0 means bytes are missing
+	struct BitReader
+	{
+		const byte* p;
+		const byte* pEnd;
+		uint32_t bits;
+		int bitpos;
+
+		void Init(const byte* begin, const byte* end)
+		{
+			p = begin;
+			pEnd = end;
+			bits = 0;
+			bitpos = 24;
+			Refill();
+		}
+		void InitBackwards(const byte* begin, const byte* end)
+		{
+			p = begin;
+			pEnd = end;
+			bits = 0;
+			bitpos = 24;
+			RefillBackwards();
+		}
+		void Refill()
+		{
+			while (bitpos > 0)
+			{
+				bits |= uint32_t(p < pEnd ? *p : 0) << bitpos;
+				bitpos -= 8;
+				p++;
+			}
+		}
+		// reads towards pEnd, which lies before p
+		void RefillBackwards()
+		{
+			while (bitpos > 0)
+			{
+				p--;
+				bits |= uint32_t(p >= pEnd ? *p : 0) << bitpos;
+				bitpos -= 8;
+			}
+		}
+		int ReadBit()
+		{
+			Refill();
+			return ReadBitNoRefill();
+		}
+		int ReadBitNoRefill()
+		{
+			int r = bits >> 31;
+			bits <<= 1;
+			bitpos += 1;
+			return r;
+		}
+		// 1 to 24 bits
+		uint32_t ReadBitsNoRefill(int n)
+		{
+			uint32_t r = bits >> (32 - n);
+			bits <<= n;
+			bitpos += n;
+			return r;
+		}
+		// 0 to 24 bits
+		uint32_t ReadBitsNoRefillZero(int n)
+		{
+			uint32_t r = bits >> 1 >> (31 - n);
+			bits <<= n;
+			bitpos += n;
+			return r;
+		}
+		template<bool Backwards>
+		void RefillDir()
+		{
+			if constexpr (Backwards)
+				RefillBackwards();
+			else
+				Refill();
+		}
+		template<bool Backwards>
+		uint32_t ReadMoreThan24Bits(int n)
+		{
+			uint32_t rv;
+			if (n <= 24)
+			{
+				rv = ReadBitsNoRefillZero(n);
+			}
+			else
+			{
+				rv = ReadBitsNoRefill(24) << (n - 24);
+				RefillDir<Backwards>();
+				rv += ReadBitsNoRefill(n - 24);
+			}
+			RefillDir<Backwards>();
+			return rv;
+		}
+		// kraken match distance, v is its byte from the packed offset stream
+		template<bool Backwards>
+		uint32_t ReadDistance(uint32_t v)
+		{
+			uint32_t w, m, n, rv;
+			if (v < 0xF0)
+			{
+				n = (v >> 4) + 4;
+				w = std::rotl(bits | 1, int(n));
+				bitpos += n;
+				m = (2u << n) - 1;
+				bits = w & ~m;
+				rv = ((w & m) << 4) + (v & 0xF) - 248;
+			}
+			else
+			{
+				n = v - 0xF0 + 4;
+				w = std::rotl(bits | 1, int(n));
+				bitpos += n;
+				m = (2u << n) - 1;
+				bits = w & ~m;
+				rv = 8322816 + ((w & m) << 12);
+				RefillDir<Backwards>();
+				rv += bits >> 20;
+				bitpos += 12;
+				bits <<= 12;
+			}
+			RefillDir<Backwards>();
+			return rv;
+		}
+		template<bool Backwards>
+		bool ReadLength(uint32_t& v)
+		{
+			if (bits == 0)
+				return false;
+			int n = std::countl_zero(bits);
+			if (n > 12)
+				return false;
+			bitpos += n;
+			bits <<= n;
+			RefillDir<Backwards>();
+			n += 7;
+			bitpos += n;
+			v = (bits >> (32 - n)) - 64;
+			bits <<= n;
+			RefillDir<Backwards>();
+			return true;
+		}
+		// number of symbols left out of a sparse symbol range list
+		int ReadFluff(int numSymbols)
+		{
+			if (numSymbols == 256)
+				return 0;
+			int x = std::min(257 - numSymbols, numSymbols) * 2;
+			int y = HighBit(uint32_t(x - 1)) + 1;
+			uint32_t v = bits >> (32 - y);
+			uint32_t z = (1u << y) - x;
+			if ((v >> 1) >= z)
+			{
+				bits <<= y;
+				bitpos += y;
+				return int(v - z);
+			}
+			bits <<= (y - 1);
+			bitpos += (y - 1);
+			return int(v >> 1);
+		}
+		// byte holding the next unread bit and the bits of it already read
+		const byte* Position() const
+		{
+			return p - ((24 - bitpos) >> 3);
+		}
+	};
+
+	// byte aligned reader for the golomb-rice coded code lengths
+	struct BitReader2
+	{
+		const byte* p;
+		const byte* pEnd;
+		uint32_t bitpos;
+
+		void From(const BitReader& br)
+		{
+			p = br.p - ((24 - br.bitpos + 7) >> 3);
+			pEnd = br.pEnd;
+			bitpos = (br.bitpos - 24) & 7;
+		}
+		void To(BitReader& br) const
+		{
+			br.bitpos = 24;
+			br.p = p;
+			br.bits = 0;
+			br.Refill();
+			br.bits <<= bitpos;
+			br.bitpos += bitpos;
+		}
+	};
+
+	// per byte value: the unary run lengths it completes, low nibbles first, and the
+	// zeros left over after its last one bit in the top nibble
+	struct RiceTables
+	{
+		uint32_t value[256];
+		uint8_t length[256];
+		constexpr RiceTables() : value(), length()
+		{
+			for (uint32_t v = 1; v < 256; v++)
+			{
+				uint32_t nibbles[8] = {};
+				uint32_t count = 0, zeros = 0;
+				for (int bit = 7; bit >= 0; bit--)
+				{
+					if (v & (1u << bit))
+					{
+						nibbles[count++] = zeros;
+						zeros = 0;
+					}
+					else
+					{
+						zeros++;
+					}
+				}
+				if (count < 8)
+					nibbles[7] = zeros;
+				uint32_t x = 0;
+				for (uint32_t i = 0; i < 4; i++)
+					x |= (nibbles[i] | (nibbles[i + 4] << 4)) << (8 * i);
+				value[v] = x;
+				length[v] = uint8_t(count);
+			}
+		}
+	};
+	constexpr RiceTables Rice;
+
+	// unary coded values, each is the number of zero bits before a one
+	bool DecodeGolombRiceLengths(uint8_t* dst, size_t size, BitReader2& br)
+	{
+		const byte* p = br.p;
+		const byte* pEnd = br.pEnd;
+		uint8_t* dstEnd = dst + size;
+		if (p >= pEnd)
+			return false;
+
+		int count = -int(br.bitpos);
+		uint32_t v = *p++ & (255 >> br.bitpos);
+		for (;;)
+		{
+			if (v == 0)
+			{
+				count += 8;
+			}
+			else
+			{
+				uint32_t x = Rice.value[v];
+				uint32_t lo = count + (x & 0x0F0F0F0F);
+				uint32_t hi = (x >> 4) & 0x0F0F0F0F;
+				memcpy(dst, &lo, 4);
+				memcpy(dst + 4, &hi, 4);
+				dst += Rice.length[v];
+				if (dst >= dstEnd)
+					break;
+				count = x >> 28;
+			}
+			if (p >= pEnd)
+				return false;
+			v = *p++;
+		}
+		// the last byte completed more values than asked for, drop their one bits
+		if (dst > dstEnd)
+		{
+			ptrdiff_t n = dst - dstEnd;
+			do
+				v &= v - 1;
+			while (--n);
+		}
+		uint32_t bitpos = 0;
+		if (!(v & 1))
+		{
+			p--;
+			bitpos = 8 - std::countr_zero(v);
+		}
+		br.p = p;
+		br.bitpos = bitpos;
+		return true;
+	}
+
+	// appends bitcount more bits below every value
+	bool DecodeGolombRiceBits(uint8_t* dst, uint32_t size, uint32_t bitcount, BitReader2& br)
+	{
+		if (bitcount == 0)
+			return true;
+		const byte* p = br.p;
+		uint32_t bitsRequired = br.bitpos + bitcount * size;
+		uint32_t bytesRequired = (bitsRequired + 7) >> 3;
+		if (bytesRequired > size_t(br.pEnd - p))
+			return false;
+
+		uint32_t bitpos = br.bitpos;
+		for (uint32_t i = 0; i < size; i++)
+		{
+			uint32_t v = 0;
+			for (uint32_t b = 0; b < bitcount; b++, bitpos++)
+				v = (v << 1) | ((p[bitpos >> 3] >> (7 - (bitpos & 7))) & 1);
+			dst[i] = uint8_t((dst[i] << bitcount) + v);
+		}
+		br.p = p + (bitsRequired >> 3);
+		br.bitpos = bitsRequired & 7;
+		return true;
+	}
+
+	struct HuffRange
+	{
+		uint16_t symbol;
+		uint16_t num;
+	};
+
+	// runs of used symbols from the interleaved run and gap lengths in symlen
+	int HuffConvertToRanges(HuffRange* range, int numSymbols, int fluff, const uint8_t* symlen, BitReader& bits)
+	{
+		int numRanges = fluff >> 1, v, symIdx = 0;
+		if (fluff & 1)
+		{
+			bits.Refill();
+			v = *symlen++;
+			if (v >= 8)
+				return -1;
+			symIdx = bits.ReadBitsNoRefill(v + 1) + (1 << (v + 1)) - 1;
+		}
+		int symsUsed = 0;
+		for (int i = 0; i < numRanges; i++)
+		{
+			bits.Refill();
+			v = symlen[0];
+			if (v >= 9)
+				return -1;
+			int num = bits.ReadBitsNoRefillZero(v) + (1 << v);
+			v = symlen[1];
+			if (v >= 8)
+				return -1;
+			int space = bits.ReadBitsNoRefill(v + 1) + (1 << (v + 1)) - 1;
+			range[i].symbol = uint16_t(symIdx);
+			range[i].num = uint16_t(num);
+			symsUsed += num;
+			symIdx += num + space;
+			symlen += 2;
+		}
+		if (symIdx >= 256 || symsUsed >= numSymbols || symIdx + numSymbols - symsUsed > 256)
+			return -1;
+		range[numRanges].symbol = uint16_t(symIdx);
+		range[numRanges].num = uint16_t(numSymbols - symsUsed);
+		return numRanges + 1;
+	}
+
+	// symbols are sorted into syms by code length, codePrefix[len] is the next free slot of a length
+	constexpr uint32_t CodePrefixOrg[12] = { 0x0, 0x0, 0x2, 0x6, 0xE, 0x1E, 0x3E, 0x7E, 0xFE, 0x1FE, 0x2FE, 0x3FE };
+
+	int HuffReadCodeLengthsOld(BitReader& bits, uint8_t* syms, uint32_t* codePrefix)
+	{
+		if (bits.ReadBitNoRefill())
+		{
+			int n, sym = 0, codelen, numSymbols = 0;
+			int avgBitsX4 = 32;
+			int forcedBits = bits.ReadBitsNoRefill(2);
+			uint32_t thresForValidGammaBits = 1u << (31 - (20u >> forcedBits));
+			bool skipInitialZeros = bits.ReadBit();
+			for (;;)
+			{
+				if (!skipInitialZeros)
+				{
+					if (!(bits.bits & 0xff000000))
+						return -1;
+					sym += bits.ReadBitsNoRefill(2 * (std::countl_zero(bits.bits) + 1)) - 2 + 1;
+					if (sym >= 256)
+						break;
+				}
+				skipInitialZeros = false;
+				bits.Refill();
+				if (!(bits.bits & 0xff000000))
+					return -1;
+				n = bits.ReadBitsNoRefill(2 * (std::countl_zero(bits.bits) + 1)) - 2 + 1;
+				if (sym + n > 256)
+					return -1;
+				bits.Refill();
+				numSymbols += n;
+				do
+				{
+					if (bits.bits < thresForValidGammaBits)
+						return -1;
+					int lz = std::countl_zero(bits.bits);
+					int v = bits.ReadBitsNoRefill(lz + forcedBits + 1) + ((lz - 1) << forcedBits);
+					codelen = (-(v & 1) ^ (v >> 1)) + ((avgBitsX4 + 2) >> 2);
+					if (codelen < 1 || codelen > 11)
+						return -1;
+					avgBitsX4 = codelen + ((3 * avgBitsX4 + 2) >> 2);
+					bits.Refill();
+					syms[codePrefix[codelen]++] = uint8_t(sym++);
+				} while (--n);
+				if (sym == 256)
+					break;
+			}
+			if (sym != 256 || numSymbols < 2)
+				return -1;
+			return numSymbols;
+		}
+
+		// sparse symbol list
+		int numSymbols = bits.ReadBitsNoRefill(8);
+		if (numSymbols == 0)
+			return -1;
+		if (numSymbols == 1)
+		{
+			syms[0] = uint8_t(bits.ReadBitsNoRefill(8));
+		}
+		else
+		{
+			int codelenBits = bits.ReadBitsNoRefill(3);
+			if (codelenBits > 4)
+				return -1;
+			for (int i = 0; i < numSymbols; i++)
+			{
+				bits.Refill();
+				int sym = bits.ReadBitsNoRefill(8);
+				int codelen = bits.ReadBitsNoRefillZero(codelenBits) + 1;
+				if (codelen > 11)
+					return -1;
+				syms[codePrefix[codelen]++] = uint8_t(sym);
+			}
+		}
+		return numSymbols;
+	}
+
+	int HuffReadCodeLengthsNew(BitReader& bits, uint8_t* syms, uint32_t* codePrefix)
+	{
+		int forcedBits = bits.ReadBitsNoRefill(2);
+		int numSymbols = bits.ReadBitsNoRefill(8) + 1;
+		int fluff = bits.ReadFluff(numSymbols);
+
+		uint8_t codeLen[512 + 16];
+		BitReader2 br2;
+		br2.From(bits);
+		if (!DecodeGolombRiceLengths(codeLen, numSymbols + fluff, br2))
+			return -1;
+		memset(codeLen + (numSymbols + fluff), 0, 16);
+		if (!DecodeGolombRiceBits(codeLen, numSymbols, forcedBits, br2))
+			return -1;
+		br2.To(bits);
+
+		uint32_t runningSum = 0x1e;
+		for (int i = 0; i < numSymbols; i++)
+		{
+			int v = codeLen[i];
+			v = -(v & 1) ^ (v >> 1);
+			int len = v + int(runningSum >> 2) + 1;
+			if (len < 1 || len > 11)
+				return -1;
+			codeLen[i] = uint8_t(len);
+			runningSum += v;
+		}
+
+		HuffRange range[128];
+		int ranges = HuffConvertToRanges(range, numSymbols, fluff, &codeLen[numSymbols], bits);
+		if (ranges <= 0)
+			return -1;
+
+		const uint8_t* cp = codeLen;
+		for (int i = 0; i < ranges; i++)
+		{
+			int sym = range[i].symbol;
+			int n = range[i].num;
+			do
+				syms[codePrefix[*cp++]++] = uint8_t(sym++);
+			while (--n);
+		}
+		return numSymbols;
+	}
+
+	// 11 bit lookup of the length and symbol of the next code, indexed LSB first
+	struct HuffLut
+	{
+		uint8_t bits2len[2048];
+		uint8_t bits2sym[2048];
+	};
+
+	bool HuffMakeLut(const uint32_t* prefixCur, const uint8_t* syms, HuffLut& lut)
+	{
+		// canonical codes are assigned MSB first, the readers consume them LSB first
+		HuffLut msb;
+		uint32_t currslot = 0;
+		for (uint32_t i = 1; i < 11; i++)
+		{
+			uint32_t start = CodePrefixOrg[i], count = prefixCur[i] - start;
+			if (count == 0)
+				continue;
+			uint32_t stepsize = 1 << (11 - i);
+			uint32_t numToSet = count << (11 - i);
+			if (currslot + numToSet > 2048)
+				return false;
+			memset(&msb.bits2len[currslot], int(i), numToSet);
+			for (uint32_t j = 0; j < count; j++)
+				memset(&msb.bits2sym[currslot + j * stepsize], syms[start + j], stepsize);
+			currslot += numToSet;
+		}
+		uint32_t count = prefixCur[11] - CodePrefixOrg[11];
+		if (count != 0)
+		{
+			if (currslot + count > 2048)
+				return false;
+			memset(&msb.bits2len[currslot], 11, count);
+			memcpy(&msb.bits2sym[currslot], &syms[CodePrefixOrg[11]], count);
+			currslot += count;
+		}
+		if (currslot != 2048)
+			return false;
+
+		for (uint32_t i = 0; i < 2048; i++)
+		{
+			uint32_t r = 0;
+			for (uint32_t b = 0; b < 11; b++)
+				r |= ((i >> b) & 1) << (10 - b);
+			lut.bits2len[i] = msb.bits2len[r];
+			lut.bits2sym[i] = msb.bits2sym[r];
+		}
+		return true;
+	}
+
+	// three interleaved streams: forward from src, backward from srcEnd and forward from srcMid
+	struct HuffReader
+	{
+		byte* output;
+		byte* outputEnd;
+		const byte* src;
+		const byte* srcMid;
+		const byte* srcEnd;
+		const byte* srcMidOrg;
+	};
+
+	bool HuffDecodeCore(const HuffReader& hr, const HuffLut& lut)
+	{
+		const byte* src = hr.src;
+		uint32_t srcBits = 0;
+		int srcBitpos = 0;
+		const byte* srcMid = hr.srcMid;
+		uint32_t srcMidBits = 0;
+		int srcMidBitpos = 0;
+		const byte* srcEnd = hr.srcEnd;
+		uint32_t srcEndBits = 0;
+		int srcEndBitpos = 0;
+		byte* dst = hr.output;
+		byte* dstEnd = hr.outputEnd;
+		uint32_t k, n;
+
+		if (src > srcMid)
+			return false;
+
+		if (hr.srcEnd - srcMid >= 4 && dstEnd - dst >= 6)
+		{
+			dstEnd -= 5;
+			srcEnd -= 4;
+			while (dst < dstEnd && src <= srcMid && srcMid <= srcEnd)
+			{
+				srcBits |= Load32(src) << srcBitpos;
+				src += (31 - srcBitpos) >> 3;
+				srcEndBits |= ByteSwap32(Load32(srcEnd)) << srcEndBitpos;
+				srcEnd -= (31 - srcEndBitpos) >> 3;
+				srcMidBits |= Load32(srcMid) << srcMidBitpos;
+				srcMid += (31 - srcMidBitpos) >> 3;
+				srcBitpos |= 0x18;
+				srcEndBitpos |= 0x18;
+				srcMidBitpos |= 0x18;
+
+				for (int i = 0; i < 2; i++)
+				{
+					k = srcBits & 0x7FF;
+					n = lut.bits2len[k];
+					srcBits >>= n;
+					srcBitpos -= n;
+					dst[0] = lut.bits2sym[k];
+
+					k = srcEndBits & 0x7FF;
+					n = lut.bits2len[k];
+					srcEndBits >>= n;
+					srcEndBitpos -= n;
+					dst[1] = lut.bits2sym[k];
+
+					k = srcMidBits & 0x7FF;
+					n = lut.bits2len[k];
+					srcMidBits >>= n;
+					srcMidBitpos -= n;
+					dst[2] = lut.bits2sym[k];
+					dst += 3;
+				}
+			}
+			dstEnd += 5;
+			src -= srcBitpos >> 3;
+			srcBitpos &= 7;
+			srcEnd += 4 + (srcEndBitpos >> 3);
+			srcEndBitpos &= 7;
+			srcMid -= srcMidBitpos >> 3;
+			srcMidBitpos &= 7;
+		}
+
+		for (;;)
+		{
+			if (dst >= dstEnd)
+				break;
+			if (srcMid - src <= 1)
+			{
+				if (srcMid - src == 1)
+					srcBits |= uint32_t(*src) << srcBitpos;
+			}
+			else
+			{
+				srcBits |= uint32_t(Load16(src)) << srcBitpos;
+			}
+			k = srcBits & 0x7FF;
+			n = lut.bits2len[k];
+			srcBitpos -= n;
+			srcBits >>= n;
+			*dst++ = lut.bits2sym[k];
+			src += (7 - srcBitpos) >> 3;
+			srcBitpos &= 7;
+
+			if (dst < dstEnd)
+			{
+				if (srcEnd - srcMid <= 1)
+				{
+					if (srcEnd - srcMid == 1)
+					{
+						srcEndBits |= uint32_t(*srcMid) << srcEndBitpos;
+						srcMidBits |= uint32_t(*srcMid) << srcMidBitpos;
+					}
+				}
+				else
+				{
+					uint32_t v = Load16(srcEnd - 2);
+					srcEndBits |= (((v >> 8) | (v << 8)) & 0xffff) << srcEndBitpos;
+					srcMidBits |= uint32_t(Load16(srcMid)) << srcMidBitpos;
+				}
+				n = lut.bits2len[srcEndBits & 0x7FF];
+				*dst++ = lut.bits2sym[srcEndBits & 0x7FF];
+				srcEndBitpos -= n;
+				srcEndBits >>= n;
+				srcEnd -= (7 - srcEndBitpos) >> 3;
+				srcEndBitpos &= 7;
+				if (dst < dstEnd)
+				{
+					n = lut.bits2len[srcMidBits & 0x7FF];
+					*dst++ = lut.bits2sym[srcMidBits & 0x7FF];
+					srcMidBitpos -= n;
+					srcMidBits >>= n;
+					srcMid += (7 - srcMidBitpos) >> 3;
+					srcMidBitpos &= 7;
+				}
+			}
+			if (src > srcMid || srcMid > srcEnd)
+				return false;
+		}
+		return src == hr.srcMidOrg && srcEnd == srcMid;
+	}
+
+	// huffman coded bytes split in one (type 1) or two (type 2) groups of three streams
+	int DecodeHuffman(const byte* src, size_t srcSize, byte* output, int outputSize, int type)
+	{
+		const byte* srcOrg = src;
+		const byte* srcEnd = src + srcSize;
+		BitReader br;
+		br.Init(src, srcEnd);
+
+		uint32_t codePrefix[12];
+		memcpy(codePrefix, CodePrefixOrg, sizeof(codePrefix));
+		uint8_t syms[1280];
+		int numSyms;
+		if (!br.ReadBitNoRefill())
+			numSyms = HuffReadCodeLengthsOld(br, syms, codePrefix);
+		else if (!br.ReadBitNoRefill())
+			numSyms = HuffReadCodeLengthsNew(br, syms, codePrefix);
+		else
+			return -1;
+		if (numSyms < 1)
+			return -1;
+		src = br.Position();
+
+		if (numSyms == 1)
+		{
+			memset(output, syms[0], outputSize);
+			return int(src - srcOrg);
+		}
+
+		HuffLut lut;
+		if (!HuffMakeLut(codePrefix, syms, lut))
+			return -1;
+
+		HuffReader hr;
+		if (type == 1)
+		{
+			if (src + 3 > srcEnd)
+				return -1;
+			uint32_t splitMid = Load16(src);
+			src += 2;
+			hr.output = output;
+			hr.outputEnd = output + outputSize;
+			hr.src = src;
+			hr.srcEnd = srcEnd;
+			hr.srcMidOrg = hr.srcMid = src + splitMid;
+			if (!HuffDecodeCore(hr, lut))
+				return -1;
+		}
+		else
+		{
+			if (src + 6 > srcEnd)
+				return -1;
+			int halfOutputSize = (outputSize + 1) >> 1;
+			uint32_t splitMid = Load32(src) & 0xFFFFFF;
+			src += 3;
+			if (splitMid > size_t(srcEnd - src))
+				return -1;
+			const byte* srcMid = src + splitMid;
+			uint32_t splitLeft = Load16(src);
+			src += 2;
+			if (srcMid - src < ptrdiff_t(splitLeft) + 2 || srcEnd - srcMid < 3)
+				return -1;
+			uint32_t splitRight = Load16(srcMid);
+			if (srcEnd - (srcMid + 2) < ptrdiff_t(splitRight) + 2)
+				return -1;
+
+			hr.output = output;
+			hr.outputEnd = output + halfOutputSize;
+			hr.src = src;
+			hr.srcEnd = srcMid;
+			hr.srcMidOrg = hr.srcMid = src + splitLeft;
+			if (!HuffDecodeCore(hr, lut))
+				return -1;
+
+			hr.output = output + halfOutputSize;
+			hr.outputEnd = output + outputSize;
+			hr.src = srcMid + 2;
+			hr.srcEnd = srcEnd;
+			hr.srcMidOrg = hr.srcMid = srcMid + 2 + splitRight;
+			if (!HuffDecodeCore(hr, lut))
+				return -1;
+		}
+		return int(srcSize);
+	}
+
+	int DecodeBytes(byte** output, const byte* src, const byte* srcEnd, int* decodedSize, size_t outputSize, bool forceMemmove, byte* scratch, byte* scratchEnd);
+
+	struct TansData
+	{
+		uint32_t aUsed;
+		uint32_t bUsed;
+		uint8_t a[256];
+		uint32_t b[256];
+	};
+
+	struct TansLutEnt
+	{
+		uint32_t x;
+		uint8_t bitsX;
+		uint8_t symbol;
+		uint16_t w;
+	};
+
+	// symbol weights, a holds the symbols of weight 1 and b symbol << 16 | weight for the others
+	bool TansDecodeTable(BitReader& bits, int lBits, TansData& tans)
+	{
+		bits.Refill();
+		if (bits.ReadBitNoRefill())
+		{
+			int q = bits.ReadBitsNoRefill(3);
+			int numSymbols = bits.ReadBitsNoRefill(8) + 1;
+			if (numSymbols < 2)
+				return false;
+			int fluff = bits.ReadFluff(numSymbols);
+			int totalRiceValues = fluff + numSymbols;
+			uint8_t rice[512 + 16];
+			BitReader2 br2;
+			br2.From(bits);
+			if (!DecodeGolombRiceLengths(rice, totalRiceValues, br2))
+				return false;
+			memset(rice + totalRiceValues, 0, 16);
+			br2.To(bits);
+
+			HuffRange range[133];
+			int ranges = HuffConvertToRanges(range, numSymbols, fluff, &rice[numSymbols], bits);
+			if (ranges < 0)
+				return false;
+			bits.Refill();
+
+			uint32_t l = 1u << lBits;
+			const uint8_t* curRice = rice;
+			int average = 6;
+			uint32_t weightSum = 0;
+			uint8_t* tableA = tans.a;
+			uint32_t* tableB = tans.b;
+			for (int ri = 0; ri < ranges; ri++)
+			{
+				int symbol = range[ri].symbol;
+				int num = range[ri].num;
+				do
+				{
+					bits.Refill();
+					int nextra = q + *curRice++;
+					if (nextra > 15)
+						return false;
+					int v = bits.ReadBitsNoRefillZero(nextra) + (1 << nextra) - (1 << q);
+					int averageDiv4 = average >> 2;
+					int limit = 2 * averageDiv4;
+					if (v <= limit)
+						v = averageDiv4 + (-(v & 1) ^ int(uint32_t(v) >> 1));
+					if (limit > v)
+						limit = v;
+					v += 1;
+					average += limit - averageDiv4;
+					*tableA = uint8_t(symbol);
+					*tableB = (uint32_t(symbol) << 16) + v;
+					tableA += (v == 1);
+					tableB += (v >= 2);
+					weightSum += v;
+					symbol += 1;
+				} while (--num);
+			}
+			tans.aUsed = uint32_t(tableA - tans.a);
+			tans.bUsed = uint32_t(tableB - tans.b);
+			return weightSum == l;
+		}
+
+		bool seen[256] = {};
+		uint32_t l = 1u << lBits;
+		int count = bits.ReadBitsNoRefill(3) + 1;
+		int bitsPerSym = HighBit(uint32_t(lBits)) + 1;
+		int maxDeltaBits = bits.ReadBitsNoRefill(bitsPerSym);
+		if (maxDeltaBits == 0 || maxDeltaBits > lBits)
+			return false;
+
+		uint8_t* tableA = tans.a;
+		uint32_t* tableB = tans.b;
+		uint32_t weight = 0;
+		uint32_t totalWeights = 0;
+		do
+		{
+			bits.Refill();
+			int sym = bits.ReadBitsNoRefill(8);
+			if (seen[sym])
+				return false;
+			weight += bits.ReadBitsNoRefill(maxDeltaBits);
+			if (weight == 0)
+				return false;
+			seen[sym] = true;
+			if (weight == 1)
+				*tableA++ = uint8_t(sym);
+			else
+				*tableB++ = (uint32_t(sym) << 16) + weight;
+			totalWeights += weight;
+		} while (--count);
+
+		bits.Refill();
+		int sym = bits.ReadBitsNoRefill(8);
+		if (seen[sym])
+			return false;
+		if (totalWeights >= l || l - totalWeights < weight || l - totalWeights <= 1)
+			return false;
+		*tableB++ = (uint32_t(sym) << 16) + (l - totalWeights);
+
+		tans.aUsed = uint32_t(tableA - tans.a);
+		tans.bUsed = uint32_t(tableB - tans.b);
+		std::sort(tans.a, tableA);
+		std::sort(tans.b, tableB);
+		return true;
+	}
+
+	// spreads the symbols over the states, four interleaved runs of slots
+	void TansInitLut(const TansData& tans, int lBits, TansLutEnt* lut)
+	{
+		TansLutEnt* pointers[4];
+		uint32_t l = 1u << lBits;
+		uint32_t aUsed = tans.aUsed;
+		uint32_t slotsLeft = l - aUsed;
+
+		uint32_t sa = slotsLeft >> 2;
+		pointers[0] = lut;
+		uint32_t sb = sa + ((slotsLeft & 3) > 0);
+		pointers[1] = lut + sb;
+		sb += sa + ((slotsLeft & 3) > 1);
+		pointers[2] = lut + sb;
+		sb += sa + ((slotsLeft & 3) > 2);
+		pointers[3] = lut + sb;
+
+		TansLutEnt* singles = lut + slotsLeft;
+		for (uint32_t i = 0; i < aUsed; i++)
+		{
+			singles[i].w = 0;
+			singles[i].bitsX = uint8_t(lBits);
+			singles[i].x = (1u << lBits) - 1;
+			singles[i].symbol = tans.a[i];
+		}
+
+		uint32_t weightsSum = 0;
+		for (uint32_t i = 0; i < tans.bUsed; i++)
+		{
+			int weight = tans.b[i] & 0xffff;
+			int symbol = tans.b[i] >> 16;
+			if (weight > 4)
+			{
+				int symBits = HighBit(uint32_t(weight));
+				int z = lBits - symBits;
+				TansLutEnt le;
+				le.symbol = uint8_t(symbol);
+				le.bitsX = uint8_t(z);
+				le.x = (1u << z) - 1;
+				le.w = uint16_t((l - 1) & (uint32_t(weight) << z));
+				int whatToAdd = 1 << z;
+				int x = (1 << (symBits + 1)) - weight;
+				for (int j = 0; j < 4; j++)
+				{
+					TansLutEnt* dst = pointers[j];
+					int y = (weight + ((weightsSum - j - 1) & 3)) >> 2;
+					if (x >= y)
+					{
+						for (int n = y; n; n--)
+						{
+							*dst++ = le;
+							le.w = uint16_t(le.w + whatToAdd);
+						}
+						x -= y;
+					}
+					else
+					{
+						for (int n = x; n; n--)
+						{
+							*dst++ = le;
+							le.w = uint16_t(le.w + whatToAdd);
+						}
+						z--;
+						whatToAdd >>= 1;
+						le.bitsX = uint8_t(z);
+						le.w = 0;
+						le.x >>= 1;
+						for (int n = y - x; n; n--)
+						{
+							*dst++ = le;
+							le.w = uint16_t(le.w + whatToAdd);
+						}
+						x = weight;
+					}
+					pointers[j] = dst;
+				}
+			}
+			else
+			{
+				uint32_t slots = ((1u << weight) - 1) << (weightsSum & 3);
+				slots |= (slots >> 4);
+				int n = weight, ww = weight;
+				do
+				{
+					uint32_t idx = std::countr_zero(slots);
+					slots &= slots - 1;
+					TansLutEnt* dst = pointers[idx]++;
+					dst->symbol = uint8_t(symbol);
+					int weightBits = HighBit(uint32_t(ww));
+					dst->bitsX = uint8_t(lBits - weightBits);
+					dst->x = (1u << (lBits - weightBits)) - 1;
+					dst->w = uint16_t((l - 1) & (uint32_t(ww++) << (lBits - weightBits)));
+				} while (--n);
+			}
+			weightsSum += weight;
+		}
+	}
+
+	struct TansDecoderParams
+	{
+		const TansLutEnt* lut;
+		byte* dst;
+		byte* dstEnd;
+		const byte* ptrF;
+		const byte* ptrB;
+		uint32_t bitsF, bitsB;
+		int bitposF, bitposB;
+		uint32_t state[5];
+	};
+
+	// five states, decoded from a forward and a backward bit stream in turns
+	bool TansDecode(TansDecoderParams& params)
+	{
+		const TansLutEnt* lut = params.lut;
+		byte* dst = params.dst;
+		byte* dstEnd = params.dstEnd;
+		const byte* ptrF = params.ptrF;
+		const byte* ptrB = params.ptrB;
+		uint32_t bitsF = params.bitsF, bitsB = params.bitsB;
+		int bitposF = params.bitposF, bitposB = params.bitposB;
+		uint32_t s0 = params.state[0], s1 = params.state[1], s2 = params.state[2], s3 = params.state[3], s4 = params.state[4];
+		if (ptrF > ptrB)
+			return false;
+
+		auto forwardBits = [&]()
+		{
+			bitsF |= Load32(ptrF) << bitposF;
+			ptrF += (31 - bitposF) >> 3;
+			bitposF |= 24;
+		};
+		auto backwardBits = [&]()
+		{
+			bitsB |= ByteSwap32(Load32(ptrB - 4)) << bitposB;
+			ptrB -= (31 - bitposB) >> 3;
+			bitposB |= 24;
+		};
+		// false once the output is full
+		auto forward = [&](uint32_t& state)
+		{
+			const TansLutEnt& e = lut[state];
+			*dst++ = e.symbol;
+			bitposF -= e.bitsX;
+			state = (bitsF & e.x) + e.w;
+			bitsF >>= e.bitsX;
+			return dst < dstEnd;
+		};
+		auto backward = [&](uint32_t& state)
+		{
+			const TansLutEnt& e = lut[state];
+			*dst++ = e.symbol;
+			bitposB -= e.bitsX;
+			state = (bitsB & e.x) + e.w;
+			bitsB >>= e.bitsX;
+			return dst < dstEnd;
+		};
+
+		if (dst < dstEnd)
+		{
+			for (;;)
+			{
+				forwardBits();
+				if (!forward(s0) || !forward(s1))
+					break;
+				forwardBits();
+				if (!forward(s2) || !forward(s3))
+					break;
+				forwardBits();
+				if (!forward(s4))
+					break;
+				backwardBits();
+				if (!backward(s0) || !backward(s1))
+					break;
+				backwardBits();
+				if (!backward(s2) || !backward(s3))
+					break;
+				backwardBits();
+				if (!backward(s4))
+					break;
+			}
+		}
+		if (ptrB - ptrF + (bitposF >> 3) + (bitposB >> 3) != 0)
+			return false;
+		if ((s0 | s1 | s2 | s3 | s4) & ~0xFFu)
+			return false;
+		dstEnd[0] = byte(s0);
+		dstEnd[1] = byte(s1);
+		dstEnd[2] = byte(s2);
+		dstEnd[3] = byte(s3);
+		dstEnd[4] = byte(s4);
+		return true;
+	}
+
+	int DecodeTans(const byte* src, size_t srcSize, byte* dst, int dstSize, byte* scratch, byte* scratchEnd)
+	{
+		if (srcSize < 8 || dstSize < 5)
+			return -1;
+		const byte* srcEnd = src + srcSize;
+		BitReader br;
+		br.Init(src, srcEnd);
+		// reserved
+		if (br.ReadBitNoRefill())
+			return -1;
+		int lBits = br.ReadBitsNoRefill(2) + 8;
+		TansData tans;
+		if (!TansDecodeTable(br, lBits, tans))
+			return -1;
+		src = br.Position();
+		if (src >= srcEnd)
+			return -1;
+
+		TansLutEnt* lut = AlignPointer((TansLutEnt*)scratch, 16);
+		if (size_t(scratchEnd - (byte*)lut) < (sizeof(TansLutEnt) << lBits))
+			return -1;
+		TansInitLut(tans, lBits, lut);
+
+		TansDecoderParams params;
+		params.lut = lut;
+		params.dst = dst;
+		params.dstEnd = dst + dstSize - 5;
+
+		uint32_t lMask = (1u << lBits) - 1;
+		uint32_t bitsF = Load32(src);
+		src += 4;
+		uint32_t bitsB = ByteSwap32(Load32(srcEnd - 4));
+		srcEnd -= 4;
+		int bitposF = 32, bitposB = 32;
+
+		params.state[0] = bitsF & lMask;
+		params.state[1] = bitsB & lMask;
+		bitsF >>= lBits, bitposF -= lBits;
+		bitsB >>= lBits, bitposB -= lBits;
+
+		params.state[2] = bitsF & lMask;
+		params.state[3] = bitsB & lMask;
+		bitsF >>= lBits, bitposF -= lBits;
+		bitsB >>= lBits, bitposB -= lBits;
+
+		bitsF |= Load32(src) << bitposF;
+		src += (31 - bitposF) >> 3;
+		bitposF |= 24;
+
+		params.state[4] = bitsF & lMask;
+		bitsF >>= lBits, bitposF -= lBits;
+
+		params.bitsF = bitsF;
+		params.ptrF = src - (bitposF >> 3);
+		params.bitposF = bitposF & 7;
+		params.bitsB = bitsB;
+		params.ptrB = srcEnd + (bitposB >> 3);
+		params.bitposB = bitposB & 7;
+		if (!TansDecode(params))
+			return -1;
+		return int(srcSize);
+	}
+
+	int DecodeRle(const byte* src, size_t srcSize, byte* dst, int dstSize, byte* scratch, byte* scratchEnd)
+	{
+		if (srcSize <= 1)
+		{
+			if (srcSize != 1)
+				return -1;
+			memset(dst, src[0], dstSize);
+			return 1;
+		}
+		byte* dstEnd = dst + dstSize;
+		const byte* cmdPtr = src + 1;
+		const byte* cmdPtrEnd = src + srcSize;
+		// the front of the command buffer is entropy coded
+		if (src[0])
+		{
+			byte* dstPtr = scratch;
+			int decSize;
+			int n = DecodeBytes(&dstPtr, src, src + srcSize, &decSize, scratchEnd - scratch, true, scratch, scratchEnd);
+			if (n <= 0)
+				return -1;
+			size_t cmdLen = srcSize - n + decSize;
+			if (cmdLen > size_t(scratchEnd - scratch))
+				return -1;
+			memcpy(dstPtr + decSize, src + n, srcSize - n);
+			cmdPtr = dstPtr;
+			cmdPtrEnd = dstPtr + cmdLen;
+		}
+
+		byte rleByte = 0;
+		while (cmdPtr < cmdPtrEnd)
+		{
+			uint32_t cmd = cmdPtrEnd[-1];
+			uint32_t bytesToCopy = 0, bytesToRle = 0;
+			if (cmd - 1 >= 0x2f)
+			{
+				cmdPtrEnd--;
+				bytesToCopy = (~cmd) & 0xF;
+				bytesToRle = cmd >> 4;
+			}
+			else if (cmd >= 0x10)
+			{
+				if (cmdPtrEnd - cmdPtr < 2)
+					return -1;
+				uint32_t data = Load16(cmdPtrEnd - 2) - 4096;
+				cmdPtrEnd -= 2;
+				bytesToCopy = data & 0x3F;
+				bytesToRle = data >> 6;
+			}
+			else if (cmd == 1)
+			{
+				rleByte = *cmdPtr++;
+				cmdPtrEnd--;
+				continue;
+			}
+			else if (cmd >= 9)
+			{
+				if (cmdPtrEnd - cmdPtr < 2)
+					return -1;
+				bytesToRle = (Load16(cmdPtrEnd - 2) - 0x8ff) * 128;
+				cmdPtrEnd -= 2;
+			}
+			else
+			{
+				if (cmdPtrEnd - cmdPtr < 2)
+					return -1;
+				bytesToCopy = (Load16(cmdPtrEnd - 2) - 511) * 64;
+				cmdPtrEnd -= 2;
+			}
+			if (size_t(dstEnd - dst) < size_t(bytesToCopy) + bytesToRle || size_t(cmdPtrEnd - cmdPtr) < bytesToCopy)
+				return -1;
+			memcpy(dst, cmdPtr, bytesToCopy);
+			cmdPtr += bytesToCopy;
+			dst += bytesToCopy;
+			memset(dst, rleByte, bytesToRle);
+			dst += bytesToRle;
+		}
+		if (cmdPtrEnd != cmdPtr || dst != dstEnd)
+			return -1;
+		return int(srcSize);
+	}
+
+	// sizes of a DecodeBytes chunk, returns the header size or -1
+	int ParseBytesHeader(const byte* src, const byte* srcEnd, int& chunkType, int& srcSize, int& dstSize)
+	{
+		if (srcEnd - src < 2)
+			return -1;
+		chunkType = (src[0] >> 4) & 0x7;
+		if (chunkType == 0)
+		{
+			int header;
+			if (src[0] >= 0x80)
+			{
+				// short memcpy, the length is in the low 12 bits
+				srcSize = ((src[0] << 8) | src[1]) & 0xFFF;
+				header = 2;
+			}
+			else
+			{
+				if (srcEnd - src < 3)
+					return -1;
+				srcSize = int(Load24BE(src));
+				if (srcSize & ~0x3ffff)
+					return -1;
+				header = 3;
+			}
+			dstSize = srcSize;
+			if (srcEnd - src - header < srcSize)
+				return -1;
+			return header;
+		}
+		if (chunkType >= 6)
+			return -1;
+		int header;
+		if (src[0] >= 0x80)
+		{
+			// 10 bit sizes
+			if (srcEnd - src < 3)
+				return -1;
+			uint32_t bits = Load24BE(src);
+			srcSize = bits & 0x3ff;
+			dstSize = srcSize + ((bits >> 10) & 0x3ff) + 1;
+			header = 3;
+		}
+		else
+		{
+			// 18 bit sizes
+			if (srcEnd - src < 5)
+				return -1;
+			uint32_t bits = (uint32_t(src[1]) << 24) | (uint32_t(src[2]) << 16) | (uint32_t(src[3]) << 8) | src[4];
+			srcSize = bits & 0x3ffff;
+			dstSize = (((bits >> 18) | (uint32_t(src[0]) << 14)) & 0x3FFFF) + 1;
+			if (srcSize >= dstSize)
+				return -1;
+			header = 5;
+		}
+		if (srcEnd - src - header < srcSize)
+			return -1;
+		return header;
+	}
+
+	int DecodeMultiArray(const byte* src, const byte* srcEnd, byte* dst, byte* dstEnd, byte** arrayData, int* arrayLens, int arrayCount,
+		int* totalSizeOut, bool forceMemmove, byte* scratch, byte* scratchEnd)
+	{
+		const byte* srcOrg = src;
+		if (srcEnd - src < 4)
+			return -1;
+		int decodedSize;
+		int numArraysInFile = *src++;
+		if (!(numArraysInFile & 0x80))
+			return -1;
+		numArraysInFile &= 0x3f;
+
+		if (dst == scratch)
+		{
+			scratch += (scratchEnd - scratch - 0xc000) >> 1;
+			dstEnd = scratch;
+		}
+
+		int totalSize = 0;
+		if (numArraysInFile == 0)
+		{
+			for (int i = 0; i < arrayCount; i++)
+			{
+				byte* chunkDst = dst;
+				int dec = DecodeBytes(&chunkDst, src, srcEnd, &decodedSize, dstEnd - dst, forceMemmove, scratch, scratchEnd);
+				if (dec < 0)
+					return -1;
+				dst += decodedSize;
+				arrayLens[i] = decodedSize;
+				totalSize += decodedSize;
+				src += dec;
+				arrayData[i] = chunkDst;
+			}
+			*totalSizeOut = totalSize;
+			return int(src - srcOrg);
+		}
+
+		byte* entropyArrayData[32];
+		uint32_t entropyArraySize[32];
+		// everything is decoded to scratch first, then pieced together by the intervals
+		byte* scratchCur = scratch;
+		for (int i = 0; i < numArraysInFile; i++)
+		{
+			byte* chunkDst = scratchCur;
+			int dec = DecodeBytes(&chunkDst, src, srcEnd, &decodedSize, scratchEnd - scratchCur, forceMemmove, scratchCur, scratchEnd);
+			if (dec < 0)
+				return -1;
+			entropyArrayData[i] = chunkDst;
+			entropyArraySize[i] = decodedSize;
+			scratchCur += decodedSize;
+			totalSize += decodedSize;
+			src += dec;
+		}
+		*totalSizeOut = totalSize;
+
+		if (srcEnd - src < 3)
+			return -1;
+		int q = Load16(src);
+		src += 2;
+
+		int chunkType, chunkSrcSize, numIndexes;
+		if (ParseBytesHeader(src, srcEnd, chunkType, chunkSrcSize, numIndexes) < 0 || numIndexes > totalSize)
+			return -1;
+		int numLens = numIndexes - arrayCount;
+		if (numLens < 1)
+			return -1;
+
+		if (scratchEnd - scratchCur < numIndexes)
+			return -1;
+		byte* intervalLenlog2 = scratchCur;
+		scratchCur += numIndexes;
+		if (scratchEnd - scratchCur < numIndexes)
+			return -1;
+		byte* intervalIndexes = scratchCur;
+		scratchCur += numIndexes;
+
+		if (q & 0x8000)
+		{
+			int sizeOut;
+			int n = DecodeBytes(&intervalIndexes, src, srcEnd, &sizeOut, numIndexes, false, scratchCur, scratchEnd);
+			if (n < 0 || sizeOut != numIndexes)
+				return -1;
+			src += n;
+			for (int i = 0; i < numIndexes; i++)
+			{
+				int t = intervalIndexes[i];
+				intervalLenlog2[i] = byte(t >> 4);
+				intervalIndexes[i] = byte(t & 0xF);
+			}
+			numLens = numIndexes;
+		}
+		else
+		{
+			int lenlog2Chunksize = numIndexes - arrayCount;
+			int sizeOut;
+			int n = DecodeBytes(&intervalIndexes, src, srcEnd, &sizeOut, numIndexes, false, scratchCur, scratchEnd);
+			if (n < 0 || sizeOut != numIndexes)
+				return -1;
+			src += n;
+			n = DecodeBytes(&intervalLenlog2, src, srcEnd, &sizeOut, numIndexes, false, scratchCur, scratchEnd);
+			if (n < 0 || sizeOut != lenlog2Chunksize)
+				return -1;
+			src += n;
+			for (int i = 0; i < lenlog2Chunksize; i++)
+			{
+				if (intervalLenlog2[i] > 16)
+					return -1;
+			}
+		}
+
+		scratchCur = AlignPointer(scratchCur, 4);
+		if (scratchEnd - scratchCur < ptrdiff_t(numLens) * 4)
+			return -1;
+		uint32_t* decodedIntervals = (uint32_t*)scratchCur;
+
+		int varbitsComplen = q & 0x3FFF;
+		if (srcEnd - src < varbitsComplen)
+			return -1;
+
+		// interval lengths with an implicit top bit, read from both ends of their bytes
+		const byte* f = src;
+		uint32_t bitsF = 0;
+		int bitposF = 24;
+		const byte* srcEndActual = src + varbitsComplen;
+		const byte* b = srcEndActual;
+		uint32_t bitsB = 0;
+		int bitposB = 24;
+		int i;
+		for (i = 0; i + 2 <= numLens; i += 2)
+		{
+			bitsF |= ByteSwap32(Load32(f)) >> (24 - bitposF);
+			f += (bitposF + 7) >> 3;
+			bitsB |= Load32(b - 4) >> (24 - bitposB);
+			b -= (bitposB + 7) >> 3;
+
+			int numbitsF = intervalLenlog2[i + 0];
+			int numbitsB = intervalLenlog2[i + 1];
+			bitsF = std::rotl(bitsF | 1, numbitsF);
+			bitposF += numbitsF - 8 * ((bitposF + 7) >> 3);
+			bitsB = std::rotl(bitsB | 1, numbitsB);
+			bitposB += numbitsB - 8 * ((bitposB + 7) >> 3);
+
+			uint32_t maskF = (2u << numbitsF) - 1;
+			uint32_t maskB = (2u << numbitsB) - 1;
+			decodedIntervals[i + 0] = bitsF & maskF;
+			bitsF &= ~maskF;
+			decodedIntervals[i + 1] = bitsB & maskB;
+			bitsB &= ~maskB;
+		}
+		if (i < numLens)
+		{
+			bitsF |= ByteSwap32(Load32(f)) >> (24 - bitposF);
+			int numbitsF = intervalLenlog2[i];
+			bitsF = std::rotl(bitsF | 1, numbitsF);
+			decodedIntervals[i] = bitsF & ((2u << numbitsF) - 1);
+		}
+
+		if (intervalIndexes[numIndexes - 1])
+			return -1;
+
+		int indi = 0, leni = 0, source;
+		int incrementLeni = (q & 0x8000) != 0;
+		for (int arri = 0; arri < arrayCount; arri++)
+		{
+			arrayData[arri] = dst;
+			if (indi >= numIndexes)
+				return -1;
+			while ((source = intervalIndexes[indi++]) != 0)
+			{
+				if (source > numArraysInFile || leni >= numLens)
+					return -1;
+				uint32_t curLen = decodedIntervals[leni++];
+				if (curLen > entropyArraySize[source - 1] || curLen > size_t(dstEnd - dst))
+					return -1;
+				memcpy(dst, entropyArrayData[source - 1], curLen);
+				entropyArraySize[source - 1] -= curLen;
+				entropyArrayData[source - 1] += curLen;
+				dst += curLen;
+			}
+			leni += incrementLeni;
+			arrayLens[arri] = int(dst - arrayData[arri]);
+		}
+		if (indi != numIndexes || leni != numLens)
+			return -1;
+		for (int j = 0; j < numArraysInFile; j++)
+		{
+			if (entropyArraySize[j])
+				return -1;
+		}
+		return int(srcEndActual - srcOrg);
+	}
+
+	int DecodeRecursive(const byte* src, size_t srcSize, byte* output, int outputSize, byte* scratch, byte* scratchEnd)
+	{
+		const byte* srcOrg = src;
+		byte* outputEnd = output + outputSize;
+		const byte* srcEnd = src + srcSize;
+		if (srcSize < 6)
+			return -1;
+		int n = src[0] & 0x7f;
+		if (n < 2)
+			return -1;
+
+		if (!(src[0] & 0x80))
+		{
+			// concatenated chunks
+			src++;
+			do
+			{
+				int decodedSize;
+				int dec = DecodeBytes(&output, src, srcEnd, &decodedSize, outputEnd - output, true, scratch, scratchEnd);
+				if (dec < 0)
+					return -1;
+				output += decodedSize;
+				src += dec;
+			} while (--n);
+			if (output != outputEnd)
+				return -1;
+			return int(src - srcOrg);
+		}
+
+		byte* arrayData;
+		int arrayLen, decodedSize;
+		int dec = DecodeMultiArray(src, srcEnd, output, outputEnd, &arrayData, &arrayLen, 1, &decodedSize, true, scratch, scratchEnd);
+		if (dec < 0)
+			return -1;
+		output += decodedSize;
+		if (output != outputEnd)
+			return -1;
+		return dec;
+	}
+
+	// one entropy coded chunk, *output is pointed at the source itself for stored chunks
+	// unless forceMemmove is set. Returns the bytes read from src or -1.
+	int DecodeBytes(byte** output, const byte* src, const byte* srcEnd, int* decodedSize, size_t outputSize, bool forceMemmove, byte* scratch, byte* scratchEnd)
+	{
+		int chunkType, srcSize, dstSize;
+		int header = ParseBytesHeader(src, srcEnd, chunkType, srcSize, dstSize);
+		if (header < 0 || size_t(dstSize) > outputSize)
+			return -1;
+		const byte* data = src + header;
+		if (chunkType == 0)
+		{
+			*decodedSize = srcSize;
+			if (forceMemmove)
+				memmove(*output, data, srcSize);
+			else
+				*output = (byte*)data;
+			return header + srcSize;
+		}
+
+		byte* dst = *output;
+		if (dst == scratch)
+		{
+			if (scratchEnd - scratch < dstSize)
+				return -1;
+			scratch += dstSize;
+		}
+		int srcUsed = -1;
+		switch (chunkType)
+		{
+		case 2:
+		case 4:
+			srcUsed = DecodeHuffman(data, srcSize, dst, dstSize, chunkType >> 1);
+			break;
+		case 5:
+			srcUsed = DecodeRecursive(data, srcSize, dst, dstSize, scratch, scratchEnd);
+			break;
+		case 3:
+			srcUsed = DecodeRle(data, srcSize, dst, dstSize, scratch, scratchEnd);
+			break;
+		case 1:
+			srcUsed = DecodeTans(data, srcSize, dst, dstSize, scratch, scratchEnd);
+			break;
+		}
+		if (srcUsed != srcSize)
+			return -1;
+		*decodedSize = dstSize;
+		return header + srcSize;
+	}
+
+	// LZ copies are exact, nothing is written past the end of the output
+	template<bool Delta>
+	inline void CopyLiterals(byte* dst, const byte* lit, size_t n, ptrdiff_t lastOffset)
+	{
+		if constexpr (Delta)
+		{
+			for (size_t i = 0; i < n; i++)
+				dst[i] = byte(lit[i] + dst[ptrdiff_t(i) + lastOffset]);
+		}
+		else
+		{
+			memcpy(dst, lit, n);
+		}
+	}
+	inline void CopyMatch(byte* dst, const byte* src, size_t n)
+	{
+		if (dst - src >= 8)
+		{
+			// every 8 byte step only reads bytes written before it
+			for (; n >= 8; n -= 8, dst += 8, src += 8)
+			{
+				uint64_t v;
+				memcpy(&v, src, sizeof(v));
+				memcpy(dst, &v, sizeof(v));
+			}
+		}
+		while (n--)
+			*dst++ = *src++;
+	}
+
+	struct KrakenLzTable
+	{
+		const byte* litStream;
+		int litStreamSize;
+		const byte* cmdStream;
+		int cmdStreamSize;
+		int* offsStream;
+		int offsStreamSize;
+		int* lenStream;
+		int lenStreamSize;
+	};
+
+	bool KrakenUnpackOffsets(const byte* src, const byte* srcEnd, const byte* packedOffs, const byte* packedOffsExtra, int packedOffsSize,
+		int multiDistScale, const byte* packedLitlen, int packedLitlenSize, int* offsStream, int* lenStream)
+	{
+		BitReader a, b;
+		a.Init(src, srcEnd);
+		b.InitBackwards(srcEnd, src);
+
+		// number of long lengths, read from the back
+		if (b.bits < 0x2000)
+			return false;
+		int n = std::countl_zero(b.bits);
+		b.bitpos += n;
+		b.bits <<= n;
+		b.RefillBackwards();
+		n++;
+		int u32LenStreamSize = int(b.bits >> (32 - n)) - 1;
+		b.bitpos += n;
+		b.bits <<= n;
+		b.RefillBackwards();
+
+		const byte* packedOffsEnd = packedOffs + packedOffsSize;
+		if (multiDistScale == 0)
+		{
+			while (packedOffs != packedOffsEnd)
+			{
+				*offsStream++ = -int32_t(a.ReadDistance<false>(*packedOffs++));
+				if (packedOffs == packedOffsEnd)
+					break;
+				*offsStream++ = -int32_t(b.ReadDistance<true>(*packedOffs++));
+			}
+		}
+		else
+		{
+			int* offsStreamOrg = offsStream;
+			while (packedOffs != packedOffsEnd)
+			{
+				uint32_t cmd = *packedOffs++;
+				if ((cmd >> 3) > 26)
+					return false;
+				uint32_t offs = ((8 + (cmd & 7)) << (cmd >> 3)) | a.ReadMoreThan24Bits<false>(cmd >> 3);
+				*offsStream++ = 8 - int32_t(offs);
+				if (packedOffs == packedOffsEnd)
+					break;
+				cmd = *packedOffs++;
+				if ((cmd >> 3) > 26)
+					return false;
+				offs = ((8 + (cmd & 7)) << (cmd >> 3)) | b.ReadMoreThan24Bits<true>(cmd >> 3);
+				*offsStream++ = 8 - int32_t(offs);
+			}
+			if (multiDistScale != 1)
+			{
+				for (int* p = offsStreamOrg; p != offsStream; p++)
+					*p = multiDistScale * *p - packedOffsExtra[p - offsStreamOrg];
+			}
+		}
+
+		// a chunk of 128KB has at most 512 lengths of 255 or more
+		uint32_t u32LenStream[512];
+		if (u32LenStreamSize < 0 || u32LenStreamSize > 512)
+			return false;
+		int i;
+		for (i = 0; i + 1 < u32LenStreamSize; i += 2)
+		{
+			if (!a.ReadLength<false>(u32LenStream[i + 0]) || !b.ReadLength<true>(u32LenStream[i + 1]))
+				return false;
+		}
+		if (i < u32LenStreamSize && !a.ReadLength<false>(u32LenStream[i]))
+			return false;
+
+		// both readers have to meet
+		a.p -= (24 - a.bitpos) >> 3;
+		b.p += (24 - b.bitpos) >> 3;
+		if (a.p != b.p)
+			return false;
+
+		const uint32_t* longLen = u32LenStream;
+		for (i = 0; i < packedLitlenSize; i++)
+		{
+			uint32_t v = packedLitlen[i];
+			if (v == 255)
+			{
+				if (longLen == u32LenStream + u32LenStreamSize)
+					return false;
+				v = *longLen++ + 255;
+			}
+			lenStream[i] = int(v + 3);
+		}
+		return longLen == u32LenStream + u32LenStreamSize;
+	}
+
+	bool KrakenReadLzTable(int mode, const byte* src, const byte* srcEnd, byte* dst, int dstSize, size_t offset,
+		byte* scratch, byte* scratchEnd, KrakenLzTable& lzt)
+	{
+		byte* out;
+		int decodeCount, n;
+		if (mode > 1 || srcEnd - src < 13)
+			return false;
+		// the first 8 bytes of a stream are stored as they are
+		if (offset == 0)
+		{
+			memcpy(dst, src, 8);
+			dst += 8;
+			src += 8;
+		}
+		// excess bytes flag, not supported
+		if (*src & 0x80)
+			return false;
+
+		out = scratch;
+		n = DecodeBytes(&out, src, srcEnd, &decodeCount, std::min<size_t>(scratchEnd - scratch, dstSize), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		lzt.litStream = out;
+		lzt.litStreamSize = decodeCount;
+		scratch += decodeCount;
+
+		out = scratch;
+		n = DecodeBytes(&out, src, srcEnd, &decodeCount, std::min<size_t>(scratchEnd - scratch, dstSize), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		lzt.cmdStream = out;
+		lzt.cmdStreamSize = decodeCount;
+		scratch += decodeCount;
+
+		if (srcEnd - src < 3)
+			return false;
+		int offsScaling = 0;
+		byte* packedOffs = scratch;
+		byte* packedOffsExtra = nullptr;
+		if (src[0] & 0x80)
+		{
+			// offsets are coded as a scaled high part and a low part
+			offsScaling = src[0] - 127;
+			src++;
+		}
+		n = DecodeBytes(&packedOffs, src, srcEnd, &lzt.offsStreamSize, std::min<size_t>(scratchEnd - scratch, lzt.cmdStreamSize), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		scratch += lzt.offsStreamSize;
+		if (offsScaling > 1)
+		{
+			packedOffsExtra = scratch;
+			n = DecodeBytes(&packedOffsExtra, src, srcEnd, &decodeCount, std::min<size_t>(scratchEnd - scratch, lzt.offsStreamSize), false, scratch, scratchEnd);
+			if (n < 0 || decodeCount != lzt.offsStreamSize)
+				return false;
+			src += n;
+			scratch += decodeCount;
+		}
+
+		// lengths of 3 or more, at most a quarter of the output
+		byte* packedLen = scratch;
+		n = DecodeBytes(&packedLen, src, srcEnd, &lzt.lenStreamSize, std::min<size_t>(scratchEnd - scratch, dstSize >> 2), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		scratch += lzt.lenStreamSize;
+
+		scratch = AlignPointer(scratch, 16);
+		lzt.offsStream = (int*)scratch;
+		scratch += lzt.offsStreamSize * 4;
+		scratch = AlignPointer(scratch, 16);
+		lzt.lenStream = (int*)scratch;
+		scratch += lzt.lenStreamSize * 4;
+		if (scratch + 64 > scratchEnd)
+			return false;
+
+		return KrakenUnpackOffsets(src, srcEnd, packedOffs, packedOffsExtra, lzt.offsStreamSize, offsScaling,
+			packedLen, lzt.lenStreamSize, lzt.offsStream, lzt.lenStream);
+	}
+
+	// mode 0 adds the literals to the bytes at the last offset, mode 1 stores them
+	template<bool Delta>
+	bool KrakenProcessLzRuns(const KrakenLzTable& lzt, byte* dst, byte* dstEnd, const byte* windowStart)
+	{
+		const byte* cmdStream = lzt.cmdStream;
+		const byte* cmdStreamEnd = cmdStream + lzt.cmdStreamSize;
+		const int* lenStream = lzt.lenStream;
+		const int* lenStreamEnd = lenStream + lzt.lenStreamSize;
+		const byte* litStream = lzt.litStream;
+		const byte* litStreamEnd = litStream + lzt.litStreamSize;
+		const int* offsStream = lzt.offsStream;
+		const int* offsStreamEnd = offsStream + lzt.offsStreamSize;
+		// the three most recent offsets move to the front on use, slot 6 takes a new one
+		int32_t recentOffs[7] = { 0, 0, 0, -8, -8, -8, 0 };
+		int32_t lastOffset = -8;
+
+		while (cmdStream < cmdStreamEnd)
+		{
+			uint32_t f = *cmdStream++;
+			size_t litlen = f & 3;
+			uint32_t offsIndex = f >> 6;
+			size_t matchlen = (f >> 2) & 0xF;
+
+			if (litlen == 3)
+			{
+				if (lenStream == lenStreamEnd)
+					return false;
+				litlen = *lenStream++;
+			}
+			if (litlen > size_t(dstEnd - dst) || litlen > size_t(litStreamEnd - litStream))
+				return false;
+			CopyLiterals<Delta>(dst, litStream, litlen, lastOffset);
+			dst += litlen;
+			litStream += litlen;
+
+			if (offsIndex == 3)
+			{
+				if (offsStream == offsStreamEnd)
+					return false;
+				recentOffs[6] = *offsStream++;
+			}
+			int32_t offset = recentOffs[offsIndex + 3];
+			recentOffs[offsIndex + 3] = recentOffs[offsIndex + 2];
+			recentOffs[offsIndex + 2] = recentOffs[offsIndex + 1];
+			recentOffs[offsIndex + 1] = recentOffs[offsIndex + 0];
+			recentOffs[3] = offset;
+			lastOffset = offset;
+			if (offset >= 0 || offset < windowStart - dst)
+				return false;
+
+			if (matchlen != 15)
+			{
+				matchlen += 2;
+			}
+			else
+			{
+				if (lenStream == lenStreamEnd)
+					return false;
+				matchlen = 14 + *lenStream++;
+			}
+			if (matchlen > size_t(dstEnd - dst))
+				return false;
+			CopyMatch(dst, dst + offset, matchlen);
+			dst += matchlen;
+		}
+
+		if (offsStream != offsStreamEnd || lenStream != lenStreamEnd)
+			return false;
+		size_t finalLen = dstEnd - dst;
+		if (finalLen != size_t(litStreamEnd - litStream))
+			return false;
+		CopyLiterals<Delta>(dst, litStream, finalLen, lastOffset);
+		return true;
+	}
+
+	// chunks of up to 128KB, each either entropy coded bytes or an LZ table and its runs
+	template<typename ReadTable, typename ProcessRuns>
+	int DecodeQuantum(byte* dst, byte* dstEnd, const byte* windowStart, const byte* src, const byte* srcEnd,
+		byte* scratch, byte* scratchEnd, ReadTable&& readTable, ProcessRuns&& processRuns)
+	{
+		const byte* srcIn = src;
+		while (dstEnd - dst != 0)
+		{
+			int dstCount = int(std::min<ptrdiff_t>(dstEnd - dst, ChunkSize));
+			int srcUsed;
+			if (srcEnd - src < 4)
+				return -1;
+			uint32_t chunkhdr = Load24BE(src);
+			if (!(chunkhdr & 0x800000))
+			{
+				// entropy coded without any matches
+				byte* out = dst;
+				int writtenBytes;
+				srcUsed = DecodeBytes(&out, src, srcEnd, &writtenBytes, dstCount, false, scratch, scratchEnd);
+				if (srcUsed < 0 || writtenBytes != dstCount)
+					return -1;
+				if (out != dst)
+					memcpy(dst, out, dstCount);
+			}
+			else
+			{
+				src += 3;
+				srcUsed = chunkhdr & 0x7FFFF;
+				int mode = (chunkhdr >> 19) & 0xF;
+				if (srcEnd - src < srcUsed)
+					return -1;
+				if (srcUsed < dstCount)
+				{
+					if (!readTable(mode, src, src + srcUsed, dst, dstCount, size_t(dst - windowStart), scratch, scratchEnd)
+						|| !processRuns(mode, src + srcUsed, dst, dstCount, size_t(dst - windowStart)))
+						return -1;
+				}
+				else if (srcUsed > dstCount || mode != 0)
+				{
+					return -1;
+				}
+				else
+				{
+					memcpy(dst, src, dstCount);
+				}
+			}
+			src += srcUsed;
+			dst += dstCount;
+		}
+		return int(src - srcIn);
+	}
+
+	int KrakenDecodeQuantum(byte* dst, byte* dstEnd, const byte* windowStart, const byte* src, const byte* srcEnd, byte* scratch, byte* scratchEnd)
+	{
+		KrakenLzTable lzt;
+		auto readTable = [&](int mode, const byte* chunk, const byte* chunkEnd, byte* out, int outSize, size_t offset, byte* tmp, byte* tmpEnd)
+		{
+			size_t usage = std::min<size_t>(std::min<size_t>(3 * size_t(outSize) + 32 + 0xd000, ScratchSize), tmpEnd - tmp);
+			return KrakenReadLzTable(mode, chunk, chunkEnd, out, outSize, offset, tmp, tmp + usage, lzt);
+		};
+		auto processRuns = [&](int mode, const byte*, byte* out, int outSize, size_t offset)
+		{
+			byte* first = out + (offset == 0 ? 8 : 0);
+			if (mode == 0)
+				return KrakenProcessLzRuns<true>(lzt, first, out + outSize, windowStart);
+			return KrakenProcessLzRuns<false>(lzt, first, out + outSize, windowStart);
+		};
+		return DecodeQuantum(dst, dstEnd, windowStart, src, srcEnd, scratch, scratchEnd, readTable, processRuns);
+	}
+
+	struct MermaidLzTable
+	{
+		const byte* cmdStream;
+		const byte* cmdStreamEnd;
+		const byte* lengthStream;
+		const byte* litStream;
+		const byte* litStreamEnd;
+		// little endian uint16
+		const byte* off16Stream;
+		const byte* off16StreamEnd;
+		const uint32_t* off32Stream;
+		const uint32_t* off32StreamEnd;
+		const uint32_t* off32Stream1;
+		const uint32_t* off32Stream2;
+		uint32_t off32Size1;
+		uint32_t off32Size2;
+		uint32_t cmdStream2Offs;
+		uint32_t cmdStream2OffsEnd;
+	};
+
+	// 24 bit distances from the start of a 64KB half, 30 bit once the window is large enough
+	int MermaidDecodeFarOffsets(const byte* src, const byte* srcEnd, uint32_t* output, size_t outputSize, size_t offset)
+	{
+		const byte* srcCur = src;
+		for (size_t i = 0; i != outputSize; i++)
+		{
+			if (srcEnd - srcCur < 3)
+				return -1;
+			uint32_t off = srcCur[0] | srcCur[1] << 8 | srcCur[2] << 16;
+			srcCur += 3;
+			if (offset >= 0xC00000 - 1 && off >= 0xc00000)
+			{
+				if (srcCur == srcEnd)
+					return -1;
+				off += uint32_t(*srcCur++) << 22;
+			}
+			output[i] = off;
+			if (off > offset)
+				return -1;
+		}
+		return int(srcCur - src);
+	}
+
+	bool MermaidReadLzTable(int mode, const byte* src, const byte* srcEnd, byte* dst, int dstSize, size_t offset,
+		byte* scratch, byte* scratchEnd, MermaidLzTable& lz)
+	{
+		byte* out;
+		int decodeCount, n;
+		if (mode > 1 || srcEnd - src < 10)
+			return false;
+		if (offset == 0)
+		{
+			memcpy(dst, src, 8);
+			dst += 8;
+			src += 8;
+		}
+
+		out = scratch;
+		n = DecodeBytes(&out, src, srcEnd, &decodeCount, std::min<size_t>(scratchEnd - scratch, dstSize), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		lz.litStream = out;
+		lz.litStreamEnd = out + decodeCount;
+		scratch += decodeCount;
+
+		out = scratch;
+		n = DecodeBytes(&out, src, srcEnd, &decodeCount, std::min<size_t>(scratchEnd - scratch, dstSize), false, scratch, scratchEnd);
+		if (n < 0)
+			return false;
+		src += n;
+		lz.cmdStream = out;
+		lz.cmdStreamEnd = out + decodeCount;
+		scratch += decodeCount;
+
+		// commands of the second 64KB half start here
+		lz.cmdStream2OffsEnd = decodeCount;
+		if (dstSize <= 0x10000)
+		{
+			lz.cmdStream2Offs = decodeCount;
+		}
+		else
+		{
+			if (srcEnd - src < 2)
+				return false;
+			lz.cmdStream2Offs = Load16(src);
+			src += 2;
+			if (lz.cmdStream2Offs > lz.cmdStream2OffsEnd)
+				return false;
+		}
+
+		if (srcEnd - src < 2)
+			return false;
+		int off16Count = Load16(src);
+		if (off16Count == 0xffff)
+		{
+			// entropy coded as high and low bytes
+			byte* off16Hi = scratch;
+			int off16HiCount, off16LoCount;
+			src += 2;
+			n = DecodeBytes(&off16Hi, src, srcEnd, &off16HiCount, std::min<size_t>(scratchEnd - scratch, dstSize >> 1), false, scratch, scratchEnd);
+			if (n < 0)
+				return false;
+			src += n;
+			scratch += off16HiCount;
+
+			byte* off16Lo = scratch;
+			n = DecodeBytes(&off16Lo, src, srcEnd, &off16LoCount, std::min<size_t>(scratchEnd - scratch, dstSize >> 1), false, scratch, scratchEnd);
+			if (n < 0)
+				return false;
+			src += n;
+			scratch += off16LoCount;
+
+			if (off16LoCount != off16HiCount || scratchEnd - scratch < off16LoCount * 2)
+				return false;
+			byte* off16 = scratch;
+			for (int i = 0; i < off16LoCount; i++)
+			{
+				off16[2 * i] = off16Lo[i];
+				off16[2 * i + 1] = off16Hi[i];
+			}
+			scratch += off16LoCount * 2;
+			lz.off16Stream = off16;
+			lz.off16StreamEnd = scratch;
+		}
+		else
+		{
+			if (srcEnd - src < 2 + off16Count * 2)
+				return false;
+			lz.off16Stream = src + 2;
+			src += 2 + off16Count * 2;
+			lz.off16StreamEnd = src;
+		}
+
+		if (srcEnd - src < 3)
+			return false;
+		uint32_t tmp = src[0] | src[1] << 8 | src[2] << 16;
+		src += 3;
+		lz.off32Size1 = 0;
+		lz.off32Size2 = 0;
+		if (tmp != 0)
+		{
+			uint32_t off32Size1 = tmp >> 12;
+			uint32_t off32Size2 = tmp & 0xFFF;
+			if (off32Size1 == 4095)
+			{
+				if (srcEnd - src < 2)
+					return false;
+				off32Size1 = Load16(src);
+				src += 2;
+			}
+			if (off32Size2 == 4095)
+			{
+				if (srcEnd - src < 2)
+					return false;
+				off32Size2 = Load16(src);
+				src += 2;
+			}
+			lz.off32Size1 = off32Size1;
+			lz.off32Size2 = off32Size2;
+		}
+		scratch = AlignPointer(scratch, 4);
+		if (scratch + 4 * size_t(lz.off32Size1 + lz.off32Size2) > scratchEnd)
+			return false;
+		uint32_t* off32Stream1 = (uint32_t*)scratch;
+		uint32_t* off32Stream2 = off32Stream1 + lz.off32Size1;
+		lz.off32Stream1 = off32Stream1;
+		lz.off32Stream2 = off32Stream2;
+		n = MermaidDecodeFarOffsets(src, srcEnd, off32Stream1, lz.off32Size1, offset);
+		if (n < 0)
+			return false;
+		src += n;
+		n = MermaidDecodeFarOffsets(src, srcEnd, off32Stream2, lz.off32Size2, offset + 0x10000);
+		if (n < 0)
+			return false;
+		src += n;
+
+		lz.lengthStream = src;
+		return true;
+	}
+
+	// lengths beyond a command byte, extended by a 16 bit value past 251
+	inline bool MermaidReadLength(const byte*& lengthStream, const byte* srcEnd, size_t& length)
+	{
+		if (lengthStream >= srcEnd)
+			return false;
+		length = *lengthStream;
+		if (length > 251)
+		{
+			if (srcEnd - lengthStream < 3)
+				return false;
+			length += size_t(Load16(lengthStream + 1)) * 4;
+			lengthStream += 2;
+		}
+		lengthStream += 1;
+		return true;
+	}
+
+	// runs of one 64KB half, far offsets count back from its start
+	template<bool Delta>
+	bool MermaidProcessHalf(byte* dst, size_t dstSize, const byte* windowStart, const byte* srcEnd, MermaidLzTable& lz, ptrdiff_t& recentOffs, size_t startOff)
+	{
+		byte* dstBegin = dst;
+		byte* dstEnd = dst + dstSize;
+		const byte* cmdStream = lz.cmdStream;
+		const byte* cmdStreamEnd = lz.cmdStreamEnd;
+		const byte* lengthStream = lz.lengthStream;
+		const byte* litStream = lz.litStream;
+		const byte* litStreamEnd = lz.litStreamEnd;
+		const byte* off16Stream = lz.off16Stream;
+		const byte* off16StreamEnd = lz.off16StreamEnd;
+		const uint32_t* off32Stream = lz.off32Stream;
+		const uint32_t* off32StreamEnd = lz.off32StreamEnd;
+		ptrdiff_t recent = recentOffs;
+		dst += startOff;
+
+		while (cmdStream < cmdStreamEnd)
+		{
+			uint32_t cmd = *cmdStream++;
+			size_t length;
+			const byte* match;
+			if (cmd >= 24)
+			{
+				// up to 7 literals and a short match, bit 7 reuses the recent offset
+				size_t litlen = cmd & 7;
+				if (litlen > size_t(dstEnd - dst) || litlen > size_t(litStreamEnd - litStream))
+					return false;
+				CopyLiterals<Delta>(dst, litStream, litlen, recent);
+				dst += litlen;
+				litStream += litlen;
+				if (!(cmd & 0x80))
+				{
+					if (off16Stream == off16StreamEnd)
+						return false;
+					recent = -ptrdiff_t(Load16(off16Stream));
+					off16Stream += 2;
+				}
+				length = (cmd >> 3) & 0xF;
+				match = dst + recent;
+			}
+			else if (cmd > 2)
+			{
+				length = cmd + 5;
+				if (off32Stream == off32StreamEnd)
+					return false;
+				match = dstBegin - *off32Stream++;
+				recent = match - dst;
+			}
+			else if (cmd == 0)
+			{
+				// long literal run
+				if (!MermaidReadLength(lengthStream, srcEnd, length))
+					return false;
+				length += 64;
+				if (length > size_t(dstEnd - dst) || length > size_t(litStreamEnd - litStream))
+					return false;
+				CopyLiterals<Delta>(dst, litStream, length, recent);
+				dst += length;
+				litStream += length;
+				continue;
+			}
+			else if (cmd == 1)
+			{
+				if (!MermaidReadLength(lengthStream, srcEnd, length))
+					return false;
+				length += 91;
+				if (off16Stream == off16StreamEnd)
+					return false;
+				match = dst - Load16(off16Stream);
+				off16Stream += 2;
+				recent = match - dst;
+			}
+			else
+			{
+				if (!MermaidReadLength(lengthStream, srcEnd, length))
+					return false;
+				length += 29;
+				if (off32Stream == off32StreamEnd)
+					return false;
+				match = dstBegin - *off32Stream++;
+				recent = match - dst;
+			}
+			if (match < windowStart || match >= dst || length > size_t(dstEnd - dst))
+				return false;
+			CopyMatch(dst, match, length);
+			dst += length;
+		}
+
+		size_t length = dstEnd - dst;
+		if (length > size_t(litStreamEnd - litStream))
+			return false;
+		CopyLiterals<Delta>(dst, litStream, length, recent);
+		litStream += length;
+
+		recentOffs = recent;
+		lz.lengthStream = lengthStream;
+		lz.off16Stream = off16Stream;
+		lz.litStream = litStream;
+		return true;
+	}
+
+	template<bool Delta>
+	bool MermaidProcessLzRuns(const byte* srcEnd, byte* dst, size_t dstSize, size_t offset, const byte* windowStart, MermaidLzTable& lz)
+	{
+		ptrdiff_t recentOffs = -8;
+		const byte* cmdStream = lz.cmdStream;
+		for (int iteration = 0; iteration != 2; iteration++)
+		{
+			size_t dstSizeCur = std::min<size_t>(dstSize, 0x10000);
+			if (iteration == 0)
+			{
+				lz.off32Stream = lz.off32Stream1;
+				lz.off32StreamEnd = lz.off32Stream1 + lz.off32Size1;
+				lz.cmdStream = cmdStream;
+				lz.cmdStreamEnd = cmdStream + lz.cmdStream2Offs;
+			}
+			else
+			{
+				lz.off32Stream = lz.off32Stream2;
+				lz.off32StreamEnd = lz.off32Stream2 + lz.off32Size2;
+				lz.cmdStream = cmdStream + lz.cmdStream2Offs;
+				lz.cmdStreamEnd = cmdStream + lz.cmdStream2OffsEnd;
+			}
+			size_t startOff = (offset == 0 && iteration == 0) ? 8 : 0;
+			if (!MermaidProcessHalf<Delta>(dst, dstSizeCur, windowStart, srcEnd, lz, recentOffs, startOff))
+				return false;
+			dst += dstSizeCur;
+			dstSize -= dstSizeCur;
+			if (dstSize == 0)
+				break;
+		}
+		return lz.lengthStream == srcEnd;
+	}
+
+	int MermaidDecodeQuantum(byte* dst, byte* dstEnd, const byte* windowStart, const byte* src, const byte* srcEnd, byte* scratch, byte* scratchEnd)
+	{
+		MermaidLzTable lz;
+		auto readTable = [&](int mode, const byte* chunk, const byte* chunkEnd, byte* out, int outSize, size_t offset, byte* tmp, byte* tmpEnd)
+		{
+			size_t usage = std::min<size_t>(std::min<size_t>(2 * size_t(outSize) + 32, 0x40000), tmpEnd - tmp);
+			return MermaidReadLzTable(mode, chunk, chunkEnd, out, outSize, offset, tmp, tmp + usage, lz);
+		};
+		auto processRuns = [&](int mode, const byte* chunkEnd, byte* out, int outSize, size_t offset)
+		{
+			if (mode == 0)
+				return MermaidProcessLzRuns<true>(chunkEnd, out, outSize, offset, windowStart, lz);
+			return MermaidProcessLzRuns<false>(chunkEnd, out, outSize, offset, windowStart, lz);
+		};
+		return DecodeQuantum(dst, dstEnd, windowStart, src, srcEnd, scratch, scratchEnd, readTable, processRuns);
+	}
+
+	struct BlockHeader
+	{
+		int decoderType;
+		bool restart;
+		bool uncompressed;
+		bool checksums;
+	};
+
+	// 2 bytes at the start of every 256KB block
+	const byte* ParseBlockHeader(const byte* p, const byte* end, BlockHeader& hdr)
+	{
+		if (end - p < 2)
+			return nullptr;
+		int b = p[0];
+		if ((b & 0xF) != 0xC || ((b >> 4) & 3) != 0)
+			return nullptr;
+		hdr.restart = (b >> 7) & 1;
+		hdr.uncompressed = (b >> 6) & 1;
+		b = p[1];
+		hdr.decoderType = b & 0x7F;
+		hdr.checksums = (b >> 7) != 0;
+		if (hdr.decoderType != KrakenDecoder && hdr.decoderType != MermaidDecoder)
+			return nullptr;
+		return p + 2;
+	}
+
+	struct QuantumHeader
+	{
+		// 0 for a block filled with memsetByte
+		uint32_t compressedSize;
+		byte memsetByte;
+	};
+
+	const byte* ParseQuantumHeader(const byte* p, const byte* end, bool checksums, QuantumHeader& hdr)
+	{
+		if (end - p < 3)
+			return nullptr;
+		uint32_t v = Load24BE(p);
+		uint32_t size = v & 0x3FFFF;
+		if (size != 0x3FFFF)
+		{
+			// the checksum that may follow isn't validated
+			hdr.compressedSize = size + 1;
+			hdr.memsetByte = 0;
+			p += checksums ? 6 : 3;
+			return p <= end ? p : nullptr;
+		}
+		if ((v >> 18) == 1 && end - p >= 4)
+		{
+			hdr.compressedSize = 0;
+			hdr.memsetByte = p[3];
+			return p + 4;
+		}
+		return nullptr;
+	}
+
+	// decodes the block of dstSize bytes at src, returns the bytes it used or 0
+	size_t DecodeBlock(const byte* src, const byte* srcEnd, byte* dst, size_t dstSize, const byte* windowStart, byte* scratch)
+	{
+		BlockHeader block;
+		QuantumHeader quantum;
+		const byte* p = ParseBlockHeader(src, srcEnd, block);
+		if (!p)
+			return 0;
+		if (block.uncompressed)
+		{
+			if (size_t(srcEnd - p) < dstSize)
+				return 0;
+			memcpy(dst, p, dstSize);
+			return p + dstSize - src;
+		}
+		p = ParseQuantumHeader(p, srcEnd, block.checksums, quantum);
+		if (!p)
+			return 0;
+		if (quantum.compressedSize == 0)
+		{
+			memset(dst, quantum.memsetByte, dstSize);
+			return p - src;
+		}
+		if (quantum.compressedSize > size_t(srcEnd - p) || quantum.compressedSize > dstSize)
+			return 0;
+		if (quantum.compressedSize == dstSize)
+		{
+			memcpy(dst, p, dstSize);
+			return p + dstSize - src;
+		}
+		const byte* quantumEnd = p + quantum.compressedSize;
+		int used = block.decoderType == KrakenDecoder
+			? KrakenDecodeQuantum(dst, dst + dstSize, windowStart, p, quantumEnd, scratch, scratch + ScratchSize)
+			: MermaidDecodeQuantum(dst, dst + dstSize, windowStart, p, quantumEnd, scratch, scratch + ScratchSize);
+		if (used != int(quantum.compressedSize))
+			return 0;
+		return quantumEnd - src;
+	}
+
+	// block boundaries found from the headers alone
+	struct BlockSpan
+	{
+		size_t srcOffset;
+		size_t dstOffset;
+		bool restart;
+	};
+
+	bool ScanBlocks(const byte* src, size_t srcSize, size_t dstSize, vector<BlockSpan>& blocks)
+	{
+		const byte* p = src;
+		const byte* end = src + srcSize;
+		for (size_t dstOffset = 0; dstOffset < dstSize; dstOffset += BlockSize)
+		{
+			size_t blockSize = std::min(dstSize - dstOffset, BlockSize);
+			BlockHeader block;
+			QuantumHeader quantum;
+			const byte* start = p;
+			p = ParseBlockHeader(p, end, block);
+			if (!p)
+				return false;
+			if (block.uncompressed)
+			{
+				if (size_t(end - p) < blockSize)
+					return false;
+				p += blockSize;
+			}
+			else
+			{
+				p = ParseQuantumHeader(p, end, block.checksums, quantum);
+				if (!p || quantum.compressedSize > size_t(end - p))
+					return false;
+				p += quantum.compressedSize;
+			}
+			blocks.push_back({ size_t(start - src), dstOffset, block.restart });
+		}
+		return p == end;
+	}
+
+	bool DecodeBlocks(const byte* src, size_t srcSize, byte* dst, size_t dstSize, const BlockSpan* first, const BlockSpan* last, const byte* windowStart)
+	{
+		thread_local vector<byte> scratch;
+		scratch.resize(ScratchSize);
+		for (const BlockSpan* block = first; block != last; block++)
+		{
+			size_t srcEnd = block + 1 != last ? block[1].srcOffset : srcSize;
+			size_t blockSize = std::min(dstSize - block->dstOffset, BlockSize);
+			size_t used = DecodeBlock(src + block->srcOffset, src + srcEnd, dst + block->dstOffset, blockSize, windowStart, scratch.data());
+			if (used != srcEnd - block->srcOffset)
+				return false;
+		}
+		return true;
+	}
+}
+
+namespace Kraken
+{
+	bool Decompress(const byte* src, size_t srcSize, byte* dst, size_t dstSize, ThreadPool* pool)
+	{
+		if (dstSize == 0)
+			return srcSize == 0;
+		// no block takes more than its own size and 8 header bytes
+		if (srcSize > dstSize + 8 * ((dstSize + BlockSize - 1) / BlockSize))
+			return false;
+
+		// the bit readers may load a word on either side of their streams
+		vector<byte> padded(SourcePadding);
+		padded.insert(padded.end(), src, src + srcSize);
+		padded.resize(padded.size() + SourcePadding);
+		const byte* data = padded.data() + SourcePadding;
+
+		vector<BlockSpan> blocks;
+		if (!ScanBlocks(data, srcSize, dstSize, blocks))
+			return false;
+
+		// runs of blocks from a decoder reset don't reference anything before it
+		vector<size_t> segments;
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			if (i == 0 || blocks[i].restart)
+				segments.push_back(i);
+		}
+		segments.push_back(blocks.size());
+
+		if (pool && pool->ThreadCount() > 1 && segments.size() > 2)
+		{
+			std::atomic<bool> failed{ false };
+			for (size_t s = 0; s + 1 < segments.size(); s++)
+			{
+				pool->Submit([&, s]()
+				{
+					const BlockSpan* first = blocks.data() + segments[s];
+					const BlockSpan* last = blocks.data() + segments[s + 1];
+					if (!DecodeBlocks(data, srcSize, dst, dstSize, first, last, dst + first->dstOffset))
+						failed = true;
+				});
+			}
+			pool->Wait();
+			if (!failed)
+				return true;
+			// a reset flag doesn't promise a stream without matches across it, redo it whole
+		}
+		return DecodeBlocks(data, srcSize, dst, dstSize, blocks.data(), blocks.data() + blocks.size(), dst);
+	}
+}
\ No newline at end of file
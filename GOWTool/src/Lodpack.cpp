@@ -2,6 +2,7 @@
 #include "Lodpack.h"
 
 Lodpack::Lodpack(std::string filename)
+	: _filename(filename)
 {
 	file.open(filename, ios::in | ios::binary);
 	file.read((char*)&groupCount, sizeof(uint32_t));
@@ -44,6 +45,13 @@ Lodpack::Lodpack(std::string filename)
 Lodpack::~Lodpack()
 {
 	file.close();
+	delete[] groupStartOff;
+	delete[] groupHash;
+	delete[] groupBlockSize;
+	delete[] memberGroupIndex;
+	delete[] memberOffsetter;
+	delete[] memberHash;
+	delete[] memberBlockSize;
 }
 
 bool Lodpack::GetBuffer(uint64_t& Hash, std::stringstream& outstream)
@@ -62,4 +70,66 @@ bool Lodpack::GetBuffer(uint64_t& Hash, std::stringstream& outstream)
 		}
 	}
 	return false;
+}
+
+uint32_t LodpackIndex::AddPack(const std::filesystem::path& filepath)
+{
+	auto pack = std::make_unique<Pack>();
+	pack->path = filepath;
+	_packs.push_back(std::move(pack));
+	return static_cast<uint32_t>(_packs.size() - 1);
+}
+
+void LodpackIndex::AddMember(uint64_t hash, const Member& member)
+{
+	_members.Insert(hash, member);
+}
+
+uint32_t LodpackIndex::Add(const Lodpack& pack)
+{
+	uint32_t packIdx = AddPack(pack._filename);
+	_members.Reserve(_members.Size() + pack.TotalmembersCount);
+	for (uint32_t e = 0; e < pack.TotalmembersCount; e++)
+	{
+		uint32_t group = pack.memberGroupIndex[e];
+		if (group >= pack.groupCount)
+			continue;
+		Member member;
+		member.packIdx = packIdx;
+		member.group = group;
+		member.offset = (uint64_t)pack.memberOffsetter[e] + pack.groupStartOff[group];
+		member.size = pack.memberBlockSize[e];
+		_members.Insert(pack.memberHash[e], member);
+	}
+	return packIdx;
+}
+
+bool LodpackIndex::Find(uint64_t hash, Member& outMember) const
+{
+	const Member* member = _members.Find(hash);
+	if (member == nullptr)
+		return false;
+	outMember = *member;
+	return true;
+}
+
+std::span<const uint8_t> LodpackIndex::GetView(uint64_t hash)
+{
+	const Member* member = _members.Find(hash);
+	if (member == nullptr)
+		return {};
+	Pack& pack = *_packs[member->packIdx];
+	std::call_once(pack.mapped, [&pack]() { pack.mapping.Open(pack.path); });
+	return pack.mapping.GetView(member->offset, member->size);
+}
+
+bool LodpackIndex::GetBuffer(uint64_t hash, std::stringstream& outstream)
+{
+	outstream.str("");
+	outstream.clear();
+	auto view = GetView(hash);
+	if (view.empty())
+		return false;
+	outstream.write((const char*)view.data(), view.size());
+	return true;
 }
\ No newline at end of file
@@ -0,0 +1,174 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(_data, other._data);
+		std::swap(_size, other._size);
+		std::swap(_open, other._open);
+		std::swap(_writable, other._writable);
+#ifdef _WIN32
+		std::swap(_file, other._file);
+		std::swap(_mapping, other._mapping);
+#endif
+	}
+	return *this;
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::filesystem::path& filepath)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(filepath.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		CloseHandle(file);
+		return false;
+	}
+	_file = file;
+	_size = static_cast<size_t>(size.QuadPart);
+	_open = true;
+
+	// empty files can't be mapped, they are still valid with no data
+	if (_size == 0)
+		return true;
+
+	_mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (_mapping != nullptr)
+		_data = (uint8_t*)MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+	int fd = ::open(filepath.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	_size = static_cast<size_t>(st.st_size);
+	_open = true;
+
+	if (_size == 0)
+	{
+		::close(fd);
+		return true;
+	}
+
+	void* data = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (data != MAP_FAILED)
+		_data = (uint8_t*)data;
+#endif
+	if (_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+bool MappedFile::Create(const std::filesystem::path& filepath, size_t size)
+{
+	Close();
+#ifdef _WIN32
+	HANDLE file = CreateFileW(filepath.wstring().c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	_file = file;
+	_size = size;
+	_open = true;
+	_writable = true;
+
+	if (_size == 0)
+		return true;
+
+	_mapping = CreateFileMappingW(file, NULL, PAGE_READWRITE, DWORD(uint64_t(size) >> 32), DWORD(size & 0xFFFFFFFF), NULL);
+	if (_mapping != nullptr)
+		_data = (uint8_t*)MapViewOfFile(_mapping, FILE_MAP_WRITE, 0, 0, 0);
+#else
+	int fd = ::open(filepath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		return false;
+
+	_size = size;
+	_open = true;
+	_writable = true;
+
+	if (_size == 0)
+	{
+		::close(fd);
+		return true;
+	}
+
+	if (ftruncate(fd, off_t(size)) == 0)
+	{
+		void* data = mmap(nullptr, _size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED)
+			_data = (uint8_t*)data;
+	}
+	::close(fd);
+#endif
+	if (_data == nullptr)
+	{
+		Close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (_data != nullptr)
+		UnmapViewOfFile(_data);
+	if (_mapping != nullptr)
+		CloseHandle(_mapping);
+	if (_file != nullptr)
+		CloseHandle(_file);
+	_mapping = nullptr;
+	_file = nullptr;
+#else
+	if (_data != nullptr)
+		munmap(_data, _size);
+#endif
+	_data = nullptr;
+	_size = 0;
+	_open = false;
+	_writable = false;
+}
+
+std::span<const uint8_t> MappedFile::GetView(uint64_t offset, uint64_t size) const
+{
+	if (offset > _size || size > _size - offset)
+		return {};
+	return std::span<const uint8_t>(_data + offset, static_cast<size_t>(size));
+}
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include <krak.h>
 #include "Gnf.h"
 #include "converter.h"
+#include "Decompressor.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstring>
 
 Texpack::Texpack(const std::filesystem::path& filepath)
 {
@@ -18,78 +22,79 @@ Texpack::Texpack(const std::filesystem::path& filepath)
 	fs.read((char*)&_TexsCount, sizeof(uint32_t));
 
 	_texInfos = new TexInfo[_TexsCount];
+	_texIndex.Reserve(_TexsCount);
 
 	fs.seekg(0x38, ios::beg);
 	for (uint32_t i = 0; i < _TexsCount; i++)
 	{
 		TexInfo& info = _texInfos[i];
 		fs.read((char*)&info, sizeof(info));
+		_texIndex.Insert(info._fileHash, i);
 	}
 
 	_blockInfos = new BlockInfo[_blocksCount];
 	_blockInfoOffsets = new uint64_t[_blocksCount];
+	_blockIndex.Reserve(_blocksCount);
 	fs.seekg(_blocksInfoOff, ios::beg);
 	for (uint32_t i = 0; i < _blocksCount; i++)
 	{
 		_blockInfoOffsets[i] = fs.tellg();
 		BlockInfo& info = _blockInfos[i];
 		fs.read((char*)&info, sizeof(info));
+		_blockIndex.Insert(_blockInfoOffsets[i], i);
 	}
+	_mipChains.resize(_TexsCount);
 }
 Texpack::~Texpack()
 {
 	fs.close();
 	delete[] _blockInfos;
+	delete[] _blockInfoOffsets;
 	delete[] _texInfos;
 }
-bool Texpack::ContainsTexture(const uint64_t& hash)
+const Texpack::TexInfo* Texpack::FindTexture(const uint64_t& hash) const
 {
-	for (uint32_t i = 0; i < _TexsCount; i++)
-	{
-		if (_texInfos[i]._fileHash == hash)
-		{
-			return true;
-		}
-	}
-	return false;
+	const uint32_t* idx = _texIndex.Find(hash);
+	return idx != nullptr ? &_texInfos[*idx] : nullptr;
 }
-bool Texpack::ExportGnf(byte* &output, const uint64_t& hash, uint32_t& expSize)
+const vector<uint32_t>& Texpack::GetMipChain(uint32_t texIdx)
 {
-	TexInfo* texInfo = nullptr;
-	for (uint32_t i = 0; i < _TexsCount; i++)
+	vector<uint32_t>& chain = _mipChains[texIdx];
+	if (!chain.empty())
+		return chain;
+
+	// the tex info points at the last block, siblings lead back to the first mip
+	const uint32_t* blockIdx = _blockIndex.Find(_texInfos[texIdx]._blockInfoOff);
+	while (blockIdx != nullptr && chain.size() < _blocksCount)
 	{
-		if (_texInfos[i]._fileHash == hash)
-		{
-			texInfo = &_texInfos[i];
+		chain.push_back(*blockIdx);
+		if (_blockInfos[*blockIdx]._nextSiblingBlockInfoOff == -1LL)
 			break;
-		}
+		blockIdx = _blockIndex.Find(_blockInfos[*blockIdx]._nextSiblingBlockInfoOff);
 	}
-	if (texInfo == nullptr)
+	std::reverse(chain.begin(), chain.end());
+	return chain;
+}
+bool Texpack::ContainsTexture(const uint64_t& hash)
+{
+	return FindTexture(hash) != nullptr;
+}
+bool Texpack::ExportGnf(byte* &output, const uint64_t& hash, uint32_t& expSize)
+{
+	const uint32_t* texIdx = _texIndex.Find(hash);
+	if (texIdx == nullptr)
 		return false;
 
+	std::lock_guard<std::mutex> lock(_fsMutex);
+	const vector<uint32_t>& chain = GetMipChain(*texIdx);
+	if (chain.size() < 1)
+		return false;
 	std::vector<BlockInfo*> texblockInfos;
-
-	for (uint32_t i = 0; i < _blocksCount; i++)
+	for (uint32_t blockIdx : chain)
 	{
-		if (texInfo->_blockInfoOff == _blockInfoOffsets[i])
-		{
-			texblockInfos.push_back(&_blockInfos[i]);
-			break;
-		}
-	}
-	if (texblockInfos.size() < 1)
-		return false;
-	while (texblockInfos.front()->_nextSiblingBlockInfoOff != -1LL)
-	{
-		for (uint32_t i = 0; i < _blocksCount; i++)
-		{
-			if (texblockInfos.front()->_nextSiblingBlockInfoOff == _blockInfoOffsets[i])
-			{
-				texblockInfos.insert(texblockInfos.begin(), &_blockInfos[i]);
-				break;
-			}
-		}
+		texblockInfos.push_back(&_blockInfos[blockIdx]);
 	}
+
 	uint32_t writeSize = 0x100; //gnf Header
 	for (uint32_t i = 0; i < texblockInfos.size(); i++)
 	{
@@ -114,12 +119,34 @@ bool Texpack::ExportGnf(byte* &output, const uint64_t& hash, uint32_t& expSize)
 			fs.seekg(4, std::ios::cur);
 		}
 
-		fs.seekg(8, std::ios::cur);
+		uint32_t packedSize = 0;
+		fs.read((char*)&packedSize, sizeof(uint32_t));
+		fs.seekg(4, std::ios::cur);
 		uint32_t decSize = 0;
 		fs.read((char*)&decSize, sizeof(uint32_t));
+		BlockEncoding encoding = BlockEncoding::Stored;
+		fs.read((char*)&encoding, sizeof(encoding));
+		if (writeOff + decSize > writeSize)
+		{
+			delete[] output;
+			return false;
+		}
 
-		fs.seekg(4, std::ios::cur);
-		fs.read((char*)(output + writeOff), decSize);
+		if (encoding == BlockEncoding::Oodle && packedSize != 0)
+		{
+			static const std::unique_ptr<Oodle::Decompressor> decompressor = Oodle::Create(Oodle::Backend::Builtin);
+			vector<byte> packed(packedSize);
+			fs.read((char*)packed.data(), packedSize);
+			if (!decompressor->Decompress(packed.data(), packedSize, output + writeOff, decSize, nullptr))
+			{
+				delete[] output;
+				return false;
+			}
+		}
+		else
+		{
+			fs.read((char*)(output + writeOff), decSize);
+		}
 
 		writeOff += decSize;
 	}
@@ -150,12 +177,15 @@ bool Texpack::ExportGnf(const std::filesystem::path& dir, const uint64_t& hash,
 	{
 		outpath.replace_extension(std::filesystem::path(".dds"));
 
-		byte* ddsout = nullptr;
-		size = ConvertGnfToDDS(output,size,ddsout);
-		std::ofstream ofs(outpath.string(), ios::binary | ios::out);
-		ofs.write((char*)ddsout, size);
-		ofs.close();
-		delete[] ddsout;
+		try
+		{
+			result = ConvertGnfToDDS(output, size, outpath);
+		}
+		catch (...)
+		{
+			delete[] output;
+			throw;
+		}
 	}
 	else
 	{
@@ -165,7 +195,7 @@ bool Texpack::ExportGnf(const std::filesystem::path& dir, const uint64_t& hash,
 	}
 
 	delete[] output;
-	return true;
+	return result;
 }
 bool Texpack::ExportAllGnf(const std::filesystem::path& dir,bool dds)
 {
@@ -177,14 +207,251 @@ bool Texpack::ExportAllGnf(const std::filesystem::path& dir,bool dds)
 }
 bool Texpack::GetUserHash(const uint64_t& hash, uint64_t& outUserHash)
 {
-	for (uint32_t i = 0; i < _TexsCount; i++)
+	const TexInfo* texInfo = FindTexture(hash);
+	if (texInfo == nullptr)
+		return false;
+	outUserHash = texInfo->_userHash;
+	return true;
+}
+
+
+
+uint32_t TexpackIndex::AddPack(const std::filesystem::path& filepath)
+{
+	auto pack = std::make_unique<Pack>();
+	pack->path = filepath;
+	_packs.push_back(std::move(pack));
+	return static_cast<uint32_t>(_packs.size() - 1);
+}
+
+void TexpackIndex::AddTexture(uint64_t hash, uint32_t packIdx)
+{
+	_textures.Insert(hash, packIdx);
+}
+
+uint32_t TexpackIndex::Add(const std::filesystem::path& filepath, std::unique_ptr<Texpack> texpack)
+{
+	uint32_t packIdx = AddPack(filepath);
+	_textures.Reserve(_textures.Size() + texpack->_TexsCount);
+	for (uint32_t i = 0; i < texpack->_TexsCount; i++)
+	{
+		_textures.Insert(texpack->_texInfos[i]._fileHash, packIdx);
+	}
+	Pack& pack = *_packs[packIdx];
+	std::call_once(pack.opened, [&]() { pack.texpack = std::move(texpack); });
+	return packIdx;
+}
+
+Texpack* TexpackIndex::Find(uint64_t hash)
+{
+	const uint32_t* packIdx = _textures.Find(hash);
+	if (packIdx == nullptr)
+		return nullptr;
+	Pack& pack = *_packs[*packIdx];
+	std::call_once(pack.opened, [&pack]() { pack.texpack = std::make_unique<Texpack>(pack.path); });
+	return pack.texpack.get();
+}
+
+const std::filesystem::path* TexpackIndex::FindPackPath(uint64_t hash) const
+{
+	const uint32_t* packIdx = _textures.Find(hash);
+	return packIdx != nullptr ? &_packs[*packIdx]->path : nullptr;
+}
+
+namespace
+{
+	constexpr int OodleKraken = 8;
+	constexpr int OodleLevel = 4; // normal
+
+	template<typename T>
+	void Append(vector<byte>& out, const T& value)
 	{
-		if (_texInfos[i]._fileHash == hash)
+		const byte* p = (const byte*)&value;
+		out.insert(out.end(), p, p + sizeof(T));
+	}
+}
+
+TexpackWriter::TexpackWriter(bool compress)
+	: _compress(compress && LoadLib())
+{
+}
+
+vector<TexpackWriter::Block> TexpackWriter::PlanBlocks(const Gnf::Header& header) const
+{
+	vector<Block> blocks;
+	vector<size_t> mips;
+	if (_compress)
+		mips = GetGnfMipSizes(header);
+	size_t total = 0;
+	for (size_t size : mips)
+		total += size;
+	if (mips.empty() || total != header.dataSize)
+	{
+		// the game's layout, or the mip sizes are unknown: everything in one block
+		blocks.push_back({ 0, header.mipmaps, 0, header.dataSize });
+		return blocks;
+	}
+	size_t offset = 0;
+	for (uint32_t i = 0; i < mips.size(); i++)
+	{
+		if (mips[i] < SplitSize || i + 1 == mips.size())
 		{
-			outUserHash = _texInfos[i]._userHash;
-			return true;
+			blocks.push_back({ i, uint32_t(mips.size() - 1), offset, header.dataSize - offset });
+			break;
 		}
+		blocks.push_back({ i, i, offset, mips[i] });
+		offset += mips[i];
 	}
-	return false;
+	return blocks;
 }
 
+bool TexpackWriter::Write(const std::filesystem::path& texpackPath, const std::filesystem::path& tocPath, ThreadPool* pool)
+{
+	vector<vector<Block>> plans;
+	size_t blockCount = 0;
+	for (const Texture& texture : _textures)
+	{
+		plans.push_back(PlanBlocks(texture.header));
+		blockCount += plans.back().size();
+	}
+	const uint32_t texsCount = uint32_t(_textures.size());
+	const uint32_t blocksInfoOff = uint32_t(0x38 + texsCount * sizeof(Texpack::TexInfo));
+	const uint32_t texSectionOff = uint32_t(blocksInfoOff + blockCount * sizeof(Texpack::BlockInfo) + 15) & ~15U;
+	vector<Texpack::TexInfo> texInfos(texsCount);
+	vector<Texpack::BlockInfo> blockInfos(blockCount);
+
+	// both files are written next to the old ones and only replace them once complete
+	std::filesystem::path tmpTexpackPath = texpackPath;
+	tmpTexpackPath += ".tmp";
+	std::filesystem::path tmpTocPath = tocPath;
+	tmpTocPath += ".tmp";
+	auto discard = [&]()
+	{
+		std::error_code ec;
+		std::filesystem::remove(tmpTexpackPath, ec);
+		std::filesystem::remove(tmpTocPath, ec);
+		return false;
+	};
+
+	std::ofstream ofs(tmpTexpackPath, ios::binary | ios::out);
+	if (!ofs)
+		return false;
+	// room for the toc, written once the block offsets are known
+	vector<byte> toc(texSectionOff, 0);
+	ofs.write((char*)toc.data(), toc.size());
+
+	static const byte zeros[16] = {};
+	uint64_t woff = texSectionOff;
+	size_t blockIdx = 0;
+	vector<vector<byte>> packed;
+	vector<byte> head;
+	for (uint32_t i = 0; i < texsCount; i++)
+	{
+		const Texture& texture = _textures[i];
+		const vector<Block>& blocks = plans[i];
+		std::shared_ptr<byte[]> data = texture.load();
+		if (!data)
+		{
+			ofs.close();
+			return discard();
+		}
+
+		// stored when compression doesn't save anything
+		packed.assign(blocks.size(), {});
+		auto compress = [&](size_t b)
+		{
+			const Block& block = blocks[b];
+			vector<byte>& out = packed[b];
+			out.resize(block.size + 274 * ((block.size + 0x3FFFF) / 0x40000) + SAFE_SPACE);
+			int size = OodLZ_Compress(OodleKraken, data.get() + block.offset, block.size, out.data(), OodleLevel, NULL, 0, 0, NULL, 0);
+			if (size <= 0 || size_t(size) + 16 >= block.size)
+				out.clear();
+			else
+				out.resize(size);
+		};
+		if (_compress)
+		{
+			for (size_t b = 0; b < blocks.size(); b++)
+			{
+				if (pool)
+					pool->Submit([&compress, b]() { compress(b); });
+				else
+					compress(b);
+			}
+			if (pool)
+				pool->Wait();
+		}
+
+		// blocks are written in data order, each links to the one before it
+		for (size_t b = 0; b < blocks.size(); b++, blockIdx++)
+		{
+			const Block& block = blocks[b];
+			const bool first = b == 0;
+			const bool oodle = !packed[b].empty();
+			const uint32_t dataOffset = first ? 0x124U : 0x20U;
+			const size_t dataBytes = oodle ? packed[b].size() : block.size;
+			const uint32_t blockSize = uint32_t(dataOffset + dataBytes + 15) & ~15U;
+			const uint16_t mipCount = uint16_t(texture.header.mipmaps + 1);
+
+			head.clear();
+			Append(head, 0x1U);
+			Append(head, dataOffset);
+			Append(head, blockSize);
+			Append(head, 0x5U);
+			if (first)
+			{
+				Append(head, texture.header);
+				Append(head, 0x3U);
+			}
+			Append(head, uint32_t(oodle ? dataBytes : 0));
+			Append(head, mipCount);
+			Append(head, mipCount);
+			Append(head, uint32_t(block.size));
+			Append(head, oodle ? Texpack::BlockEncoding::Oodle : Texpack::BlockEncoding::Stored);
+			ofs.write((char*)head.data(), head.size());
+			ofs.write((char*)(oodle ? packed[b].data() : data.get() + block.offset), dataBytes);
+			ofs.write((char*)zeros, blockSize - dataOffset - dataBytes);
+
+			Texpack::BlockInfo& blockInfo = blockInfos[blockIdx];
+			blockInfo._blockOff = uint32_t(woff >> 4);
+			blockInfo._rawSize = uint32_t(block.size);
+			blockInfo._blockSize = blockSize;
+			blockInfo._mipLvlStart = byte(block.lastMip);
+			blockInfo._mipLvlEnd = byte(block.firstMip);
+			blockInfo._tocFileIdx = 0;
+			blockInfo._mipWidth = uint16_t(std::max<uint32_t>((texture.header.width + 1) >> block.firstMip, 1));
+			blockInfo._mipHeight = uint16_t(std::max<uint32_t>((texture.header.height + 1) >> block.firstMip, 1));
+			blockInfo._nextSiblingBlockInfoOff = first ? -1LL : blocksInfoOff + (blockIdx - 1) * sizeof(Texpack::BlockInfo);
+			woff += blockSize;
+		}
+
+		// the texture points at its last block
+		Texpack::TexInfo& texInfo = texInfos[i];
+		texInfo._fileHash = texture.hash;
+		texInfo._userHash = texture.header.userHash;
+		texInfo._blockInfoOff = blocksInfoOff + (blockIdx - 1) * sizeof(Texpack::BlockInfo);
+	}
+
+	const uint32_t header[] = { texSectionOff, uint32_t(blockCount), blocksInfoOff, texsCount, 0x5U, 0x0U };
+	memcpy(toc.data() + 0x20, header, sizeof(header));
+	memcpy(toc.data() + 0x38, texInfos.data(), texInfos.size() * sizeof(Texpack::TexInfo));
+	memcpy(toc.data() + blocksInfoOff, blockInfos.data(), blockInfos.size() * sizeof(Texpack::BlockInfo));
+	ofs.seekp(0);
+	ofs.write((char*)toc.data(), toc.size());
+	ofs.close();
+
+	std::ofstream ofs1(tmpTocPath, ios::binary | ios::out);
+	ofs1.write((char*)toc.data(), toc.size());
+	ofs1.close();
+	if (!ofs.good() || !ofs1.good())
+		return discard();
+
+	std::error_code ec;
+	std::filesystem::rename(tmpTexpackPath, texpackPath, ec);
+	if (ec)
+		return discard();
+	std::filesystem::rename(tmpTocPath, tocPath, ec);
+	if (ec)
+		return discard();
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "pch.h"
+#include "ThreadPool.h"
+#include "utils.h"
+
+namespace
+{
+	thread_local const ThreadPool* currentPool = nullptr;
+	thread_local size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(size_t threadCount)
+{
+	if (threadCount <= 1)
+		return;
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		_workers.push_back(std::make_unique<Worker>());
+	}
+	for (size_t i = 0; i < threadCount; i++)
+	{
+		_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	Wait();
+	{
+		std::lock_guard<std::mutex> lock(_waitMutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+	for (auto& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void ThreadPool::Submit(std::function<void()> task)
+{
+	if (_workers.empty())
+	{
+		Run(task);
+		return;
+	}
+
+	size_t target = currentPool == this ? currentWorker : _next++ % _workers.size();
+	_pending++;
+	{
+		std::lock_guard<std::mutex> lock(_waitMutex);
+		_queued++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_workers[target]->mutex);
+		_workers[target]->tasks.push_back(std::move(task));
+	}
+	_wake.notify_one();
+}
+
+void ThreadPool::Wait()
+{
+	if (_workers.empty())
+		return;
+
+	size_t self = currentPool == this ? currentWorker : 0;
+	while (_pending > 0)
+	{
+		if (TryRun(self))
+			continue;
+		std::unique_lock<std::mutex> lock(_waitMutex);
+		_wake.wait(lock, [this]() { return _pending == 0 || _queued > 0; });
+	}
+}
+
+bool ThreadPool::TryRun(size_t self)
+{
+	std::function<void()> task;
+	for (size_t i = 0; i < _workers.size() && !task; i++)
+	{
+		Worker& worker = *_workers[(self + i) % _workers.size()];
+		std::lock_guard<std::mutex> lock(worker.mutex);
+		if (worker.tasks.empty())
+			continue;
+		if (i == 0)
+		{
+			task = std::move(worker.tasks.back());
+			worker.tasks.pop_back();
+		}
+		else
+		{
+			task = std::move(worker.tasks.front());
+			worker.tasks.pop_front();
+		}
+	}
+	if (!task)
+		return false;
+
+	_queued--;
+	Run(task);
+	if (--_pending == 0)
+	{
+		std::lock_guard<std::mutex> lock(_waitMutex);
+		_wake.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::Run(std::function<void()>& task)
+{
+	try
+	{
+		task();
+	}
+	catch (const std::exception& e)
+	{
+		Utils::Logger::Error((string("\n") + e.what()).c_str());
+	}
+}
+
+void ThreadPool::WorkerLoop(size_t self)
+{
+	currentPool = this;
+	currentWorker = self;
+	while (true)
+	{
+		if (TryRun(self))
+			continue;
+		std::unique_lock<std::mutex> lock(_waitMutex);
+		_wake.wait(lock, [this]() { return _stop || _queued > 0; });
+		if (_stop)
+			return;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,291 @@
+#include "pch.h"
+#include "VertexDecoder.h"
+#include <cmath>
+#include <cstring>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VERTEX_DECODER_SSE2
+#endif
+
+namespace
+{
+	inline const uint8_t* VertexPtr(const VertexStream& stream, uint32_t v)
+	{
+		return stream.data.data() + stream.offset + uint64_t(stream.stride) * v;
+	}
+	template<typename T>
+	inline T Load(const uint8_t* p)
+	{
+		T value;
+		memcpy(&value, p, sizeof(T));
+		return value;
+	}
+
+	// scalar versions, used for the tails of the streams and when SSE2 isn't available
+	inline void DecodePosition16(const uint8_t* p, const Vec3& scale, const Vec3& min, Vec3& out)
+	{
+		out.X = (float)Load<uint16_t>(p) / 65535.f * scale.X + min.X;
+		out.Y = (float)Load<uint16_t>(p + 2) / 65535.f * scale.Y + min.Y;
+		out.Z = (float)Load<uint16_t>(p + 4) / 65535.f * scale.Z + min.Z;
+	}
+	inline void DecodeTenBitShifted(uint32_t u, float& x, float& y, float& z)
+	{
+		x = (float(u & 1023) - 511) / 512.f;
+		y = (float((u >> 10) & 1023) - 511) / 512.f;
+		z = (float((u >> 20) & 1023) - 511) / 512.f;
+		float mag = sqrt(x * x + y * y + z * z);
+		x = x / mag, y = y / mag, z = z / mag;
+	}
+	inline void DecodeWeight(uint32_t u, float* out)
+	{
+		float x = float(u & 1023) / 1023.f;
+		float y = float((u >> 10) & 1023) / 1023.f;
+		float z = float((u >> 20) & 1023) / 1023.f;
+		float ratio = 1 / (x + y + z);
+		out[0] = x * ratio;
+		out[1] = y * ratio;
+		out[2] = z * ratio;
+		out[3] = 0.f;
+	}
+
+#ifdef VERTEX_DECODER_SSE2
+	inline __m128i Gather32(const VertexStream& stream, uint32_t v)
+	{
+		return _mm_setr_epi32(Load<int32_t>(VertexPtr(stream, v)), Load<int32_t>(VertexPtr(stream, v + 1)),
+			Load<int32_t>(VertexPtr(stream, v + 2)), Load<int32_t>(VertexPtr(stream, v + 3)));
+	}
+	// 10-10-10-2 of four vertices split into one register per component
+	inline void SplitTenBit(__m128i u, __m128& x, __m128& y, __m128& z)
+	{
+		const __m128i mask = _mm_set1_epi32(1023);
+		x = _mm_cvtepi32_ps(_mm_and_si128(u, mask));
+		y = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(u, 10), mask));
+		z = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(u, 20), mask));
+	}
+	inline void TenBitShiftedNormalized(__m128i u, __m128& x, __m128& y, __m128& z)
+	{
+		const __m128 bias = _mm_set1_ps(511.f);
+		const __m128 range = _mm_set1_ps(512.f);
+		SplitTenBit(u, x, y, z);
+		x = _mm_div_ps(_mm_sub_ps(x, bias), range);
+		y = _mm_div_ps(_mm_sub_ps(y, bias), range);
+		z = _mm_div_ps(_mm_sub_ps(z, bias), range);
+		__m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+		x = _mm_div_ps(x, mag);
+		y = _mm_div_ps(y, mag);
+		z = _mm_div_ps(z, mag);
+	}
+#endif
+}
+
+namespace VertexDecoder
+{
+	VertexStream GetStream(const MeshInfo& meshinfo, const Component& component, std::span<const uint8_t> data, uint64_t off)
+	{
+		VertexStream stream;
+		stream.data = data;
+		stream.count = meshinfo.vertCount;
+		if (component.bufferIndex >= meshinfo.bufferOffset.size() || component.bufferIndex >= meshinfo.bufferStride.size())
+		{
+			stream.count = 0;
+			return stream;
+		}
+		stream.offset = component.offset + meshinfo.bufferOffset[component.bufferIndex] + off;
+		stream.stride = meshinfo.bufferStride[component.bufferIndex];
+		return stream;
+	}
+
+	uint32_t Available(const VertexStream& stream, uint32_t elementSize)
+	{
+		if (stream.count == 0 || stream.offset > stream.data.size() || stream.data.size() - stream.offset < elementSize)
+			return 0;
+		if (stream.stride == 0)
+			return stream.count;
+		uint64_t fit = (stream.data.size() - stream.offset - elementSize) / stream.stride + 1;
+		return uint32_t(std::min<uint64_t>(fit, stream.count));
+	}
+
+	void DecodePositions(const VertexStream& stream, DataTypes type, const Vec3& scale, const Vec3& min, Vec3* out)
+	{
+		if (type != DataTypes::UNSIGNED_SHORT)
+		{
+			const uint32_t count = Available(stream, 12);
+			for (uint32_t v = 0; v < count; v++)
+			{
+				memcpy(&out[v], VertexPtr(stream, v), 12);
+			}
+			return;
+		}
+
+		const uint32_t count = Available(stream, 6);
+		uint32_t v = 0;
+#ifdef VERTEX_DECODER_SSE2
+		// reads 8 bytes per vertex, the last vertex may not have the 2 bytes of padding after it
+		const uint32_t wide = Available(stream, 8);
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 norm = _mm_set1_ps(65535.f);
+		const __m128 vscale = _mm_setr_ps(scale.X, scale.Y, scale.Z, 0.f);
+		const __m128 vmin = _mm_setr_ps(min.X, min.Y, min.Z, 0.f);
+		for (; v < wide; v++)
+		{
+			__m128i raw = _mm_unpacklo_epi16(_mm_loadl_epi64((const __m128i*)VertexPtr(stream, v)), zero);
+			__m128 pos = _mm_add_ps(_mm_mul_ps(_mm_div_ps(_mm_cvtepi32_ps(raw), norm), vscale), vmin);
+			float result[4];
+			_mm_storeu_ps(result, pos);
+			memcpy(&out[v], result, 12);
+		}
+#endif
+		for (; v < count; v++)
+		{
+			DecodePosition16(VertexPtr(stream, v), scale, min, out[v]);
+		}
+	}
+
+	void DecodeNormals(const VertexStream& stream, Vec3* out)
+	{
+		const uint32_t count = Available(stream, 4);
+		uint32_t v = 0;
+#ifdef VERTEX_DECODER_SSE2
+		for (; v + 4 <= count; v += 4)
+		{
+			__m128 x, y, z;
+			TenBitShiftedNormalized(Gather32(stream, v), x, y, z);
+			float xs[4], ys[4], zs[4];
+			_mm_storeu_ps(xs, x);
+			_mm_storeu_ps(ys, y);
+			_mm_storeu_ps(zs, z);
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				out[v + i].X = xs[i];
+				out[v + i].Y = ys[i];
+				out[v + i].Z = zs[i];
+			}
+		}
+#endif
+		for (; v < count; v++)
+		{
+			DecodeTenBitShifted(Load<uint32_t>(VertexPtr(stream, v)), out[v].X, out[v].Y, out[v].Z);
+		}
+	}
+
+	void DecodeTangents(const VertexStream& stream, Vec4* out)
+	{
+		const uint32_t count = Available(stream, 4);
+		uint32_t v = 0;
+#ifdef VERTEX_DECODER_SSE2
+		const __m128 one = _mm_set1_ps(1.f);
+		for (; v + 4 <= count; v += 4)
+		{
+			__m128 x, y, z, w = one;
+			TenBitShiftedNormalized(Gather32(stream, v), x, y, z);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_storeu_ps(out[v].XYZW, x);
+			_mm_storeu_ps(out[v + 1].XYZW, y);
+			_mm_storeu_ps(out[v + 2].XYZW, z);
+			_mm_storeu_ps(out[v + 3].XYZW, w);
+		}
+#endif
+		for (; v < count; v++)
+		{
+			DecodeTenBitShifted(Load<uint32_t>(VertexPtr(stream, v)), out[v].X, out[v].Y, out[v].Z);
+			out[v].W = 1.f;
+		}
+	}
+
+	void DecodeTexcoords(const VertexStream& stream, DataTypes type, Vec2* out)
+	{
+		if (type != DataTypes::UNSIGNED_SHORT && type != DataTypes::HALFWORD_STRUCT_2)
+		{
+			const uint32_t count = Available(stream, 8);
+			for (uint32_t v = 0; v < count; v++)
+			{
+				memcpy(&out[v], VertexPtr(stream, v), 8);
+			}
+			return;
+		}
+
+		const float norm = type == DataTypes::UNSIGNED_SHORT ? 65535.f : 32767.f;
+		const uint32_t count = Available(stream, 4);
+		uint32_t v = 0;
+#ifdef VERTEX_DECODER_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 vnorm = _mm_set1_ps(norm);
+		for (; v + 4 <= count; v += 4)
+		{
+			__m128i raw = Gather32(stream, v);
+			__m128 lo = _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero)), vnorm);
+			__m128 hi = _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero)), vnorm);
+			_mm_storeu_ps(&out[v].X, lo);
+			_mm_storeu_ps(&out[v + 2].X, hi);
+		}
+#endif
+		for (; v < count; v++)
+		{
+			const uint8_t* p = VertexPtr(stream, v);
+			out[v].X = (float)Load<uint16_t>(p) / norm;
+			out[v].Y = (float)Load<uint16_t>(p + 2) / norm;
+		}
+	}
+
+	void DecodeJoints(const VertexStream& stream, DataTypes type, uint16_t* out)
+	{
+		if (type == DataTypes::BYTE_STRUCT_0)
+		{
+			const uint32_t count = Available(stream, 4);
+			for (uint32_t v = 0; v < count; v++)
+			{
+				const uint8_t* p = VertexPtr(stream, v);
+				out[v * 4] = p[0];
+				out[v * 4 + 1] = p[1];
+				out[v * 4 + 2] = p[2];
+				out[v * 4 + 3] = p[3];
+			}
+			return;
+		}
+		const uint32_t count = Available(stream, 8);
+		for (uint32_t v = 0; v < count; v++)
+		{
+			memcpy(out + v * 4, VertexPtr(stream, v), 8);
+		}
+	}
+
+	void DecodeWeights(const VertexStream& stream, float* out)
+	{
+		const uint32_t count = Available(stream, 4);
+		uint32_t v = 0;
+#ifdef VERTEX_DECODER_SSE2
+		const __m128 norm = _mm_set1_ps(1023.f);
+		const __m128 one = _mm_set1_ps(1.f);
+		for (; v + 4 <= count; v += 4)
+		{
+			__m128 x, y, z, w = _mm_setzero_ps();
+			SplitTenBit(Gather32(stream, v), x, y, z);
+			x = _mm_div_ps(x, norm);
+			y = _mm_div_ps(y, norm);
+			z = _mm_div_ps(z, norm);
+			__m128 ratio = _mm_div_ps(one, _mm_add_ps(_mm_add_ps(x, y), z));
+			x = _mm_mul_ps(x, ratio);
+			y = _mm_mul_ps(y, ratio);
+			z = _mm_mul_ps(z, ratio);
+			_MM_TRANSPOSE4_PS(x, y, z, w);
+			_mm_storeu_ps(out + v * 4, x);
+			_mm_storeu_ps(out + v * 4 + 4, y);
+			_mm_storeu_ps(out + v * 4 + 8, z);
+			_mm_storeu_ps(out + v * 4 + 12, w);
+		}
+#endif
+		for (; v < count; v++)
+		{
+			DecodeWeight(Load<uint32_t>(VertexPtr(stream, v)), out + v * 4);
+		}
+	}
+
+	uint32_t DecodeIndices(std::span<const uint8_t> data, uint64_t offset, uint32_t count, uint16_t* out)
+	{
+		if (offset > data.size())
+			return 0;
+		count = uint32_t(std::min<uint64_t>(count, (data.size() - offset) / sizeof(uint16_t)));
+		memcpy(out, data.data() + offset, size_t(count) * sizeof(uint16_t));
+		return count;
+	}
+}
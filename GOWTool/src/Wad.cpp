@@ -1,5 +1,9 @@
 #include "pch.h"
 #include "Wad.h"
+#include "utils.h"
+#include <cstring>
+#include <set>
+#include <string_view>
 
 WadFile::~WadFile()
 {
@@ -38,18 +42,193 @@ bool WadFile::Read(const std::filesystem::path& filepath)
 			fs.seekg(pad, ios::beg);
 		}
 	}
+	BuildIndex();
 	return true;
 }
 
+bool WadFile::Map(const std::filesystem::path& filepath)
+{
+	if (!_mapping.Open(filepath))
+		return false;
+
+	const uint8_t* data = _mapping.Data();
+	const size_t end = _mapping.Size();
+	size_t pos = 0;
+	while (pos + 0x60 <= end)
+	{
+		FileDesc entry;
+		memcpy(&entry.group, data + pos, sizeof(uint16_t));
+		memcpy(&entry.type, data + pos + 2, sizeof(uint16_t));
+		memcpy(&entry.size, data + pos + 4, sizeof(uint32_t));
+		const char* name = (const char*)data + pos + 0x18;
+		entry.name = string(name, strnlen(name, 0x38));
+		pos += 0x60; // YouLoveFromMaya\0
+		if (entry.size != 0)
+		{
+			if (entry.size > end - pos)
+				break;
+			entry.offset = static_cast<uint32_t>(pos);
+			_FileEntries.push_back(entry);
+			pos = (pos + entry.size + 15) & (~15);
+		}
+	}
+	BuildIndex();
+	return true;
+}
+
+void WadFile::BuildIndex()
+{
+	_nameIndex.clear();
+	_typeIndex.clear();
+	_nameIndex.reserve(_FileEntries.size());
+	for (uint32_t i = 0; i < _FileEntries.size(); i++)
+	{
+		_nameIndex[_FileEntries[i].name].push_back(i);
+		_typeIndex[_FileEntries[i].type].push_back(i);
+	}
+	BuildRelations();
+}
+
+// Resolves what the mesh exporters used to search for per definition. A
+// definition takes the first buffer whose name contains the definition's name
+// and that no earlier definition of the same kind took already, skinned and
+// rigid definitions pick from the buffers independently. Rigs are matched by
+// the lowercased name after the "Proto" prefix.
+void WadFile::BuildRelations()
+{
+	_meshBuffers.assign(_FileEntries.size(), -1);
+	_rigs.assign(_FileEntries.size(), -1);
+
+	const vector<uint32_t>& skinnedDefs = GetEntries(FileType::SkinnedMeshDef);
+	vector<uint32_t> rigidDefs;
+	for (uint32_t i : GetEntries(FileType::RigidMeshDefData))
+	{
+		if (_FileEntries[i].name.find("smsh_data") != std::string::npos)
+			rigidDefs.push_back(i);
+	}
+	auto rigidName = [this](uint32_t i)
+	{
+		const std::string& name = _FileEntries[i].name;
+		return std::string_view(name).substr(0, name.length() - 10);
+	};
+
+	// buffers containing each definition name, in entry order
+	std::unordered_map<std::string_view, vector<uint32_t>> candidates;
+	std::set<size_t> lengths;
+	for (uint32_t i : skinnedDefs)
+	{
+		candidates.try_emplace(_FileEntries[i].name);
+		lengths.insert(_FileEntries[i].name.length());
+	}
+	for (uint32_t i : rigidDefs)
+	{
+		candidates.try_emplace(rigidName(i));
+		lengths.insert(rigidName(i).length());
+	}
+	for (uint32_t j : GetEntries(FileType::SkinnedMeshBuff))
+	{
+		std::string_view name = _FileEntries[j].name;
+		for (size_t length : lengths)
+		{
+			for (size_t pos = 0; pos + length <= name.length(); pos++)
+			{
+				auto it = candidates.find(name.substr(pos, length));
+				if (it != candidates.end() && (it->second.empty() || it->second.back() != j))
+					it->second.push_back(j);
+			}
+		}
+	}
+	auto assign = [&](const vector<uint32_t>& defs, auto&& nameOf)
+	{
+		vector<bool> used(_FileEntries.size(), false);
+		for (uint32_t i : defs)
+		{
+			for (uint32_t j : candidates[nameOf(i)])
+			{
+				if (!used[j])
+				{
+					used[j] = true;
+					_meshBuffers[i] = j;
+					break;
+				}
+			}
+		}
+	};
+	assign(skinnedDefs, [this](uint32_t i) { return std::string_view(_FileEntries[i].name); });
+	assign(rigidDefs, rigidName);
+
+	std::unordered_map<std::string, uint32_t> rigs;
+	for (uint32_t j : GetEntries(FileType::Rig))
+	{
+		const std::string& name = _FileEntries[j].name;
+		if (name.find("Proto") != std::string::npos && name.length() >= 7)
+			rigs.try_emplace(Utils::str_tolower(name.substr(7)), j);
+	}
+	for (uint32_t i : skinnedDefs)
+	{
+		const std::string& name = _FileEntries[i].name;
+		if (name.length() < 3)
+			continue;
+		auto it = rigs.find(name.substr(3, name.length() - 5));
+		if (it != rigs.end())
+			_rigs[i] = it->second;
+	}
+}
+
 bool WadFile::GetBuffer(const uint32_t& entryIdx, std::iostream& outstream)
 {
-	
 	if (entryIdx >= _FileEntries.size())
 		return false;
+	if (IsMapped())
+	{
+		auto view = GetView(entryIdx);
+		outstream.write((const char*)view.data(), view.size());
+		return true;
+	}
 	std::unique_ptr<uint8_t[]> output = std::make_unique<uint8_t[]>(_FileEntries[entryIdx].size);
 	fs.seekg(_FileEntries[entryIdx].offset, std::ios::beg);
 	fs.read((char*)output.get(), _FileEntries[entryIdx].size);
 	outstream.write((char*)output.get(), _FileEntries[entryIdx].size);
 	
 	return true;
+}
+
+std::span<const uint8_t> WadFile::GetView(const uint32_t& entryIdx) const
+{
+	if (entryIdx >= _FileEntries.size())
+		return {};
+	return _mapping.GetView(_FileEntries[entryIdx].offset, _FileEntries[entryIdx].size);
+}
+
+bool WadFile::FindEntry(const std::string& name, uint32_t& outIdx, FileType type) const
+{
+	auto it = _nameIndex.find(name);
+	if (it == _nameIndex.end())
+		return false;
+	for (uint32_t idx : it->second)
+	{
+		if (type == FileType::None || _FileEntries[idx].type == type)
+		{
+			outIdx = idx;
+			return true;
+		}
+	}
+	return false;
+}
+
+const vector<uint32_t>& WadFile::GetEntries(FileType type) const
+{
+	static const vector<uint32_t> empty;
+	auto it = _typeIndex.find(type);
+	return it != _typeIndex.end() ? it->second : empty;
+}
+
+int WadFile::GetMeshBuffer(uint32_t defIdx) const
+{
+	return defIdx < _meshBuffers.size() ? _meshBuffers[defIdx] : -1;
+}
+
+int WadFile::GetRig(uint32_t defIdx) const
+{
+	return defIdx < _rigs.size() ? _rigs[defIdx] : -1;
 }
\ No newline at end of file
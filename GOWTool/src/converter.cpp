@@ -1,123 +1,107 @@
 #include "pch.h"
-#include "gnf.h"
+#include "Gnf.h"
 #include "converter.h"
-#include <DirectXTex/DirectXTex.h>
-#include <DirectXTex/DirectXTexP.h>
-#include <DirectXTex/DDS.h>
-#include <dxgiformat.h>
+#include "Dds.h"
 #include "MathFunctions.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <utility>
 
-size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte*& ddsout)
+namespace
 {
-	Gnf::GnfImage gnfimg;
-	gnfimg.ReadImage(gnfsrc);
-
-	DirectX::TexMetadata meta;
-	meta.width = gnfimg.header.width + 1;
-	meta.height = gnfimg.header.height + 1;
-	meta.depth = gnfimg.header.depth + 1;
-	meta.arraySize = 1;
-	meta.mipLevels = gnfimg.header.mipmaps + 1;
-	meta.miscFlags = 0;
-	meta.miscFlags2 = 3;
-	meta.dimension = DirectX::TEX_DIMENSION::TEX_DIMENSION_TEXTURE2D;
-
-	switch (gnfimg.header.format)
-	{
-	case Gnf::Format::FormatBC1:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSRGB ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
-		break;
-	case Gnf::Format::FormatBC2:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSRGB ? DXGI_FORMAT_BC2_UNORM_SRGB : DXGI_FORMAT_BC2_UNORM;
-		break;
-	case Gnf::Format::FormatBC3:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSRGB ? DXGI_FORMAT_BC3_UNORM_SRGB : DXGI_FORMAT_BC3_UNORM;
-		break;
-	case Gnf::Format::FormatBC4:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSNorm ? DXGI_FORMAT_BC4_SNORM : DXGI_FORMAT_BC4_UNORM;
-		break;
-	case Gnf::Format::FormatBC5:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSNorm ? DXGI_FORMAT_BC5_SNORM : DXGI_FORMAT_BC5_UNORM;
-		break;
-	case Gnf::Format::FormatBC6:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSNorm ? DXGI_FORMAT_BC6H_SF16 : DXGI_FORMAT_BC6H_UF16;
-		break;
-	case Gnf::Format::FormatBC7:
-		meta.format = gnfimg.header.formatType == Gnf::FormatType::FormatTypeSRGB ? DXGI_FORMAT_BC7_UNORM_SRGB : DXGI_FORMAT_BC7_UNORM;
-		break;
-	case Gnf::Format::Format8:
-		if (gnfimg.header.formatType == Gnf::FormatType::FormatTypeUNorm)
-			meta.format = DXGI_FORMAT_R8_UNORM;
-		else if (gnfimg.header.formatType == Gnf::FormatType::FormatTypeSNorm)
-			meta.format = DXGI_FORMAT_R8_SNORM;
-		else if (gnfimg.header.formatType == Gnf::FormatType::FormatTypeUInt)
-			meta.format = DXGI_FORMAT_R8_UINT;
-		else if (gnfimg.header.formatType == Gnf::FormatType::FormatTypeSInt)
-			meta.format = DXGI_FORMAT_R8_SINT;
-		break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
-	}
+	using namespace Dds;
 
-	// sub to change
-	size_t bpp = 8;
-	size_t pixbl = 4;
-	switch (gnfimg.header.format)
+	// dds side of a gnf format, the memory layout comes from Gnf::GetFormatInfo
+	struct DDSFormat
 	{
-	case Gnf::Format::FormatBC1:
-	case Gnf::Format::FormatBC4:
-		bpp = 4;
-		break;
-	case Gnf::Format::FormatBC2:
-	case Gnf::Format::FormatBC3:
-	case Gnf::Format::FormatBC5:
-	case Gnf::Format::FormatBC6:
-	case Gnf::Format::FormatBC7:
-		bpp = 8;
-		break;
-	case Gnf::Format::Format8:
-		bpp = 8;
-		pixbl = 1;
-		break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
+		Gnf::Format format;
+		DxgiFormat types[16]; // per Gnf::FormatType, DXGI_FORMAT_UNKNOWN if there is no equivalent
+		DxgiFormat fallback;  // for types without an entry of their own
+		bool legacyHeader;     // written with a dx9 header unless larger than 4096 or the type has no dx9 pixel format
+		uint32_t unk7;
+		uint32_t unk9;
+	};
+
+	constexpr DDSFormat Map(Gnf::Format format, std::initializer_list<std::pair<Gnf::FormatType, DxgiFormat>> types,
+		DxgiFormat fallback = DXGI_FORMAT_UNKNOWN, bool legacyHeader = false, uint32_t unk7 = 0x96D, uint32_t unk9 = 0x0)
+	{
+		DDSFormat result{ format, {}, fallback, legacyHeader, unk7, unk9 };
+		for (auto& type : result.types)
+		{
+			type = DXGI_FORMAT_UNKNOWN;
+		}
+		for (const auto& [type, dxgi] : types)
+		{
+			result.types[uint32_t(type)] = dxgi;
+		}
+		return result;
 	}
 
-	byte* header = new byte[148];
-	size_t required;
-	DirectX::DDS_FLAGS flag = DirectX::DDS_FLAGS::DDS_FLAGS_NONE | DirectX::DDS_FLAGS::DDS_FLAGS_ALLOW_LARGE_FILES;
-	switch (gnfimg.header.format)
+	using Gnf::Format;
+	using Gnf::FormatType;
+	constexpr FormatType UNorm = FormatType::FormatTypeUNorm;
+	constexpr FormatType SNorm = FormatType::FormatTypeSNorm;
+	constexpr FormatType UInt = FormatType::FormatTypeUInt;
+	constexpr FormatType SInt = FormatType::FormatTypeSInt;
+	constexpr FormatType Float = FormatType::FormatTypeFloat;
+	constexpr FormatType SRGB = FormatType::FormatTypeSRGB;
+
+	// the first matching entry wins when going from dds to gnf
+	constexpr DDSFormat DDSFormats[] =
+	{
+		Map(Format::FormatBC1, { { UNorm, DXGI_FORMAT_BC1_UNORM }, { SRGB, DXGI_FORMAT_BC1_UNORM_SRGB } }, DXGI_FORMAT_BC1_UNORM, true),
+		Map(Format::FormatBC2, { { UNorm, DXGI_FORMAT_BC2_UNORM }, { SRGB, DXGI_FORMAT_BC2_UNORM_SRGB } }, DXGI_FORMAT_BC2_UNORM, true),
+		Map(Format::FormatBC3, { { UNorm, DXGI_FORMAT_BC3_UNORM }, { SRGB, DXGI_FORMAT_BC3_UNORM_SRGB } }, DXGI_FORMAT_BC3_UNORM, true),
+		Map(Format::FormatBC4, { { UNorm, DXGI_FORMAT_BC4_UNORM }, { SNorm, DXGI_FORMAT_BC4_SNORM } }, DXGI_FORMAT_BC4_UNORM, true),
+		Map(Format::FormatBC5, { { UNorm, DXGI_FORMAT_BC5_UNORM }, { SNorm, DXGI_FORMAT_BC5_SNORM } }, DXGI_FORMAT_BC5_UNORM, true),
+		Map(Format::FormatBC6, { { UNorm, DXGI_FORMAT_BC6H_UF16 }, { SNorm, DXGI_FORMAT_BC6H_SF16 } }, DXGI_FORMAT_BC6H_UF16, false, 0xB6D, 0xA000),
+		Map(Format::FormatBC7, { { UNorm, DXGI_FORMAT_BC7_UNORM }, { SRGB, DXGI_FORMAT_BC7_UNORM_SRGB } }, DXGI_FORMAT_BC7_UNORM),
+		Map(Format::Format8, { { UNorm, DXGI_FORMAT_R8_UNORM }, { SNorm, DXGI_FORMAT_R8_SNORM }, { UInt, DXGI_FORMAT_R8_UINT }, { SInt, DXGI_FORMAT_R8_SINT } },
+			DXGI_FORMAT_UNKNOWN, true),
+		Map(Format::Format16, { { UNorm, DXGI_FORMAT_R16_UNORM }, { SNorm, DXGI_FORMAT_R16_SNORM }, { UInt, DXGI_FORMAT_R16_UINT }, { SInt, DXGI_FORMAT_R16_SINT },
+			{ Float, DXGI_FORMAT_R16_FLOAT } }),
+		Map(Format::Format8_8, { { UNorm, DXGI_FORMAT_R8G8_UNORM }, { SNorm, DXGI_FORMAT_R8G8_SNORM }, { UInt, DXGI_FORMAT_R8G8_UINT }, { SInt, DXGI_FORMAT_R8G8_SINT } }),
+		Map(Format::Format32, { { UInt, DXGI_FORMAT_R32_UINT }, { SInt, DXGI_FORMAT_R32_SINT }, { Float, DXGI_FORMAT_R32_FLOAT } }),
+		Map(Format::Format16_16, { { UNorm, DXGI_FORMAT_R16G16_UNORM }, { SNorm, DXGI_FORMAT_R16G16_SNORM }, { UInt, DXGI_FORMAT_R16G16_UINT },
+			{ SInt, DXGI_FORMAT_R16G16_SINT }, { Float, DXGI_FORMAT_R16G16_FLOAT } }),
+		// gnf lists the components from the most significant bits down, dxgi from the least significant up
+		Map(Format::Format10_11_11, { { Float, DXGI_FORMAT_R11G11B10_FLOAT } }),
+		Map(Format::Format2_10_10_10, { { UNorm, DXGI_FORMAT_R10G10B10A2_UNORM }, { UInt, DXGI_FORMAT_R10G10B10A2_UINT } }),
+		Map(Format::Format8_8_8_8, { { UNorm, DXGI_FORMAT_R8G8B8A8_UNORM }, { SNorm, DXGI_FORMAT_R8G8B8A8_SNORM }, { UInt, DXGI_FORMAT_R8G8B8A8_UINT },
+			{ SInt, DXGI_FORMAT_R8G8B8A8_SINT }, { SRGB, DXGI_FORMAT_R8G8B8A8_UNORM_SRGB } }),
+		Map(Format::Format32_32, { { UInt, DXGI_FORMAT_R32G32_UINT }, { SInt, DXGI_FORMAT_R32G32_SINT }, { Float, DXGI_FORMAT_R32G32_FLOAT } }),
+		Map(Format::Format16_16_16_16, { { UNorm, DXGI_FORMAT_R16G16B16A16_UNORM }, { SNorm, DXGI_FORMAT_R16G16B16A16_SNORM },
+			{ UInt, DXGI_FORMAT_R16G16B16A16_UINT }, { SInt, DXGI_FORMAT_R16G16B16A16_SINT }, { Float, DXGI_FORMAT_R16G16B16A16_FLOAT } }),
+		Map(Format::Format32_32_32, { { UInt, DXGI_FORMAT_R32G32B32_UINT }, { SInt, DXGI_FORMAT_R32G32B32_SINT }, { Float, DXGI_FORMAT_R32G32B32_FLOAT } }),
+		Map(Format::Format32_32_32_32, { { UInt, DXGI_FORMAT_R32G32B32A32_UINT }, { SInt, DXGI_FORMAT_R32G32B32A32_SINT },
+			{ Float, DXGI_FORMAT_R32G32B32A32_FLOAT } }),
+		Map(Format::Format5_6_5, { { UNorm, DXGI_FORMAT_B5G6R5_UNORM } }),
+		Map(Format::Format1_5_5_5, { { UNorm, DXGI_FORMAT_B5G5R5A1_UNORM } }),
+		Map(Format::Format4_4_4_4, { { UNorm, DXGI_FORMAT_B4G4R4A4_UNORM } }),
+		Map(Format::Format5_9_9_9, { { Float, DXGI_FORMAT_R9G9B9E5_SHAREDEXP } }),
+	};
+
+	const DDSFormat* FindDDSFormat(Gnf::Format format)
 	{
-	case Gnf::Format::FormatBC1:
-	case Gnf::Format::FormatBC2:
-	case Gnf::Format::FormatBC3:
-	case Gnf::Format::FormatBC4:
-	case Gnf::Format::FormatBC5:
-	case Gnf::Format::Format8:
-		flag |= (meta.width > 4096) || (meta.height > 4096) ? DirectX::DDS_FLAGS::DDS_FLAGS_FORCE_DX10_EXT : DirectX::DDS_FLAGS::DDS_FLAGS_FORCE_DX9_LEGACY;
-		break;
-	case Gnf::Format::FormatBC6:
-	case Gnf::Format::FormatBC7:
-		flag |= DirectX::DDS_FLAGS::DDS_FLAGS_FORCE_DX10_EXT;
-		break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
+		for (const DDSFormat& entry : DDSFormats)
+		{
+			if (entry.format == format)
+				return &entry;
+		}
+		return nullptr;
 	}
-	DirectX::_EncodeDDSHeader(meta, flag, header, 148, required);
 
-	size_t datasize = 0;
-	for (uint32_t i = 0; i < meta.mipLevels; i++)
+	// size of a mip in the dds (w, h) and padded the way it's stored in the gnf (tempw, temph)
+	void GetMipSize(const Gnf::FormatInfo& info, size_t width, size_t height, uint32_t mip, size_t& w, size_t& h, size_t& tempw, size_t& temph)
 	{
-		size_t w = meta.width;
-		size_t h = meta.height;
-		w >>= i;
-		h >>= i;
+		const size_t pixbl = info.pixbl;
+		w = width >> mip;
+		h = height >> mip;
 
 		if (w < 1 && h < 1)
-			throw std::exception("Invalid Mip count");
+			throw std::runtime_error("Invalid Mip count");
 
 		w = std::max<size_t>(w, pixbl);
 		h = std::max<size_t>(h, pixbl);
@@ -125,286 +109,268 @@ size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte*& ddsout)
 		w = (w + (pixbl - 1)) & (~(pixbl - 1));
 		h = (h + (pixbl - 1)) & (~(pixbl - 1));
 
-		size_t size = w * h * bpp / 8;
-
-		datasize += size;
+		tempw = std::max<size_t>(BitHacks::RoundUpTo2(uint32_t(w)), info.minPitch);
+		temph = std::max<size_t>(BitHacks::RoundUpTo2(uint32_t(h)), info.minPitch);
 	}
 
-	ddsout = new byte[datasize + required];
-	memcpy(ddsout, header, required);
-
-	size_t ddsoff = required;
-	size_t gnfoff = 0;
-	for (uint32_t i = 0; i < meta.mipLevels; i++)
+	// everything needed to lay a gnf out as dds, derived from the gnf header alone
+	struct DDSLayout
 	{
-		size_t w = meta.width;
-		size_t h = meta.height;
-		w >>= i;
-		h >>= i;
-
-		if (w < 1 && h < 1)
-			throw std::exception("Invalid Mip count");
-
-		w = std::max<size_t>(w, pixbl);
-		h = std::max<size_t>(h, pixbl);
-
-		w = (w + (pixbl - 1)) & (~(pixbl - 1));
-		h = (h + (pixbl - 1)) & (~(pixbl - 1));
-
-		size_t tempw = BitHacks::RoundUpTo2(w);
-		size_t temph = BitHacks::RoundUpTo2(h);
-		if (i == 0 && tempw != (gnfimg.header.pitch + 1))
-			throw std::exception("Pitch doesn't match RoundUp2 Width");
-
-		tempw = pixbl == 1 ? std::max<size_t>(tempw, 16) : std::max<size_t>(tempw, 32);
-		temph = pixbl == 1 ? std::max<size_t>(temph, 16) : std::max<size_t>(temph, 32);
+		Dds::TextureDesc desc;
+		bool legacy;
+		const Gnf::FormatInfo* info;
+		size_t headerSize;
+		size_t dataSize;
+		size_t gnfDataSize;
+	};
+
+	void GetDDSLayout(const Gnf::Header& gnfheader, DDSLayout& layout)
+	{
+		const Gnf::FormatInfo* info = Gnf::GetFormatInfo(gnfheader.format);
+		const DDSFormat* ddsFormat = FindDDSFormat(gnfheader.format);
+		if (info == nullptr || ddsFormat == nullptr)
+			throw std::runtime_error("Format not implemented!");
+
+		Dds::TextureDesc& desc = layout.desc;
+		desc.width = gnfheader.width + 1;
+		desc.height = gnfheader.height + 1;
+		desc.mipLevels = gnfheader.mipmaps + 1;
+		desc.format = ddsFormat->types[uint32_t(gnfheader.formatType)];
+		if (desc.format == DXGI_FORMAT_UNKNOWN)
+			desc.format = ddsFormat->fallback;
+		if (desc.format == DXGI_FORMAT_UNKNOWN)
+			throw std::runtime_error("Format type not implemented!");
+		desc.compressed = info->pixbl > 1;
+		layout.info = info;
+
+		layout.legacy = ddsFormat->legacyHeader && desc.width <= 4096 && desc.height <= 4096 && Dds::HasLegacyHeader(desc.format);
+		layout.headerSize = Dds::GetHeaderSize(desc.format, layout.legacy);
+		if (layout.headerSize == 0)
+			throw std::runtime_error("Failed to encode DDS header");
+
+		layout.dataSize = 0;
+		layout.gnfDataSize = 0;
+		for (uint32_t i = 0; i < desc.mipLevels; i++)
+		{
+			size_t w, h, tempw, temph;
+			GetMipSize(*info, desc.width, desc.height, i, w, h, tempw, temph);
+			if (i == 0 && BitHacks::RoundUpTo2(uint32_t(w)) != uint32_t(gnfheader.pitch + 1))
+				throw std::runtime_error("Pitch doesn't match RoundUp2 Width");
+			// row pitch of the top mip, its whole size when it is made of blocks
+			if (i == 0)
+				desc.pitchOrLinearSize = uint32_t(desc.compressed ? w * h * info->bpp / 8 : w * info->bpp / 8);
+
+			layout.dataSize += w * h * info->bpp / 8;
+			layout.gnfDataSize += tempw * temph * info->bpp / 8;
+		}
+	}
 
-		size_t size = tempw * temph * bpp / 8;
+	void ReadLayout(const byte* gnfsrc, const size_t& gnfsize, DDSLayout& layout)
+	{
+		if (gnfsize < sizeof(Gnf::Header))
+			throw std::runtime_error("Invalid GNF size");
+		Gnf::Header gnfheader;
+		memcpy(&gnfheader, gnfsrc, sizeof(Gnf::Header));
+		GetDDSLayout(gnfheader, layout);
+		if (layout.gnfDataSize > gnfsize - sizeof(Gnf::Header))
+			throw std::runtime_error("GNF image data is truncated");
+	}
 
-		byte* tempData = new byte[size];
-		Gnf::GnfImage::UnSwizzle(gnfimg.imageData.get() + gnfoff, tempData, tempw, temph, bpp,pixbl);
-		gnfoff += size;
+	// gnf header of the dds and where its pixels start, ddssrc only has to hold the dds headers
+	size_t MakeGnfHeader(const byte* ddssrc, const size_t& ddssize, Gnf::Header& header, const Gnf::FormatInfo*& formatInfo)
+	{
+		Dds::TextureDesc desc;
+		const size_t ddsdata = Dds::DecodeHeader(ddssrc, ddssize, desc);
 
-		size_t size1 = w * h * bpp / 8;
-		size_t scanLineSize = w * pixbl * bpp / 8;
-		size_t scanLineSizePadded = tempw * pixbl * bpp / 8;
-		size_t off1 = 0;
-		size_t off2 = 0;
-		for (uint32_t j = 0; j < (h / pixbl); j++)
+		const DDSFormat* ddsFormat = nullptr;
+		for (const DDSFormat& entry : DDSFormats)
 		{
-			memcpy(ddsout + ddsoff + off1, tempData + off2, scanLineSize);
-			off1 += scanLineSize;
-			off2 += scanLineSizePadded;
+			for (uint32_t type = 0; type < 16 && ddsFormat == nullptr; type++)
+			{
+				if (entry.types[type] == desc.format)
+				{
+					ddsFormat = &entry;
+					header.format = entry.format;
+					header.formatType = Gnf::FormatType(type);
+				}
+			}
+			if (ddsFormat != nullptr)
+				break;
 		}
-		ddsoff += size1;
-		delete[] tempData;
+		const Gnf::FormatInfo* info = ddsFormat != nullptr ? Gnf::GetFormatInfo(ddsFormat->format) : nullptr;
+		if (info == nullptr)
+			throw std::runtime_error("Format not implemented!");
+	
+		if (desc.width < 1 || desc.height < 1 || desc.mipLevels < 1)
+			throw std::runtime_error("Invalid Resolution and/or Mip");
+
+		header.width = desc.width - 1;
+		header.height = desc.height - 1;
+		header.mipmaps = desc.mipLevels - 1;
+
+		// unused channels read as 0, alpha as 1
+		static const uint32_t destSelects[4][4] = { { 4, 0, 0, 1 }, { 4, 5, 0, 1 }, { 4, 5, 6, 1 }, { 4, 5, 6, 7 } };
+		const uint32_t* dest = destSelects[std::clamp<uint32_t>(info->channels, 1, 4) - 1];
+		header.destX = dest[0];
+		header.destY = dest[1];
+		header.destZ = dest[2];
+		header.destW = dest[3];
+		header.unk7 = ddsFormat->unk7;
+		header.unk9 = ddsFormat->unk9;
+
+		header.pitch = std::max<uint32_t>(BitHacks::RoundUpTo2(uint32_t(desc.width)), info->minPitch);
+		header.pitch--;
+
+		// mips follow the header back to back, each w * h * bpp / 8 bytes once padded to whole blocks
+		size_t ddsend = ddsdata;
+		header.dataSize = 0;
+		for (uint32_t i = 0; i < desc.mipLevels; i++)
+		{
+			size_t w, h, tempw, temph;
+			GetMipSize(*info, std::max<size_t>(desc.width >> i, 1), std::max<size_t>(desc.height >> i, 1), 0, w, h, tempw, temph);
+			if (i == 0 && tempw != size_t(header.pitch + 1))
+				throw std::runtime_error("Pitch doesn't match RoundUp2 Width");
+
+			header.dataSize += uint32_t(tempw * temph * info->bpp / 8);
+			ddsend += w * h * info->bpp / 8;
+		}
+		if (ddsend > ddssize)
+			throw std::runtime_error("DDS image data is truncated");
+		header.fileSize = header.dataSize + 0x100;
+		formatInfo = info;
+		return ddsdata;
 	}
+}
 
-	return (datasize + required);
+size_t GetDDSSize(const byte* gnfsrc, const size_t& gnfsize)
+{
+	DDSLayout layout;
+	ReadLayout(gnfsrc, gnfsize, layout);
+	return layout.headerSize + layout.dataSize;
 }
-size_t ConvertDDSToGnf(const byte* ddssrc,const size_t &ddssize, byte*& gnfout)
+size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte* ddsout, const size_t& ddssize)
 {
-	DirectX::TexMetadata meta;
-	DirectX::DDS_FLAGS flags = DirectX::DDS_FLAGS::DDS_FLAGS_ALLOW_LARGE_FILES;
-	std::unique_ptr<DirectX::ScratchImage> image(new (std::nothrow) DirectX::ScratchImage);
-	DirectX::LoadFromDDSMemory(ddssrc, ddssize, flags, &meta, *image);
+	DDSLayout layout;
+	ReadLayout(gnfsrc, gnfsize, layout);
+	if (ddssize < layout.headerSize + layout.dataSize)
+		throw std::runtime_error("DDS output buffer too small");
+
+	// mips are unswizzled one after the other, each straight into its place in the output
+	const Dds::TextureDesc& desc = layout.desc;
+	const Gnf::FormatInfo& info = *layout.info;
+	const byte* gnfdata = gnfsrc + sizeof(Gnf::Header);
+	size_t ddsoff = Dds::EncodeHeader(desc, layout.legacy, ddsout, layout.headerSize);
+	size_t gnfoff = 0;
+	for (uint32_t i = 0; i < desc.mipLevels; i++)
+	{
+		size_t w, h, tempw, temph;
+		GetMipSize(info, desc.width, desc.height, i, w, h, tempw, temph);
 
-	Gnf::GnfImage gnfImg;
+		Gnf::GnfImage::UnSwizzle(gnfdata + gnfoff, ddsout + ddsoff, tempw, temph, info.bpp, info.pixbl, w, h);
+		gnfoff += tempw * temph * info.bpp / 8;
+		ddsoff += w * h * info.bpp / 8;
+	}
 
-	switch (meta.format)
+	return ddsoff;
+}
+bool ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, const std::filesystem::path& ddspath)
+{
+	size_t ddssize = GetDDSSize(gnfsrc, gnfsize);
+	MappedFile ddsfile;
+	if (!ddsfile.Create(ddspath, ddssize))
+		return false;
+	try
 	{
-	case DXGI_FORMAT_BC1_UNORM:
-	case DXGI_FORMAT_BC1_UNORM_SRGB:
-		gnfImg.header.format = Gnf::Format::FormatBC1;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC1_UNORM_SRGB ? Gnf::FormatType::FormatTypeSRGB : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC2_UNORM:
-	case DXGI_FORMAT_BC2_UNORM_SRGB:
-		gnfImg.header.format = Gnf::Format::FormatBC2;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC2_UNORM_SRGB ? Gnf::FormatType::FormatTypeSRGB : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC3_UNORM:
-	case DXGI_FORMAT_BC3_UNORM_SRGB:
-		gnfImg.header.format = Gnf::Format::FormatBC3;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC3_UNORM_SRGB ? Gnf::FormatType::FormatTypeSRGB : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC4_UNORM:
-	case DXGI_FORMAT_BC4_SNORM:
-		gnfImg.header.format = Gnf::Format::FormatBC4;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC4_SNORM ? Gnf::FormatType::FormatTypeSNorm : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC5_UNORM:
-	case DXGI_FORMAT_BC5_SNORM:
-		gnfImg.header.format = Gnf::Format::FormatBC5;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC5_SNORM ? Gnf::FormatType::FormatTypeSNorm : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC6H_UF16:
-	case DXGI_FORMAT_BC6H_SF16:
-		gnfImg.header.format = Gnf::Format::FormatBC6;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC6H_SF16 ? Gnf::FormatType::FormatTypeSNorm : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_BC7_UNORM:
-	case DXGI_FORMAT_BC7_UNORM_SRGB:
-		gnfImg.header.format = Gnf::Format::FormatBC7;
-		gnfImg.header.formatType = meta.format == DXGI_FORMAT_BC7_UNORM_SRGB ? Gnf::FormatType::FormatTypeSRGB : Gnf::FormatType::FormatTypeUNorm;
-		break;
-	case DXGI_FORMAT_R8_UNORM:
-	case DXGI_FORMAT_R8_SNORM:
-	case DXGI_FORMAT_R8_UINT:
-	case DXGI_FORMAT_R8_SINT:
-		gnfImg.header.format = Gnf::Format::Format8;
-		if(meta.format == DXGI_FORMAT_R8_UNORM)
-			gnfImg.header.formatType = Gnf::FormatType::FormatTypeUNorm;
-		else if (meta.format == DXGI_FORMAT_R8_SNORM)
-			gnfImg.header.formatType = Gnf::FormatType::FormatTypeSNorm;
-		else if (meta.format == DXGI_FORMAT_R8_UINT)
-			gnfImg.header.formatType = Gnf::FormatType::FormatTypeUInt;
-		else if (meta.format == DXGI_FORMAT_R8_SINT)
-			gnfImg.header.formatType = Gnf::FormatType::FormatTypeSInt;
-	break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
+		ConvertGnfToDDS(gnfsrc, gnfsize, ddsfile.MutableData(), ddssize);
 	}
-	
-	if (meta.width < 1 || meta.height < 1 || meta.mipLevels < 1)
-		throw std::exception("Invalid Resolution and/or Mip");
-
-	gnfImg.header.width = meta.width - 1;
-	gnfImg.header.height = meta.height - 1;
-	gnfImg.header.mipmaps = meta.mipLevels - 1;
-	switch (gnfImg.header.format)
+	catch (...)
 	{
-	case Gnf::Format::FormatBC1:
-	case Gnf::Format::FormatBC2:
-	case Gnf::Format::FormatBC3:
-	case Gnf::Format::FormatBC7:
-		gnfImg.header.destX = 4;
-		gnfImg.header.destY = 5;
-		gnfImg.header.destZ = 6;
-		gnfImg.header.destW = 7;
-		break;
-	case Gnf::Format::FormatBC4:
-		gnfImg.header.destX = 4;
-		gnfImg.header.destY = 0;
-		gnfImg.header.destZ = 0;
-		gnfImg.header.destW = 1;
-		break;
-	case Gnf::Format::FormatBC5:
-		gnfImg.header.destX = 4;
-		gnfImg.header.destY = 5;
-		gnfImg.header.destZ = 0;
-		gnfImg.header.destW = 1;
-		break;
-	case Gnf::Format::FormatBC6:
-		gnfImg.header.destX = 4;
-		gnfImg.header.destY = 5;
-		gnfImg.header.destZ = 6;
-		gnfImg.header.destW = 1;
-		gnfImg.header.unk7 = 0xB6D;
-		gnfImg.header.unk9 = 0xA000;
-		break;
-	case Gnf::Format::Format8:
-		gnfImg.header.destX = 4;
-		gnfImg.header.destY = 0;
-		gnfImg.header.destZ = 0;
-		gnfImg.header.destW = 1;
-		break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
+		ddsfile.Close();
+		std::filesystem::remove(ddspath);
+		throw;
 	}
-
-	uint16_t bpp = 8;
-	uint16_t pixbl = 4;
-	switch (gnfImg.header.format)
+	return true;
+}
+size_t ConvertGnfToDDS(const byte* gnfsrc, const size_t& gnfsize, byte*& ddsout)
+{
+	size_t ddssize = GetDDSSize(gnfsrc, gnfsize);
+	ddsout = new byte[ddssize];
+	try
 	{
-	case Gnf::Format::FormatBC1:
-	case Gnf::Format::FormatBC4:
-		bpp = 4;
-		break;
-	case Gnf::Format::FormatBC2:
-	case Gnf::Format::FormatBC3:
-	case Gnf::Format::FormatBC5:
-	case Gnf::Format::FormatBC6:
-	case Gnf::Format::FormatBC7:
-		bpp = 8;
-		break;
-	case Gnf::Format::Format8:
-		bpp = 8;
-		pixbl = 1;
-		break;
-	default:
-		throw std::exception("Format not implemented!");
-		break;
+		return ConvertGnfToDDS(gnfsrc, gnfsize, ddsout, ddssize);
 	}
-	gnfImg.header.pitch = BitHacks::RoundUpTo2(meta.width);
-	gnfImg.header.pitch = pixbl == 1 ? std::max<size_t>(gnfImg.header.pitch, 16) : std::max<size_t>(gnfImg.header.pitch, 32);
-	gnfImg.header.pitch--;
-
-	gnfImg.header.dataSize = 0;
-	for (uint32_t i = 0; i < meta.mipLevels; i++)
+	catch (...)
 	{
-		auto mipImg = (*image).GetImages()[i];
-		size_t w = mipImg.width;
-		size_t h = mipImg.height;
-
-		if (w < 1 && h < 1)
-			throw std::exception("Invalid Mip count");
-
-		w = std::max<size_t>(w, pixbl);
-		h = std::max<size_t>(h, pixbl);
-
-		w = (w + (pixbl - 1)) & (~(pixbl - 1));
-		h = (h + (pixbl - 1)) & (~(pixbl - 1));
-
-		w = BitHacks::RoundUpTo2(w);
-		h = BitHacks::RoundUpTo2(h);
-		if (i == 0 && w != (gnfImg.header.pitch + 1))
-			throw std::exception("Pitch doesn't match RoundUp2 Width");
-
-		w = pixbl == 1 ? std::max<size_t>(w, 16) : std::max<size_t>(w, 32);
-		h = pixbl == 1 ? std::max<size_t>(h, 16) : std::max<size_t>(h, 32);
-
-		size_t size = w * h * bpp / 8;
-		gnfImg.header.dataSize += uint32_t(size);
+		delete[] ddsout;
+		ddsout = nullptr;
+		throw;
 	}
-
-	gnfImg.imageData = std::make_shared<byte[]>(gnfImg.header.dataSize);
-	for (size_t k = 0; k < gnfImg.header.dataSize; k++)
+}
+Gnf::Header GetGnfHeader(const byte* ddssrc, const size_t& ddssize)
+{
+	Gnf::Header header{};
+	const Gnf::FormatInfo* info;
+	MakeGnfHeader(ddssrc, ddssize, header, info);
+	return header;
+}
+vector<size_t> GetGnfMipSizes(const Gnf::Header& header)
+{
+	vector<size_t> sizes;
+	const Gnf::FormatInfo* info = Gnf::GetFormatInfo(header.format);
+	if (info == nullptr)
+		return sizes;
+	const size_t width = header.width + 1;
+	const size_t height = header.height + 1;
+	for (uint32_t i = 0; i <= header.mipmaps; i++)
 	{
-		gnfImg.imageData.get()[k] = byte(0);
+		if ((width >> i) == 0 && (height >> i) == 0)
+			return {};
+		size_t w, h, tempw, temph;
+		GetMipSize(*info, width, height, i, w, h, tempw, temph);
+		sizes.push_back(tempw * temph * info->bpp / 8);
 	}
+	return sizes;
+}
+size_t ConvertDDSToGnf(const byte* ddssrc,const size_t &ddssize, byte*& gnfout)
+{
+	Gnf::GnfImage gnfImg;
+	const Gnf::FormatInfo* info;
+	const size_t ddsdata = MakeGnfHeader(ddssrc, ddssize, gnfImg.header, info);
+	const size_t width = gnfImg.header.width + 1;
+	const size_t height = gnfImg.header.height + 1;
+	const uint32_t mipLevels = gnfImg.header.mipmaps + 1;
+
+	gnfImg.imageData = std::make_shared<byte[]>(gnfImg.header.dataSize);
+	memset(gnfImg.imageData.get(), 0, gnfImg.header.dataSize);
 
 	size_t gnfoff = 0;
-	for (size_t i = 0; i < meta.mipLevels; i++)
+	const byte* pixels = ddssrc + ddsdata;
+	for (uint32_t i = 0; i < mipLevels; i++)
 	{
-		auto mipImg = (*image).GetImages()[i];
-		size_t w = mipImg.width;
-		size_t h = mipImg.height;
+		size_t w, h, tempw, temph;
+		GetMipSize(*info, std::max<size_t>(width >> i, 1), std::max<size_t>(height >> i, 1), 0, w, h, tempw, temph);
 
-		if (w < 1 && h < 1)
-			throw std::exception("Invalid Mip Count/Resolution");
-
-		w = std::max<size_t>(w, pixbl);
-		h = std::max<size_t>(h, pixbl);
-
-		w = (w + (pixbl - 1)) & (~(pixbl - 1));
-		h = (h + (pixbl - 1)) & (~(pixbl - 1));
-
-		size_t tempw = BitHacks::RoundUpTo2(w);
-		size_t temph = BitHacks::RoundUpTo2(h);
-
-		if (i == 0 && tempw != (gnfImg.header.pitch + 1))
-			throw std::exception("Pitch doesn't match RoundUp2 Width");
-
-		tempw = pixbl == 1 ? std::max<size_t>(tempw, 16) : std::max<size_t>(tempw, 32);
-		temph = pixbl == 1 ? std::max<size_t>(temph, 16) : std::max<size_t>(temph, 32);
-
-		size_t size = tempw * temph * bpp / 8;
+		size_t size = tempw * temph * info->bpp / 8;
 		byte* tempData = new byte[size];
-		for (size_t k = 0; k < size; k++)
-		{
-			tempData[k] = byte(0);
-		}
-		size_t scanLineSize = w * pixbl * bpp / 8;
-		size_t scanLineSizePadded = tempw * pixbl * bpp / 8;
+		memset(tempData, 0, size);
+		size_t scanLineSize = w * info->pixbl * info->bpp / 8;
+		size_t scanLineSizePadded = tempw * info->pixbl * info->bpp / 8;
 		size_t off1 = 0;
 		size_t off2 = 0;
-		for (uint32_t j = 0; j < (h / pixbl); j++)
+		for (uint32_t j = 0; j < (h / info->pixbl); j++)
 		{
-			memcpy(tempData + off2, mipImg.pixels + off1, scanLineSize);
+			memcpy(tempData + off2, pixels + off1, scanLineSize);
 			off1 += scanLineSize;
 			off2 += scanLineSizePadded;
 		}
 
-		Gnf::GnfImage::Swizzle(tempData, gnfImg.imageData.get() + gnfoff, tempw, temph, bpp, pixbl);
+		Gnf::GnfImage::Swizzle(tempData, gnfImg.imageData.get() + gnfoff, tempw, temph, info->bpp, info->pixbl);
 		gnfoff += size;
+		pixels += w * h * info->bpp / 8;
 		delete[] tempData;
 	}
 
-	gnfImg.header.fileSize = gnfImg.header.dataSize + 0x100;
 	gnfImg.WriteImage(gnfout);
 
 	return gnfImg.header.fileSize;
-}
\ No newline at end of file
+}
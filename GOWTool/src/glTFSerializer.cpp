@@ -11,6 +11,11 @@
 #include <sstream>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
+#include <cmath>
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 using namespace Microsoft::glTF;
 
@@ -67,6 +72,66 @@ private:
     std::filesystem::path m_pathBase;
     mutable std::vector<std::shared_ptr<std::ofstream>> m_streams;
 };
+namespace
+{
+    void AddDefaultMaterial(Document& document)
+    {
+        Material material;
+        material.name = "Default";
+        material.metallicRoughness.baseColorFactor = Color4(1.0f, 1.0f, 1.0f, 1.0f);
+        material.metallicRoughness.metallicFactor = 0.0f;
+        material.metallicRoughness.roughnessFactor = 0.5f;
+        material.doubleSided = true;
+        document.materials.Append(std::move(material), AppendIdPolicy::GenerateOnEmpty);
+    }
+
+    // Appends a node per bone of the rig, children linked to their parents. Returns the node ids in bone order
+    std::vector<std::string> AddBones(Document& document, const Rig& Armature)
+    {
+        std::vector<Node> nodes;
+        std::vector<string> nodeIds;
+        for (uint16_t i = 0; i < Armature.boneCount; i++)
+        {
+            Node node;
+            node.id = std::to_string(i);
+            node.name = Armature.boneNames[i] + "_" + node.id;
+            node.matrix = Microsoft::glTF::Matrix4();
+            for (size_t r = 0; r < 4; r++)
+            {
+                for (size_t c = 0; c < 4; c++)
+                {
+                    node.matrix.values[r * 4 + c] = Armature.matrix[i][r][c];
+                }
+            }
+            nodes.push_back(node);
+            if (Armature.boneParents[i] > -1)
+                nodes[Armature.boneParents[i]].children.push_back(std::to_string(i));
+        }
+        for (uint16_t i = 0; i < Armature.boneCount; i++)
+        {
+            nodeIds.push_back(document.nodes.Append(std::move(nodes[i]), AppendIdPolicy::GenerateOnEmpty).id);
+        }
+        return nodeIds;
+    }
+
+    // Wraps the primitive into a Mesh referenced by node, which comes with its skin and
+    // transform already set. Returns the node id
+    std::string AddMeshNode(Document& document, MeshPrimitive&& meshPrimitive, const std::string& name, Node node)
+    {
+        // Construct a Mesh and add the MeshPrimitive as a child
+        Mesh mesh;
+        mesh.name = name;
+        mesh.primitives.push_back(std::move(meshPrimitive));
+        // Add it to the Document and store the generated ID
+        auto meshId = document.meshes.Append(std::move(mesh), AppendIdPolicy::GenerateOnEmpty).id;
+
+        // Add a reference to the Mesh to the Node
+        node.meshId = meshId;
+        node.name = name;
+        // Add it to the Document and store the generated ID
+        return document.nodes.Append(std::move(node), AppendIdPolicy::GenerateOnEmpty).id;
+    }
+}
 auto AddMesh(Document& document, BufferBuilder& bufferBuilder, const RawMeshContainer& expMesh, bool Skinned)
 {
     MeshPrimitive meshPrimitive;
@@ -198,10 +263,10 @@ auto AddMesh(Document& document, BufferBuilder& bufferBuilder, const RawMeshCont
         std::vector<uint16_t> joints0;
         for (uint32_t i = 0; i < expMesh.VertCount; i++)
         {
-            joints0.push_back(expMesh.joints[i][0]);
-            joints0.push_back(expMesh.joints[i][1]);
-            joints0.push_back(expMesh.joints[i][2]);
-            joints0.push_back(expMesh.joints[i][3]);
+            joints0.push_back(expMesh.joints[i * 4 + 0]);
+            joints0.push_back(expMesh.joints[i * 4 + 1]);
+            joints0.push_back(expMesh.joints[i * 4 + 2]);
+            joints0.push_back(expMesh.joints[i * 4 + 3]);
         }
         meshPrimitive.attributes[ACCESSOR_JOINTS_0] = bufferBuilder.AddAccessor(joints0, { TYPE_VEC4, COMPONENT_UNSIGNED_SHORT }).id;
     }
@@ -212,58 +277,18 @@ auto AddMesh(Document& document, BufferBuilder& bufferBuilder, const RawMeshCont
         std::vector<float> weights0;
         for (uint32_t i = 0; i < expMesh.VertCount; i++)
         {
-            weights0.push_back(expMesh.weights[i][0]);
-            weights0.push_back(expMesh.weights[i][1]);
-            weights0.push_back(expMesh.weights[i][2]);
-            weights0.push_back(expMesh.weights[i][3]);
+            weights0.push_back(expMesh.weights[i * 4 + 0]);
+            weights0.push_back(expMesh.weights[i * 4 + 1]);
+            weights0.push_back(expMesh.weights[i * 4 + 2]);
+            weights0.push_back(expMesh.weights[i * 4 + 3]);
         }
         meshPrimitive.attributes[ACCESSOR_WEIGHTS_0] = bufferBuilder.AddAccessor(weights0, { TYPE_VEC4, COMPONENT_FLOAT }).id;
     }
 
-    // Create a very simple glTF Document with the following hierarchy:
-    //  Scene
-    //     Node
-    //       Mesh (Triangle)
-    //         MeshPrimitive
-    //           Material (Blue)
-    // 
-    // A Document can be constructed top-down or bottom up. However, if constructed top-down
-    // then the IDs of child entities must be known in advance, which prevents using the glTF
-    // SDK's automatic ID generation functionality.
-
-    // Construct a Material
-    /*
-    Material material;
-    material.metallicRoughness.baseColorFactor = Color4(0.0f, 0.0f, 1.0f, 1.0f);
-    material.metallicRoughness.metallicFactor = 0.2f;
-    material.metallicRoughness.roughnessFactor = 0.4f;
-    material.doubleSided = true;
-
-    // Add it to the Document and store the generated ID
-    //auto materialId = document.materials.Append(std::move(material), AppendIdPolicy::GenerateOnEmpty).id;
-    */
-
-    // Construct a MeshPrimitive. Unlike most types in glTF, MeshPrimitives are direct children
-    // of their parent Mesh entity rather than being children of the Document. This is why they
-    // don't have an ID member.
-
-    // Construct a Mesh and add the MeshPrimitive as a child
-    Mesh mesh;
-    mesh.name = expMesh.name;
-    mesh.primitives.push_back(std::move(meshPrimitive));
-    // Add it to the Document and store the generated ID
-    auto meshId = document.meshes.Append(std::move(mesh), AppendIdPolicy::GenerateOnEmpty).id;
-
-    // Construct a Node adding a reference to the Mesh
     Node node;
-    node.meshId = meshId;
-    node.name = expMesh.name;
-    if(Skinned)
-    node.skinId = document.skins.Front().id;
-    // Add it to the Document and store the generated ID
-    auto nodeId = document.nodes.Append(std::move(node), AppendIdPolicy::GenerateOnEmpty).id;
-
-    return nodeId;
+    if (Skinned)
+        node.skinId = document.skins.Front().id;
+    return AddMeshNode(document, std::move(meshPrimitive), expMesh.name, std::move(node));
 }
 void WriteGLTF(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature)
 {
@@ -322,42 +347,14 @@ void WriteGLTF(const std::filesystem::path& path, const vector<RawMeshContainer>
     // created by this BufferBuilder will automatically reference
     bufferBuilder.AddBuffer(bufferId);
 
-    Material material;
-    material.name = "Default";
-    material.metallicRoughness.baseColorFactor = Color4(1.0f, 1.0f, 1.0f, 1.0f);
-    material.metallicRoughness.metallicFactor = 0.0f;
-    material.metallicRoughness.roughnessFactor = 0.5f;
-    material.doubleSided = true;
-    document.materials.Append(std::move(material), AppendIdPolicy::GenerateOnEmpty);
+    AddDefaultMaterial(document);
 
     // Construct a Scene
     Scene scene;
     scene.name = "Scene";
     if (Armature.boneCount > 0u)
     {
-        std::vector<Node> nodes;
-        std::vector<string> nodeIds;
-        for (uint16_t i = 0; i < Armature.boneCount; i++)
-        {
-            Node node;
-            node.id = std::to_string(i);
-            node.name = Armature.boneNames[i] + "_" + node.id;
-            node.matrix = Microsoft::glTF::Matrix4();
-            for (size_t r = 0; r < 4; r++)
-            {
-                for (size_t c = 0; c < 4; c++)
-                {
-                    node.matrix.values[r * 4 + c] = Armature.matrix[i][r][c];
-                }
-            }
-            nodes.push_back(node);
-            if (Armature.boneParents[i] > -1)
-                nodes[Armature.boneParents[i]].children.push_back(std::to_string(i));
-        }
-        for (uint16_t i = 0; i < Armature.boneCount; i++)
-        {
-            nodeIds.push_back(document.nodes.Append(std::move(nodes[i]), AppendIdPolicy::GenerateOnEmpty).id);
-        }
+        std::vector<string> nodeIds = AddBones(document, Armature);
         scene.nodes.push_back(nodeIds[0]);
         Skin skin;
         skin.jointIds = nodeIds;
@@ -426,4 +423,471 @@ void WriteGLTF(const std::filesystem::path& path, const vector<RawMeshContainer>
     {
         gltfResourceWriter.WriteExternal(pathFile.string(), manifest); // Binary resources have already been written, just need to write the manifest
     }
+}
+namespace
+{
+    static_assert(sizeof(Vec2) == 8 && sizeof(Vec3) == 12 && sizeof(Vec4) == 16 && sizeof(Matrix4x4) == 64, "mesh arrays are written as packed floats");
+
+    constexpr const char* KHR_MESH_QUANTIZATION = "KHR_mesh_quantization";
+
+    // Binary chunk of a GLB written by WriteGLB. Accessors only record where their data
+    // lives, Write then streams every section from the source arrays to the file in one pass
+    class GlbBinaryChunk
+    {
+    public:
+        // adds a buffer view holding a single accessor over count elements of data, which are
+        // tightly packed unless byteStride is given
+        std::string AddAccessor(Document& document, const void* data, size_t count, AccessorDesc desc, Optional<BufferViewTarget> target, size_t byteStride = 0)
+        {
+            size_t elementSize = Accessor::GetComponentTypeSize(desc.componentType) * Accessor::GetTypeCount(desc.accessorType);
+            Accessor accessor;
+            accessor.bufferViewId = AddBufferView(document, data, count * (byteStride != 0 ? byteStride : elementSize), target, byteStride, false);
+            accessor.componentType = desc.componentType;
+            accessor.normalized = desc.normalized;
+            accessor.count = count;
+            accessor.type = desc.accessorType;
+            accessor.min = std::move(desc.minValues);
+            accessor.max = std::move(desc.maxValues);
+            return document.accessors.Append(std::move(accessor), AppendIdPolicy::GenerateOnEmpty).id;
+        }
+        // same for a triangle list, the winding of every triangle is flipped while it is written
+        std::string AddTriangles(Document& document, const uint16_t* indices, size_t count)
+        {
+            Accessor accessor;
+            accessor.bufferViewId = AddBufferView(document, indices, count * sizeof(uint16_t), BufferViewTarget::ELEMENT_ARRAY_BUFFER, 0, true);
+            accessor.componentType = COMPONENT_UNSIGNED_SHORT;
+            accessor.count = count;
+            accessor.type = TYPE_SCALAR;
+            return document.accessors.Append(std::move(accessor), AppendIdPolicy::GenerateOnEmpty).id;
+        }
+        // the buffer backing the chunk, added once every accessor is in
+        void AddBuffer(Document& document) const
+        {
+            Buffer buffer;
+            buffer.id = GLB_BUFFER_ID;
+            buffer.byteLength = m_size;
+            document.buffers.Append(std::move(buffer), AppendIdPolicy::ThrowOnEmpty);
+        }
+        // chunk size including the trailing padding
+        uint32_t ChunkLength() const
+        {
+            return static_cast<uint32_t>(Align(m_size));
+        }
+        void Write(std::ostream& stream) const
+        {
+            static const char zeros[GLB_CHUNK_ALIGNMENT_SIZE] = {};
+            size_t written = 0;
+            for (const Section& section : m_sections)
+            {
+                stream.write(zeros, section.offset - written);
+                if (section.flipWinding)
+                    WriteTriangles(stream, (const uint16_t*)section.data, section.size / sizeof(uint16_t));
+                else
+                    stream.write((const char*)section.data, section.size);
+                written = section.offset + section.size;
+            }
+            stream.write(zeros, ChunkLength() - written);
+        }
+    private:
+        struct Section
+        {
+            const void* data;
+            size_t offset;
+            size_t size;
+            bool flipWinding;
+        };
+
+        static size_t Align(size_t offset)
+        {
+            return (offset + GLB_CHUNK_ALIGNMENT_SIZE - 1) & ~size_t(GLB_CHUNK_ALIGNMENT_SIZE - 1);
+        }
+        std::string AddBufferView(Document& document, const void* data, size_t size, Optional<BufferViewTarget> target, size_t byteStride, bool flipWinding)
+        {
+            if (size == 0)
+                throw GLTFException("Invalid accessor count: 0");
+            // every view starts 4 byte aligned, which satisfies any component type and the vertex attribute alignment
+            size_t offset = Align(m_size);
+            m_sections.push_back({ data, offset, size, flipWinding });
+            m_size = offset + size;
+
+            BufferView bufferView;
+            bufferView.bufferId = GLB_BUFFER_ID;
+            bufferView.byteOffset = offset;
+            bufferView.byteLength = size;
+            if (byteStride != 0)
+                bufferView.byteStride = byteStride;
+            bufferView.target = target;
+            return document.bufferViews.Append(std::move(bufferView), AppendIdPolicy::GenerateOnEmpty).id;
+        }
+        // writes (i1, i0, i2) for every triangle (i0, i1, i2) through a small staging buffer
+        static void WriteTriangles(std::ostream& stream, const uint16_t* indices, size_t count)
+        {
+            uint16_t staging[3 * 1024];
+            size_t i = 0;
+            while (i + 3 <= count)
+            {
+                size_t n = 0;
+                for (; n < std::size(staging) && i + 3 <= count; n += 3, i += 3)
+                {
+                    staging[n] = indices[i + 1];
+                    staging[n + 1] = indices[i];
+                    staging[n + 2] = indices[i + 2];
+                }
+                stream.write((const char*)staging, n * sizeof(uint16_t));
+            }
+            // a trailing partial triangle is kept as is
+            stream.write((const char*)(indices + i), (count - i) * sizeof(uint16_t));
+        }
+
+        std::vector<Section> m_sections;
+        size_t m_size = 0;
+    };
+
+    // component wise min/max of the positions, which accessors require for POSITION
+    void PositionBounds(const Vec3* positions, size_t count, std::vector<float>& minValues, std::vector<float>& maxValues)
+    {
+        minValues.assign(3U, std::numeric_limits<float>::max());
+        maxValues.assign(3U, std::numeric_limits<float>::lowest());
+        const float* values = &positions[0].X;
+        size_t i = 0;
+#if defined(_M_X64) || defined(__SSE2__)
+        // 4 positions are 3 vectors, each lane keeps seeing the same component
+        // (xyzx yzxy zxyz) so the lanes are only folded once at the end
+        if (count >= 4)
+        {
+            __m128 min0 = _mm_loadu_ps(values), min1 = _mm_loadu_ps(values + 4), min2 = _mm_loadu_ps(values + 8);
+            __m128 max0 = min0, max1 = min1, max2 = min2;
+            for (i = 4; i + 4 <= count; i += 4)
+            {
+                const float* p = values + i * 3;
+                __m128 v0 = _mm_loadu_ps(p), v1 = _mm_loadu_ps(p + 4), v2 = _mm_loadu_ps(p + 8);
+                min0 = _mm_min_ps(min0, v0);
+                min1 = _mm_min_ps(min1, v1);
+                min2 = _mm_min_ps(min2, v2);
+                max0 = _mm_max_ps(max0, v0);
+                max1 = _mm_max_ps(max1, v1);
+                max2 = _mm_max_ps(max2, v2);
+            }
+            float lanesMin[12], lanesMax[12];
+            _mm_storeu_ps(lanesMin, min0);
+            _mm_storeu_ps(lanesMin + 4, min1);
+            _mm_storeu_ps(lanesMin + 8, min2);
+            _mm_storeu_ps(lanesMax, max0);
+            _mm_storeu_ps(lanesMax + 4, max1);
+            _mm_storeu_ps(lanesMax + 8, max2);
+            for (size_t l = 0; l < 12; l++)
+            {
+                minValues[l % 3] = std::min(lanesMin[l], minValues[l % 3]);
+                maxValues[l % 3] = std::max(lanesMax[l], maxValues[l % 3]);
+            }
+        }
+#endif
+        for (size_t j = i * 3; j < count * 3; j++)
+        {
+            minValues[j % 3] = std::min(values[j], minValues[j % 3]);
+            maxValues[j % 3] = std::max(values[j], maxValues[j % 3]);
+        }
+    }
+
+    std::string AddMeshDirect(Document& document, GlbBinaryChunk& chunk, const RawMeshContainer& expMesh, Node node)
+    {
+        MeshPrimitive meshPrimitive;
+        meshPrimitive.materialId = document.materials.Front().id;
+
+        if (expMesh.indices != nullptr)
+            meshPrimitive.indicesAccessorId = chunk.AddTriangles(document, expMesh.indices, expMesh.IndCount);
+        if (expMesh.vertices != nullptr)
+        {
+            std::vector<float> minValues, maxValues;
+            PositionBounds(expMesh.vertices, expMesh.VertCount, minValues, maxValues);
+            meshPrimitive.attributes[ACCESSOR_POSITION] = chunk.AddAccessor(document, expMesh.vertices, expMesh.VertCount,
+                { TYPE_VEC3, COMPONENT_FLOAT, false, std::move(minValues), std::move(maxValues) }, BufferViewTarget::ARRAY_BUFFER);
+        }
+        if (expMesh.normals != nullptr)
+            meshPrimitive.attributes[ACCESSOR_NORMAL] = chunk.AddAccessor(document, expMesh.normals, expMesh.VertCount, { TYPE_VEC3, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.tangents != nullptr)
+            meshPrimitive.attributes[ACCESSOR_TANGENT] = chunk.AddAccessor(document, expMesh.tangents, expMesh.VertCount, { TYPE_VEC4, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.txcoord0 != nullptr)
+            meshPrimitive.attributes[ACCESSOR_TEXCOORD_0] = chunk.AddAccessor(document, expMesh.txcoord0, expMesh.VertCount, { TYPE_VEC2, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.txcoord1 != nullptr)
+            meshPrimitive.attributes[ACCESSOR_TEXCOORD_1] = chunk.AddAccessor(document, expMesh.txcoord1, expMesh.VertCount, { TYPE_VEC2, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.txcoord2 != nullptr)
+            meshPrimitive.attributes["TEXCOORD_2"] = chunk.AddAccessor(document, expMesh.txcoord2, expMesh.VertCount, { TYPE_VEC2, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.joints != nullptr)
+            meshPrimitive.attributes[ACCESSOR_JOINTS_0] = chunk.AddAccessor(document, expMesh.joints, expMesh.VertCount, { TYPE_VEC4, COMPONENT_UNSIGNED_SHORT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.weights != nullptr)
+            meshPrimitive.attributes[ACCESSOR_WEIGHTS_0] = chunk.AddAccessor(document, expMesh.weights, expMesh.VertCount, { TYPE_VEC4, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+
+        return AddMeshNode(document, std::move(meshPrimitive), expMesh.name, std::move(node));
+    }
+
+    // glTF normalized components, c / 65535 and max(c / 32767, -1)
+    inline uint16_t QuantizeUnorm16(float value)
+    {
+        return std::isnan(value) ? 0 : uint16_t(std::lround(std::clamp(value, 0.f, 1.f) * 65535.f));
+    }
+    inline int16_t QuantizeSnorm16(float value)
+    {
+        return std::isnan(value) ? 0 : int16_t(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+    }
+    // normalizes x, y, z after scaling them by s and stores them as SNORM16
+    inline void QuantizeDirection(float x, float y, float z, const Vec3& s, int16_t* out)
+    {
+        x *= s.X, y *= s.Y, z *= s.Z;
+        float mag = sqrt(x * x + y * y + z * z);
+        if (mag > 0.f)
+            x /= mag, y /= mag, z /= mag;
+        out[0] = QuantizeSnorm16(x);
+        out[1] = QuantizeSnorm16(y);
+        out[2] = QuantizeSnorm16(z);
+    }
+
+    // Stores the attributes in the integer formats KHR_mesh_quantization allows. UNORM16 positions
+    // keep the grid they were stored on in the game files: the accessor holds the original
+    // integers and the node's scale/translation (the inverse bind matrices for skinned meshes,
+    // whose node transforms are ignored) bring them back to meshScale/meshMin. Normals and
+    // tangents go from 10 to 16 bit, UVs stay 16 bit where they were, weights become UNORM16.
+    // Everything else is written as floats.
+    std::string AddQuantizedMesh(Document& document, GlbBinaryChunk& chunk, Arena& arena, const RawMeshContainer& expMesh,
+        const Rig& Armature, const std::vector<std::string>& jointIds)
+    {
+        const size_t count = expMesh.VertCount;
+        const Vec3& scale = expMesh.positionScale;
+        const Vec3& offset = expMesh.positionMin;
+        const bool unormPositions = expMesh.vertices != nullptr && expMesh.positionType == DataTypes::UNSIGNED_SHORT &&
+            scale.X > 0.f && scale.Y > 0.f && scale.Z > 0.f && std::isfinite(scale.X) && std::isfinite(scale.Y) && std::isfinite(scale.Z) &&
+            std::isfinite(offset.X) && std::isfinite(offset.Y) && std::isfinite(offset.Z);
+        // normals transform with the inverse transpose of the dequantization, tangents with the dequantization itself
+        const Vec3 normalScale = unormPositions ? scale : Vec3(1.f, 1.f, 1.f);
+        const Vec3 tangentScale = unormPositions ? Vec3(1.f / scale.X, 1.f / scale.Y, 1.f / scale.Z) : Vec3(1.f, 1.f, 1.f);
+
+        MeshPrimitive meshPrimitive;
+        meshPrimitive.materialId = document.materials.Front().id;
+        if (expMesh.indices != nullptr)
+            meshPrimitive.indicesAccessorId = chunk.AddTriangles(document, expMesh.indices, expMesh.IndCount);
+
+        Node node;
+        if (!jointIds.empty())
+            node.skinId = document.skins.Front().id;
+        if (unormPositions)
+        {
+            // padded to 4 components, vertex attributes have to start on 4 byte boundaries
+            uint16_t* positions = arena.Allocate<uint16_t>(count * 4);
+            std::vector<float> minValues(3U, 65535.f), maxValues(3U, 0.f);
+            for (size_t v = 0; v < count; v++)
+            {
+                const Vec3& p = expMesh.vertices[v];
+                positions[v * 4] = QuantizeUnorm16((p.X - offset.X) / scale.X);
+                positions[v * 4 + 1] = QuantizeUnorm16((p.Y - offset.Y) / scale.Y);
+                positions[v * 4 + 2] = QuantizeUnorm16((p.Z - offset.Z) / scale.Z);
+                for (size_t k = 0; k < 3; k++)
+                {
+                    minValues[k] = std::min<float>(positions[v * 4 + k], minValues[k]);
+                    maxValues[k] = std::max<float>(positions[v * 4 + k], maxValues[k]);
+                }
+            }
+            meshPrimitive.attributes[ACCESSOR_POSITION] = chunk.AddAccessor(document, positions, count,
+                { TYPE_VEC3, COMPONENT_UNSIGNED_SHORT, true, std::move(minValues), std::move(maxValues) }, BufferViewTarget::ARRAY_BUFFER, 8);
+
+            if (jointIds.empty())
+            {
+                node.scale = Vector3(scale.X, scale.Y, scale.Z);
+                node.translation = Vector3(offset.X, offset.Y, offset.Z);
+            }
+            else
+            {
+                // IBM * dequantization, the matrices are stored column major like the ones of the shared skin
+                float* IBMs = arena.Allocate<float>(size_t(Armature.boneCount) * 16);
+                for (uint16_t b = 0; b < Armature.boneCount; b++)
+                {
+                    const float* m = Armature.IBMs[b].rows[0].XYZW;
+                    float* out = IBMs + b * 16;
+                    for (size_t r = 0; r < 4; r++)
+                    {
+                        out[r] = m[r] * scale.X;
+                        out[4 + r] = m[4 + r] * scale.Y;
+                        out[8 + r] = m[8 + r] * scale.Z;
+                        out[12 + r] = m[r] * offset.X + m[4 + r] * offset.Y + m[8 + r] * offset.Z + m[12 + r];
+                    }
+                }
+                Skin skin;
+                skin.jointIds = jointIds;
+                skin.inverseBindMatricesAccessorId = chunk.AddAccessor(document, IBMs, Armature.boneCount, { TYPE_MAT4, COMPONENT_FLOAT }, {});
+                node.skinId = document.skins.Append(std::move(skin), AppendIdPolicy::GenerateOnEmpty).id;
+            }
+        }
+        else if (expMesh.vertices != nullptr)
+        {
+            std::vector<float> minValues, maxValues;
+            PositionBounds(expMesh.vertices, count, minValues, maxValues);
+            meshPrimitive.attributes[ACCESSOR_POSITION] = chunk.AddAccessor(document, expMesh.vertices, count,
+                { TYPE_VEC3, COMPONENT_FLOAT, false, std::move(minValues), std::move(maxValues) }, BufferViewTarget::ARRAY_BUFFER);
+        }
+
+        if (expMesh.normals != nullptr)
+        {
+            int16_t* normals = arena.Allocate<int16_t>(count * 4);
+            for (size_t v = 0; v < count; v++)
+                QuantizeDirection(expMesh.normals[v].X, expMesh.normals[v].Y, expMesh.normals[v].Z, normalScale, normals + v * 4);
+            meshPrimitive.attributes[ACCESSOR_NORMAL] = chunk.AddAccessor(document, normals, count, { TYPE_VEC3, COMPONENT_SHORT, true }, BufferViewTarget::ARRAY_BUFFER, 8);
+        }
+        if (expMesh.tangents != nullptr)
+        {
+            int16_t* tangents = arena.Allocate<int16_t>(count * 4);
+            for (size_t v = 0; v < count; v++)
+            {
+                const Vec4& t = expMesh.tangents[v];
+                QuantizeDirection(t.X, t.Y, t.Z, tangentScale, tangents + v * 4);
+                tangents[v * 4 + 3] = t.W < 0.f ? -32767 : 32767;
+            }
+            meshPrimitive.attributes[ACCESSOR_TANGENT] = chunk.AddAccessor(document, tangents, count, { TYPE_VEC4, COMPONENT_SHORT, true }, BufferViewTarget::ARRAY_BUFFER);
+        }
+
+        const Vec2* txcoords[3] = { expMesh.txcoord0, expMesh.txcoord1, expMesh.txcoord2 };
+        const char* txcoordNames[3] = { ACCESSOR_TEXCOORD_0, ACCESSOR_TEXCOORD_1, "TEXCOORD_2" };
+        for (size_t set = 0; set < 3; set++)
+        {
+            const Vec2* uv = txcoords[set];
+            if (uv == nullptr)
+                continue;
+            // UNSIGNED_SHORT UVs were q / 65535, HALFWORD_STRUCT_2 ones q / 32767 which is a
+            // glTF SNORM16 as long as none of them goes past 1
+            bool unorm = expMesh.txcoordTypes[set] == DataTypes::UNSIGNED_SHORT;
+            bool snorm = expMesh.txcoordTypes[set] == DataTypes::HALFWORD_STRUCT_2 &&
+                std::all_of(uv, uv + count, [](const Vec2& c) { return c.X <= 1.f && c.Y <= 1.f; });
+            if (unorm)
+            {
+                uint16_t* data = arena.Allocate<uint16_t>(count * 2);
+                for (size_t v = 0; v < count; v++)
+                {
+                    data[v * 2] = QuantizeUnorm16(uv[v].X);
+                    data[v * 2 + 1] = QuantizeUnorm16(uv[v].Y);
+                }
+                meshPrimitive.attributes[txcoordNames[set]] = chunk.AddAccessor(document, data, count, { TYPE_VEC2, COMPONENT_UNSIGNED_SHORT, true }, BufferViewTarget::ARRAY_BUFFER);
+            }
+            else if (snorm)
+            {
+                int16_t* data = arena.Allocate<int16_t>(count * 2);
+                for (size_t v = 0; v < count; v++)
+                {
+                    data[v * 2] = QuantizeSnorm16(uv[v].X);
+                    data[v * 2 + 1] = QuantizeSnorm16(uv[v].Y);
+                }
+                meshPrimitive.attributes[txcoordNames[set]] = chunk.AddAccessor(document, data, count, { TYPE_VEC2, COMPONENT_SHORT, true }, BufferViewTarget::ARRAY_BUFFER);
+            }
+            else
+            {
+                meshPrimitive.attributes[txcoordNames[set]] = chunk.AddAccessor(document, uv, count, { TYPE_VEC2, COMPONENT_FLOAT }, BufferViewTarget::ARRAY_BUFFER);
+            }
+        }
+
+        if (expMesh.joints != nullptr)
+            meshPrimitive.attributes[ACCESSOR_JOINTS_0] = chunk.AddAccessor(document, expMesh.joints, count, { TYPE_VEC4, COMPONENT_UNSIGNED_SHORT }, BufferViewTarget::ARRAY_BUFFER);
+        if (expMesh.weights != nullptr)
+        {
+            uint16_t* weights = arena.Allocate<uint16_t>(count * 4);
+            for (size_t v = 0; v < count; v++)
+            {
+                uint16_t* w = weights + v * 4;
+                int sum = 0;
+                size_t largest = 0;
+                for (size_t k = 0; k < 4; k++)
+                {
+                    w[k] = QuantizeUnorm16(expMesh.weights[v * 4 + k]);
+                    sum += w[k];
+                    if (w[k] > w[largest])
+                        largest = k;
+                }
+                // rounding must not change the sum, the difference goes to the largest weight
+                if (sum > 0)
+                    w[largest] = uint16_t(std::clamp(int(w[largest]) + 65535 - sum, 0, 65535));
+            }
+            meshPrimitive.attributes[ACCESSOR_WEIGHTS_0] = chunk.AddAccessor(document, weights, count, { TYPE_VEC4, COMPONENT_UNSIGNED_SHORT, true }, BufferViewTarget::ARRAY_BUFFER);
+        }
+
+        return AddMeshNode(document, std::move(meshPrimitive), expMesh.name, std::move(node));
+    }
+}
+void WriteGLB(const std::filesystem::path& path, const vector<RawMeshContainer>& expMeshes, const Rig& Armature, bool quantize)
+{
+    Document document;
+    document.asset.copyright = "Santa Monica Studios";
+    document.asset.generator = "God of War Tool - HitmanHimself";
+    AddDefaultMaterial(document);
+
+    // the chunk refers to the mesh arrays, the rig and the quantized copies in arena until it has been written
+    GlbBinaryChunk chunk;
+    Arena arena;
+    Scene scene;
+    scene.name = "Scene";
+    std::vector<string> jointIds;
+    if (Armature.boneCount > 0u)
+    {
+        jointIds = AddBones(document, Armature);
+        scene.nodes.push_back(jointIds[0]);
+        Skin skin;
+        skin.jointIds = jointIds;
+        skin.inverseBindMatricesAccessorId = chunk.AddAccessor(document, Armature.IBMs, Armature.boneCount, { TYPE_MAT4, COMPONENT_FLOAT }, {});
+        document.skins.Append(std::move(skin), AppendIdPolicy::GenerateOnEmpty);
+    }
+    for (size_t i = 0; i < expMeshes.size(); i++)
+    {
+        if (quantize)
+        {
+            scene.nodes.push_back(AddQuantizedMesh(document, chunk, arena, expMeshes[i], Armature, jointIds));
+            continue;
+        }
+        Node node;
+        if (!jointIds.empty())
+            node.skinId = document.skins.Front().id;
+        scene.nodes.push_back(AddMeshDirect(document, chunk, expMeshes[i], std::move(node)));
+    }
+    if (quantize && !expMeshes.empty())
+    {
+        document.extensionsUsed.insert(KHR_MESH_QUANTIZATION);
+        document.extensionsRequired.insert(KHR_MESH_QUANTIZATION);
+    }
+    document.SetDefaultScene(std::move(scene), AppendIdPolicy::GenerateOnEmpty);
+    chunk.AddBuffer(document);
+
+    std::string manifest;
+    try
+    {
+        manifest = Serialize(document);
+    }
+    catch (const GLTFException& ex)
+    {
+        std::stringstream ss;
+
+        ss << "Microsoft::glTF::Serialize failed: ";
+        ss << ex.what();
+
+        throw std::runtime_error(ss.str());
+    }
+    // GLB spec requires the JSON chunk to be padded with trailing space characters
+    manifest.resize((manifest.size() + GLB_CHUNK_ALIGNMENT_SIZE - 1) & ~size_t(GLB_CHUNK_ALIGNMENT_SIZE - 1), ' ');
+
+    const uint32_t jsonChunkLength = static_cast<uint32_t>(manifest.size());
+    const uint32_t binaryChunkLength = chunk.ChunkLength();
+    const uint32_t length = GLB_HEADER_BYTE_SIZE + jsonChunkLength + sizeof(binaryChunkLength) + GLB_CHUNK_TYPE_SIZE + binaryChunkLength;
+    const uint32_t version = GLB_HEADER_VERSION_2;
+
+    std::ofstream stream(path, std::ios_base::binary);
+    if (!stream)
+    {
+        throw std::runtime_error("Unable to create a valid output stream for " + path.string());
+    }
+    stream.write(GLB_HEADER_MAGIC_STRING, GLB_HEADER_MAGIC_STRING_SIZE);
+    stream.write((const char*)&version, sizeof(version));
+    stream.write((const char*)&length, sizeof(length));
+    stream.write((const char*)&jsonChunkLength, sizeof(jsonChunkLength));
+    stream.write(GLB_CHUNK_TYPE_JSON, GLB_CHUNK_TYPE_SIZE);
+    stream.write(manifest.data(), manifest.size());
+    stream.write((const char*)&binaryChunkLength, sizeof(binaryChunkLength));
+    stream.write(GLB_CHUNK_TYPE_BIN, GLB_CHUNK_TYPE_SIZE);
+    chunk.Write(stream);
+    if (!stream)
+    {
+        throw std::runtime_error("Failed to write " + path.string());
+    }
 }
\ No newline at end of file
@@ -1,10 +1,11 @@
 #include "pch.h"
 #include "krak.h"
+#include "utils.h"
 
 OodLZ_CompressFunc* OodLZ_Compress;
 OodLZ_DecompressFunc* OodLZ_Decompress;
 
-void LoadLib() {
+static bool LoadSymbols() {
 
 #if defined(_M_X64)
 #define LIBNAME "oo2core_7_win64.dll"
@@ -12,16 +13,35 @@ void LoadLib() {
 	char DECFUNCNAME[] = "XXdleLZ_Decompress";
 	COMPFUNCNAME[0] = DECFUNCNAME[0] = 'O';
 	COMPFUNCNAME[1] = DECFUNCNAME[1] = 'o';
-#else
+#elif defined(_WIN32)
 #define LIBNAME "oo2core_7_win32.dll"
 	char COMPFUNCNAME[] = "_XXdleLZ_Compress@40";
 	char DECFUNCNAME[] = "_XXdleLZ_Decompress@56";
 	COMPFUNCNAME[1] = DECFUNCNAME[1] = 'O';
 	COMPFUNCNAME[2] = DECFUNCNAME[2] = 'o';
+#else
+	// searched on the library path, same exports as the 64-bit dll
+#define LIBNAME "liboo2corelinux64.so"
+	char COMPFUNCNAME[] = "XXdleLZ_Compress";
+	char DECFUNCNAME[] = "XXdleLZ_Decompress";
+	COMPFUNCNAME[0] = DECFUNCNAME[0] = 'O';
+	COMPFUNCNAME[1] = DECFUNCNAME[1] = 'o';
 #endif
-	HINSTANCE mod = LoadLibraryA(LIBNAME);
-	OodLZ_Compress = (OodLZ_CompressFunc*)GetProcAddress(mod, COMPFUNCNAME);
-	OodLZ_Decompress = (OodLZ_DecompressFunc*)GetProcAddress(mod, DECFUNCNAME);
+	// kept loaded for the lifetime of the process
+	static Utils::SharedLibrary mod;
+	mod.Open(LIBNAME);
+	OodLZ_Compress = (OodLZ_CompressFunc*)mod.GetSymbol(COMPFUNCNAME);
+	OodLZ_Decompress = (OodLZ_DecompressFunc*)mod.GetSymbol(DECFUNCNAME);
 	if (!OodLZ_Compress || !OodLZ_Decompress)
-		cout << ("error loading", LIBNAME);
+	{
+		Utils::Logger::Error("error loading " LIBNAME "\n");
+		return false;
+	}
+	return true;
+}
+
+bool LoadLib() {
+	// tried once, later calls return the first result
+	static const bool loaded = LoadSymbols();
+	return loaded;
 }
\ No newline at end of file
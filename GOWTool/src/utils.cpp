@@ -1,15 +1,25 @@
 #include "pch.h"
 #include "utils.h"
+#include <mutex>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
 
 namespace Utils
 {
-	std::string FileDialogs::OpenFile(const char* filter, const char* title, HWND owner)
+	static std::mutex logMutex;
+
+#ifdef _WIN32
+	std::string FileDialogs::OpenFile(const char* filter, const char* title, void* owner)
 	{
 		OPENFILENAMEA ofn;
 		CHAR szFile[260] = { 0 };
 		ZeroMemory(&ofn, sizeof(OPENFILENAME));
 		ofn.lStructSize = sizeof(OPENFILENAME);
-		ofn.hwndOwner = owner;
+		ofn.hwndOwner = (HWND)owner;
 		ofn.lpstrTitle = title;
 		ofn.lpstrFilter = filter;
 		ofn.lpstrFile = szFile;
@@ -22,31 +32,186 @@ namespace Utils
 		}
 		return std::string();
 	}
-	void Logger::Error(const char* msg)
+
+	static void Log(const char* msg, WORD color, bool newline)
 	{
+		std::lock_guard<std::mutex> lock(logMutex);
 		auto hndl = GetStdHandle(STD_OUTPUT_HANDLE);
 		CONSOLE_SCREEN_BUFFER_INFO csbi;
 		GetConsoleScreenBufferInfo(hndl, &csbi);
-		SetConsoleTextAttribute(hndl, 4);
+		SetConsoleTextAttribute(hndl, color);
 		cout << msg;
+		if (newline)
+			cout << std::endl;
 		SetConsoleTextAttribute(hndl, csbi.wAttributes);
 	}
+	void Logger::Error(const char* msg)
+	{
+		Log(msg, 4, false);
+	}
 	void Logger::Success(const char* msg)
 	{
-		auto hndl = GetStdHandle(STD_OUTPUT_HANDLE);
-		CONSOLE_SCREEN_BUFFER_INFO csbi;
-		GetConsoleScreenBufferInfo(hndl, &csbi);
-		SetConsoleTextAttribute(hndl, 2);
-		cout << msg << std::endl;
-		SetConsoleTextAttribute(hndl, csbi.wAttributes);
+		Log(msg, 2, true);
 	}
 	void Logger::Warning(const char* msg)
 	{
-		auto hndl = GetStdHandle(STD_OUTPUT_HANDLE);
-		CONSOLE_SCREEN_BUFFER_INFO csbi;
-		GetConsoleScreenBufferInfo(hndl, &csbi);
-		SetConsoleTextAttribute(hndl, 14);
-		cout << msg;
-		SetConsoleTextAttribute(hndl, csbi.wAttributes);
+		Log(msg, 14, false);
+	}
+
+	std::string GetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* fallback)
+	{
+		CHAR buffer[260] = { 0 };
+		GetPrivateProfileStringA(section, key, fallback, buffer, sizeof(buffer), configpath.string().c_str());
+		return buffer;
+	}
+	bool SetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* value)
+	{
+		return WritePrivateProfileStringA(section, key, value, configpath.string().c_str()) != FALSE;
+	}
+
+	SharedLibrary::~SharedLibrary()
+	{
+		if (_handle != nullptr)
+			FreeLibrary((HMODULE)_handle);
+	}
+	bool SharedLibrary::Open(const char* name)
+	{
+		if (_handle == nullptr)
+			_handle = LoadLibraryA(name);
+		return _handle != nullptr;
+	}
+	void* SharedLibrary::GetSymbol(const char* name) const
+	{
+		return _handle != nullptr ? (void*)GetProcAddress((HMODULE)_handle, name) : nullptr;
+	}
+#else
+	std::string FileDialogs::OpenFile(const char* /*filter*/, const char* /*title*/, void* /*owner*/)
+	{
+		return std::string();
+	}
+
+	// ansi versions of the console colors used on windows
+	static void Log(const char* msg, const char* color, bool newline)
+	{
+		std::lock_guard<std::mutex> lock(logMutex);
+		cout << color << msg << "\033[0m";
+		if (newline)
+			cout << std::endl;
+	}
+	void Logger::Error(const char* msg)
+	{
+		Log(msg, "\033[31m", false);
+	}
+	void Logger::Success(const char* msg)
+	{
+		Log(msg, "\033[32m", true);
+	}
+	void Logger::Warning(const char* msg)
+	{
+		Log(msg, "\033[93m", false);
+	}
+
+	static string trim(string s)
+	{
+		const char* space = " \t\r\n";
+		s.erase(0, s.find_first_not_of(space));
+		s.erase(s.find_last_not_of(space) + 1);
+		return s;
+	}
+
+	// same lookup as GetPrivateProfileString: [section] headers, key=value lines, ; comments
+	std::string GetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* fallback)
+	{
+		ifstream file(configpath);
+		string line;
+		bool inSection = false;
+		while (std::getline(file, line))
+		{
+			line = trim(line);
+			if (line.empty() || line[0] == ';')
+				continue;
+			if (line[0] == '[')
+			{
+				size_t end = line.find(']');
+				inSection = end != string::npos && str_tolower(trim(line.substr(1, end - 1))) == str_tolower(section);
+				continue;
+			}
+			size_t eq = line.find('=');
+			if (!inSection || eq == string::npos || str_tolower(trim(line.substr(0, eq))) != str_tolower(key))
+				continue;
+
+			string value = trim(line.substr(eq + 1));
+			if (value.size() >= 2 && (value.front() == '"' || value.front() == '\'') && value.back() == value.front())
+				value = value.substr(1, value.size() - 2);
+			return value;
+		}
+		return fallback;
+	}
+	bool SetConfigString(const std::filesystem::path& configpath, const char* section, const char* key, const char* value)
+	{
+		vector<string> lines;
+		{
+			ifstream file(configpath);
+			string line;
+			while (std::getline(file, line))
+				lines.push_back(line);
+		}
+		// line after the last entry of the section, or npos while it wasn't seen
+		size_t sectionEnd = string::npos;
+		bool inSection = false, written = false;
+		for (size_t i = 0; i < lines.size() && !written; i++)
+		{
+			string line = trim(lines[i]);
+			if (line.empty() || line[0] == ';')
+				continue;
+			if (line[0] == '[')
+			{
+				size_t end = line.find(']');
+				inSection = end != string::npos && str_tolower(trim(line.substr(1, end - 1))) == str_tolower(section);
+				if (inSection)
+					sectionEnd = i + 1;
+				continue;
+			}
+			if (!inSection)
+				continue;
+			sectionEnd = i + 1;
+			size_t eq = line.find('=');
+			if (eq != string::npos && str_tolower(trim(line.substr(0, eq))) == str_tolower(key))
+			{
+				lines[i] = trim(line.substr(0, eq)) + "=" + value;
+				written = true;
+			}
+		}
+		if (!written)
+		{
+			if (sectionEnd == string::npos)
+			{
+				lines.push_back(string("[") + section + "]");
+				sectionEnd = lines.size();
+			}
+			lines.insert(lines.begin() + sectionEnd, string(key) + "=" + value);
+		}
+
+		ofstream file(configpath, std::ios::trunc);
+		for (const auto& line : lines)
+			file << line << "\n";
+		return file.good();
+	}
+
+	SharedLibrary::~SharedLibrary()
+	{
+		if (_handle != nullptr)
+			dlclose(_handle);
+	}
+	bool SharedLibrary::Open(const char* name)
+	{
+		if (_handle == nullptr)
+			_handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+		return _handle != nullptr;
+	}
+	void* SharedLibrary::GetSymbol(const char* name) const
+	{
+		return _handle != nullptr ? dlsym(_handle, name) : nullptr;
 	}
+#endif
 }
\ No newline at end of file
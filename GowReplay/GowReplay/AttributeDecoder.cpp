@@ -0,0 +1,164 @@
+#include "AttributeDecoder.h"
+#include "Tools.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "glm.hpp"
+#include "half.hpp"
+
+namespace
+{
+	template <typename T, CompType Type>
+	inline float readComponent(const uint8_t* data, uint32_t index)
+	{
+		T value;
+		std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+
+		if constexpr (Type == CompType::UNorm)
+		{
+			return float(value) / float(std::numeric_limits<T>::max());
+		}
+		else if constexpr (Type == CompType::SNorm)
+		{
+			// both the minimum and the one above it map to -1
+			return std::max(float(value) / float(std::numeric_limits<T>::max()), -1.0f);
+		}
+		else
+		{
+			// float, half and plain integers
+			return float(value);
+		}
+	}
+
+	template <typename T, CompType Type, typename Vec, int FillW>
+	void decodeRegular(const uint8_t* data, size_t stride, size_t count, uint32_t compCount, void* out)
+	{
+		Vec*     dst = static_cast<Vec*>(out);
+		uint32_t n   = std::min<uint32_t>(compCount, Vec::length());
+		for (size_t i = 0; i != count; ++i, data += stride)
+		{
+			glm::vec4 value(0.0f, 0.0f, 0.0f, float(FillW));
+			for (uint32_t c = 0; c != n; ++c)
+			{
+				value[c] = readComponent<T, Type>(data, c);
+			}
+			dst[i] = Vec(value);
+		}
+	}
+
+	template <typename Vec>
+	void decodeR10G10B10A2(const uint8_t* data, size_t stride, size_t count, uint32_t /*compCount*/, void* out)
+	{
+		const float divisor10 = 1023.0f;
+		const float divisor2  = 3.0f;
+
+		Vec* dst = static_cast<Vec*>(out);
+		for (size_t i = 0; i != count; ++i, data += stride)
+		{
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+
+			glm::vec4 unpacked((float)bit::extract(value, 9, 0) / divisor10,
+							   (float)bit::extract(value, 19, 10) / divisor10,
+							   (float)bit::extract(value, 29, 20) / divisor10,
+							   (float)bit::extract(value, 31, 30) / divisor2);
+			dst[i] = Vec(unpacked);
+		}
+	}
+
+	template <CompType Type, typename Vec, int FillW>
+	AttributeDecoder::DecodeFunc selectInteger(uint32_t width)
+	{
+		constexpr bool isSigned = Type == CompType::SNorm || Type == CompType::SInt;
+		switch (width)
+		{
+		case 1:
+			return decodeRegular<std::conditional_t<isSigned, int8_t, uint8_t>, Type, Vec, FillW>;
+		case 2:
+			return decodeRegular<std::conditional_t<isSigned, int16_t, uint16_t>, Type, Vec, FillW>;
+		case 4:
+			// 32 bit normalized formats don't exist
+			if constexpr (Type == CompType::UInt || Type == CompType::SInt)
+			{
+				return decodeRegular<std::conditional_t<isSigned, int32_t, uint32_t>, Type, Vec, FillW>;
+			}
+		}
+		return nullptr;
+	}
+
+	template <typename Vec, int FillW>
+	AttributeDecoder::DecodeFunc selectDecoder(const ResourceFormat& fmt)
+	{
+		if (fmt.BGRAOrder())
+		{
+			return nullptr;
+		}
+
+		if (fmt.type == ResourceFormatType::R10G10B10A2)
+		{
+			return fmt.compType == CompType::UNorm ? decodeR10G10B10A2<Vec> : nullptr;
+		}
+
+		if (fmt.type != ResourceFormatType::Regular)
+		{
+			return nullptr;
+		}
+
+		switch (fmt.compType)
+		{
+		case CompType::Float:
+			if (fmt.compByteWidth == sizeof(float))
+			{
+				return decodeRegular<float, CompType::Float, Vec, FillW>;
+			}
+			if (fmt.compByteWidth == sizeof(half_float::half))
+			{
+				return decodeRegular<half_float::half, CompType::Float, Vec, FillW>;
+			}
+			break;
+		case CompType::UNorm:
+			return selectInteger<CompType::UNorm, Vec, FillW>(fmt.compByteWidth);
+		case CompType::SNorm:
+			return selectInteger<CompType::SNorm, Vec, FillW>(fmt.compByteWidth);
+		case CompType::UInt:
+			return selectInteger<CompType::UInt, Vec, FillW>(fmt.compByteWidth);
+		case CompType::SInt:
+			return selectInteger<CompType::SInt, Vec, FillW>(fmt.compByteWidth);
+		default:
+			break;
+		}
+		return nullptr;
+	}
+}  // namespace
+
+AttributeDecoder AttributeDecoder::compile(const std::string& name, const ResourceFormat& fmt)
+{
+	AttributeDecoder result;
+	result.m_compCount = fmt.compCount;
+
+	if (name == "POSITION")
+	{
+		result.m_semantic = VertexSemantic::Position;
+		result.m_func     = selectDecoder<glm::vec3, 0>(fmt);
+	}
+	else if (name == "TEXCOORD" || name == "TEXCOORD0")
+	{
+		result.m_semantic = VertexSemantic::Texcoord;
+		result.m_func     = selectDecoder<glm::vec2, 0>(fmt);
+	}
+	else if (name == "NORMAL")
+	{
+		result.m_semantic = VertexSemantic::Normal;
+		result.m_func     = selectDecoder<glm::vec4, 0>(fmt);
+	}
+	else if (name == "TANGENT")
+	{
+		result.m_semantic = VertexSemantic::Tangent;
+		result.m_func     = selectDecoder<glm::vec4, 1>(fmt);
+	}
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#define RENDERDOC_PLATFORM_WIN32
+#include "renderdoc_replay.h"
+
+#include <string>
+
+// vertex attributes extracted into a MeshObject
+enum class VertexSemantic
+{
+	Unknown,
+	Position,  // glm::vec3
+	Texcoord,  // glm::vec2
+	Normal,    // glm::vec4, w is 0 when not in the buffer
+	Tangent    // glm::vec4, w is 1 when not in the buffer
+};
+
+// An attribute's semantic and format resolved once per draw into a function
+// decoding the whole stream straight into the semantic's glm vector array.
+class AttributeDecoder
+{
+public:
+	using DecodeFunc = void (*)(const uint8_t* data, size_t stride, size_t count, uint32_t compCount, void* out);
+
+	// semantic is Unknown for attributes not extracted,
+	// the decoder is invalid if the format isn't supported
+	static AttributeDecoder compile(const std::string& name, const ResourceFormat& fmt);
+
+	VertexSemantic semantic() const { return m_semantic; }
+	bool           isValid() const { return m_func != nullptr; }
+
+	// data points at the first vertex, out at count elements of the semantic's type
+	void decode(const uint8_t* data, size_t stride, size_t count, void* out) const
+	{
+		m_func(data, stride, count, m_compCount, out);
+	}
+
+private:
+	VertexSemantic m_semantic  = VertexSemantic::Unknown;
+	uint32_t       m_compCount = 0;
+	DecodeFunc     m_func      = nullptr;
+};
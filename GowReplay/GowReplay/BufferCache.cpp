@@ -0,0 +1,130 @@
+#include "BufferCache.h"
+#include "Log.h"
+
+#include <algorithm>
+
+BufferCache::BufferCache(size_t budget) :
+	m_budget(budget)
+{
+}
+
+BufferCache::~BufferCache()
+{
+	clear();
+}
+
+void BufferCache::setController(IReplayController* player)
+{
+	clear();
+	m_player = player;
+}
+
+std::shared_ptr<const bytebuf> BufferCache::get(ResourceId id, uint32_t eventId)
+{
+	auto iter = m_entries.find(id);
+	if (iter != m_entries.end())
+	{
+		auto& entry = iter->second;
+		if (eventId >= entry.firstEventId && eventId <= entry.lastEventId)
+		{
+			++m_hits;
+			m_lru.splice(m_lru.begin(), m_lru, entry.lruIter);
+			return entry.data;
+		}
+
+		// written since the download
+		m_size -= entry.data->size();
+		m_lru.erase(entry.lruIter);
+		m_entries.erase(iter);
+	}
+
+	++m_misses;
+	LOG_TRACE("Download buffer for event {}", eventId);
+
+	Entry entry   = {};
+	entry.data    = std::make_shared<const bytebuf>(m_player->GetBufferData(id, 0, 0));
+	updateValidRange(entry, id, eventId);
+
+	m_lru.push_front(id);
+	entry.lruIter = m_lru.begin();
+	m_size += entry.data->size();
+
+	auto data = entry.data;
+	m_entries.emplace(id, std::move(entry));
+
+	evict();
+	return data;
+}
+
+void BufferCache::clear()
+{
+	if (m_hits || m_misses)
+	{
+		LOG_DEBUG("buffer cache: {} hits, {} downloads", m_hits, m_misses);
+	}
+
+	m_lru.clear();
+	m_entries.clear();
+	m_size   = 0;
+	m_hits   = 0;
+	m_misses = 0;
+}
+
+void BufferCache::updateValidRange(Entry& entry, ResourceId id, uint32_t eventId)
+{
+	// the contents read at eventId are the same from the event after
+	// the previous write up to the event before the next one
+	entry.firstEventId = 0;
+	entry.lastEventId  = UINT32_MAX;
+	for (const auto& use : m_player->GetUsage(id))
+	{
+		switch (use.usage)
+		{
+		case ResourceUsage::StreamOut:
+		case ResourceUsage::VS_RWResource:
+		case ResourceUsage::HS_RWResource:
+		case ResourceUsage::DS_RWResource:
+		case ResourceUsage::GS_RWResource:
+		case ResourceUsage::PS_RWResource:
+		case ResourceUsage::CS_RWResource:
+		case ResourceUsage::All_RWResource:
+		case ResourceUsage::Clear:
+		case ResourceUsage::Discard:
+		case ResourceUsage::ResolveDst:
+		case ResourceUsage::Copy:
+		case ResourceUsage::CopyDst:
+		case ResourceUsage::CPUWrite:
+			break;
+		default:
+			continue;
+		}
+
+		if (use.eventId > eventId)
+		{
+			entry.lastEventId = std::min(entry.lastEventId, use.eventId - 1);
+		}
+		else if (use.eventId < eventId)
+		{
+			entry.firstEventId = std::max(entry.firstEventId, use.eventId + 1);
+		}
+		else
+		{
+			// written by the event itself, can't be shared with any other
+			entry.firstEventId = eventId;
+			entry.lastEventId  = eventId;
+			break;
+		}
+	}
+}
+
+void BufferCache::evict()
+{
+	// the most recent entry is kept even if it is over the budget on its own
+	while (m_size > m_budget && m_lru.size() > 1)
+	{
+		auto iter = m_entries.find(m_lru.back());
+		m_size -= iter->second.data->size();
+		m_lru.pop_back();
+		m_entries.erase(iter);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+
+#define RENDERDOC_PLATFORM_WIN32
+#include "renderdoc_replay.h"
+
+#include <list>
+#include <memory>
+#include <map>
+
+// Whole buffer downloads shared by all draws of a capture.
+// A download made at some event stays valid for every event up to the next write
+// to the buffer, entries are evicted least recently used first once the total
+// size goes over the budget.
+class BufferCache
+{
+public:
+	static constexpr size_t DefaultBudget = 1024ull * 1024 * 1024;
+
+	explicit BufferCache(size_t budget = DefaultBudget);
+	~BufferCache();
+
+	// must be set before get, and reset when the capture is closed
+	void setController(IReplayController* player);
+
+	// contents of the buffer as seen at eventId, the returned data stays alive
+	// after the entry is evicted
+	std::shared_ptr<const bytebuf> get(ResourceId id, uint32_t eventId);
+
+	void clear();
+
+private:
+	struct Entry
+	{
+		std::shared_ptr<const bytebuf>  data;
+		uint32_t                        firstEventId;
+		uint32_t                        lastEventId;
+		std::list<ResourceId>::iterator lruIter;
+	};
+
+	void updateValidRange(Entry& entry, ResourceId id, uint32_t eventId);
+	void evict();
+
+private:
+	IReplayController* m_player = nullptr;
+	size_t             m_budget;
+	size_t             m_size   = 0;
+	size_t             m_hits   = 0;
+	size_t             m_misses = 0;
+
+	// most recently used at the front
+	std::list<ResourceId>       m_lru;
+	std::map<ResourceId, Entry> m_entries;
+};
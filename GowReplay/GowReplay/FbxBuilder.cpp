@@ -1,8 +1,10 @@
 #include "FbxBuilder.h"
+#include "FbxWriter.h"
 #include "Log.h"
 
 #include <algorithm>
 #include <filesystem>
+#include <fstream>
 
 #ifdef IOS_REF
 #undef IOS_REF
@@ -23,9 +25,13 @@ bool MeshObject::isValid()
 	return !position.empty();
 }
 
-FbxBuilder::FbxBuilder()
+FbxBuilder::FbxBuilder(Backend backend) :
+	m_backend(backend)
 {
-	initializeSdkObjects();
+	if (m_backend == Backend::Sdk)
+	{
+		initializeSdkObjects();
+	}
 }
 
 FbxBuilder::~FbxBuilder()
@@ -35,6 +41,12 @@ FbxBuilder::~FbxBuilder()
 
 void FbxBuilder::addMesh(const MeshObject& mesh)
 {
+	if (m_backend == Backend::Native)
+	{
+		m_meshes.push_back(mesh);
+		return;
+	}
+
 	auto lMesh     = createMesh(mesh);
 	auto meshNodes = createInstances(mesh, lMesh);
 
@@ -54,6 +66,12 @@ void FbxBuilder::addMesh(const MeshObject& mesh)
 
 void FbxBuilder::build(const std::string& filename)
 {
+	if (m_backend == Backend::Native)
+	{
+		buildNative(filename);
+		return;
+	}
+
 	int  lMajor, lMinor, lRevision;
 	bool lStatus = true;
 	int  lFileFormat = -1;
@@ -114,6 +132,101 @@ void FbxBuilder::build(const std::string& filename)
 	lExporter->Destroy();
 }
 
+void FbxBuilder::buildNative(const std::string& filename)
+{
+	std::ofstream ofs(filename, std::ios::binary | std::ios::trunc);
+	if (!ofs)
+	{
+		LOG_ERR("Failed to open {}\n", filename);
+		return;
+	}
+
+	try
+	{
+		FbxSceneWriter writer(ofs, "GowReplay");
+
+		// the same material the SDK backend gives every instance node
+		FbxSceneWriter::Material material;
+		material.ambientFactor      = 1.0;
+		material.diffuseFactor      = 1.0;
+		material.transparencyFactor = 0.4;
+		material.specularFactor     = 0.3;
+
+		const std::pair<const char*, const char*> channels[] = {
+			{ "_diffuse", "DiffuseColor" },
+			{ "_normal", "NormalMap" },
+			{ "_emissive", "EmissiveColor" }
+		};
+
+		for (const auto& mesh : m_meshes)
+		{
+			if (mesh.position.empty())
+			{
+				continue;
+			}
+
+			auto normals = ComputeNormalsWeightedByAngle(
+				mesh.indices,
+				mesh.position,
+				true);
+
+			FbxSceneWriter::Geometry geometry;
+			geometry.vertexCount = mesh.position.size();
+			geometry.positions   = { &mesh.position[0].x, sizeof(glm::vec3) };
+			if (!normals.empty())
+			{
+				geometry.normals = { &normals[0].x, sizeof(glm::vec3) };
+			}
+			if (mesh.texcoord.size() == mesh.position.size())
+			{
+				geometry.uvSets.push_back({ m_uvName, { &mesh.texcoord[0].x, sizeof(glm::vec2) } });
+			}
+			geometry.indices    = mesh.indices.data();
+			geometry.indexCount = mesh.indices.size();
+			geometry.indexSize  = sizeof(uint32_t);
+			geometry.material   = true;
+
+			// instances share the geometry and one material,
+			// the SDK backend creates both per instance node
+			auto geometryId = writer.AddGeometry("", geometry);
+			auto materialId = writer.AddMaterial("GowMaterial", material);
+			for (const auto& [suffix, property] : channels)
+			{
+				auto texture = findTexturePath(mesh, suffix);
+				if (!texture.empty())
+				{
+					auto basename  = fs::path(texture).filename().string();
+					auto textureId = writer.AddTexture(basename, texture, m_uvName);
+					writer.Connect(textureId, materialId, property);
+				}
+			}
+
+			uint32_t instanceId = 0;
+			for (const auto& trs : mesh.instances)
+			{
+				FbxSceneWriter::Transform transform;
+				for (int i = 0; i != 3; ++i)
+				{
+					transform.translation[i] = trs.translation[i];
+					transform.rotation[i]    = trs.rotation[i];
+					transform.scaling[i]     = trs.scaling[i];
+				}
+
+				auto nodeName = fmt::format("{}_{}", mesh.name, instanceId++);
+				auto modelId  = writer.AddModel(nodeName, FbxSceneWriter::ModelType::Mesh, transform);
+				writer.Connect(geometryId, modelId);
+				writer.Connect(materialId, modelId);
+			}
+		}
+
+		writer.Finish();
+	}
+	catch (const std::exception& e)
+	{
+		LOG_ERR("Failed to write {}: {}\n", filename, e.what());
+	}
+}
+
 FbxMesh* FbxBuilder::createMesh(const MeshObject& mesh)
 {
 	FbxMesh* lMesh = FbxMesh::Create(m_scene, "");
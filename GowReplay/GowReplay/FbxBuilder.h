@@ -36,7 +36,15 @@ struct MeshObject
 class FbxBuilder
 {
 public:
-	FbxBuilder();
+	// Sdk builds an FbxScene and exports it through the FBX SDK,
+	// Native keeps the meshes and streams the file with FbxSceneWriter on build.
+	enum class Backend
+	{
+		Sdk,
+		Native
+	};
+
+	explicit FbxBuilder(Backend backend = Backend::Sdk);
 	~FbxBuilder();
 
 	void addMesh(const MeshObject& mesh);
@@ -44,6 +52,7 @@ public:
 	void build(const std::string& filename);
 
 private:
+	void                   buildNative(const std::string& filename);
 	FbxMesh*               createMesh(const MeshObject& mesh);
 	std::vector<FbxNode*>  createInstances(const MeshObject& info, FbxMesh* mesh);
 	void                   assignNormal(const MeshObject& info, FbxMesh* mesh);
@@ -61,8 +70,10 @@ private:
 	void destroySdkObjects();
 
 private:
-	FbxManager* m_manager = nullptr;
-	FbxScene*   m_scene   = nullptr;
-	std::string m_uvName  = "SharedUV";
+	Backend                 m_backend;
+	FbxManager*             m_manager = nullptr;
+	FbxScene*               m_scene   = nullptr;
+	std::string             m_uvName  = "SharedUV";
+	std::vector<MeshObject> m_meshes;
 };
 
@@ -1,12 +1,13 @@
 #include "GowReplayer.h"
 #include "Log.h"
+#include "AttributeDecoder.h"
 #include "Tools.h"
 
 template <>
 rdcstr DoStringise(const uint32_t& el)
 {
-	static char tmp[16];
-	memset(tmp, 0, sizeof(tmp));
+	// on the stack, batch workers stringise concurrently
+	char tmp[16] = {};
 	_snprintf_s(tmp, 15, "%u", el);
 	return tmp;
 }
@@ -19,17 +20,38 @@ rdcstr DoStringise(const uint32_t& el)
 #include <filesystem>
 #include <map>
 #include <cmath>
+#include <algorithm>
+#include <mutex>
 
 #include "gtc/matrix_access.hpp"
 #include "gtc/constants.hpp"
 #include "gtx/euler_angles.hpp"
-#include "half.hpp"
 
 namespace fs = std::filesystem;
 
+namespace
+{
+	// sized output for an attribute stream, null if the stream was already decoded
+	template <typename T>
+	void* allocStream(std::vector<T>& stream, size_t count)
+	{
+		if (!stream.empty())
+		{
+			return nullptr;
+		}
+		stream.resize(count);
+		return stream.data();
+	}
+
+	// the replay library is set up once for all replayers in the process
+	std::mutex g_replayLock;
+	uint32_t   g_replayCount = 0;
+}  // namespace
+
 REPLAY_PROGRAM_MARKER();
 
-GowReplayer::GowReplayer()
+GowReplayer::GowReplayer(FbxBuilder::Backend fbxBackend) :
+	m_fbx(fbxBackend)
 {
 	initialize();
 }
@@ -40,28 +62,58 @@ GowReplayer::~GowReplayer()
 }
 
 void GowReplayer::replay(const std::string& capFile)
+{
+	if (!extract(capFile))
+	{
+		return;
+	}
+
+	for (const auto& mesh : m_scene.meshes())
+	{
+		m_fbx.addMesh(mesh);
+	}
+	m_scene.clear();
+
+	auto outFilename = getOutFilename();
+	m_fbx.build(outFilename);
+}
+
+bool GowReplayer::extract(const std::string& capFile, const std::string& captureName)
 {
 	m_capFilename = capFile;
+	m_captureName = captureName.empty() ? fs::path(capFile).stem().string() : captureName;
 
-	captureLoad();
+	if (!captureLoad())
+	{
+		captureUnload();
+		return false;
+	}
 
 	processActions();
 
 	captureUnload();
 
-	auto outFilename = getOutFilename();
-	m_fbx.build(outFilename);
+	LOG_DEBUG("{} unique meshes after {}", m_scene.size(), m_capFilename);
+	return true;
 }
 
 void GowReplayer::initialize()
 {
-	GlobalEnvironment env = {};
-	RENDERDOC_InitialiseReplay(env, {});
+	std::lock_guard<std::mutex> lock(g_replayLock);
+	if (g_replayCount++ == 0)
+	{
+		GlobalEnvironment env = {};
+		RENDERDOC_InitialiseReplay(env, {});
+	}
 }
 
 void GowReplayer::shutdown()
 {
-	RENDERDOC_ShutdownReplay();
+	std::lock_guard<std::mutex> lock(g_replayLock);
+	if (--g_replayCount == 0)
+	{
+		RENDERDOC_ShutdownReplay();
+	}
 }
 
 bool GowReplayer::captureLoad()
@@ -77,6 +129,9 @@ bool GowReplayer::captureLoad()
 
 		LOG_DEBUG("loading capture file: {}", m_capFilename);
 
+		// captures are opened one at a time, replay runs in parallel
+		std::lock_guard<std::mutex> lock(g_replayLock);
+
 		m_cap = RENDERDOC_OpenCaptureFile();
 		if (!m_cap)
 		{
@@ -100,6 +155,8 @@ bool GowReplayer::captureLoad()
 			break;
 		}
 
+		m_buffers.setController(m_player);
+
 		ret  = true;
 	}while(false);
 
@@ -113,6 +170,12 @@ bool GowReplayer::captureLoad()
 
 void GowReplayer::captureUnload()
 {
+	// resource ids are only unique within a capture
+	m_buffers.setController(nullptr);
+	m_textureCache.clear();
+
+	std::lock_guard<std::mutex> lock(g_replayLock);
+
 	if (m_player)
 	{
 		m_player->Shutdown();
@@ -177,20 +240,47 @@ void GowReplayer::extractResource(const ActionDescription& act)
 
 	m_player->SetFrameEvent(act.eventId, true);
 
-	auto mesh    = extractMesh(act);
 	auto texList = extractTexture(act);
+	extractMesh(act, texList);
+}
 
-	if (mesh.isValid())
+void GowReplayer::extractMesh(const ActionDescription& act, const std::vector<std::string>& textures)
+{
+	auto meshAttrs = getMeshAttributes(act);
+	if (meshAttrs.empty())
 	{
-		mesh.textures = texList;
-		m_fbx.addMesh(mesh);
+		// in case the mesh has already been added.
+		return;
+	}
+
+	auto indices = getMeshIndices(meshAttrs.front(), act.eventId);
+	if (indices.empty())
+	{
+		return;
+	}
+
+	// draws of the same geometry with the same textures share one mesh,
+	// later draws only add their instances
+	uint64_t key = hashGeometry(act, meshAttrs, indices);
+	for (const auto& tex : textures)
+	{
+		key = hash::bytes(tex.data(), tex.size(), key);
+	}
+
+	if (auto known = m_scene.find(key))
+	{
+		LOG_TRACE("Reuse mesh {} for event {}", known->name, act.eventId);
+		MeshCollection::appendInstances(*known, getMeshTransforms(act));
+		return;
 	}
-}
 
-MeshObject GowReplayer::extractMesh(const ActionDescription& act)
-{
 	LOG_TRACE("Add mesh from event {}", act.eventId);
-	return buildMeshObject(act);
+	auto mesh = buildMeshObject(act, meshAttrs, std::move(indices));
+	if (mesh.isValid())
+	{
+		mesh.textures = textures;
+		m_scene.add(key, std::move(mesh));
+	}
 }
 
 std::vector<std::string> GowReplayer::extractTexture(const ActionDescription& act)
@@ -213,8 +303,10 @@ std::vector<std::string> GowReplayer::extractTexture(const ActionDescription& ac
 		if (iter == m_textureCache.end())
 		{
 			// construct texture filename
-			auto packName  = fs::path(m_capFilename).stem();
-			auto texFolder = outDir / packName / "Textures" / fmt::format("EID-{:05d}", act.eventId);
+			auto packName  = fs::path(m_captureName);
+			auto texFolder = m_textureStore
+								 ? m_textureStore->root() / packName / fmt::format("EID-{:05d}", act.eventId)
+								 : outDir / packName / "Textures" / fmt::format("EID-{:05d}", act.eventId);
 			if (!fs::exists(texFolder))
 			{
 				fs::create_directories(texFolder);
@@ -239,9 +331,10 @@ std::vector<std::string> GowReplayer::extractTexture(const ActionDescription& ac
 				LOG_TRACE("Use saved texture {} for event {}", filename.string(), act.eventId);
 			}
 
-			result.push_back(filename.string());
+			auto path = m_textureStore ? m_textureStore->intern(filename.string()) : filename.string();
+			result.push_back(path);
 
-			m_textureCache[tex.id] = filename.string();
+			m_textureCache[tex.id] = path;
 		}
 		else
 		{
@@ -302,15 +395,22 @@ std::vector<MeshData> GowReplayer::getMeshAttributes(const ActionDescription& ac
 	return result;
 }
 
-std::vector<uint32_t> GowReplayer::getMeshIndices(const MeshData& mesh)
+std::vector<uint32_t> GowReplayer::getMeshIndices(const MeshData& mesh, uint32_t eventId)
 {
 	std::vector<uint32_t> result(mesh.numIndices);
 
 	if (mesh.indexResourceId != ResourceId::Null())
 	{
-		auto ibData = m_player->GetBufferData(mesh.indexResourceId, mesh.indexByteOffset, 0);
-		auto offset = mesh.indexOffset * mesh.indexByteStride;
-		const void* data   = ibData.data() + offset;
+		auto   ibData = m_buffers.get(mesh.indexResourceId, eventId);
+		size_t offset = mesh.indexByteOffset + mesh.indexOffset * mesh.indexByteStride;
+		size_t end    = offset + size_t(mesh.numIndices) * mesh.indexByteStride;
+		if (end > ibData->size())
+		{
+			LOG_WARN("index buffer too small for EID {}, {} of {} bytes.", eventId, ibData->size(), end);
+			return {};
+		}
+
+		const void* data = ibData->data() + offset;
 		std::generate(result.begin(), result.end(), [&, n = 0]() mutable
 		{ 
 			if (mesh.indexByteStride == 2)
@@ -406,31 +506,39 @@ std::vector<MeshTransform> GowReplayer::getMeshTransforms(const ActionDescriptio
 	auto insBufferInfo = getShaderResourceBuffer(ShaderStage::Vertex, "instancingBuffer");
 	LOG_ASSERT(insBufferInfo.id != ResourceId::Null(), "can not find instancingBuffer for EID {}", act.eventId);
 
-	for (uint32_t instanceId = 0; instanceId != act.numInstances; ++instanceId)
+	// convert quant scale and bias into matrix
+	glm::mat4 quant(1);
+	quant[0][0] = quantScale[0];
+	quant[1][1] = quantScale[1];
+	quant[2][2] = quantScale[2];
+
+	quant[3][0] += quantBias[0];
+	quant[3][1] += quantBias[1];
+	quant[3][2] += quantBias[2];
+
+	// all instances of the draw are read from one download of the buffer
+	auto           insBuffer  = m_buffers.get(insBufferInfo.id, act.eventId);
+	size_t         insStride  = insBufferInfo.format.arrayByteStride;
+	size_t         matrixSize = std::min<size_t>(insBufferInfo.format.members[0].type.arrayByteStride, sizeof(glm::mat4));
+	size_t         begin      = insStride * instanceOffset;
+	size_t         end        = begin + insStride * act.numInstances;
+	if (end > insBuffer->size())
 	{
-		uint32_t       instanceIndex = instanceId + instanceOffset;
-		uint32_t       size          = insBufferInfo.format.arrayByteStride;
-		uint32_t       offset        = size * instanceIndex;
-		auto           instanceData  = m_player->GetBufferData(insBufferInfo.id, offset, size);
-		const uint8_t* data          = instanceData.data();
+		LOG_WARN("instancingBuffer too small for EID {}, {} of {} bytes.", act.eventId, insBuffer->size(), end);
+		return instances;
+	}
 
+	instances.reserve(act.numInstances);
+	const uint8_t* data = insBuffer->data() + begin;
+	for (uint32_t instanceId = 0; instanceId != act.numInstances; ++instanceId, data += insStride)
+	{
 		glm::mat4 insTransform(0);
-		std::memcpy(&insTransform, data, insBufferInfo.format.members[0].type.arrayByteStride);
+		std::memcpy(&insTransform, data, matrixSize);
 		insTransform[3][3] = 1.0;
 		insTransform = glm::transpose(insTransform);
 
-		// convert quant scale and bias into matrix
-		glm::mat4 quant(1);
-		quant[0][0] = quantScale[0];
-		quant[1][1] = quantScale[1];
-		quant[2][2] = quantScale[2];
-
-		quant[3][0] += quantBias[0];
-		quant[3][1] += quantBias[1];
-		quant[3][2] += quantBias[2];
-		
 		// merge all transform
-		glm::mat4 modelView = view * insTransform * quant;
+		glm::mat4 modelView = m_worldSpace ? insTransform * quant : view * insTransform * quant;
 
 		auto transform = decomposeTransform(modelView);
 		instances.push_back(transform);
@@ -452,64 +560,101 @@ uint32_t GowReplayer::getVertexCount(const std::vector<uint32_t>& indices, uint3
 	return maxIndex + baseVertex + 1;
 }
 
-MeshObject GowReplayer::buildMeshObject(const ActionDescription& act)
+uint64_t GowReplayer::hashGeometry(
+	const ActionDescription&     act,
+	const std::vector<MeshData>& meshAttrs,
+	const std::vector<uint32_t>& indices)
 {
-	MeshObject mesh;
+	uint64_t result   = hash::bytes(indices.data(), indices.size() * sizeof(uint32_t));
+	uint32_t vtxCount = getVertexCount(indices, meshAttrs.front().baseVertex);
 
-	auto meshAttrs = getMeshAttributes(act);
-	if (meshAttrs.empty())
+	for (const auto& attr : meshAttrs)
 	{
-		// in case the mesh has already been added.
-		return mesh;
+		// only the attributes buildMeshObject extracts tell meshes apart
+		if (AttributeDecoder::compile(attr.name, attr.format).semantic() == VertexSemantic::Unknown)
+		{
+			continue;
+		}
+
+		const auto& fmt = attr.format;
+		result = hash::bytes(attr.name.data(), attr.name.size(), result);
+		result = hash::combine(result, uint64_t(fmt.type));
+		result = hash::combine(result, uint64_t(fmt.compType));
+		result = hash::combine(result, fmt.compCount);
+		result = hash::combine(result, fmt.compByteWidth);
+		result = hash::combine(result, fmt.BGRAOrder());
+		result = hash::combine(result, attr.vertexByteStride);
+
+		// the vertex range the draw reads, wherever it is in the buffer
+		auto   buffer = m_buffers.get(attr.vertexResourceId, act.eventId);
+		size_t begin  = std::min<size_t>(attr.vertexByteOffset, buffer->size());
+		size_t end    = std::min<size_t>(begin + size_t(vtxCount) * attr.vertexByteStride, buffer->size());
+		result        = hash::bytes(buffer->data() + begin, end - begin, result);
 	}
 
+	return result;
+}
+
+MeshObject GowReplayer::buildMeshObject(
+	const ActionDescription&     act,
+	const std::vector<MeshData>& meshAttrs,
+	std::vector<uint32_t>        indices)
+{
+	MeshObject mesh;
+
 	mesh.eid          = act.eventId;
 	mesh.name         = fmt::format("EID_{}", act.eventId);
-	mesh.indices      = getMeshIndices(meshAttrs.front());
+	mesh.indices      = std::move(indices);
 	uint32_t vtxCount = getVertexCount(mesh.indices, meshAttrs.front().baseVertex);
 
-	// cache the vertex buffer
-	std::map<ResourceId, bytebuf> vtxCache;
 	for (const auto& attr : meshAttrs)
 	{
-		vtxCache[attr.vertexResourceId] = m_player->GetBufferData(attr.vertexResourceId, 0, 0);
-	}
+		// format and semantic are resolved once for the whole stream
+		auto decoder = AttributeDecoder::compile(attr.name, attr.format);
+		if (decoder.semantic() == VertexSemantic::Unknown)
+		{
+			continue;
+		}
 
-	for (const auto& attr : meshAttrs)
-	{
-		auto& buffer = vtxCache[attr.vertexResourceId];
-		auto  offset = attr.vertexByteOffset;
-		auto  stride = attr.vertexByteStride;
-		// auto  count  = buffer.size() / stride;
-		auto count = vtxCount;
+		LOG_ASSERT(decoder.isValid(), "unsupported buffer format {} for {}.", attr.format.Name().c_str(), attr.name);
+
+		auto buffer = m_buffers.get(attr.vertexResourceId, act.eventId);
+		auto offset = attr.vertexByteOffset;
+		auto stride = attr.vertexByteStride;
+		auto count  = vtxCount;
 
-		for (size_t i = 0; i != count; ++i)
+		if (offset + (count - 1) * stride + attr.format.ElementSize() > buffer->size())
 		{
-			uint8_t* data  = &buffer[offset + i * stride];
-			auto     value = unpackData(attr.format, data);
+			LOG_WARN("vertex buffer too small for {} of EID {}.", attr.name, act.eventId);
+			return MeshObject();
+		}
 
-			if (attr.name == "POSITION")
-			{
-				LOG_ASSERT(value.size() == 3, "");
-				glm::vec3 vtx(value[0], value[1], value[2]);
-				mesh.position.push_back(vtx);
-			}
-			else if (attr.name == "TEXCOORD" || attr.name == "TEXCOORD0")
-			{
-				glm::vec2 texcoord(value[0], value[1]);
-				mesh.texcoord.push_back(texcoord);
-			}
-			else if (attr.name == "NORMAL")
-			{
-				glm::vec4 normal(value[0], value[1], value[2], value.size() == 4 ? value[3] : 0.0f);
-				mesh.normal.push_back(normal);
-			}
-			else if (attr.name == "TANGENT")
-			{
-				glm::vec4 tangent(value[0], value[1], value[2], value.size() == 4 ? value[3] : 1.0f);
-				mesh.tangent.push_back(tangent);
-			}
+		void* out = nullptr;
+		switch (decoder.semantic())
+		{
+		case VertexSemantic::Position:
+			out = allocStream(mesh.position, count);
+			break;
+		case VertexSemantic::Texcoord:
+			out = allocStream(mesh.texcoord, count);
+			break;
+		case VertexSemantic::Normal:
+			out = allocStream(mesh.normal, count);
+			break;
+		case VertexSemantic::Tangent:
+			out = allocStream(mesh.tangent, count);
+			break;
+		default:
+			break;
+		}
+
+		if (!out)
+		{
+			LOG_WARN("duplicate attribute {} ignored for EID {}.", attr.name, act.eventId);
+			continue;
 		}
+
+		decoder.decode(buffer->data() + offset, stride, count, out);
 	}
 
 	LOG_ASSERT(mesh.texcoord.empty() || mesh.texcoord.size() == mesh.position.size(), "texcoord count not match");
@@ -659,117 +804,6 @@ GowReplayer::getShaderResourceTextures(ShaderStage stage)
 	return result;
 }
 
-std::vector<float> GowReplayer::unpackData(
-	const ResourceFormat& fmt,
-	const uint8_t*        data)
-{
-	std::vector<float> result;
-
-	LOG_ASSERT(fmt.BGRAOrder() == false, "BGRA order not supported.");
-
-	auto fmtName = fmt.Name();
-
-	// TODO:
-	// this implementation is really ugly,
-	// we should use a uniform way instead of support by name...
-	if (fmtName == "R32G32B32_FLOAT" || fmtName == "R32G32_FLOAT" || fmtName == "R32G32B32A32_FLOAT")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(float), "TODO");
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			result.push_back((reinterpret_cast<const float*>(data))[i]);
-		}
-	}
-	else if (fmtName == "R16G16_UNORM")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(uint16_t), "TODO");
-		float divisor = float(std::exp2(fmt.compByteWidth * 8) - 1);
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			uint16_t val = (reinterpret_cast<const uint16_t*>(data))[i];
-			result.push_back((float)val / divisor);
-		}
-	}
-	else if (fmtName == "R8G8B8A8_UNORM")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(uint8_t), "TODO");
-		float divisor = float(std::exp2(fmt.compByteWidth * 8) - 1);
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			uint8_t val = (reinterpret_cast<const uint8_t*>(data))[i];
-			result.push_back((float)val / divisor);
-		}
-	}
-	else if (fmtName == "R16G16_SNORM")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(int16_t), "TODO");
-		float maxNeg  = -float(std::exp2(fmt.compByteWidth * 8)) / 2;
-		float divisor = float(-(maxNeg - 1));
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			int16_t val  = (reinterpret_cast<const int16_t*>(data))[i];
-			float   fval = (float)val == maxNeg ? (float)val : (float)val / divisor;
-			result.push_back(fval);
-		}
-	}
-	else if (fmtName == "R10G10B10A2_UNORM")
-	{
-		float divisor10 = float(std::exp2(10) - 1);
-		float divisor2 = float(std::exp2(2) - 1);
-
-		uint32_t value = *reinterpret_cast<const uint32_t*>(data);
-		uint16_t r     = bit::extract(value, 9, 0);
-		uint16_t g     = bit::extract(value, 19, 10);
-		uint16_t b     = bit::extract(value, 29, 20);
-		uint16_t a     = bit::extract(value, 31, 30);
-		result.push_back((float)r / divisor10);
-		result.push_back((float)g / divisor10);
-		result.push_back((float)b / divisor10);
-		result.push_back((float)a / divisor2);
-	}
-	else if (fmtName == "R16G16B16A16_UINT")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(uint16_t), "TODO");
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			uint16_t val = (reinterpret_cast<const uint16_t*>(data))[i];
-			result.push_back((float)val);
-		}
-	}
-	else if (fmtName == "R16G16B16A16_FLOAT")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(half_float::half), "TODO");
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			half_float::half val = (reinterpret_cast<const half_float::half*>(data))[i];
-			result.push_back(val);
-		}
-	}
-	else if (fmtName == "R8G8B8A8_UINT")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(uint8_t), "TODO");
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			uint8_t val = (reinterpret_cast<const uint8_t*>(data))[i];
-			result.push_back((float)val);
-		}
-	}
-	else if (fmtName == "R32_UINT")
-	{
-		LOG_ASSERT(fmt.compByteWidth == sizeof(uint32_t), "TODO");
-		for (size_t i = 0; i != fmt.compCount; ++i)
-		{
-			uint32_t val = (reinterpret_cast<const uint32_t*>(data))[i];
-			result.push_back((float)val);
-		}
-	}
-	else
-	{
-		LOG_ASSERT(false, "unsupported buffer format {}.", fmtName.c_str());
-	}
-	return result;
-}
-
 MeshTransform GowReplayer::decomposeTransform(const glm::mat4& modelView)
 {
 	MeshTransform result = {};
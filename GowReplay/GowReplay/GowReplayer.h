@@ -4,6 +4,9 @@
 #include "renderdoc_replay.h"
 
 #include "FbxBuilder.h"
+#include "BufferCache.h"
+#include "MeshCollection.h"
+#include "TextureStore.h"
 
 #include <string>
 #include <set>
@@ -31,11 +34,25 @@ class GowReplayer
 	};
 
 public:
-	GowReplayer();
+	explicit GowReplayer(FbxBuilder::Backend fbxBackend = FbxBuilder::Backend::Sdk);
 	~GowReplayer();
 
+	// extracts a capture and writes its fbx next to it
 	void replay(const std::string& capFile);
 
+	// replays a capture and adds its unique meshes to the scene, several
+	// replayers can extract captures at the same time. Textures are saved
+	// in a folder named captureName, the capture's file name by default.
+	bool extract(const std::string& capFile, const std::string& captureName = {});
+
+	MeshCollection& scene() { return m_scene; }
+
+	// save textures into a store shared with other replayers
+	void setTextureStore(TextureStore* store) { m_textureStore = store; }
+	// leave the camera's view out of instance transforms,
+	// so captures taken from different places line up
+	void setWorldSpace(bool worldSpace) { m_worldSpace = worldSpace; }
+
 private:
 	void initialize();
 	void shutdown();
@@ -47,13 +64,14 @@ private:
 	void iterAction(const ActionDescription& act);
 
 	void                     extractResource(const ActionDescription& act);
-	MeshObject               extractMesh(const ActionDescription& act);
+	void                     extractMesh(const ActionDescription& act, const std::vector<std::string>& textures);
 	std::vector<std::string> extractTexture(const ActionDescription& act);
 
 	std::vector<MeshData>      getMeshAttributes(const ActionDescription& act);
-	std::vector<uint32_t>      getMeshIndices(const MeshData& mesh);
+	std::vector<uint32_t>      getMeshIndices(const MeshData& mesh, uint32_t eventId);
 	std::vector<MeshTransform> getMeshTransforms(const ActionDescription& act);
-	MeshObject                 buildMeshObject(const ActionDescription& act);
+	MeshObject                 buildMeshObject(const ActionDescription& act, const std::vector<MeshData>& meshAttrs, std::vector<uint32_t> indices);
+	uint64_t                   hashGeometry(const ActionDescription& act, const std::vector<MeshData>& meshAttrs, const std::vector<uint32_t>& indices);
 
 	std::optional<ShaderVariable> getShaderConstantVariable(
 		ShaderStage stage, const std::string& name);
@@ -62,10 +80,6 @@ private:
 	std::vector<ResourceTexture> getShaderResourceTextures(
 		ShaderStage stage);
 
-	std::vector<float> unpackData(
-		const ResourceFormat& fmt,
-		const uint8_t*        data);
-
 	MeshTransform decomposeTransform(const glm::mat4& modelView);
 
 	std::string getOutFilename();
@@ -75,10 +89,18 @@ private:
 
 private:
 	std::string          m_capFilename;
+	std::string          m_captureName;
 	ICaptureFile*        m_cap    = nullptr;
 	IReplayController*   m_player = nullptr;
 	FbxBuilder           m_fbx;
+	BufferCache          m_buffers;
+
+	TextureStore*        m_textureStore = nullptr;
+	bool                 m_worldSpace   = false;
 
 	std::map<ResourceId, std::string> m_textureCache;
+
+	// unique meshes, added to m_fbx once the capture is processed
+	MeshCollection m_scene;
 };
 
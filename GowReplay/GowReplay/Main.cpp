@@ -1,8 +1,171 @@
 #include "GowReplayer.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	// a directory of captures, a single capture or a text file listing one capture per line
+	std::vector<std::string> findCaptures(const fs::path& input)
+	{
+		std::vector<std::string> result;
+		if (fs::is_directory(input))
+		{
+			for (const auto& entry : fs::directory_iterator(input))
+			{
+				if (entry.is_regular_file() && entry.path().extension() == ".rdc")
+				{
+					result.push_back(entry.path().string());
+				}
+			}
+			std::sort(result.begin(), result.end());
+		}
+		else if (input.extension() == ".rdc")
+		{
+			result.push_back(input.string());
+		}
+		else
+		{
+			std::ifstream ifs(input);
+			std::string   line;
+			while (std::getline(ifs, line))
+			{
+				line.erase(line.find_last_not_of(" \t\r") + 1);
+				if (!line.empty() && line[0] != '#')
+				{
+					result.push_back(line);
+				}
+			}
+		}
+		return result;
+	}
+
+	// replays all captures on parallel workers, each with its own capture and
+	// replay controller, and writes one scene with a single texture folder
+	int replayBatch(const fs::path& input, fs::path outFile, uint32_t jobs, FbxBuilder::Backend backend)
+	{
+		auto captures = findCaptures(input);
+		if (captures.empty())
+		{
+			LOG_ERR("no capture found in {}", input.string());
+			return 1;
+		}
+
+		if (outFile.empty())
+		{
+			// next to the input, named after it
+			auto base = fs::absolute(input).lexically_normal();
+			if (!base.has_filename())
+			{
+				base = base.parent_path();
+			}
+			outFile = fs::is_directory(base) ? base / (base.filename().string() + ".fbx") : fs::path(base).replace_extension(".fbx");
+		}
+
+		TextureStore   textures(outFile.parent_path() / outFile.stem() / "Textures");
+		MeshCollection scene;
+		std::mutex     sceneLock;
+
+		jobs = std::clamp<uint32_t>(jobs, 1, (uint32_t)captures.size());
+		LOG_DEBUG("replaying {} captures on {} workers", captures.size(), jobs);
+
+		std::atomic<size_t>      next{ 0 };
+		std::vector<std::thread> workers;
+		for (uint32_t i = 0; i != jobs; ++i)
+		{
+			workers.emplace_back([&]()
+			{
+				// workers only collect meshes, the native backend creates no sdk objects
+				GowReplayer replayer(FbxBuilder::Backend::Native);
+				replayer.setTextureStore(&textures);
+				replayer.setWorldSpace(true);
+
+				for (size_t index = next++; index < captures.size(); index = next++)
+				{
+					// listed captures may share a file name, the index keeps
+					// their texture folders and mesh names apart
+					const auto& capFile     = captures[index];
+					auto        captureName = fmt::format("{:03d}_{}", index, fs::path(capFile).stem().string());
+					if (!replayer.extract(capFile, captureName))
+					{
+						continue;
+					}
+
+					// mesh names are only unique within a capture
+					auto prefix = captureName + "_";
+
+					std::lock_guard<std::mutex> lock(sceneLock);
+					scene.merge(std::move(replayer.scene()), prefix);
+				}
+			});
+		}
+
+		for (auto& worker : workers)
+		{
+			worker.join();
+		}
+
+		LOG_DEBUG("{} unique meshes from {} captures", scene.size(), captures.size());
+
+		FbxBuilder fbx(backend);
+		for (const auto& mesh : scene.meshes())
+		{
+			fbx.addMesh(mesh);
+		}
+		fbx.build(outFile.string());
+		return 0;
+	}
+}  // namespace
 
 int main(int argc, char* argv[])
 {
-	GowReplayer replayer;
+	// GowReplay <capture.rdc> [--native-fbx]
+	// GowReplay --batch <folder|capture list> [--jobs N] [--out scene.fbx] [--native-fbx]
+	auto        backend = FbxBuilder::Backend::Sdk;
+	std::string batchInput;
+	std::string outFile;
+	uint32_t    jobs = std::max(1u, std::thread::hardware_concurrency() / 2);
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string_view arg = argv[i];
+		if (arg == "--native-fbx")
+		{
+			backend = FbxBuilder::Backend::Native;
+		}
+		else if (arg == "--batch" && i + 1 < argc)
+		{
+			batchInput = argv[++i];
+		}
+		else if (arg == "--jobs" && i + 1 < argc)
+		{
+			jobs = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (arg == "--out" && i + 1 < argc)
+		{
+			outFile = argv[++i];
+		}
+	}
+
+	if (!batchInput.empty())
+	{
+		return replayBatch(batchInput, outFile, jobs, backend);
+	}
+
+	if (argc < 2)
+	{
+		return 1;
+	}
+
+	GowReplayer replayer(backend);
 
 	replayer.replay(argv[1]);
 
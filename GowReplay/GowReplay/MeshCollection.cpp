@@ -0,0 +1,51 @@
+#include "MeshCollection.h"
+
+#include <algorithm>
+
+MeshObject* MeshCollection::find(uint64_t key)
+{
+	auto iter = m_index.find(key);
+	return iter != m_index.end() ? &m_meshes[iter->second] : nullptr;
+}
+
+void MeshCollection::add(uint64_t key, MeshObject mesh)
+{
+	m_index.emplace(key, m_meshes.size());
+	m_meshes.push_back(std::move(mesh));
+}
+
+void MeshCollection::appendInstances(MeshObject& mesh, const std::vector<MeshTransform>& instances)
+{
+	for (const auto& trs : instances)
+	{
+		// the same object drawn again by another pass
+		if (std::find(mesh.instances.begin(), mesh.instances.end(), trs) != mesh.instances.end())
+		{
+			continue;
+		}
+		mesh.instances.push_back(trs);
+	}
+}
+
+void MeshCollection::merge(MeshCollection&& other, const std::string& prefix)
+{
+	for (const auto& [key, index] : other.m_index)
+	{
+		auto& mesh = other.m_meshes[index];
+		if (auto known = find(key))
+		{
+			appendInstances(*known, mesh.instances);
+			continue;
+		}
+
+		mesh.name = prefix + mesh.name;
+		add(key, std::move(mesh));
+	}
+	other.clear();
+}
+
+void MeshCollection::clear()
+{
+	m_meshes.clear();
+	m_index.clear();
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "FbxBuilder.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Unique meshes keyed by a hash of their geometry and textures,
+// drawing a known mesh again only adds its instances.
+class MeshCollection
+{
+public:
+	MeshObject* find(uint64_t key);
+	void        add(uint64_t key, MeshObject mesh);
+
+	// instances already in the mesh are skipped
+	static void appendInstances(MeshObject& mesh, const std::vector<MeshTransform>& instances);
+
+	// moves the meshes of other in, the names of new ones get prefix
+	void merge(MeshCollection&& other, const std::string& prefix = {});
+
+	const std::vector<MeshObject>& meshes() const { return m_meshes; }
+	size_t                         size() const { return m_meshes.size(); }
+
+	void clear();
+
+private:
+	std::vector<MeshObject>    m_meshes;
+	std::map<uint64_t, size_t> m_index;
+};
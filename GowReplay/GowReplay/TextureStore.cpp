@@ -0,0 +1,66 @@
+#include "TextureStore.h"
+#include "Log.h"
+#include "Tools.h"
+
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TextureStore::TextureStore(const fs::path& root) :
+	m_root(root)
+{
+	fs::create_directories(m_root);
+}
+
+std::string TextureStore::intern(const std::string& filename)
+{
+	std::ifstream ifs(filename, std::ios::binary);
+	if (!ifs)
+	{
+		LOG_WARN("texture not saved: {}", filename);
+		return filename;
+	}
+
+	std::vector<char> data((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	ifs.close();
+
+	uint64_t key = hash::bytes(data.data(), data.size());
+
+	std::lock_guard<std::mutex> lock(m_lock);
+
+	// the hash only finds candidates, files are the same if their bytes are
+	auto range = m_files.equal_range(key);
+	for (auto iter = range.first; iter != range.second; ++iter)
+	{
+		const auto& stored = iter->second;
+		if (stored.path == filename)
+		{
+			return stored.path;
+		}
+
+		if (sameContents(stored, data))
+		{
+			LOG_TRACE("Use stored texture {} for {}", stored.path, filename);
+			std::error_code ec;
+			fs::remove(filename, ec);
+			return stored.path;
+		}
+	}
+
+	m_files.emplace(key, StoredFile{ data.size(), filename });
+	return filename;
+}
+
+bool TextureStore::sameContents(const StoredFile& stored, const std::vector<char>& data)
+{
+	if (stored.size != data.size())
+	{
+		return false;
+	}
+
+	std::ifstream     ifs(stored.path, std::ios::binary);
+	std::vector<char> other((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+	return other == data;
+}
\ No newline at end of file
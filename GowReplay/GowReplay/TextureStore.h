@@ -0,0 +1,35 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Texture files shared by the replayers of a batch, textures saved by several
+// captures with the same contents are kept once. Thread safe.
+class TextureStore
+{
+public:
+	explicit TextureStore(const std::filesystem::path& root);
+
+	const std::filesystem::path& root() const { return m_root; }
+
+	// path of the stored file with the same contents as filename,
+	// filename is removed if that is another file
+	std::string intern(const std::string& filename);
+
+private:
+	struct StoredFile
+	{
+		uintmax_t   size;
+		std::string path;
+	};
+
+	bool sameContents(const StoredFile& stored, const std::vector<char>& data);
+
+private:
+	std::filesystem::path               m_root;
+	std::mutex                          m_lock;
+	std::multimap<uint64_t, StoredFile> m_files;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 
 namespace bit
 {
@@ -10,3 +11,33 @@ namespace bit
 		return (value >> fst) & ~(~T(0) << (lst - fst + 1));
 	}
 }  // namespace bit
+
+namespace hash
+{
+	constexpr uint64_t Seed = 0xcbf29ce484222325ull;
+
+	inline uint64_t combine(uint64_t seed, uint64_t value)
+	{
+		return seed ^ (value + 0x9e3779b97f4a7c15ull + (seed << 12) + (seed >> 4));
+	}
+
+	// FNV-1a style over 8 byte words, rotated so high bits reach the low ones
+	inline uint64_t bytes(const void* data, size_t size, uint64_t seed = Seed)
+	{
+		const uint64_t prime = 0x100000001b3ull;
+		const uint8_t* p     = static_cast<const uint8_t*>(data);
+		uint64_t       h     = combine(seed, size);
+		for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t))
+		{
+			uint64_t word;
+			std::memcpy(&word, p, sizeof(word));
+			h ^= word;
+			h = ((h << 31) | (h >> 33)) * prime;
+		}
+		for (; size != 0; --size, ++p)
+		{
+			h = (h ^ *p) * prime;
+		}
+		return h;
+	}
+}  // namespace hash